@@ -34,3 +34,5 @@ $(TEST)_DEFS := $(TMK_COMMON_DEFS) $(OPT_DEFS)
 $(TEST)_CONFIG := $(TEST_PATH)/config.h
 
 VPATH += $(TOP_DIR)/tests/test_common
+# Lets sources including "config.h" pick up the config of the test
+VPATH += $(TEST_PATH)
@@ -45,6 +45,13 @@ else ifeq ($(strip $(DEBUG_MATRIX_SCAN_RATE_ENABLE)), api)
     OPT_DEFS += -DDEBUG_MATRIX_SCAN_RATE
 endif
 
+SCAN_PROFILER_ENABLE ?= no
+ifeq ($(strip $(SCAN_PROFILER_ENABLE)), yes)
+    OPT_DEFS += -DSCAN_PROFILER_ENABLE
+    SRC += $(QUANTUM_DIR)/scan_profiler.c
+    SRC += $(PLATFORM_COMMON_DIR)/scan_profiler_ticks.c
+endif
+
 AUDIO_ENABLE ?= no
 ifeq ($(strip $(AUDIO_ENABLE)), yes)
     ifeq ($(PLATFORM),CHIBIOS)
@@ -188,7 +195,13 @@ else
         OPT_DEFS += -DEEPROM_DRIVER -DEEPROM_STM32_FLASH_EMULATED
         COMMON_VPATH += $(DRIVER_PATH)/eeprom
         SRC += eeprom_driver.c
-        SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32.c
+        ifeq ($(strip $(EEPROM_STM32_BANKED)), yes)
+          # Wear-leveled across several banks, compacted in the background
+          OPT_DEFS += -DEEPROM_STM32_BANKED
+          SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32_banked.c
+        else
+          SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32.c
+        endif
         SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
       else ifneq ($(filter $(MCU_SERIES),STM32L0xx STM32L1xx),)
         # True EEPROM on STM32L0xx, L1xx
@@ -510,6 +523,10 @@ ifeq ($(strip $(WS2812_DRIVER_REQUIRED)), yes)
     else
         SRC += ws2812_$(strip $(WS2812_DRIVER)).c
 
+        ifneq ($(filter pwm spi,$(WS2812_DRIVER)),)
+            SRC += ws2812_encoder.c
+        endif
+
         ifeq ($(strip $(PLATFORM)), CHIBIOS)
             ifeq ($(strip $(WS2812_DRIVER)), pwm)
                 OPT_DEFS += -DSTM32_DMA_REQUIRED=TRUE
@@ -601,6 +618,7 @@ ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
     # Determine which (if any) transport files are required
     ifneq ($(strip $(SPLIT_TRANSPORT)), custom)
         QUANTUM_SRC += $(QUANTUM_DIR)/split_common/transport.c \
+                       $(QUANTUM_DIR)/split_common/transport_batch.c \
                        $(QUANTUM_DIR)/split_common/transactions.c
 
         OPT_DEFS += -DSPLIT_COMMON_TRANSACTIONS
@@ -663,10 +681,23 @@ ifeq ($(strip $(OLED_ENABLE)), yes)
         ifeq ($(strip $(OLED_DRIVER)), SSD1306)
             SRC += ssd1306_sh1106.c
             QUANTUM_LIB_SRC += i2c_master.c
+            ifeq ($(strip $(OLED_RENDER_BUDGET_ENABLE)), yes)
+                OPT_DEFS += -DOLED_RENDER_BUDGET_ENABLE
+                # Tick counter for OLED_RENDER_BUDGET_US
+                ifneq ($(strip $(SCAN_PROFILER_ENABLE)), yes)
+                    SRC += $(PLATFORM_COMMON_DIR)/scan_profiler_ticks.c
+                endif
+            endif
         endif
     endif
 endif
 
+ifeq ($(strip $(I2C_QUEUE_ENABLE)), yes)
+    OPT_DEFS += -DI2C_QUEUE_ENABLE
+    QUANTUM_LIB_SRC += i2c_master.c
+    SRC += i2c_queue.c
+endif
+
 ifeq ($(strip $(ST7565_ENABLE)), yes)
     OPT_DEFS += -DST7565_ENABLE
     COMMON_VPATH += $(DRIVER_PATH)/oled # For glcdfont.h
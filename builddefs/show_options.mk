@@ -45,6 +45,7 @@ OTHER_OPTION_NAMES = \
   KEY_OVERRIDE_ENABLE \
   LEADER_ENABLE \
   PRINTING_ENABLE \
+  SEND_STRING_ASYNC_ENABLE \
   STENO_ENABLE \
   TAP_DANCE_ENABLE \
   VIRTSER_ENABLE \
@@ -69,6 +70,9 @@ OTHER_OPTION_NAMES = \
   RAW_ENABLE \
   SWAP_HANDS_ENABLE \
   RING_BUFFERED_6KRO_REPORT_ENABLE \
+  KEYBOARD_REPORT_BITMAP_ENABLE \
+  HOST_REPORT_QUEUE_ENABLE \
+  I2C_QUEUE_ENABLE \
   WATCHDOG_ENABLE \
   ERGOINU \
   NO_USB_STARTUP_CHECK \
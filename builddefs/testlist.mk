@@ -3,6 +3,8 @@ FULL_TESTS := $(notdir $(TEST_LIST))
 
 include $(QUANTUM_PATH)/debounce/tests/testlist.mk
 include $(QUANTUM_PATH)/sequencer/tests/testlist.mk
+include $(QUANTUM_PATH)/split_common/tests/testlist.mk
+include $(QUANTUM_PATH)/tests/testlist.mk
 include $(PLATFORM_PATH)/test/testlist.mk
 
 define VALIDATE_TEST_LIST
@@ -0,0 +1,139 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+
+#include "i2c_queue.h"
+
+enum {
+    I2C_TRANSFER_IDLE,
+    I2C_TRANSFER_QUEUED,
+    I2C_TRANSFER_RUNNING,
+};
+
+static i2c_transfer_t *queue_head[I2C_QUEUE_PRIORITY_COUNT] = {NULL};
+static i2c_transfer_t *queue_tail[I2C_QUEUE_PRIORITY_COUNT] = {NULL};
+static i2c_transfer_t *running                              = NULL;
+
+#ifndef I2C_QUEUE_PLATFORM_TRANSPORT
+// Runs the transfer on the spot, its callback still waits for i2c_queue_task()
+static i2c_status_t transport_status;
+
+static void i2c_queue_transport_start(i2c_transfer_t *transfer) {
+    uint8_t reg8 = transfer->reg;
+
+    if (transfer->tx_length && transfer->rx_length) {
+        transport_status = I2C_STATUS_ERROR;
+    } else if (transfer->rx_length) {
+        switch (transfer->reg_length) {
+            case 0:
+                transport_status = i2c_receive(transfer->address, transfer->rx_data, transfer->rx_length, transfer->timeout);
+                break;
+            case 1:
+                transport_status = i2c_readReg(transfer->address, reg8, transfer->rx_data, transfer->rx_length, transfer->timeout);
+                break;
+            default:
+                transport_status = i2c_readReg16(transfer->address, transfer->reg, transfer->rx_data, transfer->rx_length, transfer->timeout);
+                break;
+        }
+    } else {
+        switch (transfer->reg_length) {
+            case 0:
+                transport_status = i2c_transmit(transfer->address, transfer->tx_data, transfer->tx_length, transfer->timeout);
+                break;
+            case 1:
+                transport_status = i2c_writeReg(transfer->address, reg8, transfer->tx_data, transfer->tx_length, transfer->timeout);
+                break;
+            default:
+                transport_status = i2c_writeReg16(transfer->address, transfer->reg, transfer->tx_data, transfer->tx_length, transfer->timeout);
+                break;
+        }
+    }
+}
+
+static bool i2c_queue_transport_poll(i2c_status_t *status) {
+    *status = transport_status;
+    return true;
+}
+#endif
+
+static void start_next(void) {
+    if (running) {
+        return;
+    }
+
+    for (int8_t priority = I2C_QUEUE_PRIORITY_COUNT - 1; priority >= 0; priority--) {
+        i2c_transfer_t *transfer = queue_head[priority];
+        if (transfer) {
+            queue_head[priority] = transfer->next;
+            if (!queue_head[priority]) {
+                queue_tail[priority] = NULL;
+            }
+            transfer->state = I2C_TRANSFER_RUNNING;
+            running         = transfer;
+            i2c_queue_transport_start(transfer);
+            return;
+        }
+    }
+}
+
+bool i2c_queue_submit(i2c_transfer_t *transfer) {
+    if (transfer->state != I2C_TRANSFER_IDLE) {
+        return false;
+    }
+    if (transfer->priority >= I2C_QUEUE_PRIORITY_COUNT) {
+        transfer->priority = I2C_QUEUE_PRIORITY_HIGH;
+    }
+
+    transfer->next  = NULL;
+    transfer->state = I2C_TRANSFER_QUEUED;
+    if (queue_tail[transfer->priority]) {
+        queue_tail[transfer->priority]->next = transfer;
+    } else {
+        queue_head[transfer->priority] = transfer;
+    }
+    queue_tail[transfer->priority] = transfer;
+
+    start_next();
+    return true;
+}
+
+bool i2c_transfer_pending(const i2c_transfer_t *transfer) {
+    return transfer->state != I2C_TRANSFER_IDLE;
+}
+
+void i2c_queue_flush(void) {
+    while (running) {
+        i2c_queue_task();
+    }
+}
+
+void i2c_queue_task(void) {
+    i2c_status_t status;
+
+    while (running && i2c_queue_transport_poll(&status)) {
+        i2c_transfer_t *transfer = running;
+
+        transfer->state = I2C_TRANSFER_IDLE;
+        running         = NULL;
+        // Keep the bus busy while the callback runs
+        start_next();
+
+        if (transfer->callback) {
+            transfer->callback(transfer, status);
+        }
+    }
+}
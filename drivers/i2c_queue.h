@@ -0,0 +1,105 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c_master.h"
+
+/*
+ * Non-blocking I2C transfers.
+ *
+ * Transfers are queued and run one at a time, high priority ones first. A transfer writes the
+ * register address bytes, then tx_data, then reads rx_length bytes into rx_data with a repeated
+ * start. Nothing is copied: the transfer and its buffers belong to the queue from
+ * i2c_queue_submit() until its callback is called from i2c_queue_task().
+ *
+ * Platforms defining I2C_QUEUE_PLATFORM_TRANSPORT run transfers in the background. Elsewhere they
+ * run on submit through the blocking i2c_master functions, which can either write or read: a
+ * transfer with both tx_length and rx_length fails there.
+ *
+ * Blocking i2c_master calls are not ordered with queued transfers. Drivers mixing both call
+ * i2c_queue_flush() before blocking calls that must not overtake queued ones.
+ */
+
+typedef enum {
+    I2C_QUEUE_PRIORITY_NORMAL,
+    I2C_QUEUE_PRIORITY_HIGH, // e.g. sensor reads, run before any queued normal transfer
+    I2C_QUEUE_PRIORITY_COUNT,
+} i2c_queue_priority_t;
+
+typedef struct i2c_transfer_t i2c_transfer_t;
+
+/**
+ * \brief Called from i2c_queue_task() once a transfer completed or failed.
+ *
+ * The transfer may be submitted again from its callback.
+ */
+typedef void (*i2c_transfer_callback_t)(i2c_transfer_t *transfer, i2c_status_t status);
+
+struct i2c_transfer_t {
+    uint8_t                 address;    // Device address, shifted as for i2c_transmit()
+    uint8_t                 priority;   // i2c_queue_priority_t
+    uint8_t                 reg_length; // Register address bytes written first, 0 to 2
+    uint16_t                reg;        // Register address, most significant byte first
+    const uint8_t *         tx_data;
+    uint16_t                tx_length;
+    uint8_t *               rx_data;
+    uint16_t                rx_length;
+    uint16_t                timeout; // Milliseconds
+    i2c_transfer_callback_t callback;
+    void *                  cb_arg;
+
+    // Owned by the queue
+    i2c_transfer_t *next;
+    uint8_t         state;
+};
+
+/**
+ * \brief Queue a transfer.
+ *
+ * \return false if the transfer is still queued or running
+ */
+bool i2c_queue_submit(i2c_transfer_t *transfer);
+
+/**
+ * \brief Whether a transfer is queued or running, so that it and its buffers are in use.
+ */
+bool i2c_transfer_pending(const i2c_transfer_t *transfer);
+
+/**
+ * \brief Run everything queued, blocking until the queue is empty.
+ */
+void i2c_queue_flush(void);
+
+/**
+ * \brief Complete finished transfers and start the next one. Called from keyboard_task().
+ */
+void i2c_queue_task(void);
+
+#ifdef I2C_QUEUE_PLATFORM_TRANSPORT
+/**
+ * \brief Start running a transfer in the background, never called while one is running.
+ */
+void i2c_queue_transport_start(i2c_transfer_t *transfer);
+
+/**
+ * \brief Whether the transfer started last is done, and its status.
+ */
+bool i2c_queue_transport_poll(i2c_status_t *status);
+#endif
@@ -57,8 +57,11 @@
 #    define AW_SPI_DIVISOR 4
 #endif
 
+// Registers [dirty_start, dirty_end) have changed since they were last sent,
+// nothing needs sending while dirty_end is 0.
 uint8_t g_pwm_buffer[DRIVER_COUNT][AW_PWM_REGISTER_COUNT];
-bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
+uint8_t g_pwm_buffer_dirty_start[DRIVER_COUNT] = {0};
+uint8_t g_pwm_buffer_dirty_end[DRIVER_COUNT]   = {0};
 
 bool AW20216_write(pin_t cs_pin, uint8_t page, uint8_t reg, uint8_t* data, uint8_t len) {
     static uint8_t s_spi_transfer_buffer[2] = {0};
@@ -116,16 +119,37 @@ void AW20216_init(pin_t cs_pin, pin_t en_pin) {
     AW20216_init_scaling(cs_pin);
 
     AW20216_soft_enable(cs_pin);
+
+    // The PWM registers are not cleared here, make sure the first update sends all of them
+    for (uint8_t i = 0; i < DRIVER_COUNT; i++) {
+        g_pwm_buffer_dirty_start[i] = 0;
+        g_pwm_buffer_dirty_end[i]   = AW_PWM_REGISTER_COUNT;
+    }
+}
+
+static inline void AW20216_set_pwm_buffer(uint8_t driver, uint8_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] == value) {
+        return;
+    }
+
+    g_pwm_buffer[driver][reg] = value;
+    if (g_pwm_buffer_dirty_end[driver] == 0) {
+        g_pwm_buffer_dirty_start[driver] = reg;
+        g_pwm_buffer_dirty_end[driver]   = reg + 1;
+    } else if (reg < g_pwm_buffer_dirty_start[driver]) {
+        g_pwm_buffer_dirty_start[driver] = reg;
+    } else if (reg >= g_pwm_buffer_dirty_end[driver]) {
+        g_pwm_buffer_dirty_end[driver] = reg + 1;
+    }
 }
 
 void AW20216_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     aw_led led;
     memcpy_P(&led, (&g_aw_leds[index]), sizeof(led));
 
-    g_pwm_buffer[led.driver][led.r]          = red;
-    g_pwm_buffer[led.driver][led.g]          = green;
-    g_pwm_buffer[led.driver][led.b]          = blue;
-    g_pwm_buffer_update_required[led.driver] = true;
+    AW20216_set_pwm_buffer(led.driver, led.r, red);
+    AW20216_set_pwm_buffer(led.driver, led.g, green);
+    AW20216_set_pwm_buffer(led.driver, led.b, blue);
 }
 
 void AW20216_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
@@ -135,8 +159,15 @@ void AW20216_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
 }
 
 void AW20216_update_pwm_buffers(pin_t cs_pin, uint8_t index) {
-    if (g_pwm_buffer_update_required[index]) {
-        AW20216_write(cs_pin, AW_PAGE_PWM, 0, g_pwm_buffer[index], AW_PWM_REGISTER_COUNT);
+    uint8_t start = g_pwm_buffer_dirty_start[index];
+    uint8_t end   = g_pwm_buffer_dirty_end[index];
+    if (end) {
+        // Only send the changed range; if that fails, resend everything next time
+        if (!AW20216_write(cs_pin, AW_PAGE_PWM, start, &g_pwm_buffer[index][start], end - start)) {
+            g_pwm_buffer_dirty_start[index] = 0;
+            g_pwm_buffer_dirty_end[index]   = AW_PWM_REGISTER_COUNT;
+            return;
+        }
     }
-    g_pwm_buffer_update_required[index] = false;
+    g_pwm_buffer_dirty_end[index] = 0;
 }
@@ -17,6 +17,9 @@
 #include "ckled2001.h"
 #include "i2c_master.h"
 #include "wait.h"
+#ifdef I2C_QUEUE_ENABLE
+#    include "i2c_queue.h"
+#endif
 
 #ifndef CKLED2001_TIMEOUT
 #    define CKLED2001_TIMEOUT 100
@@ -30,6 +33,8 @@
 #    define PHASE_CHANNEL MSKPHASE_12CHANNEL
 #endif
 
+#define CKLED2001_PWM_BLOCKS_ALL 0x0FFF // 12 blocks of 16 registers
+
 // Transfer buffer for TWITransmitData()
 uint8_t g_twi_transfer_buffer[20];
 
@@ -39,13 +44,18 @@ uint8_t g_twi_transfer_buffer[20];
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in CKLED2001_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][192];
-bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
+// Bit n flags the 16 PG1 PWM registers of SW(n+1) for resending
+uint8_t  g_pwm_buffer[DRIVER_COUNT][192];
+uint16_t g_pwm_buffer_update_required[DRIVER_COUNT] = {0};
 
 uint8_t g_led_control_registers[DRIVER_COUNT][24]             = {0};
 bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
 
 bool CKLED2001_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+#ifdef I2C_QUEUE_ENABLE
+    // Queued PWM updates rely on the page they selected
+    i2c_queue_flush();
+#endif
     // If the transaction fails function returns false.
     g_twi_transfer_buffer[0] = reg;
     g_twi_transfer_buffer[1] = data;
@@ -64,14 +74,17 @@ bool CKLED2001_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
     return true;
 }
 
-bool CKLED2001_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static bool CKLED2001_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // Assumes PG1 is already selected.
     // If any of the transactions fails function returns false.
-    // Transmit PWM registers in 12 transfers of 16 bytes.
+    // Transmit PWM registers in up to 12 transfers of 16 bytes.
     // g_twi_transfer_buffer[] is 20 bytes
 
     // Iterate over the pwm_buffer contents at 16 byte intervals.
     for (int i = 0; i < 192; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         g_twi_transfer_buffer[0] = i;
         // Copy the data from i to i+15.
         // Device will auto-increment register for data after the first byte
@@ -95,6 +108,10 @@ bool CKLED2001_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     return true;
 }
 
+bool CKLED2001_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+    return CKLED2001_write_pwm_blocks(addr, pwm_buffer, CKLED2001_PWM_BLOCKS_ALL);
+}
+
 void CKLED2001_init(uint8_t addr) {
     // Select to function page
     CKLED2001_write_register(addr, CONFIGURE_CMD_PAGE, FUNCTION_PAGE);
@@ -118,7 +135,7 @@ void CKLED2001_init(uint8_t addr) {
 
     // Set PWM PAGE (Page 1)
     CKLED2001_write_register(addr, CONFIGURE_CMD_PAGE, LED_PWM_PAGE);
-    for (int i = 0; i < LED_CURRENT_TUNE_LENGTH; i++) {
+    for (int i = 0; i < LED_PWM_LENGTH; i++) {
         CKLED2001_write_register(addr, i, 0x00);
     }
 
@@ -149,15 +166,21 @@ void CKLED2001_init(uint8_t addr) {
     CKLED2001_write_register(addr, CONFIGURATION_REG, MSKSW_NORMAL_MODE);
 }
 
+static inline void CKLED2001_set_pwm_buffer(uint8_t driver, uint8_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] != value) {
+        g_pwm_buffer[driver][reg] = value;
+        g_pwm_buffer_update_required[driver] |= (1 << (reg / 16));
+    }
+}
+
 void CKLED2001_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     ckled2001_led led;
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         memcpy_P(&led, (&g_ckled2001_leds[index]), sizeof(led));
 
-        g_pwm_buffer[led.driver][led.r]          = red;
-        g_pwm_buffer[led.driver][led.g]          = green;
-        g_pwm_buffer[led.driver][led.b]          = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        CKLED2001_set_pwm_buffer(led.driver, led.r, red);
+        CKLED2001_set_pwm_buffer(led.driver, led.g, green);
+        CKLED2001_set_pwm_buffer(led.driver, led.b, blue);
     }
 }
 
@@ -197,18 +220,74 @@ void CKLED2001_set_led_control_register(uint8_t index, bool red, bool green, boo
     g_led_control_registers_update_required[led.driver] = true;
 }
 
+#ifdef I2C_QUEUE_ENABLE
+static const uint8_t  g_pwm_page                       = LED_PWM_PAGE;
+static i2c_transfer_t g_pwm_transfers[DRIVER_COUNT][2] = {0};
+
+static void CKLED2001_pwm_transfer_done(i2c_transfer_t *transfer, i2c_status_t status) {
+    uint8_t index = (uintptr_t)transfer->cb_arg;
+
+    // Same as for a blocking update, refresh PG0 and resend all of PG1 next time
+    if (status != I2C_STATUS_SUCCESS) {
+        g_led_control_registers_update_required[index] = true;
+        g_pwm_buffer_update_required[index]            = CKLED2001_PWM_BLOCKS_ALL;
+    }
+}
+
+static void CKLED2001_queue_register_write(i2c_transfer_t *transfer, uint8_t addr, uint8_t index, uint8_t reg, const uint8_t *data, uint8_t length) {
+    transfer->address    = addr << 1;
+    transfer->reg_length = 1;
+    transfer->reg        = reg;
+    transfer->tx_data    = data;
+    transfer->tx_length  = length;
+    transfer->timeout    = CKLED2001_TIMEOUT;
+    transfer->callback   = CKLED2001_pwm_transfer_done;
+    transfer->cb_arg     = (void *)(uintptr_t)index;
+    i2c_queue_submit(transfer);
+}
+
+void CKLED2001_update_pwm_buffers(uint8_t addr, uint8_t index) {
+    uint16_t blocks = g_pwm_buffer_update_required[index];
+    if (!blocks) {
+        return;
+    }
+
+    i2c_transfer_t *transfers = g_pwm_transfers[index];
+    // Changes keep accumulating while the previous update is on the bus
+    if (i2c_transfer_pending(&transfers[1])) {
+        return;
+    }
+
+    // One burst from the first to the last changed block, sent straight from the PWM buffer.
+    // Colours set while it is on the bus mark their block again, so they are sent next time.
+    uint8_t first = 0, last = 11;
+    while (!(blocks & (1 << first))) {
+        first++;
+    }
+    while (!(blocks & (1 << last))) {
+        last--;
+    }
+
+    CKLED2001_queue_register_write(&transfers[0], addr, index, CONFIGURE_CMD_PAGE, &g_pwm_page, 1);
+    CKLED2001_queue_register_write(&transfers[1], addr, index, first * 16, &g_pwm_buffer[index][first * 16], (last - first + 1) * 16);
+    g_pwm_buffer_update_required[index] = 0;
+}
+#else
 void CKLED2001_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
         CKLED2001_write_register(addr, CONFIGURE_CMD_PAGE, LED_PWM_PAGE);
 
         // If any of the transactions fail we risk writing dirty PG0,
-        // refresh page 0 just in case.
-        if (!CKLED2001_write_pwm_buffer(addr, g_pwm_buffer[index])) {
+        // refresh page 0 just in case, and resend all of PG1 next time.
+        if (!CKLED2001_write_pwm_blocks(addr, g_pwm_buffer[index], g_pwm_buffer_update_required[index])) {
             g_led_control_registers_update_required[index] = true;
+            g_pwm_buffer_update_required[index]            = CKLED2001_PWM_BLOCKS_ALL;
+            return;
         }
     }
-    g_pwm_buffer_update_required[index] = false;
+    g_pwm_buffer_update_required[index] = 0;
 }
+#endif
 
 void CKLED2001_update_led_control_registers(uint8_t addr, uint8_t index) {
     if (g_led_control_registers_update_required[index]) {
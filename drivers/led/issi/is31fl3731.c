@@ -19,6 +19,9 @@
 #include "is31fl3731.h"
 #include "i2c_master.h"
 #include "wait.h"
+#ifdef I2C_QUEUE_ENABLE
+#    include "i2c_queue.h"
+#endif
 
 // This is a 7-bit address, that gets left-shifted and bit 0
 // set to 0 for write, 1 for read (as per I2C protocol)
@@ -49,6 +52,8 @@
 #define ISSI_COMMANDREGISTER 0xFD
 #define ISSI_BANK_FUNCTIONREG 0x0B // helpfully called 'page nine'
 
+#define ISSI_PWM_BLOCKS_ALL 0x01FF // 9 blocks of 16 registers
+
 #ifndef ISSI_TIMEOUT
 #    define ISSI_TIMEOUT 100
 #endif
@@ -65,8 +70,9 @@ uint8_t g_twi_transfer_buffer[20];
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in IS31FL3731_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][144];
-bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
+// Bit n flags frame registers 0x24 + 16n to 0x33 + 16n for resending
+uint8_t  g_pwm_buffer[DRIVER_COUNT][144];
+uint16_t g_pwm_buffer_update_required[DRIVER_COUNT] = {0};
 
 uint8_t g_led_control_registers[DRIVER_COUNT][18]             = {{0}};
 bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
@@ -86,6 +92,10 @@ bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
 // 0x10 - R16,R15,R14,R13,R12,R11,R10,R09
 
 void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+#ifdef I2C_QUEUE_ENABLE
+    // Keep register writes in order with queued PWM updates
+    i2c_queue_flush();
+#endif
     g_twi_transfer_buffer[0] = reg;
     g_twi_transfer_buffer[1] = data;
 
@@ -98,14 +108,18 @@ void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static bool IS31FL3731_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // assumes bank is already selected
 
-    // transmit PWM registers in 9 transfers of 16 bytes
+    // transmit PWM registers in up to 9 transfers of 16 bytes
+    // returns false if any of the transfers failed
     // g_twi_transfer_buffer[] is 20 bytes
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < 144; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         // set the first register, e.g. 0x24, 0x34, 0x44, etc.
         g_twi_transfer_buffer[0] = 0x24 + i;
         // copy the data from i to i+15
@@ -116,13 +130,22 @@ void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
         }
 
 #if ISSI_PERSISTENCE > 0
-        for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0) break;
+        bool sent = false;
+        for (uint8_t i = 0; i < ISSI_PERSISTENCE && !sent; i++) {
+            sent = i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0;
         }
 #else
-        i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT);
+        bool sent = i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0;
 #endif
+        if (!sent) {
+            return false;
+        }
     }
+    return true;
+}
+
+void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+    IS31FL3731_write_pwm_blocks(addr, pwm_buffer, ISSI_PWM_BLOCKS_ALL);
 }
 
 void IS31FL3731_init(uint8_t addr) {
@@ -180,16 +203,22 @@ void IS31FL3731_init(uint8_t addr) {
     IS31FL3731_write_register(addr, ISSI_COMMANDREGISTER, 0);
 }
 
+static inline void IS31FL3731_set_pwm_buffer(uint8_t driver, uint8_t offset, uint8_t value) {
+    if (g_pwm_buffer[driver][offset] != value) {
+        g_pwm_buffer[driver][offset] = value;
+        g_pwm_buffer_update_required[driver] |= (1 << (offset / 16));
+    }
+}
+
 void IS31FL3731_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     is31_led led;
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         memcpy_P(&led, (&g_is31_leds[index]), sizeof(led));
 
         // Subtract 0x24 to get the second index of g_pwm_buffer
-        g_pwm_buffer[led.driver][led.r - 0x24]   = red;
-        g_pwm_buffer[led.driver][led.g - 0x24]   = green;
-        g_pwm_buffer[led.driver][led.b - 0x24]   = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        IS31FL3731_set_pwm_buffer(led.driver, led.r - 0x24, red);
+        IS31FL3731_set_pwm_buffer(led.driver, led.g - 0x24, green);
+        IS31FL3731_set_pwm_buffer(led.driver, led.b - 0x24, blue);
     }
 }
 
@@ -229,12 +258,68 @@ void IS31FL3731_set_led_control_register(uint8_t index, bool red, bool green, bo
     g_led_control_registers_update_required[led.driver] = true;
 }
 
+#ifdef I2C_QUEUE_ENABLE
+static i2c_transfer_t g_pwm_transfers[DRIVER_COUNT] = {0};
+
+static void IS31FL3731_pwm_transfer_done(i2c_transfer_t *transfer, i2c_status_t status) {
+    uint8_t index = (uintptr_t)transfer->cb_arg;
+
+    // Same as for a blocking update, resend the whole buffer next time
+    if (status != I2C_STATUS_SUCCESS) {
+        g_pwm_buffer_update_required[index] = ISSI_PWM_BLOCKS_ALL;
+    }
+}
+
+static void IS31FL3731_queue_register_write(i2c_transfer_t *transfer, uint8_t addr, uint8_t index, uint8_t reg, const uint8_t *data, uint8_t length) {
+    transfer->address    = addr << 1;
+    transfer->reg_length = 1;
+    transfer->reg        = reg;
+    transfer->tx_data    = data;
+    transfer->tx_length  = length;
+    transfer->timeout    = ISSI_TIMEOUT;
+    transfer->callback   = IS31FL3731_pwm_transfer_done;
+    transfer->cb_arg     = (void *)(uintptr_t)index;
+    i2c_queue_submit(transfer);
+}
+
+void IS31FL3731_update_pwm_buffers(uint8_t addr, uint8_t index) {
+    uint16_t blocks = g_pwm_buffer_update_required[index];
+    if (!blocks) {
+        return;
+    }
+
+    i2c_transfer_t *transfer = &g_pwm_transfers[index];
+    // Changes keep accumulating while the previous update is on the bus
+    if (i2c_transfer_pending(transfer)) {
+        return;
+    }
+
+    // One burst from the first to the last changed block, sent straight from the PWM buffer.
+    // Colours set while it is on the bus mark their block again, so they are sent next time.
+    uint8_t first = 0, last = 8;
+    while (!(blocks & (1 << first))) {
+        first++;
+    }
+    while (!(blocks & (1 << last))) {
+        last--;
+    }
+
+    // Assumes the frame register is already selected, as for a blocking update
+    IS31FL3731_queue_register_write(transfer, addr, index, 0x24 + first * 16, &g_pwm_buffer[index][first * 16], (last - first + 1) * 16);
+    g_pwm_buffer_update_required[index] = 0;
+}
+#else
 void IS31FL3731_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        IS31FL3731_write_pwm_buffer(addr, g_pwm_buffer[index]);
+        // If any of the transfers fail, resend the whole buffer next time
+        if (!IS31FL3731_write_pwm_blocks(addr, g_pwm_buffer[index], g_pwm_buffer_update_required[index])) {
+            g_pwm_buffer_update_required[index] = ISSI_PWM_BLOCKS_ALL;
+            return;
+        }
     }
-    g_pwm_buffer_update_required[index] = false;
+    g_pwm_buffer_update_required[index] = 0;
 }
+#endif
 
 void IS31FL3731_update_led_control_registers(uint8_t addr, uint8_t index) {
     if (g_led_control_registers_update_required[index]) {
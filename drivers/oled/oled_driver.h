@@ -170,6 +170,32 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define OLED_UPDATE_INTERVAL 50
 #endif
 
+// Time oled_render() may spend sending, 0 to send everything that changed
+#if !defined(OLED_RENDER_BUDGET_US)
+#    if defined(OLED_RENDER_BUDGET_ENABLE)
+#        define OLED_RENDER_BUDGET_US 2000
+#    else
+#        define OLED_RENDER_BUDGET_US 0
+#    endif
+#elif OLED_RENDER_BUDGET_US > 0 && !defined(OLED_RENDER_BUDGET_ENABLE)
+#    error "OLED_RENDER_BUDGET_US needs OLED_RENDER_BUDGET_ENABLE = yes in rules.mk"
+#endif
+
+// With OLED_RENDER_SHADOW, runs of unchanged bytes shorter than this are sent rather than readdressed
+#if !defined(OLED_RENDER_SHADOW_GAP)
+#    define OLED_RENDER_SHADOW_GAP 8
+#endif
+
+// With I2C_QUEUE_ENABLE, bursts oled_render() can queue before the rest waits for the next call
+#if !defined(OLED_RENDER_QUEUE_SIZE)
+#    define OLED_RENDER_QUEUE_SIZE 8
+#endif
+
+// Longest data transfer oled_render() sends, longer runs are split into several bursts
+#if !defined(OLED_RENDER_BURST_SIZE)
+#    define OLED_RENDER_BURST_SIZE 256
+#endif
+
 typedef struct __attribute__((__packed__)) {
     uint8_t *current_element;
     uint16_t remaining_element_count;
@@ -15,6 +15,9 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "i2c_master.h"
+#ifdef I2C_QUEUE_ENABLE
+#    include "i2c_queue.h"
+#endif
 #include "oled_driver.h"
 #include OLED_FONT_H
 #include "timer.h"
@@ -26,6 +29,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "keyboard.h"
 
+#if OLED_RENDER_BUDGET_US > 0
+#    include "scan_profiler.h"
+#endif
+
 // Used commands from spec sheet: https://cdn-shop.adafruit.com/datasheets/SSD1306.pdf
 // for SH1106: https://www.velleman.eu/downloads/29/infosheets/sh1106_datasheet.pdf
 
@@ -95,12 +102,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // i2c defines
 #define I2C_CMD 0x00
 #define I2C_DATA 0x40
+#ifdef I2C_QUEUE_ENABLE
+// Commands must not overtake render data still queued
+#    define I2C_QUEUE_FLUSH() i2c_queue_flush()
+#else
+#    define I2C_QUEUE_FLUSH() (void)0
+#endif
 #if defined(__AVR__)
-#    define I2C_TRANSMIT_P(data) i2c_transmit_P((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
+#    define I2C_TRANSMIT_P(data) (I2C_QUEUE_FLUSH(), i2c_transmit_P((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT))
 #else // defined(__AVR__)
-#    define I2C_TRANSMIT_P(data) i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
+#    define I2C_TRANSMIT_P(data) (I2C_QUEUE_FLUSH(), i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT))
 #endif // defined(__AVR__)
-#define I2C_TRANSMIT(data) i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
+#define I2C_TRANSMIT(data) (I2C_QUEUE_FLUSH(), i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT))
 #define I2C_WRITE_REG(mode, data, size) i2c_writeReg((OLED_DISPLAY_ADDRESS << 1), mode, data, size, OLED_I2C_TIMEOUT)
 
 #define HAS_FLAGS(bits, flags) ((bits & flags) == flags)
@@ -132,6 +145,20 @@ uint32_t oled_scroll_timeout;
 uint16_t oled_update_timeout;
 #endif
 
+#ifdef OLED_RENDER_SHADOW
+// What the panel shows, in the order it was sent: the layout of oled_buffer, or rotated blocks.
+// Only blocks with their bit set in oled_shadow_valid are known.
+static uint8_t         oled_shadow[OLED_MATRIX_SIZE];
+static OLED_BLOCK_TYPE oled_shadow_valid = 0;
+#endif
+
+static void oled_invalidate_panel(void) {
+#ifdef OLED_RENDER_SHADOW
+    oled_shadow_valid = 0;
+#endif
+    oled_dirty = OLED_ALL_BLOCKS_MASK;
+}
+
 // Internal variables to reduce math instructions
 
 #if defined(__AVR__)
@@ -225,7 +252,9 @@ bool oled_init(oled_rotation_t rotation) {
     oled_scroll_timeout = timer_read32() + OLED_SCROLL_TIMEOUT;
 #endif
 
+    // Whatever the panel showed before is unknown
     oled_clear();
+    oled_invalidate_panel();
     oled_initialized = true;
     oled_active      = true;
     oled_scrolling   = false;
@@ -245,49 +274,209 @@ void oled_clear(void) {
     oled_dirty  = OLED_ALL_BLOCKS_MASK;
 }
 
-static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
-    // Calculate commands to set memory addressing bounds.
-    uint8_t start_page   = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_WIDTH;
-    uint8_t start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
+// Part of the panel a run of blocks is sent to, width bytes per page from column col of page page
+typedef struct {
+    uint8_t col;
+    uint8_t page;
+    uint8_t width;
+} oled_window_t;
+
+static void calc_window_90(uint8_t block, oled_window_t *window) {
+    window->col   = OLED_BLOCK_SIZE * block / OLED_DISPLAY_HEIGHT * 8;
+    window->page  = OLED_BLOCK_SIZE * block % OLED_DISPLAY_HEIGHT;
+    window->width = (OLED_BLOCK_SIZE + OLED_DISPLAY_HEIGHT - 1) / OLED_DISPLAY_HEIGHT * 8;
+}
+
+uint8_t crot(uint8_t a, int8_t n) {
+    const uint8_t mask = 0x7;
+    n &= mask;
+    return a << n | a >> (-n & mask);
+}
+
+// Bit n of dest[i] is bit i of src[7 - n], an 8x8 bit transpose (Hacker's Delight, 7-3)
+static void rotate_90(const uint8_t *src, uint8_t *dest) {
+    uint32_t x = (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+    uint32_t y = (uint32_t)src[4] << 24 | (uint32_t)src[5] << 16 | (uint32_t)src[6] << 8 | src[7];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    dest[0] = y;
+    dest[1] = y >> 8;
+    dest[2] = y >> 16;
+    dest[3] = y >> 24;
+    dest[4] = x;
+    dest[5] = x >> 8;
+    dest[6] = x >> 16;
+    dest[7] = x >> 24;
+}
+
+#ifdef I2C_QUEUE_ENABLE
+#    if OLED_RENDER_BURST_SIZE + 1 > I2C_QUEUE_BUFFER_SIZE
+#        error OLED_RENDER_BURST_SIZE does not fit in a queued I2C transfer, reduce it below I2C_QUEUE_BUFFER_SIZE
+#    endif
+
+typedef struct {
+    uint8_t        command[7];
+    i2c_transfer_t start;
+    i2c_transfer_t data;
+} oled_burst_t;
+
+static oled_burst_t oled_bursts[OLED_RENDER_QUEUE_SIZE];
+static uint8_t      oled_bursts_used = 0;
+
+static void oled_render_done(i2c_transfer_t *transfer, i2c_status_t status) {
+    if (status != I2C_STATUS_SUCCESS) {
+        print("oled_render failed\n");
+        oled_invalidate_panel();
+    }
+}
+
+static bool oled_render_pending(void) {
+    for (uint8_t i = 0; i < oled_bursts_used; i++) {
+        if (i2c_transfer_pending(&oled_bursts[i].start) || i2c_transfer_pending(&oled_bursts[i].data)) {
+            return true;
+        }
+    }
+    oled_bursts_used = 0;
+    return false;
+}
+#endif
+
+// Sends data to the panel from start_col of start_page on, wrapping to start_col of the next page after end_col
+static bool oled_send_burst(const uint8_t *data, uint16_t length, uint8_t start_col, uint8_t end_col, uint8_t start_page, uint8_t end_page) {
+#ifdef I2C_QUEUE_ENABLE
+    // Everything queued so far goes out, the rest of the frame waits for the next render
+    if (oled_bursts_used == OLED_RENDER_QUEUE_SIZE) {
+        return false;
+    }
+    oled_burst_t *burst   = &oled_bursts[oled_bursts_used++];
+    uint8_t *     command = burst->command;
+#else
+    static uint8_t command[7];
+#endif
+
+    command[0] = I2C_CMD;
 #if (OLED_IC == OLED_IC_SH1106)
     // Commands for Page Addressing Mode. Sets starting page and column; has no end bound.
     // Column value must be split into high and low nybble and sent as two commands.
-    cmd_array[0] = PAM_PAGE_ADDR | start_page;
-    cmd_array[1] = PAM_SETCOLUMN_LSB | ((OLED_COLUMN_OFFSET + start_column) & 0x0f);
-    cmd_array[2] = PAM_SETCOLUMN_MSB | ((OLED_COLUMN_OFFSET + start_column) >> 4 & 0x0f);
-    cmd_array[3] = NOP;
-    cmd_array[4] = NOP;
-    cmd_array[5] = NOP;
+    command[1] = PAM_PAGE_ADDR | start_page;
+    command[2] = PAM_SETCOLUMN_LSB | ((OLED_COLUMN_OFFSET + start_col) & 0x0f);
+    command[3] = PAM_SETCOLUMN_MSB | ((OLED_COLUMN_OFFSET + start_col) >> 4 & 0x0f);
+    command[4] = NOP;
+    command[5] = NOP;
+    command[6] = NOP;
 #else
     // Commands for use in Horizontal Addressing mode.
-    cmd_array[1] = start_column;
-    cmd_array[4] = start_page;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) % OLED_DISPLAY_WIDTH + cmd_array[1];
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1;
+    command[1] = COLUMN_ADDR;
+    command[2] = start_col;
+    command[3] = end_col;
+    command[4] = PAGE_ADDR;
+    command[5] = start_page;
+    command[6] = end_page;
 #endif
-}
 
-static void calc_bounds_90(uint8_t update_start, uint8_t *cmd_array) {
-    cmd_array[1] = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_HEIGHT * 8;
-    cmd_array[4] = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_HEIGHT;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_HEIGHT - 1) / OLED_DISPLAY_HEIGHT * 8 - 1 + cmd_array[1];
-    ;
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_HEIGHT - 1) % OLED_DISPLAY_HEIGHT / 8;
+#ifdef I2C_QUEUE_ENABLE
+    burst->start = (i2c_transfer_t){.address = OLED_DISPLAY_ADDRESS << 1, .tx_data = command, .tx_length = sizeof(burst->command), .timeout = OLED_I2C_TIMEOUT, .callback = oled_render_done};
+    burst->data  = (i2c_transfer_t){.address = OLED_DISPLAY_ADDRESS << 1, .reg_length = 1, .reg = I2C_DATA, .tx_data = data, .tx_length = length, .timeout = OLED_I2C_TIMEOUT, .callback = oled_render_done};
+    i2c_queue_submit(&burst->start);
+    i2c_queue_submit(&burst->data);
+#else
+    if (I2C_TRANSMIT(command) != I2C_STATUS_SUCCESS) {
+        print("oled_render offset command failed\n");
+        return false;
+    }
+    if (I2C_WRITE_REG(I2C_DATA, data, length) != I2C_STATUS_SUCCESS) {
+        print("oled_render data failed\n");
+        return false;
+    }
+#endif
+    return true;
 }
 
-uint8_t crot(uint8_t a, int8_t n) {
-    const uint8_t mask = 0x7;
-    n &= mask;
-    return a << n | a >> (-n & mask);
+// Sends bytes from to to of a window, in as few bursts of at most OLED_RENDER_BURST_SIZE bytes as
+// the addressing mode allows
+static bool oled_send_span(const uint8_t *data, uint16_t from, uint16_t to, const oled_window_t *window) {
+    const uint16_t burst_rows = OLED_RENDER_BURST_SIZE / window->width;
+
+    while (from < to) {
+        uint8_t  row    = from / window->width;
+        uint8_t  column = from % window->width;
+        uint16_t end    = to;
+#if (OLED_IC == OLED_IC_SH1106)
+        // Page addressing never moves on to the next page
+        bool whole_rows = false;
+#else
+        // Past the end column, writes continue from the start column of the window
+        bool whole_rows = column == 0 && burst_rows > 0;
+#endif
+        if (whole_rows) {
+            if (end > from + burst_rows * window->width) {
+                end = from + burst_rows * window->width;
+            }
+        } else {
+            if (end > (row + 1) * window->width) {
+                end = (row + 1) * window->width;
+            }
+            if (end > from + OLED_RENDER_BURST_SIZE) {
+                end = from + OLED_RENDER_BURST_SIZE;
+            }
+        }
+
+        uint8_t end_col = whole_rows ? window->width - 1 : (end - 1) % window->width;
+        if (!oled_send_burst(&data[from], end - from, window->col + column, window->col + end_col, window->page + row, window->page + (end - 1) / window->width)) {
+            return false;
+        }
+        from = end;
+    }
+    return true;
 }
 
-static void rotate_90(const uint8_t *src, uint8_t *dest) {
-    for (uint8_t i = 0, shift = 7; i < 8; ++i, --shift) {
-        uint8_t selector = (1 << i);
-        for (uint8_t j = 0; j < 8; ++j) {
-            dest[i] |= crot(src[j] & selector, shift - (int8_t)j);
+// Sends bytes from to to of a window. With a shadow, only the ones that changed, the shadow is
+// updated and sent from so that queued transfers do not depend on data.
+static bool oled_send_changes(const uint8_t *data, uint8_t *shadow, uint16_t from, uint16_t to, const oled_window_t *window) {
+#ifdef OLED_RENDER_SHADOW
+    uint16_t i = from;
+    while (i < to) {
+        // Skip what the panel already shows
+        while (i < to && data[i] == shadow[i]) {
+            i++;
+        }
+        if (i == to) {
+            break;
+        }
+
+        // Take in unchanged bytes as long as that is cheaper than a new address command
+        uint16_t start = i, end = i;
+        for (uint8_t unchanged = 0; i < to && unchanged < OLED_RENDER_SHADOW_GAP; i++) {
+            if (data[i] != shadow[i]) {
+                unchanged = 0;
+                end       = i + 1;
+            } else {
+                unchanged++;
+            }
         }
+
+        memcpy(&shadow[start], &data[start], end - start);
+        if (!oled_send_span(shadow, start, end, window)) {
+            return false;
+        }
+        i = end;
     }
+    return true;
+#else
+    return oled_send_span(data, from, to, window);
+#endif
 }
 
 void oled_render(void) {
@@ -301,55 +490,109 @@ void oled_render(void) {
         return;
     }
 
-    // Find first dirty block
-    uint8_t update_start = 0;
-    while (!(oled_dirty & ((OLED_BLOCK_TYPE)1 << update_start))) {
-        ++update_start;
+#ifdef I2C_QUEUE_ENABLE
+    // The previous render is still on its way, its buffers are in use
+    if (oled_render_pending()) {
+        return;
     }
+#endif
 
-    // Set column & page position
-    static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
-    if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        calc_bounds(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
-    } else {
-        calc_bounds_90(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
-    }
+#if OLED_RENDER_BUDGET_US > 0
+    uint32_t start_ticks  = scan_profiler_read_ticks();
+    uint32_t budget_ticks = (uint64_t)OLED_RENDER_BUDGET_US * scan_profiler_ticks_per_ms() / 1000;
+#endif
 
-    // Send column & page position
-    if (I2C_TRANSMIT(display_start) != I2C_STATUS_SUCCESS) {
-        print("oled_render offset command failed\n");
-        return;
-    }
+    uint8_t block = 0;
+    while (oled_dirty) {
+        // Find the next dirty block
+        while (!(oled_dirty & ((OLED_BLOCK_TYPE)1 << block))) {
+            ++block;
+        }
 
-    if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        // Send render data chunk as is
-        if (I2C_WRITE_REG(I2C_DATA, &oled_buffer[OLED_BLOCK_SIZE * update_start], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
-            print("oled_render data failed\n");
-            return;
+        uint8_t        last = block;
+        oled_window_t  window;
+        const uint8_t *data;
+        uint8_t *      shadow = NULL;
+        uint16_t       from, to;
+
+        if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+            // Adjacent dirty blocks are contiguous on the panel too, send them together
+            while (last + 1 < OLED_BLOCK_COUNT && (oled_dirty & ((OLED_BLOCK_TYPE)1 << (last + 1)))) {
+                ++last;
+            }
+            window = (oled_window_t){.col = 0, .page = 0, .width = OLED_DISPLAY_WIDTH};
+            data   = oled_buffer;
+#ifdef OLED_RENDER_SHADOW
+            shadow = oled_shadow;
+#endif
+            from = OLED_BLOCK_SIZE * block;
+            to   = OLED_BLOCK_SIZE * (last + 1);
+        } else {
+            // Rotate the render chunks
+            const static uint8_t source_map[] = OLED_SOURCE_MAP;
+            const static uint8_t target_map[] = OLED_TARGET_MAP;
+
+            static uint8_t temp_buffer[OLED_BLOCK_SIZE];
+            memset(temp_buffer, 0, sizeof(temp_buffer));
+            for (uint8_t i = 0; i < sizeof(source_map); ++i) {
+                rotate_90(&oled_buffer[OLED_BLOCK_SIZE * block + source_map[i]], &temp_buffer[target_map[i]]);
+            }
+
+            calc_window_90(block, &window);
+            data = temp_buffer;
+#ifdef OLED_RENDER_SHADOW
+            shadow = &oled_shadow[OLED_BLOCK_SIZE * block];
+#endif
+            from = 0;
+            to   = OLED_BLOCK_SIZE;
         }
-    } else {
-        // Rotate the render chunks
-        const static uint8_t source_map[] = OLED_SOURCE_MAP;
-        const static uint8_t target_map[] = OLED_TARGET_MAP;
-
-        static uint8_t temp_buffer[OLED_BLOCK_SIZE];
-        memset(temp_buffer, 0, sizeof(temp_buffer));
-        for (uint8_t i = 0; i < sizeof(source_map); ++i) {
-            rotate_90(&oled_buffer[OLED_BLOCK_SIZE * update_start + source_map[i]], &temp_buffer[target_map[i]]);
+
+#ifdef OLED_RENDER_SHADOW
+        // Whatever the panel shows there is unknown, make every byte differ
+        for (uint8_t i = block; i <= last; i++) {
+            if (!(oled_shadow_valid & ((OLED_BLOCK_TYPE)1 << i))) {
+                for (uint16_t j = OLED_BLOCK_SIZE * (i - block) + from; j < OLED_BLOCK_SIZE * (i - block + 1) + from; j++) {
+                    shadow[j] = ~data[j];
+                }
+            }
         }
+#endif
 
-        // Send render data chunk after rotating
-        if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
-            print("oled_render90 data failed\n");
-            return;
+        if (!oled_send_changes(data, shadow, from, to, &window)) {
+#ifndef I2C_QUEUE_ENABLE
+            oled_invalidate_panel();
+#elif defined(OLED_RENDER_SHADOW)
+            // The shadow already holds what did not fit in the queue, send these blocks in full next time
+            for (uint8_t i = block; i <= last; i++) {
+                oled_shadow_valid &= ~((OLED_BLOCK_TYPE)1 << i);
+            }
+#endif
+            break;
+        }
+
+        // Clear dirty flags
+        for (; block <= last; ++block) {
+            oled_dirty &= ~((OLED_BLOCK_TYPE)1 << block);
+#ifdef OLED_RENDER_SHADOW
+            oled_shadow_valid |= (OLED_BLOCK_TYPE)1 << block;
+#endif
         }
+
+#if defined(I2C_QUEUE_ENABLE) && !defined(OLED_RENDER_SHADOW)
+        // The rotated block is sent from temp_buffer
+        if (HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+            break;
+        }
+#endif
+#if OLED_RENDER_BUDGET_US > 0
+        if (scan_profiler_read_ticks() - start_ticks >= budget_ticks) {
+            break;
+        }
+#endif
     }
 
     // Turn on display if it is off
     oled_on();
-
-    // Clear dirty flag
-    oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
 }
 
 void oled_set_cursor(uint8_t col, uint8_t line) {
@@ -697,7 +940,8 @@ bool oled_scroll_off(void) {
             return oled_scrolling;
         }
         oled_scrolling = false;
-        oled_dirty     = OLED_ALL_BLOCKS_MASK;
+        // Scrolling moved the contents of the panel
+        oled_invalidate_panel();
     }
     return !oled_scrolling;
 }
@@ -27,3 +27,10 @@ void soft_serial_initiator_init(void);
 void soft_serial_target_init(void);
 
 bool soft_serial_transaction(int sstd_index);
+
+#ifdef SPLIT_TRANSPORT_BATCH
+// target side buffers for batched frames, set before soft_serial_target_init()
+void soft_serial_batch_target_init(uint8_t *request, uint8_t *response, uint16_t buffer_size);
+// exchange one batched request frame for its response frame
+bool soft_serial_batch_transaction(const uint8_t *request, uint16_t request_length, uint8_t *response, uint16_t response_length);
+#endif // SPLIT_TRANSPORT_BATCH
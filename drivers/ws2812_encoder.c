@@ -0,0 +1,99 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "quantum.h"
+#include "ws2812_encoder.h"
+
+static ws2812_symbol_t *buffers[2];
+static uint8_t          back;
+
+// The colours currently encoded in each buffer, so unchanged LEDs can be skipped. LED_TYPE is
+// packed in wire order, so its bytes are encoded as they are laid out.
+static LED_TYPE encoded[WS2812_BUFFER_COUNT][RGBLED_NUM];
+
+#if defined(WS2812_DRIVER_PWM)
+void ws2812_encode_byte(ws2812_symbol_t *symbols, uint8_t value) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        symbols[bit] = (value & (0x80 >> bit)) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
+    }
+}
+#else
+// Two data bits per SPI byte, the more significant one in the high nibble
+static const uint8_t spi_symbols[4] = {0x88, 0x8E, 0xE8, 0xEE};
+
+void ws2812_encode_byte(ws2812_symbol_t *symbols, uint8_t value) {
+    symbols[0] = spi_symbols[(value >> 6) & 0x03];
+    symbols[1] = spi_symbols[(value >> 4) & 0x03];
+    symbols[2] = spi_symbols[(value >> 2) & 0x03];
+    symbols[3] = spi_symbols[value & 0x03];
+}
+#endif
+
+static void encode_led(ws2812_symbol_t *symbols, const LED_TYPE *led) {
+    const uint8_t *bytes = (const uint8_t *)led;
+    for (uint8_t channel = 0; channel < WS2812_CHANNELS; channel++) {
+        ws2812_encode_byte(&symbols[channel * WS2812_SYMBOLS_PER_BYTE], bytes[channel]);
+    }
+}
+
+void ws2812_encoder_init(ws2812_symbol_t *buffer_a, ws2812_symbol_t *buffer_b) {
+    buffers[0] = buffer_a;
+    buffers[1] = buffer_b;
+    back       = 0;
+
+    memset(encoded, 0, sizeof(encoded));
+    for (uint8_t i = 0; i < WS2812_BUFFER_COUNT; i++) {
+        for (uint16_t led = 0; led < RGBLED_NUM; led++) {
+            encode_led(&buffers[i][led * WS2812_SYMBOLS_PER_LED], &encoded[i][led]);
+        }
+    }
+}
+
+ws2812_symbol_t *ws2812_encoder_encode(const LED_TYPE *ledarray, uint16_t leds) {
+    ws2812_symbol_t *symbols = buffers[back];
+    LED_TYPE *       current = encoded[back];
+
+    if (leds > RGBLED_NUM) {
+        leds = RGBLED_NUM;
+    }
+
+    for (uint16_t led = 0; led < leds; led++) {
+        if (memcmp(&current[led], &ledarray[led], sizeof(LED_TYPE)) != 0) {
+            current[led] = ledarray[led];
+            encode_led(&symbols[led * WS2812_SYMBOLS_PER_LED], &current[led]);
+        }
+    }
+
+    return symbols;
+}
+
+ws2812_symbol_t *ws2812_encoder_swap(void) {
+    ws2812_symbol_t *front = buffers[back];
+#if WS2812_BUFFER_COUNT > 1
+    back ^= 1;
+#endif
+    return front;
+}
+
+ws2812_symbol_t *ws2812_encoder_front(void) {
+#if WS2812_BUFFER_COUNT > 1
+    return buffers[back ^ 1];
+#else
+    return buffers[back];
+#endif
+}
@@ -0,0 +1,131 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ws2812.h"
+
+/*
+ * Encoded framebuffer shared by the DMA backed WS2812 drivers.
+ *
+ * Every colour bit on the wire is stored as a ready to send symbol, so the transport only has to
+ * point its DMA at the buffer:
+ * - spi: one nibble per bit (1110 for a one, 1000 for a zero), two bits per byte, MSB first
+ * - pwm: one timer compare value per bit, loaded into the CCR on every update event
+ *
+ * The encoder owns two buffers. ws2812_encoder_encode() writes the back buffer while the transport
+ * is still sending the front one, and only re-encodes the LEDs whose colour differs from the frame
+ * that buffer last held. ws2812_encoder_swap() hands the back buffer to the transport once it is
+ * free. Defining WS2812_SINGLE_BUFFER halves the RAM use at the cost of frames being written into
+ * the buffer the transport may still be reading. The SPI transport's circular buffer mode always
+ * uses a single buffer, as the DMA never stops reading it. PWM frames take 32 bytes per colour
+ * byte, so the PWM transport only gets a second buffer with WS2812_PWM_DOUBLE_BUFFER.
+ *
+ * The buffers only hold the colour data: any preamble or reset period around it belongs to the
+ * transport.
+ */
+
+#ifdef RGBW
+#    define WS2812_CHANNELS 4
+#else
+#    define WS2812_CHANNELS 3
+#endif
+
+#if defined(WS2812_SINGLE_BUFFER) || (defined(WS2812_DRIVER_SPI) && defined(WS2812_SPI_USE_CIRCULAR_BUFFER)) || (defined(WS2812_DRIVER_PWM) && !defined(WS2812_PWM_DOUBLE_BUFFER))
+#    define WS2812_BUFFER_COUNT 1
+#else
+#    define WS2812_BUFFER_COUNT 2
+#endif
+
+#if defined(WS2812_DRIVER_PWM)
+typedef uint32_t ws2812_symbol_t;
+#    define WS2812_SYMBOLS_PER_BYTE 8
+
+#    ifndef WS2812_PWM_FREQUENCY
+#        define WS2812_PWM_FREQUENCY (CPU_CLOCK / 2) /**< Clock frequency of PWM, must be valid with respect to system clock! */
+#    endif
+
+/*
+ * High period for a zero, in ticks
+ *
+ * Per the datasheet:
+ * WS2812:
+ * - T0H: 200 nS to 500 nS, inclusive
+ * - T0L: 650 nS to 950 nS, inclusive
+ * WS2812B:
+ * - T0H: 200 nS to 500 nS, inclusive
+ * - T0L: 750 nS to 1050 nS, inclusive
+ *
+ * The duty cycle is calculated for a high period of 350 nS.
+ */
+#    ifndef WS2812_DUTYCYCLE_0
+#        define WS2812_DUTYCYCLE_0 (WS2812_PWM_FREQUENCY / (1000000000 / 350))
+#    endif
+
+/*
+ * High period for a one, in ticks
+ *
+ * Per the datasheet:
+ * WS2812:
+ * - T1H: 550 nS to 850 nS, inclusive
+ * - T1L: 450 nS to 750 nS, inclusive
+ * WS2812B:
+ * - T1H: 750 nS to 1050 nS, inclusive
+ * - T1L: 200 nS to 500 nS, inclusive
+ *
+ * The duty cycle is calculated for a high period of 800 nS.
+ * This is in the middle of the specifications of the WS2812 and WS2812B.
+ */
+#    ifndef WS2812_DUTYCYCLE_1
+#        define WS2812_DUTYCYCLE_1 (WS2812_PWM_FREQUENCY / (1000000000 / 800))
+#    endif
+#else
+typedef uint8_t ws2812_symbol_t;
+#    define WS2812_SYMBOLS_PER_BYTE 4
+#endif
+
+#define WS2812_SYMBOLS_PER_LED (WS2812_SYMBOLS_PER_BYTE * WS2812_CHANNELS)
+#define WS2812_FRAME_SYMBOLS (WS2812_SYMBOLS_PER_LED * RGBLED_NUM)
+
+/**
+ * Attach the colour data areas of the transport's buffers and fill them with black.
+ *
+ * Pass the same buffer twice when WS2812_BUFFER_COUNT is 1.
+ */
+void ws2812_encoder_init(ws2812_symbol_t *buffer_a, ws2812_symbol_t *buffer_b);
+
+/**
+ * Encode a frame into the back buffer and return it. LEDs past RGBLED_NUM are ignored.
+ */
+ws2812_symbol_t *ws2812_encoder_encode(const LED_TYPE *ledarray, uint16_t leds);
+
+/**
+ * Make the back buffer the front one. Call when the transport starts sending it.
+ */
+ws2812_symbol_t *ws2812_encoder_swap(void);
+
+/**
+ * The buffer last handed to the transport.
+ */
+ws2812_symbol_t *ws2812_encoder_front(void);
+
+/**
+ * Encode one colour byte into WS2812_SYMBOLS_PER_BYTE symbols, MSB first.
+ */
+void ws2812_encode_byte(ws2812_symbol_t *symbols, uint8_t value);
@@ -6,6 +6,7 @@ import re
 from milc import cli
 
 from qmk.comment_remover import comment_remover
+import qmk.parse_cache
 
 default_key_entry = {'x': -1, 'y': 0, 'w': 1}
 single_comment_regex = re.compile(r'\s+/[/*].*$')
@@ -39,6 +40,7 @@ def c_source_files(dir_names):
     return files
 
 
+@qmk.parse_cache.cached(copy_result=True)
 def find_layouts(file):
     """Returns list of parsed LAYOUT preprocessor macros found in the supplied include file.
     """
@@ -90,12 +92,11 @@ def find_layouts(file):
     return parsed_layouts, aliases
 
 
-def parse_config_h_file(config_h_file, config_h=None):
-    """Extract defines from a config.h file.
+@qmk.parse_cache.cached()
+def _parse_config_h_directives(config_h_file):
+    """Returns the #define and #undef directives in a config.h file as (directive, name, value) tuples.
     """
-    if not config_h:
-        config_h = {}
-
+    directives = []
     config_h_file = Path(config_h_file)
 
     if config_h_file.exists():
@@ -115,20 +116,35 @@ def parse_config_h_file(config_h_file, config_h=None):
                 if len(line) == 1:
                     cli.log.error('%s: Incomplete #define! On or around line %s' % (config_h_file, linenum))
                 elif len(line) == 2:
-                    config_h[line[1]] = True
+                    directives.append(('#define', line[1], True))
                 else:
-                    config_h[line[1]] = ' '.join(line[2:])
+                    directives.append(('#define', line[1], ' '.join(line[2:])))
 
             elif line[0] == '#undef':
                 if len(line) == 2:
-                    if line[1] in config_h:
-                        if config_h[line[1]] is True:
-                            del config_h[line[1]]
-                        else:
-                            config_h[line[1]] = False
+                    directives.append(('#undef', line[1], None))
                 else:
                     cli.log.error('%s: Incomplete #undef! On or around line %s' % (config_h_file, linenum))
 
+    return tuple(directives)
+
+
+def parse_config_h_file(config_h_file, config_h=None):
+    """Extract defines from a config.h file.
+    """
+    if not config_h:
+        config_h = {}
+
+    for directive, name, value in _parse_config_h_directives(config_h_file):
+        if directive == '#define':
+            config_h[name] = value
+
+        elif name in config_h:
+            if config_h[name] is True:
+                del config_h[name]
+            else:
+                config_h[name] = False
+
     return config_h
 
 
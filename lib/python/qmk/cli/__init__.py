@@ -67,6 +67,7 @@ subcommands = [
     'qmk.cli.multibuild',
     'qmk.cli.new.keyboard',
     'qmk.cli.new.keymap',
+    'qmk.cli.parse_cache',
     'qmk.cli.pyformat',
     'qmk.cli.pytest',
     'qmk.cli.via2json',
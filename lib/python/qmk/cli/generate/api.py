@@ -1,19 +1,160 @@
 """This script automates the generation of the QMK API data.
 """
+from filecmp import cmp
+from hashlib import sha256
+from multiprocessing import Pool
 from pathlib import Path
 from shutil import copyfile
 import json
+import os
+import pickle
 
 from milc import cli
 
+from qmk.constants import BUILD_DIR
 from qmk.datetime import current_datetime
 from qmk.info import info_json
 from qmk.json_encoders import InfoJSONEncoder
 from qmk.json_schema import json_load
 from qmk.keyboard import find_readme, list_keyboards
+from qmk.makefile import parse_rules_mk_file
+
+# Bump this when the layout of the cache file changes
+CACHE_VERSION = 1
+CACHE_FILE = Path(BUILD_DIR) / 'generate_api.cache'
+
+
+def _hash_files(hasher, directory, contents=True):
+    """Feed the names, and optionally the contents, of the files directly in `directory` to `hasher`.
+    """
+    if not directory.is_dir():
+        return
+
+    for path in sorted(directory.iterdir()):
+        if path.is_file():
+            hasher.update(path.name.encode('utf-8') + b'\0')
+
+            if contents:
+                hasher.update(path.read_bytes() + b'\0')
+
+
+def _global_fingerprint():
+    """Returns a hash of the inputs shared by every keyboard.
+
+    This covers the mappings and schemas info_json() reads, the code that does the parsing, and which community layouts exist.
+    """
+    hasher = sha256()
+    hasher.update(b'%d\0' % CACHE_VERSION)
+
+    for root in (Path('data'), Path('lib/python/qmk')):
+        for path in sorted(root.glob('**/*')):
+            if path.is_file() and '__pycache__' not in path.parts:
+                hasher.update(str(path).encode('utf-8') + b'\0' + path.read_bytes() + b'\0')
+
+    for path in sorted(Path('layouts').glob('**/*')):
+        hasher.update(str(path).encode('utf-8') + b'\0')
+
+    return hasher.hexdigest()
+
+
+def _keyboard_fingerprint(keyboard, global_fingerprint):
+    """Returns a hash of every file info_json() can read for `keyboard`.
+
+    Each directory from keyboards/ down to the keyboard (and down to its DEFAULT_FOLDER, if it has one) contributes the contents of its files and the layout of its keymaps.
+    """
+    hasher = sha256()
+    hasher.update(global_fingerprint.encode('utf-8') + b'\0')
+    keyboards = [keyboard]
+
+    root_rules_mk = parse_rules_mk_file(Path('keyboards') / keyboard / 'rules.mk')
+    if 'DEFAULT_FOLDER' in root_rules_mk:
+        keyboards.append(root_rules_mk['DEFAULT_FOLDER'])
+
+    for kb in keyboards:
+        hasher.update(kb.encode('utf-8') + b'\0')
+        current_path = Path('keyboards')
+
+        for directory in Path(kb).parts:
+            current_path = current_path / directory
+            hasher.update(str(current_path).encode('utf-8') + b'\0')
+            _hash_files(hasher, current_path)
+
+            keymaps_dir = current_path / 'keymaps'
+            if keymaps_dir.is_dir():
+                for keymap in sorted(keymaps_dir.iterdir()):
+                    hasher.update(keymap.name.encode('utf-8') + b'\0')
+                    _hash_files(hasher, keymap, contents=False)
+
+    return hasher.hexdigest()
+
+
+def _keyboard_info(job):
+    """Returns the fingerprint and info.json data for a keyboard.
+
+    The data is None when the fingerprint matches the cached one, in which case the cached data is still valid.
+    """
+    keyboard, global_fingerprint, cached_fingerprint = job
+    fingerprint = _keyboard_fingerprint(keyboard, global_fingerprint) if global_fingerprint else None
+
+    if fingerprint and fingerprint == cached_fingerprint:
+        return keyboard, fingerprint, None
+
+    return keyboard, fingerprint, info_json(keyboard)
+
+
+def _load_cache():
+    """Returns the cached info.json data from the last run, if it's usable.
+    """
+    try:
+        with CACHE_FILE.open('rb') as cache_file:
+            cache = pickle.load(cache_file)
+
+        if cache.get('version') == CACHE_VERSION:
+            return cache['keyboards']
+
+    except Exception as e:
+        if CACHE_FILE.exists():
+            cli.log.warning('Ignoring unreadable cache file %s: %s', CACHE_FILE, e)
+
+    return {}
+
+
+def _save_cache(keyboards):
+    """Writes the cache for the next run.
+    """
+    CACHE_FILE.parent.mkdir(parents=True, exist_ok=True)
+    tmp_file = CACHE_FILE.with_suffix('.tmp')
+
+    with tmp_file.open('wb') as cache_file:
+        pickle.dump({'version': CACHE_VERSION, 'keyboards': keyboards}, cache_file, protocol=pickle.HIGHEST_PROTOCOL)
+
+    tmp_file.replace(CACHE_FILE)
+
+
+def _write_json(json_file, data, **kwargs):
+    """Writes `data` with a fresh `last_updated` timestamp, unless the file already holds the same data.
+
+    Returns True if the file was written.
+    """
+    if json_file.exists():
+        try:
+            existing = json_file.read_text(encoding='utf-8')
+            last_updated = json.loads(existing).get('last_updated')
+            if existing == json.dumps({'last_updated': last_updated, **data}, **kwargs):
+                return False
+
+        except (ValueError, AttributeError):
+            pass
+
+    json_file.write_text(json.dumps({'last_updated': current_datetime(), **data}, **kwargs), encoding='utf-8')
+    cli.log.debug('Wrote file %s', json_file)
+
+    return True
 
 
 @cli.argument('-n', '--dry-run', arg_only=True, action='store_true', help="Don't write the data to disk.")
+@cli.argument('-j', '--parallel', type=int, default=0, help="Set the number of parallel jobs; 0 means one per CPU.")
+@cli.argument('--no-cache', arg_only=True, action='store_true', help="Regenerate the data for every keyboard instead of reusing the results of the last run.")
 @cli.subcommand('Creates a new keymap for the keyboard of your choosing', hidden=False if cli.config.user.developer else True)
 def generate_api(cli):
     """Generates the QMK API data.
@@ -31,27 +172,43 @@ def generate_api(cli):
 
     kb_all = {}
     usb_list = {}
-
-    # Generate and write keyboard specific JSON files
-    for keyboard_name in list_keyboards():
-        kb_all[keyboard_name] = info_json(keyboard_name)
+    written = 0
+
+    # Generate the keyboard specific data, reusing the results of the last run for unchanged keyboards
+    cache = {} if cli.args.no_cache else _load_cache()
+    global_fingerprint = None if cli.args.no_cache else _global_fingerprint()
+    new_cache = {}
+    jobs = [(keyboard_name, global_fingerprint, cache.get(keyboard_name, {}).get('fingerprint')) for keyboard_name in list_keyboards()]
+    parallel = cli.config.generate_api.parallel or os.cpu_count() or 1
+
+    with Pool(min(parallel, len(jobs) or 1)) as pool:
+        # imap() hands the results back in submission order, so the output doesn't depend on which job finishes first
+        for keyboard_name, fingerprint, keyboard_data in pool.imap(_keyboard_info, jobs, chunksize=8):
+            if keyboard_data is None:
+                keyboard_data = cache[keyboard_name]['info']
+                cli.log.debug('Reusing cached data for %s', keyboard_name)
+
+            kb_all[keyboard_name] = keyboard_data
+            new_cache[keyboard_name] = {'fingerprint': fingerprint, 'info': keyboard_data}
+
+    # Write keyboard specific JSON files
+    for keyboard_name, keyboard_data in kb_all.items():
         keyboard_dir = v1_dir / 'keyboards' / keyboard_name
         keyboard_info = keyboard_dir / 'info.json'
         keyboard_readme = keyboard_dir / 'readme.md'
         keyboard_readme_src = find_readme(keyboard_name)
 
-        keyboard_dir.mkdir(parents=True, exist_ok=True)
-        keyboard_json = json.dumps({'last_updated': current_datetime(), 'keyboards': {keyboard_name: kb_all[keyboard_name]}})
         if not cli.args.dry_run:
-            keyboard_info.write_text(keyboard_json)
-            cli.log.debug('Wrote file %s', keyboard_info)
+            keyboard_dir.mkdir(parents=True, exist_ok=True)
+            written += _write_json(keyboard_info, {'keyboards': {keyboard_name: keyboard_data}})
 
-            if keyboard_readme_src:
+            if keyboard_readme_src and not (keyboard_readme.exists() and cmp(keyboard_readme_src, keyboard_readme, shallow=False)):
                 copyfile(keyboard_readme_src, keyboard_readme)
                 cli.log.debug('Copied %s -> %s', keyboard_readme_src, keyboard_readme)
+                written += 1
 
-        if 'usb' in kb_all[keyboard_name]:
-            usb = kb_all[keyboard_name]['usb']
+        if 'usb' in keyboard_data:
+            usb = keyboard_data['usb']
 
             if 'vid' in usb and usb['vid'] not in usb_list:
                 usb_list[usb['vid']] = {}
@@ -66,22 +223,21 @@ def generate_api(cli):
     keyboard_list = sorted(kb_all)
     keyboard_aliases = json_load(Path('data/mappings/keyboard_aliases.json'))
     keyboard_metadata = {
-        'last_updated': current_datetime(),
         'keyboards': keyboard_list,
         'keyboard_aliases': keyboard_aliases,
         'usb': usb_list,
     }
 
     # Write the global JSON files
-    keyboard_all_json = json.dumps({'last_updated': current_datetime(), 'keyboards': kb_all}, cls=InfoJSONEncoder)
-    usb_json = json.dumps({'last_updated': current_datetime(), 'usb': usb_list}, cls=InfoJSONEncoder)
-    keyboard_list_json = json.dumps({'last_updated': current_datetime(), 'keyboards': keyboard_list}, cls=InfoJSONEncoder)
-    keyboard_aliases_json = json.dumps({'last_updated': current_datetime(), 'keyboard_aliases': keyboard_aliases}, cls=InfoJSONEncoder)
-    keyboard_metadata_json = json.dumps(keyboard_metadata, cls=InfoJSONEncoder)
-
     if not cli.args.dry_run:
-        keyboard_all_file.write_text(keyboard_all_json)
-        usb_file.write_text(usb_json)
-        keyboard_list_file.write_text(keyboard_list_json)
-        keyboard_aliases_file.write_text(keyboard_aliases_json)
-        keyboard_metadata_file.write_text(keyboard_metadata_json)
+        written += _write_json(keyboard_all_file, {'keyboards': kb_all}, cls=InfoJSONEncoder)
+        written += _write_json(usb_file, {'usb': usb_list}, cls=InfoJSONEncoder)
+        written += _write_json(keyboard_list_file, {'keyboards': keyboard_list}, cls=InfoJSONEncoder)
+        written += _write_json(keyboard_aliases_file, {'keyboard_aliases': keyboard_aliases}, cls=InfoJSONEncoder)
+        written += _write_json(keyboard_metadata_file, keyboard_metadata, cls=InfoJSONEncoder)
+
+        if not cli.args.no_cache:
+            _save_cache(new_cache)
+
+    reused = sum(1 for keyboard_name in new_cache if keyboard_name in cache and cache[keyboard_name]['fingerprint'] == new_cache[keyboard_name]['fingerprint'])
+    cli.log.info('Generated API data for %d keyboards (%d from cache), %d files updated.', len(kb_all), reused, written)
@@ -2,9 +2,12 @@
 
 This will compile everything in parallel, for testing purposes.
 """
+import json
 import os
 import re
+import shutil
 from pathlib import Path
+from statistics import mean
 from subprocess import DEVNULL
 
 from milc import cli
@@ -28,11 +31,97 @@ def _is_split(keyboard_name):
     return True if 'SPLIT_KEYBOARD' in rules_mk and rules_mk['SPLIT_KEYBOARD'].lower() == 'yes' else False
 
 
+def _build_signature(keyboard_name):
+    """Returns the MCU and the enabled features of a keyboard, which between them decide most of what gets compiled.
+    """
+    rules_mk = qmk.keyboard.rules_mk(keyboard_name)
+    features = sorted(key for key, value in rules_mk.items() if key.endswith('_ENABLE') and value.lower() == 'yes')
+
+    return ' '.join([rules_mk.get('MCU', 'unknown'), *features])
+
+
+def _load_timings(timings_file):
+    """Returns the build times recorded by earlier runs.
+    """
+    try:
+        return json.loads(timings_file.read_text(encoding='utf-8'))
+
+    except (OSError, ValueError):
+        return {}
+
+
+def _schedule(targets, timings):
+    """Orders the targets so the longest builds start first.
+
+    Targets that haven't been built before are assumed to take as long as the average of those with the same build signature, or the same MCU, that have.
+    """
+    by_signature = {}
+    by_mcu = {}
+
+    for target, signature in targets.items():
+        if target in timings:
+            by_signature.setdefault(signature, []).append(timings[target])
+            by_mcu.setdefault(signature.split()[0], []).append(timings[target])
+
+    default = mean(timings.values()) if timings else 0
+
+    def estimate(target):
+        signature = targets[target]
+
+        if target in timings:
+            return timings[target]
+
+        elif signature in by_signature:
+            return mean(by_signature[signature])
+
+        elif signature.split()[0] in by_mcu:
+            return mean(by_mcu[signature.split()[0]])
+
+        return default
+
+    return sorted(targets, key=lambda target: (-estimate(target), target))
+
+
+def _collect_timings(builddir, targets):
+    """Reads the start and end times written by each build, returning the build time of each target that built successfully.
+    """
+    timings = {}
+
+    for target in targets:
+        keyboard_name, keymap = target.split(':')
+        keyboard_safe = keyboard_name.replace('/', '_')
+        time_file = builddir / f"build.time.{os.getpid()}.{keyboard_safe}"
+
+        if time_file.exists():
+            times = time_file.read_text().split()
+            time_file.unlink()
+
+            # A failed build stops early, which would make it look quick next time
+            if len(times) == 2 and not (builddir / f'failed.log.{os.getpid()}.{keyboard_safe}').exists():
+                timings[target] = int(times[1]) - int(times[0])
+
+    return timings
+
+
+def _print_timings(timings, count=10):
+    """Prints the slowest builds and the total build time.
+    """
+    if not timings:
+        return
+
+    cli.log.info('Slowest builds:')
+    for target in sorted(timings, key=timings.get, reverse=True)[:count]:
+        cli.log.info('%6ds %s', timings[target], target)
+
+    cli.log.info('Total build time %ds across %d targets.', sum(timings.values()), len(timings))
+
+
 @cli.argument('-j', '--parallel', type=int, default=1, help="Set the number of parallel make jobs; 0 means unlimited.")
 @cli.argument('-c', '--clean', arg_only=True, action='store_true', help="Remove object files before compiling.")
 @cli.argument('-f', '--filter', arg_only=True, action='append', default=[], help="Filter the list of keyboards based on the supplied value in rules.mk. Supported format is 'SPLIT_KEYBOARD=yes'. May be passed multiple times.")
 @cli.argument('-km', '--keymap', type=str, default='default', help="The keymap name to build. Default is 'default'.")
 @cli.argument('-e', '--env', arg_only=True, action='append', default=[], help="Set a variable to be passed to make. May be passed multiple times.")
+@cli.argument('--no-ccache', arg_only=True, action='store_true', help="Don't compile through ccache, even when it's installed.")
 @cli.subcommand('Compile QMK Firmware for all keyboards.', hidden=False if cli.config.user.developer else True)
 def multibuild(cli):
     """Compile QMK Firmware against all keyboards.
@@ -44,6 +133,7 @@ def multibuild(cli):
 
     builddir = Path(QMK_FIRMWARE) / '.build'
     makefile = builddir / 'parallel_kb_builds.mk'
+    timings_file = builddir / 'multibuild_timings.json'
 
     keyboard_list = qmk.keyboard.list_keyboards()
 
@@ -58,31 +148,48 @@ def multibuild(cli):
     if len(keyboard_list) == 0:
         return
 
+    # Start the longest builds first, so the tail of the run isn't one slow keyboard building on its own
+    targets = {f'{keyboard_name}:{cli.args.keymap}': _build_signature(keyboard_name) for keyboard_name in keyboard_list if qmk.keymap.locate_keymap(keyboard_name, cli.args.keymap) is not None}
+    timings = _load_timings(timings_file)
+    schedule = _schedule(targets, timings)
+
+    # Identical compiles, such as a rebuild of unchanged code, come out of ccache instead of the compiler
+    env = list(cli.args.env)
+    if not cli.args.no_ccache and shutil.which('ccache') and not any(e.startswith('USE_CCACHE=') for e in env):
+        env.append('USE_CCACHE=yes')
+
     builddir.mkdir(parents=True, exist_ok=True)
     with open(makefile, "w") as f:
-        for keyboard_name in keyboard_list:
-            if qmk.keymap.locate_keymap(keyboard_name, cli.args.keymap) is not None:
-                keyboard_safe = keyboard_name.replace('/', '_')
-                # yapf: disable
-                f.write(
-                    f"""\
+        for target in schedule:
+            keyboard_name = target.split(':')[0]
+            keyboard_safe = keyboard_name.replace('/', '_')
+            # yapf: disable
+            f.write(
+                f"""\
 all: {keyboard_safe}_binary
 {keyboard_safe}_binary:
 	@rm -f "{QMK_FIRMWARE}/.build/failed.log.{keyboard_safe}" || true
-	+@$(MAKE) -C "{QMK_FIRMWARE}" -f "{QMK_FIRMWARE}/builddefs/build_keyboard.mk" KEYBOARD="{keyboard_name}" KEYMAP="{cli.args.keymap}" REQUIRE_PLATFORM_KEY= COLOR=true SILENT=false {' '.join(cli.args.env)} \\
+	@date +%s > "{QMK_FIRMWARE}/.build/build.time.{os.getpid()}.{keyboard_safe}"
+	+@$(MAKE) -C "{QMK_FIRMWARE}" -f "{QMK_FIRMWARE}/builddefs/build_keyboard.mk" KEYBOARD="{keyboard_name}" KEYMAP="{cli.args.keymap}" REQUIRE_PLATFORM_KEY= COLOR=true SILENT=false {' '.join(env)} \\
 		>>"{QMK_FIRMWARE}/.build/build.log.{os.getpid()}.{keyboard_safe}" 2>&1 \\
 		|| cp "{QMK_FIRMWARE}/.build/build.log.{os.getpid()}.{keyboard_safe}" "{QMK_FIRMWARE}/.build/failed.log.{os.getpid()}.{keyboard_safe}"
+	@date +%s >> "{QMK_FIRMWARE}/.build/build.time.{os.getpid()}.{keyboard_safe}"
 	@{{ grep '\[ERRORS\]' "{QMK_FIRMWARE}/.build/build.log.{os.getpid()}.{keyboard_safe}" >/dev/null 2>&1 && printf "Build %-64s \e[1;31m[ERRORS]\e[0m\\n" "{keyboard_name}:{cli.args.keymap}" ; }} \\
 		|| {{ grep '\[WARNINGS\]' "{QMK_FIRMWARE}/.build/build.log.{os.getpid()}.{keyboard_safe}" >/dev/null 2>&1 && printf "Build %-64s \e[1;33m[WARNINGS]\e[0m\\n" "{keyboard_name}:{cli.args.keymap}" ; }} \\
 		|| printf "Build %-64s \e[1;32m[OK]\e[0m\\n" "{keyboard_name}:{cli.args.keymap}"
 	@rm -f "{QMK_FIRMWARE}/.build/build.log.{os.getpid()}.{keyboard_safe}" || true
 
 """# noqa
-                )
-                # yapf: enable
+            )
+            # yapf: enable
 
     cli.run([make_cmd, *get_make_parallel_args(cli.args.parallel), '-f', makefile.as_posix(), 'all'], capture_output=False, stdin=DEVNULL)
 
+    # Report and remember how long each target took
+    new_timings = _collect_timings(builddir, targets)
+    _print_timings(new_timings)
+    timings_file.write_text(json.dumps({**timings, **new_timings}, indent=4, sort_keys=True), encoding='utf-8')
+
     # Check for failures
     failures = [f for f in builddir.glob(f'failed.log.{os.getpid()}.*')]
     if len(failures) > 0:
@@ -0,0 +1,66 @@
+"""Inspect, clear, or benchmark the cache of parsed config.h, rules.mk, and layout files.
+"""
+from time import perf_counter
+
+from milc import cli
+
+import qmk.parse_cache
+from qmk.info import _search_keyboard_h
+from qmk.keyboard import config_h, list_keyboards, rules_mk
+
+
+def _full_tree_pass():
+    """Parses the rules.mk, config.h, and layout macros of every keyboard, returning how long that took.
+    """
+    start = perf_counter()
+
+    for keyboard in list_keyboards():
+        rules_mk(keyboard)
+        config_h(keyboard)
+        _search_keyboard_h(keyboard)
+
+    return perf_counter() - start
+
+
+def _benchmark():
+    """Times a full tree pass with an empty cache, again with the in-memory cache, and again with only the on-disk cache.
+    """
+    qmk.parse_cache.clear()
+    cold = _full_tree_pass()
+    cold_stats = qmk.parse_cache.stats()
+    cli.log.info('Cold:              %6.2fs (%d files parsed)', cold, cold_stats['misses'])
+
+    qmk.parse_cache.clear_counters()
+    warm = _full_tree_pass()
+    cli.log.info('Warm (in-memory):  %6.2fs (%d cache hits, %.1fx faster)', warm, qmk.parse_cache.stats()['hits'], cold / warm)
+
+    if qmk.parse_cache.disk_cache_enabled():
+        qmk.parse_cache.save()
+        qmk.parse_cache.clear()
+        qmk.parse_cache.load()
+        warm_disk = _full_tree_pass()
+        cli.log.info('Warm (on-disk):    %6.2fs (%d cache hits, %.1fx faster)', warm_disk, qmk.parse_cache.stats()['hits'], cold / warm_disk)
+
+    else:
+        cli.log.info('Set user.parse_cache to also time loading the cache from %s.', qmk.parse_cache.CACHE_FILE)
+
+
+@cli.argument('-b', '--benchmark', arg_only=True, action='store_true', help='Time a full tree pass with a cold and a warm cache.')
+@cli.argument('-c', '--clear', arg_only=True, action='store_true', help='Delete the on-disk cache.')
+@cli.subcommand('Inspect, clear, or benchmark the parse cache.', hidden=False if cli.config.user.developer else True)
+def parse_cache(cli):
+    """Inspect, clear, or benchmark the cache of parsed config.h, rules.mk, and layout files.
+    """
+    if cli.args.clear:
+        qmk.parse_cache.clear(disk=True)
+        cli.log.info('Deleted %s.', qmk.parse_cache.CACHE_FILE)
+
+    if cli.args.benchmark:
+        _benchmark()
+
+    elif not cli.args.clear:
+        enabled = qmk.parse_cache.disk_cache_enabled()
+        qmk.parse_cache.load()
+
+        cli.log.info('On-disk cache: %s (%s)', qmk.parse_cache.CACHE_FILE, 'enabled' if enabled else 'disabled')
+        cli.log.info('Cached files: %d', qmk.parse_cache.stats()['entries'])
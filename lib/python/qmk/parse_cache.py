@@ -0,0 +1,185 @@
+"""Memoization for the functions that parse files in the QMK tree.
+
+A parser decorated with `cached()` only runs once for each version of a file, where a version is identified by the file's path, mtime and size. Results are kept in memory for the lifetime of the process, and when `user.parse_cache` is enabled (or `QMK_PARSE_CACHE` is set) they are also stored in `.build/` so the next invocation can reuse them.
+
+Anything the parser logs while parsing is recorded and logged again whenever the cached result is used, so cached and uncached runs report the same problems.
+"""
+import atexit
+import functools
+import logging
+import os
+import pickle
+import sys
+from pathlib import Path
+
+from milc import cli
+
+from qmk.constants import BUILD_DIR
+
+# Bump this when the layout of the cache file changes
+CACHE_VERSION = 1
+CACHE_FILE = Path(BUILD_DIR) / 'parse_cache.pickle'
+
+_entries = {}  # (parser, path, mtime, size) -> (result, log records)
+_parsers = {}  # parser -> fingerprint of the module it lives in
+_state = {'loaded': False, 'dirty': False, 'hits': 0, 'misses': 0}
+
+
+class _LogRecorder(logging.Handler):
+    """Collects the messages logged while a file is parsed.
+    """
+    def __init__(self):
+        super().__init__()
+        self.messages = []
+
+    def emit(self, record):
+        self.messages.append((record.levelno, record.getMessage()))
+
+
+def _module_fingerprint(module_name):
+    """Identifies the version of the code that produced a cached result.
+    """
+    module_file = getattr(sys.modules.get(module_name), '__file__', None)
+
+    try:
+        stat = os.stat(module_file)
+        return (stat.st_mtime_ns, stat.st_size)
+
+    except (OSError, TypeError):
+        return None
+
+
+def disk_cache_enabled():
+    """Returns True if parse results should be kept in `.build/` between invocations.
+    """
+    enabled = os.environ.get('QMK_PARSE_CACHE', cli.config.user.parse_cache)
+
+    return str(enabled).lower() in ('1', 'true', 'yes', 'on')
+
+
+def load():
+    """Reads the results stored by earlier invocations, dropping those whose parser has changed since.
+    """
+    _state['loaded'] = True
+
+    try:
+        with CACHE_FILE.open('rb') as cache_file:
+            cache = pickle.load(cache_file)
+
+        if cache.get('version') != CACHE_VERSION:
+            return
+
+    except FileNotFoundError:
+        return
+
+    except Exception as e:
+        cli.log.warning('Ignoring unreadable parse cache %s: %s', CACHE_FILE, e)
+        return
+
+    for key, entry in cache['entries'].items():
+        if key not in _entries and key[0] in _parsers and cache['parsers'].get(key[0]) == _parsers[key[0]]:
+            _entries[key] = entry
+
+
+def save():
+    """Writes the results to `.build/` if anything new was parsed.
+    """
+    if not _state['dirty']:
+        return
+
+    CACHE_FILE.parent.mkdir(parents=True, exist_ok=True)
+    tmp_file = CACHE_FILE.with_name(f'{CACHE_FILE.name}.{os.getpid()}')
+
+    with tmp_file.open('wb') as cache_file:
+        pickle.dump({'version': CACHE_VERSION, 'parsers': _parsers, 'entries': _entries}, cache_file, protocol=pickle.HIGHEST_PROTOCOL)
+
+    tmp_file.replace(CACHE_FILE)
+    _state['dirty'] = False
+
+
+def clear(disk=False):
+    """Forgets all results, and deletes the cache file when `disk` is True.
+
+    The on-disk cache is not read again until `load()` is called.
+    """
+    _entries.clear()
+    _state.update(loaded=True, dirty=False, hits=0, misses=0)
+
+    if disk and CACHE_FILE.exists():
+        CACHE_FILE.unlink()
+
+
+def clear_counters():
+    """Resets the hit and miss counters without forgetting any results.
+    """
+    _state.update(hits=0, misses=0)
+
+
+def stats():
+    """Returns the number of cached results and how often they were used since the counters were last reset.
+    """
+    return {'entries': len(_entries), 'hits': _state['hits'], 'misses': _state['misses']}
+
+
+def cached(copy_result=False):
+    """Memoize a function that parses the file passed as its only argument.
+
+    Args:
+
+        copy_result
+            Return a fresh copy of the cached result every time, for results that callers modify.
+    """
+    def decorator(func):
+        parser = f'{func.__module__}.{func.__qualname__}'
+        _parsers[parser] = _module_fingerprint(func.__module__)
+
+        @functools.wraps(func)
+        def wrapper(path):
+            if not _state['loaded'] and disk_cache_enabled():
+                load()
+
+            abs_path = os.path.abspath(path)
+
+            try:
+                stat = os.stat(abs_path)
+                key = (parser, abs_path, stat.st_mtime_ns, stat.st_size)
+
+            except OSError:
+                key = (parser, abs_path, None, None)
+
+            if key in _entries:
+                _state['hits'] += 1
+                result, messages = _entries[key]
+
+                for level, message in messages:
+                    cli.log.log(level, message)
+
+                # Unpickling is several times faster than copy.deepcopy() for the nested layout data
+                return pickle.loads(result) if copy_result else result
+
+            _state['misses'] += 1
+            recorder = _LogRecorder()
+            cli.log.addHandler(recorder)
+
+            try:
+                result = func(path)
+            finally:
+                cli.log.removeHandler(recorder)
+
+            _entries[key] = (pickle.dumps(result, protocol=pickle.HIGHEST_PROTOCOL) if copy_result else result, recorder.messages)
+            _state['dirty'] = True
+
+            return result
+
+        return wrapper
+
+    return decorator
+
+
+@atexit.register
+def _save_on_exit():
+    if disk_cache_enabled():
+        try:
+            save()
+        except OSError as e:
+            cli.log.warning('Could not write parse cache %s: %s', CACHE_FILE, e)
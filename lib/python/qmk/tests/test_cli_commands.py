@@ -1,8 +1,14 @@
+import json
 import platform
+import re
+from pathlib import Path
+from shutil import rmtree
 from subprocess import DEVNULL
 
 from milc import cli
 
+from qmk.constants import BUILD_DIR
+
 is_windows = 'windows' in platform.platform().lower()
 
 
@@ -248,6 +254,58 @@ def test_generate_api():
     check_returncode(result)
 
 
+def test_generate_api_serial_no_cache():
+    result = check_subcommand('generate-api', '--dry-run', '--no-cache', '-j', '1')
+    check_returncode(result)
+
+
+def _read_api_json(name):
+    """Returns the content of a generated API file, without its timestamp.
+    """
+    data = json.loads((Path('api_data/v1') / name).read_text(encoding='utf-8'))
+    data.pop('last_updated', None)
+
+    return data
+
+
+def test_generate_api_cache_matches_serial_no_cache():
+    v1_dir = Path('api_data/v1')
+    cache_file = Path(BUILD_DIR) / 'generate_api.cache'
+    api_files = ['keyboards.json', 'keyboard_list.json', 'keyboard_metadata.json', 'usb.json']
+    created = not v1_dir.exists()
+
+    try:
+        result = check_subcommand('generate-api', '--no-cache', '-j', '1')
+        check_returncode(result)
+        expected = {name: _read_api_json(name) for name in api_files}
+
+        if cache_file.exists():
+            cache_file.unlink()
+
+        for run in ['cold', 'warm']:
+            result = check_subcommand('generate-api')
+            check_returncode(result)
+
+            for name in api_files:
+                assert _read_api_json(name) == expected[name], f'{name} differs from the --no-cache output with a {run} cache'
+
+        # The warm run reuses every keyboard and has nothing left to write
+        summary = re.search(r'Generated API data for (\d+) keyboards \((\d+) from cache\), (\d+) files updated', result.stdout)
+        assert summary
+        assert summary.group(1) == summary.group(2)
+        assert summary.group(3) == '0'
+
+    finally:
+        if created:
+            rmtree(v1_dir, ignore_errors=True)
+
+
+def test_parse_cache():
+    result = check_subcommand('parse-cache')
+    check_returncode(result)
+    assert 'Cached files:' in result.stdout
+
+
 def test_generate_rgb_breathe_table():
     result = check_subcommand("generate-rgb-breathe-table", "-c", "1.2", "-m", "127")
     check_returncode(result)
@@ -0,0 +1,37 @@
+import qmk.parse_cache
+from qmk.c_parse import find_layouts, parse_config_h_file
+from qmk.makefile import parse_rules_mk_file
+
+
+def test_parse_cache_reuses_results(tmp_path):
+    rules_mk = tmp_path / 'rules.mk'
+    rules_mk.write_text('FOO = yes\nBAR += one\n')
+
+    qmk.parse_cache.clear()
+    assert parse_rules_mk_file(rules_mk) == {'FOO': 'yes', 'BAR': 'one'}
+    assert parse_rules_mk_file(rules_mk, {'BAR': 'zero'}) == {'FOO': 'yes', 'BAR': 'zero one'}
+    assert qmk.parse_cache.stats()['misses'] == 1
+    assert qmk.parse_cache.stats()['hits'] == 1
+
+
+def test_parse_cache_sees_changes(tmp_path):
+    config_h = tmp_path / 'config.h'
+    config_h.write_text('#define FOO 1\n')
+
+    qmk.parse_cache.clear()
+    assert parse_config_h_file(config_h) == {'FOO': '1'}
+
+    config_h.write_text('#define FOO 1\n#undef FOO\n')
+    assert parse_config_h_file(config_h) == {'FOO': False}
+    assert qmk.parse_cache.stats()['misses'] == 2
+
+
+def test_parse_cache_copies_layouts(tmp_path):
+    keyboard_h = tmp_path / 'keyboard.h'
+    keyboard_h.write_text('#define LAYOUT_ortho_1x1(k00) { { k00 } }\n')
+
+    layouts, _ = find_layouts(keyboard_h)
+    layouts['LAYOUT_ortho_1x1']['c_macro'] = True
+
+    layouts, _ = find_layouts(keyboard_h)
+    assert 'c_macro' not in layouts['LAYOUT_ortho_1x1']
@@ -0,0 +1,50 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "timer_avr.h"
+#include "scan_profiler.h"
+
+extern volatile uint32_t timer_count;
+
+#if defined(__AVR_ATmega32A__)
+#    define TIMER_COMPARE_PENDING() (TIFR & _BV(OCF0))
+#elif defined(__AVR_ATtiny85__)
+#    define TIMER_COMPARE_PENDING() (TIFR & _BV(OCF0A))
+#else
+#    define TIMER_COMPARE_PENDING() (TIFR0 & _BV(OCF0A))
+#endif
+
+// Timer0 prescaler ticks, extended by the millisecond counter it drives
+uint32_t scan_profiler_read_ticks(void) {
+    uint32_t ms;
+    uint8_t  raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms  = timer_count;
+        raw = TIMER_RAW;
+        // The counter already wrapped, but the interrupt has not run yet
+        if (TIMER_COMPARE_PENDING() && raw < TIMER_RAW_TOP) {
+            ms++;
+        }
+    }
+    return ms * (TIMER_RAW_TOP + 1) + raw;
+}
+
+uint32_t scan_profiler_ticks_per_ms(void) {
+    return TIMER_RAW_TOP + 1;
+}
@@ -30,6 +30,10 @@
 #include <ch.h>
 #include <hal.h>
 
+#ifdef I2C_QUEUE_ENABLE
+#    include "i2c_queue.h"
+#endif
+
 #ifndef I2C1_SCL_PIN
 #    define I2C1_SCL_PIN B6
 #endif
@@ -90,6 +94,16 @@
 
 static uint8_t i2c_address;
 
+#ifdef I2C_QUEUE_ENABLE
+// Queued transfers run on their own thread, blocking calls wait for the one in flight
+static MUTEX_DECL(i2c_bus_mutex);
+#    define I2C_BUS_LOCK() chMtxLock(&i2c_bus_mutex)
+#    define I2C_BUS_UNLOCK() chMtxUnlock(&i2c_bus_mutex)
+#else
+#    define I2C_BUS_LOCK()
+#    define I2C_BUS_UNLOCK()
+#endif
+
 static const I2CConfig i2cconfig = {
 #if defined(USE_I2CV1_CONTRIB)
     I2C1_CLOCK_SPEED,
@@ -140,28 +154,33 @@ __attribute__((weak)) void i2c_init(void) {
 }
 
 i2c_status_t i2c_start(uint8_t address) {
+    I2C_BUS_LOCK();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
+    I2C_BUS_UNLOCK();
     return I2C_STATUS_SUCCESS;
 }
 
 i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_BUS_LOCK();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, 0, 0, TIME_MS2I(timeout));
+    I2C_BUS_UNLOCK();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_BUS_LOCK();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterReceiveTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, TIME_MS2I(timeout));
+    I2C_BUS_UNLOCK();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout) {
     i2c_address = devaddr;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
 
     uint8_t complete_packet[length + 1];
     for (uint16_t i = 0; i < length; i++) {
@@ -169,13 +188,15 @@ i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data,
     }
     complete_packet[0] = regaddr;
 
+    I2C_BUS_LOCK();
+    i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), complete_packet, length + 1, 0, 0, TIME_MS2I(timeout));
+    I2C_BUS_UNLOCK();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_writeReg16(uint8_t devaddr, uint16_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout) {
     i2c_address = devaddr;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
 
     uint8_t complete_packet[length + 2];
     for (uint16_t i = 0; i < length; i++) {
@@ -184,25 +205,108 @@ i2c_status_t i2c_writeReg16(uint8_t devaddr, uint16_t regaddr, const uint8_t* da
     complete_packet[0] = regaddr >> 8;
     complete_packet[1] = regaddr & 0xFF;
 
+    I2C_BUS_LOCK();
+    i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), complete_packet, length + 2, 0, 0, TIME_MS2I(timeout));
+    I2C_BUS_UNLOCK();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_BUS_LOCK();
     i2c_address = devaddr;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), &regaddr, 1, data, length, TIME_MS2I(timeout));
+    I2C_BUS_UNLOCK();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_readReg16(uint8_t devaddr, uint16_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_BUS_LOCK();
     i2c_address = devaddr;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     uint8_t register_packet[2] = {regaddr >> 8, regaddr & 0xFF};
     msg_t   status             = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), register_packet, 2, data, length, TIME_MS2I(timeout));
+    I2C_BUS_UNLOCK();
     return chibios_to_qmk(&status);
 }
 
 void i2c_stop(void) {
+    I2C_BUS_LOCK();
     i2cStop(&I2C_DRIVER);
+    I2C_BUS_UNLOCK();
+}
+
+#ifdef I2C_QUEUE_ENABLE
+static i2c_transfer_t *volatile queue_transfer = NULL;
+static volatile bool            queue_done     = false;
+static volatile i2c_status_t    queue_status   = I2C_STATUS_SUCCESS;
+static BSEMAPHORE_DECL(queue_start, true);
+
+// ChibiOS takes the register address and the payload as one buffer, the copy is made on the
+// transfer thread rather than in keyboard_task()
+static uint8_t queue_buffer[I2C_QUEUE_BUFFER_SIZE];
+
+static THD_WORKING_AREA(waI2CQueueThread, 256);
+static THD_FUNCTION(I2CQueueThread, arg) {
+    (void)arg;
+    chRegSetThreadName("i2c_queue");
+
+    while (true) {
+        chBSemWait(&queue_start);
+
+        i2c_transfer_t *transfer  = queue_transfer;
+        uint16_t        tx_length = transfer->reg_length + transfer->tx_length;
+        msg_t           status    = I2C_NO_ERROR;
+
+        if (transfer->reg_length > 2 || tx_length > sizeof(queue_buffer)) {
+            queue_status = I2C_STATUS_ERROR;
+            queue_done   = true;
+            continue;
+        }
+
+        if (transfer->reg_length == 2) {
+            queue_buffer[0] = transfer->reg >> 8;
+            queue_buffer[1] = transfer->reg & 0xFF;
+        } else if (transfer->reg_length == 1) {
+            queue_buffer[0] = transfer->reg;
+        }
+        if (transfer->tx_length) {
+            memcpy(&queue_buffer[transfer->reg_length], transfer->tx_data, transfer->tx_length);
+        }
+
+        I2C_BUS_LOCK();
+        i2cStart(&I2C_DRIVER, &i2cconfig);
+        if (tx_length) {
+            status = i2cMasterTransmitTimeout(&I2C_DRIVER, (transfer->address >> 1), queue_buffer, tx_length, transfer->rx_data, transfer->rx_length, TIME_MS2I(transfer->timeout));
+        } else if (transfer->rx_length) {
+            status = i2cMasterReceiveTimeout(&I2C_DRIVER, (transfer->address >> 1), transfer->rx_data, transfer->rx_length, TIME_MS2I(transfer->timeout));
+        }
+        I2C_BUS_UNLOCK();
+
+        queue_status = chibios_to_qmk(&status);
+        queue_done   = true;
+    }
+}
+
+void i2c_queue_transport_start(i2c_transfer_t *transfer) {
+    static bool thread_started = false;
+    if (!thread_started) {
+        thread_started = true;
+        // Above the main thread, which keeps scanning while the transfer waits for the bus
+        chThdCreateStatic(waI2CQueueThread, sizeof(waI2CQueueThread), NORMALPRIO + 1, I2CQueueThread, NULL);
+    }
+
+    queue_done     = false;
+    queue_transfer = transfer;
+    chBSemSignal(&queue_start);
 }
+
+bool i2c_queue_transport_poll(i2c_status_t *status) {
+    if (!queue_done) {
+        return false;
+    }
+    *status = queue_status;
+    return true;
+}
+#endif
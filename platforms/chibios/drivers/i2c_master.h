@@ -41,3 +41,11 @@ i2c_status_t i2c_writeReg16(uint8_t devaddr, uint16_t regaddr, const uint8_t* da
 i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout);
 i2c_status_t i2c_readReg16(uint8_t devaddr, uint16_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout);
 void         i2c_stop(void);
+
+// Transfers queued through i2c_queue.h run on a thread of their own
+#define I2C_QUEUE_PLATFORM_TRANSPORT
+
+// Longest queued transfer, register address included
+#ifndef I2C_QUEUE_BUFFER_SIZE
+#    define I2C_QUEUE_BUFFER_SIZE 258 // Register address and a 256 byte payload
+#endif
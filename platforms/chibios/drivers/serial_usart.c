@@ -16,6 +16,10 @@
 
 #include "serial_usart.h"
 
+#if defined(SPLIT_TRANSPORT_BATCH)
+#    include "transport_batch.h"
+#endif
+
 #if defined(SERIAL_USART_CONFIG)
 static SerialConfig serial_config = SERIAL_USART_CONFIG;
 #else
@@ -39,6 +43,15 @@ static inline bool __attribute__((nonnull)) send(const uint8_t* source, const si
 static inline bool initiate_transaction(uint8_t sstd_index);
 static inline void usart_clear(void);
 
+#if defined(SPLIT_TRANSPORT_BATCH)
+static inline bool react_to_batch(void);
+
+/* Frame buffers of the transport, see soft_serial_batch_target_init(). */
+static uint8_t* batch_request;
+static uint8_t* batch_response;
+static uint16_t batch_buffer_size;
+#endif
+
 /**
  * @brief Clear the receive input queue.
  */
@@ -77,8 +90,14 @@ static inline bool send(const uint8_t* source, const size_t size) {
         /* Half duplex fills the input queue with the data we wrote - just throw it away.
            Under the right circumstances (e.g. bad cables paired with high baud rates)
            less bytes can be present in the input queue, therefore a timeout is needed. */
-        uint8_t dump[size];
-        return receive(dump, size);
+        uint8_t dump[16];
+        for (size_t remaining = size; remaining > 0;) {
+            size_t chunk = remaining < sizeof(dump) ? remaining : sizeof(dump);
+            if (!receive(dump, chunk)) {
+                return false;
+            }
+            remaining -= chunk;
+        }
     }
 #endif
 
@@ -195,6 +214,12 @@ static inline bool react_to_transactions(void) {
     /* Wait until there is a transaction for us. */
     uint8_t sstd_index = (uint8_t)sdGet(serial_driver);
 
+#if defined(SPLIT_TRANSPORT_BATCH)
+    if (sstd_index == SPLIT_BATCH_FRAME_START) {
+        return react_to_batch();
+    }
+#endif
+
     /* Sanity check that we are actually responding to a valid transaction. */
     if (sstd_index >= NUM_TOTAL_TRANSACTIONS) {
         return false;
@@ -231,6 +256,42 @@ static inline bool react_to_transactions(void) {
     return true;
 }
 
+#if defined(SPLIT_TRANSPORT_BATCH)
+
+/**
+ * @brief React to a batched frame started by the master.
+ */
+static inline bool react_to_batch(void) {
+    if (!batch_request) {
+        return false;
+    }
+
+    /* The start byte was already consumed, fetch the rest of the header to learn the frame length. */
+    batch_request[0] = SPLIT_BATCH_FRAME_START;
+    if (!receive(&batch_request[1], SPLIT_BATCH_REQUEST_HEADER_SIZE - 1)) {
+        return false;
+    }
+
+    uint16_t request_length = split_batch_request_length(batch_request);
+    if (request_length == 0 || request_length > batch_buffer_size) {
+        return false;
+    }
+
+    if (!receive(&batch_request[SPLIT_BATCH_REQUEST_HEADER_SIZE], request_length - SPLIT_BATCH_REQUEST_HEADER_SIZE)) {
+        return false;
+    }
+
+    /* Runs every transaction in the frame, the master gets nothing back if the frame was corrupted. */
+    uint16_t response_length = split_batch_handle_request(batch_request, request_length, batch_response, batch_buffer_size);
+    if (response_length == 0) {
+        return false;
+    }
+
+    return send(batch_response, response_length);
+}
+
+#endif
+
 /**
  * @brief Master specific initializations.
  */
@@ -304,3 +365,40 @@ static inline bool initiate_transaction(uint8_t sstd_index) {
 
     return true;
 }
+
+#if defined(SPLIT_TRANSPORT_BATCH)
+
+/**
+ * @brief Set the buffers the slave half receives batched frames into and builds its responses in.
+ */
+void soft_serial_batch_target_init(uint8_t* request, uint8_t* response, uint16_t buffer_size) {
+    batch_request     = request;
+    batch_response    = response;
+    batch_buffer_size = buffer_size;
+}
+
+/**
+ * @brief Exchange a batched request frame for the response frame of the slave half.
+ *
+ * @return bool Indicates success of the exchange.
+ */
+bool soft_serial_batch_transaction(const uint8_t* request, uint16_t request_length, uint8_t* response, uint16_t response_length) {
+    /* Clear the receive queue, to start with a clean slate.
+     * Parts of failed transactions or spurious bytes could still be in it. */
+    usart_clear();
+
+    if (!send(request, request_length)) {
+        dprintln("USART: Send batch failed.");
+        return false;
+    }
+
+    /* The response doubles as the handshake, a slave that is not ready simply never answers. */
+    if (!receive(response, response_length)) {
+        dprintln("USART: Receive batch failed.");
+        return false;
+    }
+
+    return true;
+}
+
+#endif
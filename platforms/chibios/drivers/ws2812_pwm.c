@@ -1,15 +1,10 @@
 #include "ws2812.h"
+#include "ws2812_encoder.h"
 #include "quantum.h"
 #include <hal.h>
 
 /* Adapted from https://github.com/joewa/WS2812-LED-Driver_ChibiOS/ */
 
-#ifdef RGBW
-#    define WS2812_CHANNELS 4
-#else
-#    define WS2812_CHANNELS 3
-#endif
-
 #ifndef WS2812_PWM_DRIVER
 #    define WS2812_PWM_DRIVER PWMD2 // TIMx
 #endif
@@ -61,7 +56,6 @@
 
 /* --- PRIVATE CONSTANTS ---------------------------------------------------- */
 
-#define WS2812_PWM_FREQUENCY (CPU_CLOCK / 2)                                /**< Clock frequency of PWM, must be valid with respect to system clock! */
 #define WS2812_PWM_PERIOD (WS2812_PWM_FREQUENCY / WS2812_PWM_TARGET_PERIOD) /**< Clock period in ticks. 1 / 800kHz = 1.25 uS (as per datasheet) */
 
 /**
@@ -70,199 +64,54 @@
  * The reset period for each frame is defined in WS2812_TRST_US.
  * Calculate the number of zeroes to add at the end assuming 1.25 uS/bit:
  */
-#define WS2812_COLOR_BITS (WS2812_CHANNELS * 8)
 #define WS2812_RESET_BIT_N (1000 * WS2812_TRST_US / WS2812_TIMING)
-#define WS2812_COLOR_BIT_N (RGBLED_NUM * WS2812_COLOR_BITS)    /**< Number of data bits */
+#define WS2812_COLOR_BIT_N WS2812_FRAME_SYMBOLS                 /**< Number of data bits */
 #define WS2812_BIT_N (WS2812_COLOR_BIT_N + WS2812_RESET_BIT_N) /**< Total number of bits in a frame */
 
-/**
- * @brief   High period for a zero, in ticks
- *
- * Per the datasheet:
- * WS2812:
- * - T0H: 200 nS to 500 nS, inclusive
- * - T0L: 650 nS to 950 nS, inclusive
- * WS2812B:
- * - T0H: 200 nS to 500 nS, inclusive
- * - T0L: 750 nS to 1050 nS, inclusive
- *
- * The duty cycle is calculated for a high period of 350 nS.
- */
-#define WS2812_DUTYCYCLE_0 (WS2812_PWM_FREQUENCY / (1000000000 / 350))
-
-/**
- * @brief   High period for a one, in ticks
- *
- * Per the datasheet:
- * WS2812:
- * - T1H: 550 nS to 850 nS, inclusive
- * - T1L: 450 nS to 750 nS, inclusive
- * WS2812B:
- * - T1H: 750 nS to 1050 nS, inclusive
- * - T1L: 200 nS to 500 nS, inclusive
- *
- * The duty cycle is calculated for a high period of 800 nS.
- * This is in the middle of the specifications of the WS2812 and WS2812B.
- */
-#define WS2812_DUTYCYCLE_1 (WS2812_PWM_FREQUENCY / (1000000000 / 800))
-
-/* --- PRIVATE MACROS ------------------------------------------------------- */
-
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given bit
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] byte:                 The byte number [0, 2]
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#define WS2812_BIT(led, byte, bit) (WS2812_COLOR_BITS * (led) + 8 * (byte) + (7 - (bit)))
-
-#if (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB)
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given red bit
- *
- * @note    The red byte is the middle byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_RED_BIT(led, bit) WS2812_BIT((led), 1, (bit))
-
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given green bit
- *
- * @note    The red byte is the first byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_GREEN_BIT(led, bit) WS2812_BIT((led), 0, (bit))
-
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given blue bit
- *
- * @note    The red byte is the last byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit index [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_BLUE_BIT(led, bit) WS2812_BIT((led), 2, (bit))
-
-#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB)
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given red bit
- *
- * @note    The red byte is the middle byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_RED_BIT(led, bit) WS2812_BIT((led), 0, (bit))
-
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given green bit
- *
- * @note    The red byte is the first byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_GREEN_BIT(led, bit) WS2812_BIT((led), 1, (bit))
+/* --- PRIVATE VARIABLES ---------------------------------------------------- */
 
 /**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given blue bit
+ * @brief   Buffers for a frame, encoded by ws2812_encoder
  *
- * @note    The red byte is the last byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit index [0, 7]
- *
- * @return                          The bit index
+ * The trailing zero duty cycle after the reset bits leaves the output low once the DMA stops.
  */
-#    define WS2812_BLUE_BIT(led, bit) WS2812_BIT((led), 2, (bit))
+static uint32_t ws2812_frame_buffer[WS2812_BUFFER_COUNT][WS2812_BIT_N + 1];
 
-#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR)
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given red bit
- *
- * @note    The red byte is the middle byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_RED_BIT(led, bit) WS2812_BIT((led), 2, (bit))
+static volatile bool dma_busy    = false; /**< A frame is being sent */
+static volatile bool dma_pending = false; /**< The back buffer holds a frame waiting for the current one */
 
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given green bit
- *
- * @note    The red byte is the first byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit number [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_GREEN_BIT(led, bit) WS2812_BIT((led), 1, (bit))
+/* --- PRIVATE FUNCTIONS ---------------------------------------------------- */
 
 /**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given blue bit
- *
- * @note    The red byte is the last byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref RGBLED_NUM)
- * @param[in] bit:                  The bit index [0, 7]
- *
- * @return                          The bit index
+ * @brief   Start sending the back buffer, must be called locked with the stream idle
  */
-#    define WS2812_BLUE_BIT(led, bit) WS2812_BIT((led), 0, (bit))
-#endif
-
-#ifdef RGBW
-/**
- * @brief   Determine the index in @ref ws2812_frame_buffer "the frame buffer" of a given white bit
- *
- * @note    The white byte is the last byte in the color packet
- *
- * @param[in] led:                  The led index [0, @ref WS2812_LED_N)
- * @param[in] bit:                  The bit index [0, 7]
- *
- * @return                          The bit index
- */
-#    define WS2812_WHITE_BIT(led, bit) WS2812_BIT((led), 3, (bit))
-#endif
-
-/* --- PRIVATE VARIABLES ---------------------------------------------------- */
+static void ws2812_kick(void) {
+    dma_busy = true;
+    dmaStreamSetMemory0(WS2812_DMA_STREAM, ws2812_encoder_swap());
+    dmaStreamSetTransactionSize(WS2812_DMA_STREAM, WS2812_BIT_N + 1);
+    dmaStreamEnable(WS2812_DMA_STREAM);
+}
 
-static uint32_t ws2812_frame_buffer[WS2812_BIT_N + 1]; /**< Buffer for a frame */
+static void ws2812_dma_cb(void *param, uint32_t flags) {
+    (void)param;
+
+    if (flags & STM32_DMA_ISR_TCIF) {
+        chSysLockFromISR();
+        dmaStreamDisable(WS2812_DMA_STREAM);
+        if (dma_pending) {
+            dma_pending = false;
+            ws2812_kick();
+        } else {
+            dma_busy = false;
+        }
+        chSysUnlockFromISR();
+    }
+}
 
 /* --- PUBLIC FUNCTIONS ----------------------------------------------------- */
-/*
- * Gedanke: Double-buffer type transactions: double buffer transfers using two memory pointers for
-the memory (while the DMA is reading/writing from/to a buffer, the application can
-write/read to/from the other buffer).
- */
 
 void ws2812_init(void) {
-    // Initialize led frame buffer
-    uint32_t i;
-    for (i = 0; i < WS2812_COLOR_BIT_N; i++)
-        ws2812_frame_buffer[i] = WS2812_DUTYCYCLE_0; // All color bits are zero duty cycle
-    for (i = 0; i < WS2812_RESET_BIT_N; i++)
-        ws2812_frame_buffer[i + WS2812_COLOR_BIT_N] = 0; // All reset bits are zero
+    ws2812_encoder_init(ws2812_frame_buffer[0], ws2812_frame_buffer[WS2812_BUFFER_COUNT - 1]);
 
     palSetLineMode(RGB_DI_PIN, WS2812_OUTPUT_MODE);
 
@@ -283,12 +132,11 @@ void ws2812_init(void) {
     //#pragma GCC diagnostic pop  // Restore command-line warning options
 
     // Configure DMA
-    // dmaInit(); // Joe added this
-    dmaStreamAlloc(WS2812_DMA_STREAM - STM32_DMA_STREAM(0), 10, NULL, NULL);
+    // Each frame is a single transfer started by ws2812_kick(); the transfer complete interrupt
+    // starts the next one if a frame was encoded while this one was being sent.
+    dmaStreamAlloc(WS2812_DMA_STREAM - STM32_DMA_STREAM(0), 10, ws2812_dma_cb, NULL);
     dmaStreamSetPeripheral(WS2812_DMA_STREAM, &(WS2812_PWM_DRIVER.tim->CCR[WS2812_PWM_CHANNEL - 1])); // Ziel ist der An-Zeit im Cap-Comp-Register
-    dmaStreamSetMemory0(WS2812_DMA_STREAM, ws2812_frame_buffer);
-    dmaStreamSetTransactionSize(WS2812_DMA_STREAM, WS2812_BIT_N);
-    dmaStreamSetMode(WS2812_DMA_STREAM, STM32_DMA_CR_CHSEL(WS2812_DMA_CHANNEL) | STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_PSIZE_WORD | STM32_DMA_CR_MSIZE_WORD | STM32_DMA_CR_MINC | STM32_DMA_CR_CIRC | STM32_DMA_CR_PL(3));
+    dmaStreamSetMode(WS2812_DMA_STREAM, STM32_DMA_CR_CHSEL(WS2812_DMA_CHANNEL) | STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_PSIZE_WORD | STM32_DMA_CR_MSIZE_WORD | STM32_DMA_CR_MINC | STM32_DMA_CR_TCIE | STM32_DMA_CR_PL(3));
     // M2P: Memory 2 Periph; PL: Priority Level
 
 #if (STM32_DMA_SUPPORTS_DMAMUX == TRUE)
@@ -296,9 +144,6 @@ void ws2812_init(void) {
     dmaSetRequestSource(WS2812_DMA_STREAM, WS2812_DMAMUX_ID);
 #endif
 
-    // Start DMA
-    dmaStreamEnable(WS2812_DMA_STREAM);
-
     // Configure PWM
     // NOTE: It's required that preload be enabled on the timer channel CCR register. This is currently enabled in the
     // ChibiOS driver code, so we don't have to do anything special to the timer. If we did, we'd have to start the timer,
@@ -307,26 +152,6 @@ void ws2812_init(void) {
     pwmEnableChannel(&WS2812_PWM_DRIVER, WS2812_PWM_CHANNEL - 1, 0); // Initial period is 0; output will be low until first duty cycle is DMA'd in
 }
 
-void ws2812_write_led(uint16_t led_number, uint8_t r, uint8_t g, uint8_t b) {
-    // Write color to frame buffer
-    for (uint8_t bit = 0; bit < 8; bit++) {
-        ws2812_frame_buffer[WS2812_RED_BIT(led_number, bit)]   = ((r >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-        ws2812_frame_buffer[WS2812_GREEN_BIT(led_number, bit)] = ((g >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-        ws2812_frame_buffer[WS2812_BLUE_BIT(led_number, bit)]  = ((b >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-    }
-}
-void ws2812_write_led_rgbw(uint16_t led_number, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
-    // Write color to frame buffer
-    for (uint8_t bit = 0; bit < 8; bit++) {
-        ws2812_frame_buffer[WS2812_RED_BIT(led_number, bit)]   = ((r >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-        ws2812_frame_buffer[WS2812_GREEN_BIT(led_number, bit)] = ((g >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-        ws2812_frame_buffer[WS2812_BLUE_BIT(led_number, bit)]  = ((b >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-#ifdef RGBW
-        ws2812_frame_buffer[WS2812_WHITE_BIT(led_number, bit)] = ((w >> bit) & 0x01) ? WS2812_DUTYCYCLE_1 : WS2812_DUTYCYCLE_0;
-#endif
-    }
-}
-
 // Setleds for standard RGB
 void ws2812_setleds(LED_TYPE* ledarray, uint16_t leds) {
     static bool s_init = false;
@@ -335,11 +160,19 @@ void ws2812_setleds(LED_TYPE* ledarray, uint16_t leds) {
         s_init = true;
     }
 
-    for (uint16_t i = 0; i < leds; i++) {
-#ifdef RGBW
-        ws2812_write_led_rgbw(i, ledarray[i].r, ledarray[i].g, ledarray[i].b, ledarray[i].w);
-#else
-        ws2812_write_led(i, ledarray[i].r, ledarray[i].g, ledarray[i].b);
-#endif
+    // Nothing can start the back buffer while it is being rewritten
+    chSysLock();
+    dma_pending = false;
+    chSysUnlock();
+
+    ws2812_encoder_encode(ledarray, leds);
+
+    // Returns straight away, the frame is sent by DMA
+    chSysLock();
+    if (dma_busy) {
+        dma_pending = true;
+    } else {
+        ws2812_kick();
     }
+    chSysUnlock();
 }
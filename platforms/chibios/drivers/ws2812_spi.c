@@ -1,5 +1,6 @@
 #include "quantum.h"
 #include "ws2812.h"
+#include "ws2812_encoder.h"
 
 /* Adapted from https://github.com/gamazeps/ws2812b-chibios-SPIDMA/ */
 
@@ -69,67 +70,39 @@
 #    define WS2812_SCK_OUTPUT_MODE PAL_MODE_ALTERNATE(WS2812_SPI_SCK_PAL_MODE) | PAL_OUTPUT_TYPE_PUSHPULL
 #endif
 
-#define BYTES_FOR_LED_BYTE 4
-#ifdef RGBW
-#    define WS2812_CHANNELS 4
-#else
-#    define WS2812_CHANNELS 3
-#endif
-#define BYTES_FOR_LED (BYTES_FOR_LED_BYTE * WS2812_CHANNELS)
-#define DATA_SIZE (BYTES_FOR_LED * RGBLED_NUM)
 #define RESET_SIZE (1000 * WS2812_TRST_US / (2 * WS2812_TIMING))
 #define PREAMBLE_SIZE 4
+#define TXBUF_SIZE (PREAMBLE_SIZE + WS2812_FRAME_SYMBOLS + RESET_SIZE)
 
-static uint8_t txbuf[PREAMBLE_SIZE + DATA_SIZE + RESET_SIZE] = {0};
+static uint8_t txbuf[WS2812_BUFFER_COUNT][TXBUF_SIZE] = {0};
 
+#if !defined(WS2812_SPI_USE_CIRCULAR_BUFFER) && !defined(WS2812_SPI_SYNC)
 /*
- * As the trick here is to use the SPI to send a huge pattern of 0 and 1 to
- * the ws2812b protocol, we use this helper function to translate bytes into
- * 0s and 1s for the LED (with the appropriate timing).
+ * Frames are sent in the background. A frame encoded while the previous one is still going out is
+ * left pending, and started from the end of transfer callback.
  */
-static uint8_t get_protocol_eq(uint8_t data, int pos) {
-    uint8_t eq = 0;
-    if (data & (1 << (2 * (3 - pos))))
-        eq = 0b1110;
-    else
-        eq = 0b1000;
-    if (data & (2 << (2 * (3 - pos))))
-        eq += 0b11100000;
-    else
-        eq += 0b10000000;
-    return eq;
+static volatile bool tx_busy    = false;
+static volatile bool tx_pending = false;
+
+static void kick_frame(void) {
+    tx_busy = true;
+    spiStartSendI(&WS2812_SPI, TXBUF_SIZE, ws2812_encoder_swap() - PREAMBLE_SIZE);
 }
 
-static void set_led_color_rgb(LED_TYPE color, int pos) {
-    uint8_t* tx_start = &txbuf[PREAMBLE_SIZE];
-
-#if (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.r, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.b, j);
-#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.r, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.b, j);
-#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.b, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.r, j);
-#endif
-#ifdef RGBW
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 4 + j] = get_protocol_eq(color.w, j);
-#endif
+static void ws2812_spi_end_cb(SPIDriver* spip) {
+    chSysLockFromISR();
+    if (tx_pending) {
+        tx_pending = false;
+        kick_frame();
+    } else {
+        tx_busy = false;
+    }
+    chSysUnlockFromISR();
 }
+#    define WS2812_SPI_END_CB ws2812_spi_end_cb
+#else
+#    define WS2812_SPI_END_CB NULL
+#endif
 
 void ws2812_init(void) {
     palSetLineMode(RGB_DI_PIN, WS2812_MOSI_OUTPUT_MODE);
@@ -139,13 +112,15 @@ void ws2812_init(void) {
 #endif // WS2812_SPI_SCK_PIN
 
     // TODO: more dynamic baudrate
-    static const SPIConfig spicfg = {WS2812_SPI_BUFFER_MODE, NULL, PAL_PORT(RGB_DI_PIN), PAL_PAD(RGB_DI_PIN), WS2812_SPI_DIVISOR_CR1_BR_X};
+    static const SPIConfig spicfg = {WS2812_SPI_BUFFER_MODE, WS2812_SPI_END_CB, PAL_PORT(RGB_DI_PIN), PAL_PAD(RGB_DI_PIN), WS2812_SPI_DIVISOR_CR1_BR_X};
+
+    ws2812_encoder_init(&txbuf[0][PREAMBLE_SIZE], &txbuf[WS2812_BUFFER_COUNT - 1][PREAMBLE_SIZE]);
 
     spiAcquireBus(&WS2812_SPI);     /* Acquire ownership of the bus.    */
     spiStart(&WS2812_SPI, &spicfg); /* Setup transfer parameters.       */
     spiSelect(&WS2812_SPI);         /* Slave Select assertion.          */
 #ifdef WS2812_SPI_USE_CIRCULAR_BUFFER
-    spiStartSend(&WS2812_SPI, sizeof(txbuf) / sizeof(txbuf[0]), txbuf);
+    spiStartSend(&WS2812_SPI, TXBUF_SIZE, txbuf[0]);
 #endif
 }
 
@@ -156,17 +131,28 @@ void ws2812_setleds(LED_TYPE* ledarray, uint16_t leds) {
         s_init = true;
     }
 
-    for (uint8_t i = 0; i < leds; i++) {
-        set_led_color_rgb(ledarray[i], i);
-    }
+#if !defined(WS2812_SPI_USE_CIRCULAR_BUFFER) && !defined(WS2812_SPI_SYNC)
+    // Nothing can start the back buffer while it is being rewritten
+    chSysLock();
+    tx_pending = false;
+    chSysUnlock();
+#endif
+
+    ws2812_encoder_encode(ledarray, leds);
 
-    // Send async - each led takes ~0.03ms, 50 leds ~1.5ms, animations flushing faster than send will cause issues.
-    // Instead spiSend can be used to send synchronously (or the thread logic can be added back).
+    // Each led takes ~0.03ms to send, 50 leds ~1.5ms. The circular buffer is sent continuously, so
+    // the new colours go out with its next pass.
 #ifndef WS2812_SPI_USE_CIRCULAR_BUFFER
 #    ifdef WS2812_SPI_SYNC
-    spiSend(&WS2812_SPI, sizeof(txbuf) / sizeof(txbuf[0]), txbuf);
+    spiSend(&WS2812_SPI, TXBUF_SIZE, ws2812_encoder_swap() - PREAMBLE_SIZE);
 #    else
-    spiStartSend(&WS2812_SPI, sizeof(txbuf) / sizeof(txbuf[0]), txbuf);
+    chSysLock();
+    if (tx_busy) {
+        tx_pending = true;
+    } else {
+        kick_frame();
+    }
+    chSysUnlock();
 #    endif
 #endif
 }
@@ -30,4 +30,8 @@ uint8_t  EEPROM_WriteDataWord(uint16_t Address, uint16_t DataWord);
 uint8_t  EEPROM_ReadDataByte(uint16_t Address);
 uint16_t EEPROM_ReadDataWord(uint16_t Address);
 
+#ifdef EEPROM_STM32_BANKED
+void EEPROM_Task(void);
+#endif
+
 void print_eeprom(void);
@@ -0,0 +1,659 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "util.h"
+#include "debug.h"
+#include "eeprom_stm32.h"
+#include "flash_stm32.h"
+
+/*
+ * Banked variant of the emulated eeprom in eeprom_stm32.c.
+ *
+ * The pages are split into FEE_BANK_COUNT banks. Each bank holds a complete compacted copy of
+ * the eeprom followed by its own write log, both encoded exactly as in eeprom_stm32.c:
+ *
+ * ┌─ Bank 0 ─────────────────────┬─ Bank 1 ─────────────────────┬─ ...
+ * │[Header][Compacted][Write Log]│[Header][Compacted][Write Log]│
+ * └──────────────────────────────┴──────────────────────────────┴─ ...
+ *
+ * ╔═══════════════ Header ═════════════════╗
+ * ║ Magic  ║Sequence║~Sequence║ Committed  ║
+ * ║ 0x51EE ║        ║         ║   0x0000   ║
+ * ╚════════╩════════╩═════════╩════════════╝
+ *
+ * The committed bank with the most recent sequence number is the active one.
+ *
+ * Compaction copies the contents into the next bank in turn, so erases rotate over all pages. It
+ * is started in the background once FEE_COMPACTION_THRESHOLD bytes of the active write log are
+ * used and advanced by EEPROM_Task(), one page erase or FEE_COMPACTION_SLICE_WORDS words per call:
+ *
+ *  - ERASE:  erase the pages of the next bank that are not blank yet, then write its header
+ *  - COPY:   program the current contents into its compacted area
+ *  - COMMIT: program the commit marker, the next bank becomes the active one
+ *
+ * The active bank keeps receiving every write until the commit, so a reset at any point loses
+ * nothing. Writes to addresses already copied are also stored into the next bank. Only when the
+ * active write log runs full before the background compaction is done is the rest of it run on
+ * the spot.
+ *
+ * Unless FEE_NO_RAM_CACHE is defined, the contents are cached in RAM like eeprom_stm32.c does.
+ * With it, reads replay the compacted area and write log of the active bank from flash, so
+ * FEE_DENSITY_BYTES may exceed the available RAM at the cost of slower reads.
+ *
+ * The following configuration defines can be set:
+ *
+ * FEE_PAGE_COUNT              # Total number of pages, split across the banks
+ * FEE_BANK_COUNT              # Number of banks (Defaults to 2)
+ * FEE_DENSITY_BYTES           # Size of simulated eeprom (Defaults to half a bank)
+ * FEE_COMPACTION_THRESHOLD    # Write log bytes used before compaction starts (Defaults to 3/4 of the log)
+ * FEE_COMPACTION_SLICE_WORDS  # Words copied per EEPROM_Task() call (Defaults to 32)
+ * FEE_NO_RAM_CACHE            # Do not cache the contents in RAM
+ */
+
+#include "eeprom_stm32_defs.h"
+
+#if !defined(FEE_PAGE_SIZE) || !defined(FEE_PAGE_COUNT) || !defined(FEE_MCU_FLASH_SIZE) || !defined(FEE_PAGE_BASE_ADDRESS)
+#    error "not implemented."
+#endif
+
+/* Return value of bank_store() when the write log has no room left */
+#define FEE_LOG_FULL 0
+
+typedef struct {
+    uint8_t   bank;
+    uint16_t *empty_slot;
+} fee_log_t;
+
+enum {
+    FEE_COMPACTION_IDLE,
+    FEE_COMPACTION_ERASE,
+    FEE_COMPACTION_COPY,
+    FEE_COMPACTION_COMMIT,
+};
+
+/* Bank serving reads and writes */
+static fee_log_t active;
+static uint16_t  active_sequence;
+
+/* Bank being compacted into */
+static fee_log_t target;
+static uint8_t   compaction_state = FEE_COMPACTION_IDLE;
+/* Page being erased, or offset of the next word to copy */
+static uint16_t compaction_cursor;
+
+#ifndef FEE_NO_RAM_CACHE
+/* In-memory contents of emulated eeprom for faster access */
+static uint16_t WordBuf[FEE_DENSITY_BYTES / 2];
+#endif
+
+// #define DEBUG_EEPROM_OUTPUT
+
+/*
+ * Debug print utils
+ */
+
+#if defined(DEBUG_EEPROM_OUTPUT)
+
+#    define debug_eeprom debug_enable
+#    define eeprom_println(s) println(s)
+#    define eeprom_printf(fmt, ...) xprintf(fmt, ##__VA_ARGS__);
+
+#else /* NO_DEBUG */
+
+#    define debug_eeprom false
+#    define eeprom_println(s)
+#    define eeprom_printf(fmt, ...)
+
+#endif /* NO_DEBUG */
+
+void print_eeprom(void) {
+#ifndef NO_DEBUG
+    int empty_rows = 0;
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        if (i % 16 == 0) {
+            if (i >= FEE_DENSITY_BYTES - 16) {
+                /* Make sure we display the last row */
+                empty_rows = 0;
+            }
+            /* Check if this row is uninitialized */
+            ++empty_rows;
+            for (uint16_t j = 0; j < 16; j++) {
+                if (EEPROM_ReadDataByte(i + j)) {
+                    empty_rows = 0;
+                    break;
+                }
+            }
+            if (empty_rows > 1) {
+                /* Repeat empty row */
+                if (empty_rows == 2) {
+                    /* Only display the first repeat empty row */
+                    println("*");
+                }
+                i += 15;
+                continue;
+            }
+            xprintf("%04x", i);
+        }
+        if (i % 8 == 0) print(" ");
+
+        xprintf(" %02x", EEPROM_ReadDataByte(i));
+        if ((i + 1) % 16 == 0) {
+            println("");
+        }
+    }
+#endif
+}
+
+static bool bank_is_committed(uint8_t bank, uint16_t *sequence) {
+    uint16_t *header = (uint16_t *)FEE_BANK_BASE_ADDRESS(bank);
+    if (header[0] != FEE_BANK_MAGIC || header[1] != (uint16_t)~header[2] || header[3] != FEE_BANK_COMMITTED) {
+        return false;
+    }
+    *sequence = header[1];
+    return true;
+}
+
+static bool page_is_erased(uintptr_t page) {
+    for (uint16_t *word = (uint16_t *)page; word < (uint16_t *)(page + FEE_PAGE_SIZE); ++word) {
+        if (*word != FEE_EMPTY_WORD) return false;
+    }
+    return true;
+}
+
+static uint16_t bank_log_used(const fee_log_t *log) {
+    return (uintptr_t)log->empty_slot - FEE_BANK_WRITE_LOG_ADDRESS(log->bank);
+}
+
+/*
+ * Apply the compacted area and the write log of a bank to the word aligned window
+ * [start, start + len) of the emulated eeprom, stored into dest.
+ *
+ * Returns the first empty slot of the write log.
+ */
+static uint16_t *bank_replay(uint8_t bank, uint16_t start, uint16_t len, uint8_t *dest) {
+    uint16_t  end = start + len;
+    uint16_t *src = (uint16_t *)(FEE_BANK_COMPACTED_ADDRESS(bank) + start);
+    for (uint16_t i = 0; i < len; i += 2, ++src) {
+        uint16_t value = ~*src;
+        dest[i]        = value;
+        dest[i + 1]    = value >> 8;
+    }
+
+    uint16_t *log_addr;
+    uint16_t *log_last = (uint16_t *)FEE_BANK_LAST_ADDRESS(bank);
+    for (log_addr = (uint16_t *)FEE_BANK_WRITE_LOG_ADDRESS(bank); log_addr < log_last; ++log_addr) {
+        uint16_t address = *log_addr;
+        if (address == FEE_EMPTY_WORD) {
+            break;
+        }
+        /* Check for lowest 128-bytes optimization */
+        if (!(address & FEE_WORD_ENCODING)) {
+            uint8_t bvalue = (uint8_t)address;
+            address >>= 8;
+            if (address >= start && address < end) {
+                dest[address - start] = bvalue;
+            }
+        } else {
+            uint16_t wvalue;
+            /* Check if value is in next word */
+            if ((address & FEE_VALUE_NEXT) == FEE_VALUE_NEXT) {
+                /* Read value from next word */
+                if (++log_addr >= log_last) {
+                    break;
+                }
+                wvalue = ~*log_addr;
+                if (!wvalue) {
+                    eeprom_printf("Incomplete write at log_addr: 0x%04x;\n", (uint32_t)log_addr);
+                    /* Possibly incomplete write.  Ignore and continue */
+                    continue;
+                }
+                address &= 0x1FFF;
+                address <<= 1;
+                /* Writes to addresses less than 128 are byte log entries */
+                address += FEE_BYTE_RANGE;
+            } else {
+                /* Reserved for future use */
+                if (address & FEE_VALUE_RESERVED) {
+                    eeprom_printf("Reserved encoded value at log_addr: 0x%04x;\n", (uint32_t)log_addr);
+                    continue;
+                }
+                /* Optimization for 0 or 1 values. */
+                wvalue = (address & FEE_VALUE_ENCODED) >> 13;
+                address &= 0x1FFF;
+                address <<= 1;
+            }
+            if (address >= start && address < end) {
+                dest[address - start]     = wvalue;
+                dest[address - start + 1] = wvalue >> 8;
+            }
+        }
+    }
+    return log_addr;
+}
+
+static uint16_t read_word(uint16_t Address) {
+#ifdef FEE_NO_RAM_CACHE
+    uint8_t value[2];
+    bank_replay(active.bank, Address, 2, value);
+    return value[0] | (value[1] << 8);
+#else
+    return WordBuf[Address / 2];
+#endif
+}
+
+/*
+ * Record the aligned word at Address in a bank: directly into its compacted area if that word
+ * is still unprogrammed, otherwise as a write log entry. Below FEE_BYTE_RANGE, only the bytes
+ * set in byte_mask are logged.
+ */
+static uint8_t bank_store(fee_log_t *log, uint16_t Address, uint16_t value, uint8_t byte_mask) {
+    uintptr_t directAddress = FEE_BANK_COMPACTED_ADDRESS(log->bank) + Address;
+    if (*(uint16_t *)directAddress == FEE_EMPTY_WORD) {
+        /* Early exit if a write isn't needed */
+        if (!value) return FLASH_COMPLETE;
+
+        FLASH_Unlock();
+        eeprom_printf("FLASH_ProgramHalfWord(0x%08x, 0x%04x) [DIRECT]\n", (uint32_t)directAddress, (uint16_t)~value);
+        FLASH_Status status = FLASH_ProgramHalfWord(directAddress, ~value);
+        FLASH_Lock();
+        return status;
+    }
+
+    uint16_t entries[2];
+    uint8_t  entry_count = 0;
+    if (Address < FEE_BYTE_RANGE) {
+        /* Pack address and value into the same word */
+        if (byte_mask & 0x01) entries[entry_count++] = (Address << 8) | (value & 0xFF);
+        if (byte_mask & 0x02) entries[entry_count++] = ((Address + 1) << 8) | (value >> 8);
+    } else if (value <= 1) {
+        entries[entry_count++] = FEE_WORD_ENCODING | (value << 13) | (Address >> 1);
+    } else {
+        /* Writes to addresses less than 128 are byte log entries */
+        entries[entry_count++] = FEE_WORD_ENCODING | FEE_VALUE_NEXT | ((Address - FEE_BYTE_RANGE) >> 1);
+        entries[entry_count++] = ~value;
+    }
+
+    if (log->empty_slot + entry_count > (uint16_t *)FEE_BANK_LAST_ADDRESS(log->bank)) {
+        return FEE_LOG_FULL;
+    }
+
+    FLASH_Unlock();
+    FLASH_Status final_status = FLASH_COMPLETE;
+    for (uint8_t i = 0; i < entry_count; i++) {
+        eeprom_printf("FLASH_ProgramHalfWord(0x%08x, 0x%04x)\n", (uint32_t)log->empty_slot, entries[i]);
+        FLASH_Status status = FLASH_ProgramHalfWord((uintptr_t)log->empty_slot++, entries[i]);
+        if (status != FLASH_COMPLETE) final_status = status;
+    }
+    FLASH_Lock();
+    return final_status;
+}
+
+/* Erase every bank and start over with an empty bank 0 */
+static void eeprom_format(void) {
+    FLASH_Unlock();
+
+    for (uint16_t page_num = 0; page_num < FEE_PAGE_COUNT; ++page_num) {
+        eeprom_printf("FLASH_ErasePage(0x%04x)\n", (uint32_t)(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE)));
+        FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE));
+    }
+
+    uintptr_t header = FEE_BANK_BASE_ADDRESS(0);
+    FLASH_ProgramHalfWord(header, FEE_BANK_MAGIC);
+    FLASH_ProgramHalfWord(header + 2, 0);
+    FLASH_ProgramHalfWord(header + 4, (uint16_t)~0);
+    FLASH_ProgramHalfWord(header + 6, FEE_BANK_COMMITTED);
+
+    FLASH_Lock();
+
+    active.bank      = 0;
+    active_sequence  = 0;
+    compaction_state = FEE_COMPACTION_IDLE;
+}
+
+static void compaction_start(void) {
+    if (compaction_state != FEE_COMPACTION_IDLE) return;
+
+    eeprom_printf("compaction_start: bank %d -> %d\n", active.bank, (active.bank + 1) % FEE_BANK_COUNT);
+    target.bank       = (active.bank + 1) % FEE_BANK_COUNT;
+    compaction_state  = FEE_COMPACTION_ERASE;
+    compaction_cursor = 0;
+}
+
+static void compaction_step(void) {
+    switch (compaction_state) {
+        case FEE_COMPACTION_ERASE: {
+            uintptr_t page = FEE_BANK_BASE_ADDRESS(target.bank) + compaction_cursor * FEE_PAGE_SIZE;
+            if (!page_is_erased(page)) {
+                FLASH_Unlock();
+                eeprom_printf("FLASH_ErasePage(0x%04x)\n", (uint32_t)page);
+                FLASH_ErasePage(page);
+                FLASH_Lock();
+            }
+            if (++compaction_cursor < FEE_BANK_PAGES) {
+                break;
+            }
+
+            /* Not committed yet, so the bank stays ignored until its contents are complete */
+            uintptr_t header   = FEE_BANK_BASE_ADDRESS(target.bank);
+            uint16_t  sequence = active_sequence + 1;
+            FLASH_Unlock();
+            FLASH_ProgramHalfWord(header, FEE_BANK_MAGIC);
+            FLASH_ProgramHalfWord(header + 2, sequence);
+            FLASH_ProgramHalfWord(header + 4, ~sequence);
+            FLASH_Lock();
+
+            target.empty_slot = (uint16_t *)FEE_BANK_WRITE_LOG_ADDRESS(target.bank);
+            compaction_state  = FEE_COMPACTION_COPY;
+            compaction_cursor = 0;
+            break;
+        }
+        case FEE_COMPACTION_COPY: {
+            uint16_t len = FEE_DENSITY_BYTES - compaction_cursor;
+            if (len > FEE_COMPACTION_SLICE_WORDS * 2) {
+                len = FEE_COMPACTION_SLICE_WORDS * 2;
+            }
+#ifdef FEE_NO_RAM_CACHE
+            uint16_t slice[FEE_COMPACTION_SLICE_WORDS];
+            bank_replay(active.bank, compaction_cursor, len, (uint8_t *)slice);
+            uint16_t *src = slice;
+#else
+            uint16_t *src = &WordBuf[compaction_cursor / 2];
+#endif
+            uintptr_t dest = FEE_BANK_COMPACTED_ADDRESS(target.bank) + compaction_cursor;
+            FLASH_Unlock();
+            for (uint16_t i = 0; i < len / 2; ++i, dest += 2) {
+                if (src[i]) {
+                    FLASH_ProgramHalfWord(dest, ~src[i]);
+                }
+            }
+            FLASH_Lock();
+
+            compaction_cursor += len;
+            if (compaction_cursor >= FEE_DENSITY_BYTES) {
+                compaction_state = FEE_COMPACTION_COMMIT;
+            }
+            break;
+        }
+        case FEE_COMPACTION_COMMIT:
+            FLASH_Unlock();
+            FLASH_ProgramHalfWord(FEE_BANK_BASE_ADDRESS(target.bank) + 6, FEE_BANK_COMMITTED);
+            FLASH_Lock();
+
+            eeprom_printf("compaction done: bank %d\n", target.bank);
+            active = target;
+            active_sequence++;
+            compaction_state = FEE_COMPACTION_IDLE;
+            break;
+    }
+}
+
+/* Start or finish compaction right away */
+static void compaction_run(void) {
+    compaction_start();
+    while (compaction_state != FEE_COMPACTION_IDLE) {
+        compaction_step();
+    }
+}
+
+static uint8_t eeprom_store(uint16_t Address, uint16_t value, uint8_t byte_mask) {
+    /* Words already copied would miss this write otherwise */
+    if (compaction_state >= FEE_COMPACTION_COPY && Address < compaction_cursor) {
+        if (bank_store(&target, Address, value, byte_mask) == FEE_LOG_FULL) {
+            /* Out of room before it was even committed, start over */
+            compaction_state  = FEE_COMPACTION_ERASE;
+            compaction_cursor = 0;
+        }
+    }
+
+    uint8_t status = bank_store(&active, Address, value, byte_mask);
+    if (status == FEE_LOG_FULL) {
+        compaction_run();
+#ifdef FEE_NO_RAM_CACHE
+        /* The copy was made from flash, which lacks this write */
+        status = bank_store(&active, Address, value, byte_mask);
+#else
+        status = FLASH_COMPLETE;
+#endif
+    } else if (bank_log_used(&active) >= FEE_COMPACTION_THRESHOLD) {
+        compaction_start();
+    }
+    return status;
+}
+
+uint16_t EEPROM_Init(void) {
+    bool     found = false;
+    uint16_t sequence;
+
+    compaction_state = FEE_COMPACTION_IDLE;
+    for (uint8_t bank = 0; bank < FEE_BANK_COUNT; ++bank) {
+        if (bank_is_committed(bank, &sequence) && (!found || (int16_t)(sequence - active_sequence) > 0)) {
+            found           = true;
+            active.bank     = bank;
+            active_sequence = sequence;
+        }
+    }
+
+    if (!found) {
+        eeprom_println("EEPROM_Init no committed bank");
+        eeprom_format();
+    }
+
+#ifdef FEE_NO_RAM_CACHE
+    active.empty_slot = bank_replay(active.bank, 0, 0, NULL);
+#else
+    active.empty_slot = bank_replay(active.bank, 0, FEE_DENSITY_BYTES, (uint8_t *)WordBuf);
+#endif
+
+    if (debug_eeprom) {
+        xprintf("EEPROM_Init bank %d, sequence %d:\n", active.bank, active_sequence);
+        print_eeprom();
+    }
+
+    /* A reset may have interrupted the previous compaction */
+    if (bank_log_used(&active) >= FEE_COMPACTION_THRESHOLD) {
+        compaction_start();
+    }
+
+    return FEE_DENSITY_BYTES;
+}
+
+/* Erase emulated eeprom */
+void EEPROM_Erase(void) {
+    eeprom_println("EEPROM_Erase");
+    eeprom_format();
+    /* re-initialize to reset the cache */
+    EEPROM_Init();
+}
+
+void EEPROM_Task(void) {
+    if (compaction_state != FEE_COMPACTION_IDLE) {
+        compaction_step();
+    }
+}
+
+uint8_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
+    /* if the address is out-of-bounds, do nothing */
+    if (Address >= FEE_DENSITY_BYTES) {
+        eeprom_printf("EEPROM_WriteDataByte(0x%04x, 0x%02x) [BAD ADDRESS]\n", Address, DataByte);
+        return FLASH_BAD_ADDRESS;
+    }
+
+    uint16_t aligned = Address & 0xFFFE;
+    uint8_t  shift   = (Address & 1) * 8;
+    uint16_t value   = read_word(aligned);
+
+    /* if the value is the same, don't bother writing it */
+    if ((uint8_t)(value >> shift) == DataByte) {
+        eeprom_printf("EEPROM_WriteDataByte(0x%04x, 0x%02x) [SKIP SAME]\n", Address, DataByte);
+        return 0;
+    }
+
+    value = (value & ~(0xFF << shift)) | (DataByte << shift);
+#ifndef FEE_NO_RAM_CACHE
+    /* keep WordBuf cache in sync */
+    WordBuf[aligned / 2] = value;
+#endif
+
+    FLASH_Status status = eeprom_store(aligned, value, 1 << (Address & 1));
+    if (status != FLASH_COMPLETE) {
+        eeprom_printf("EEPROM_WriteDataByte [STATUS == %d]\n", status);
+    }
+    return status;
+}
+
+uint8_t EEPROM_WriteDataWord(uint16_t Address, uint16_t DataWord) {
+    /* if the address is out-of-bounds, do nothing */
+    if (Address >= FEE_DENSITY_BYTES) {
+        eeprom_printf("EEPROM_WriteDataWord(0x%04x, 0x%04x) [BAD ADDRESS]\n", Address, DataWord);
+        return FLASH_BAD_ADDRESS;
+    }
+
+    /* Check for word alignment */
+    if (Address % 2) {
+        FLASH_Status final_status = EEPROM_WriteDataByte(Address, DataWord);
+        FLASH_Status status       = EEPROM_WriteDataByte(Address + 1, DataWord >> 8);
+        if (status != FLASH_COMPLETE) final_status = status;
+        if (final_status != 0 && final_status != FLASH_COMPLETE) {
+            eeprom_printf("EEPROM_WriteDataWord [STATUS == %d]\n", final_status);
+        }
+        return final_status;
+    }
+
+    /* if the value is the same, don't bother writing it */
+    uint16_t oldValue = read_word(Address);
+    if (oldValue == DataWord) {
+        eeprom_printf("EEPROM_WriteDataWord(0x%04x, 0x%04x) [SKIP SAME]\n", Address, DataWord);
+        return 0;
+    }
+
+#ifndef FEE_NO_RAM_CACHE
+    /* keep WordBuf cache in sync */
+    WordBuf[Address / 2] = DataWord;
+#endif
+
+    /* Below FEE_BYTE_RANGE, only log the bytes that have changed */
+    uint8_t byte_mask = 0;
+    if ((uint8_t)oldValue != (uint8_t)DataWord) byte_mask |= 0x01;
+    if ((oldValue >> 8) != (DataWord >> 8)) byte_mask |= 0x02;
+
+    FLASH_Status status = eeprom_store(Address, DataWord, byte_mask);
+    if (status != FLASH_COMPLETE) {
+        eeprom_printf("EEPROM_WriteDataWord [STATUS == %d]\n", status);
+    }
+    return status;
+}
+
+uint8_t EEPROM_ReadDataByte(uint16_t Address) {
+    uint8_t DataByte = 0xFF;
+
+    if (Address < FEE_DENSITY_BYTES) {
+        DataByte = read_word(Address & 0xFFFE) >> ((Address & 1) * 8);
+    }
+
+    eeprom_printf("EEPROM_ReadDataByte(0x%04x): 0x%02x\n", Address, DataByte);
+
+    return DataByte;
+}
+
+uint16_t EEPROM_ReadDataWord(uint16_t Address) {
+    uint16_t DataWord = 0xFFFF;
+
+    if (Address < FEE_DENSITY_BYTES - 1) {
+        /* Check word alignment */
+        if (Address % 2) {
+            DataWord = EEPROM_ReadDataByte(Address) | (EEPROM_ReadDataByte(Address + 1) << 8);
+        } else {
+            DataWord = read_word(Address);
+        }
+    }
+
+    eeprom_printf("EEPROM_ReadDataWord(0x%04x): 0x%04x\n", Address, DataWord);
+
+    return DataWord;
+}
+
+/*****************************************************************************
+ *  Bind to eeprom_driver.c
+ *******************************************************************************/
+void eeprom_driver_init(void) {
+    EEPROM_Init();
+}
+
+void eeprom_driver_erase(void) {
+    EEPROM_Erase();
+}
+
+void eeprom_read_block(void *buf, const void *addr, size_t len) {
+    const uint8_t *src  = (const uint8_t *)addr;
+    uint8_t *      dest = (uint8_t *)buf;
+
+    /* Check word alignment */
+    if (len && (uintptr_t)src % 2) {
+        /* Read the unaligned first byte */
+        *dest++ = EEPROM_ReadDataByte((const uintptr_t)src++);
+        --len;
+    }
+
+    uint16_t value;
+    bool     aligned = ((uintptr_t)dest % 2 == 0);
+    while (len > 1) {
+        value = EEPROM_ReadDataWord((const uintptr_t)((uint16_t *)src));
+        if (aligned) {
+            *(uint16_t *)dest = value;
+            dest += 2;
+        } else {
+            *dest++ = value;
+            *dest++ = value >> 8;
+        }
+        src += 2;
+        len -= 2;
+    }
+    if (len) {
+        *dest = EEPROM_ReadDataByte((const uintptr_t)src);
+    }
+}
+
+void eeprom_write_block(const void *buf, void *addr, size_t len) {
+    uint8_t *      dest = (uint8_t *)addr;
+    const uint8_t *src  = (const uint8_t *)buf;
+
+    /* Check word alignment */
+    if (len && (uintptr_t)dest % 2) {
+        /* Write the unaligned first byte */
+        EEPROM_WriteDataByte((uintptr_t)dest++, *src++);
+        --len;
+    }
+
+    uint16_t value;
+    bool     aligned = ((uintptr_t)src % 2 == 0);
+    while (len > 1) {
+        if (aligned) {
+            value = *(uint16_t *)src;
+        } else {
+            value = *(uint8_t *)src | (*(uint8_t *)(src + 1) << 8);
+        }
+        EEPROM_WriteDataWord((uintptr_t)((uint16_t *)dest), value);
+        dest += 2;
+        src += 2;
+        len -= 2;
+    }
+
+    if (len) {
+        EEPROM_WriteDataByte((uintptr_t)dest, *src);
+    }
+}
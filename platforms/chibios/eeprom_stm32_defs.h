@@ -86,6 +86,23 @@
 #    endif
 #endif
 
+#ifdef EEPROM_STM32_BANKED
+/* Number of banks the pages are split into, each holds a compacted copy and its own write log */
+#    ifndef FEE_BANK_COUNT
+#        define FEE_BANK_COUNT 2
+#    endif
+#    if FEE_BANK_COUNT < 2
+#        error emulated eeprom: FEE_BANK_COUNT must be at least 2
+#    endif
+#    if (FEE_PAGE_COUNT % FEE_BANK_COUNT) != 0
+#        error emulated eeprom: FEE_PAGE_COUNT must be a multiple of FEE_BANK_COUNT
+#    endif
+#    define FEE_BANK_PAGES (FEE_PAGE_COUNT / FEE_BANK_COUNT)
+#    define FEE_BANK_SIZE (FEE_BANK_PAGES * FEE_PAGE_SIZE)
+/* Magic, sequence number, complemented sequence number and commit marker */
+#    define FEE_BANK_HEADER_SIZE 8
+#endif
+
 /* Size of emulated eeprom */
 #ifdef FEE_DENSITY_BYTES
 #    if (FEE_DENSITY_BYTES > FEE_DENSITY_MAX_SIZE)
@@ -104,8 +121,13 @@
 #        error emulated eeprom: FEE_DENSITY_BYTES must be even
 #    endif
 #else
+#    ifdef EEPROM_STM32_BANKED
+/* Default to half of each bank used for emulated eeprom, half for its write log */
+#        define FEE_DENSITY_BYTES ((FEE_BANK_SIZE - FEE_BANK_HEADER_SIZE) / 2)
+#    else
 /* Default to half of allocated space used for emulated eeprom, half for write log */
-#    define FEE_DENSITY_BYTES (FEE_PAGE_COUNT * FEE_PAGE_SIZE / 2)
+#        define FEE_DENSITY_BYTES (FEE_PAGE_COUNT * FEE_PAGE_SIZE / 2)
+#    endif
 #endif
 
 /* Size of write log */
@@ -131,6 +153,42 @@
 /* End of the emulated eeprom write log */
 #define FEE_WRITE_LOG_LAST_ADDRESS (FEE_WRITE_LOG_BASE_ADDRESS + FEE_WRITE_LOG_BYTES)
 
+#ifdef EEPROM_STM32_BANKED
+#    if (FEE_BANK_HEADER_SIZE + FEE_DENSITY_BYTES) >= FEE_BANK_SIZE
+#        pragma message STR(FEE_BANK_HEADER_SIZE) " + " STR(FEE_DENSITY_BYTES) " >= " STR(FEE_BANK_SIZE)
+#        error emulated eeprom: FEE_DENSITY_BYTES leaves no room for a write log in each bank
+#    endif
+/* Size of the write log of each bank */
+#    define FEE_BANK_WRITE_LOG_BYTES (FEE_BANK_SIZE - FEE_BANK_HEADER_SIZE - FEE_DENSITY_BYTES)
+/* Start of a bank, of its compacted flash area, of its write log, and its end */
+#    define FEE_BANK_BASE_ADDRESS(bank) (FEE_PAGE_BASE_ADDRESS + (uintptr_t)(bank)*FEE_BANK_SIZE)
+#    define FEE_BANK_COMPACTED_ADDRESS(bank) (FEE_BANK_BASE_ADDRESS(bank) + FEE_BANK_HEADER_SIZE)
+#    define FEE_BANK_WRITE_LOG_ADDRESS(bank) (FEE_BANK_COMPACTED_ADDRESS(bank) + FEE_DENSITY_BYTES)
+#    define FEE_BANK_LAST_ADDRESS(bank) (FEE_BANK_BASE_ADDRESS(bank) + FEE_BANK_SIZE)
+
+#    define FEE_BANK_MAGIC 0x51EE
+#    define FEE_BANK_COMMITTED 0x0000
+
+/* Write log bytes used before the next bank is compacted into in the background */
+#    ifndef FEE_COMPACTION_THRESHOLD
+#        define FEE_COMPACTION_THRESHOLD (FEE_BANK_WRITE_LOG_BYTES * 3 / 4)
+#    endif
+/* Words copied per EEPROM_Task() call while compacting */
+#    ifndef FEE_COMPACTION_SLICE_WORDS
+#        define FEE_COMPACTION_SLICE_WORDS 32
+#    endif
+#endif
+
+/* Write log encoding. These bits are used for optimizing encoding of bytes, 0 and 1 */
+#define FEE_WORD_ENCODING 0x8000
+#define FEE_VALUE_NEXT 0x6000
+#define FEE_VALUE_RESERVED 0x4000
+#define FEE_VALUE_ENCODED 0x2000
+#define FEE_BYTE_RANGE 0x80
+
+/* Flash word value after erase */
+#define FEE_EMPTY_WORD ((uint16_t)0xFFFF)
+
 #if defined(DYNAMIC_KEYMAP_EEPROM_MAX_ADDR) && (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR >= FEE_DENSITY_BYTES)
 #    error emulated eeprom: DYNAMIC_KEYMAP_EEPROM_MAX_ADDR is greater than the FEE_DENSITY_BYTES available
 #endif
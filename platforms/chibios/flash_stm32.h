@@ -25,7 +25,8 @@ extern "C" {
 #include <stdint.h>
 
 #ifdef FLASH_STM32_MOCKED
-extern uint8_t FlashBuf[MOCK_FLASH_SIZE];
+extern uint8_t  FlashBuf[MOCK_FLASH_SIZE];
+extern uint32_t FlashEraseCount[MOCK_FLASH_SIZE / FEE_PAGE_SIZE];
 #endif
 
 typedef enum { FLASH_BUSY = 1, FLASH_ERROR_PG, FLASH_ERROR_WRP, FLASH_ERROR_OPT, FLASH_COMPLETE, FLASH_TIMEOUT, FLASH_BAD_ADDRESS } FLASH_Status;
@@ -0,0 +1,42 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ch.h>
+#include <hal.h>
+
+#include "chibios_config.h"
+#include "timer.h"
+#include "scan_profiler.h"
+
+#if PORT_SUPPORTS_RT == TRUE && defined(CPU_CLOCK)
+// Core cycle counter
+uint32_t scan_profiler_read_ticks(void) {
+    return chSysGetRealtimeCounterX();
+}
+
+uint32_t scan_profiler_ticks_per_ms(void) {
+    return CPU_CLOCK / 1000;
+}
+#else
+// No cycle counter available, only millisecond resolution
+uint32_t scan_profiler_read_ticks(void) {
+    return timer_read32();
+}
+
+uint32_t scan_profiler_ticks_per_ms(void) {
+    return 1;
+}
+#endif
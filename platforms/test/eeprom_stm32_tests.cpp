@@ -44,9 +44,16 @@ extern "C" {
  *
  */
 
-#define LOG_SIZE EEPROM_SIZE
-#define LOG_BASE (MOCK_FLASH_SIZE - LOG_SIZE)
-#define EEPROM_BASE (LOG_BASE - EEPROM_SIZE)
+#ifdef EEPROM_STM32_BANKED
+/* Bank 0 is the active one after erasing */
+#    define EEPROM_BASE (FEE_BANK_COMPACTED_ADDRESS(0) - (uintptr_t)FlashBuf)
+#    define LOG_SIZE FEE_BANK_WRITE_LOG_BYTES
+#    define LOG_BASE (EEPROM_BASE + EEPROM_SIZE)
+#else
+#    define LOG_SIZE EEPROM_SIZE
+#    define LOG_BASE (MOCK_FLASH_SIZE - LOG_SIZE)
+#    define EEPROM_BASE (LOG_BASE - EEPROM_SIZE)
+#endif
 
 /* Log encoding helpers */
 #define BYTE_VALUE(addr, value) (((addr) << 8) | (value))
@@ -400,6 +407,7 @@ TEST_F(EepromStm32Test, TestBlockRoundTrip) {
     EXPECT_EQ(strcmp((char*)src1, dst1d), 0);
 }
 
+#ifndef EEPROM_STM32_BANKED
 TEST_F(EepromStm32Test, TestCompaction) {
     /* Direct writes */
     eeprom_write_dword((uint32_t*)0, 0xdeadbeef);
@@ -435,3 +443,182 @@ TEST_F(EepromStm32Test, TestCompaction) {
     EXPECT_EQ(*(uint16_t*)&FlashBuf[LOG_BASE], 0xFFFF);
     EXPECT_EQ(*(uint16_t*)&FlashBuf[LOG_BASE + LOG_SIZE - 2], 0xFFFF);
 }
+#endif
+
+#ifdef EEPROM_STM32_BANKED
+/* Enough EEPROM_Task() calls to erase a bank, copy everything and commit */
+#    define COMPACTION_STEPS (FEE_BANK_PAGES + EEPROM_SIZE / 2 + 2)
+
+static int active_bank() {
+    int      bank     = -1;
+    uint16_t sequence = 0;
+    for (int i = 0; i < FEE_BANK_COUNT; i++) {
+        uint16_t* header = (uint16_t*)FEE_BANK_BASE_ADDRESS(i);
+        if (header[0] == FEE_BANK_MAGIC && header[1] == (uint16_t)~header[2] && header[3] == FEE_BANK_COMMITTED && (bank < 0 || (int16_t)(header[1] - sequence) > 0)) {
+            bank     = i;
+            sequence = header[1];
+        }
+    }
+    return bank;
+}
+
+static uint32_t total_erases() {
+    uint32_t total = 0;
+    for (auto count : FlashEraseCount) {
+        total += count;
+    }
+    return total;
+}
+
+/* Word writes >= 0x80 of values > 1 take 4 bytes of write log each, the first one may be direct */
+static void fill_log_to_threshold() {
+    for (uint16_t i = 0; i * 4 < FEE_COMPACTION_THRESHOLD + 4; i++) {
+        eeprom_write_word((uint16_t*)200, 0x1000 + i);
+    }
+}
+
+TEST_F(EepromStm32Test, TestBackgroundCompaction) {
+    eeprom_write_dword((uint32_t*)0, 0xdeadbeef);
+    eeprom_write_dword((uint32_t*)300, 0xcafef00d);
+    fill_log_to_threshold();
+    uint16_t last = eeprom_read_word((uint16_t*)200);
+
+    /* Nothing blocks in the write path */
+    for (int round = 0; round < 2; round++) {
+        int      bank   = active_bank();
+        uint32_t erases = total_erases();
+        for (int i = 0; i < COMPACTION_STEPS; i++) {
+            uint32_t before = total_erases();
+            EEPROM_Task();
+            EXPECT_LE(total_erases() - before, 1u);
+        }
+        EXPECT_EQ(active_bank(), (bank + 1) % FEE_BANK_COUNT);
+        /* The first round goes into a blank bank */
+        if (round == 0) {
+            EXPECT_EQ(total_erases(), erases);
+        }
+
+        EXPECT_EQ(eeprom_read_dword((uint32_t*)0), 0xdeadbeef);
+        EXPECT_EQ(eeprom_read_dword((uint32_t*)300), 0xcafef00d);
+        EXPECT_EQ(eeprom_read_word((uint16_t*)200), last);
+        EEPROM_Init();
+        EXPECT_EQ(eeprom_read_dword((uint32_t*)0), 0xdeadbeef);
+        EXPECT_EQ(eeprom_read_dword((uint32_t*)300), 0xcafef00d);
+        EXPECT_EQ(eeprom_read_word((uint16_t*)200), last);
+
+        fill_log_to_threshold();
+        last = eeprom_read_word((uint16_t*)200);
+    }
+}
+
+TEST_F(EepromStm32Test, TestWritesDuringCompaction) {
+    eeprom_write_word((uint16_t*)2, 0x1234);
+    eeprom_write_word((uint16_t*)(EEPROM_SIZE - 2), 0x5678);
+    fill_log_to_threshold();
+
+    /* Erase, header, then half of the copy */
+    for (int i = 0; i < FEE_BANK_PAGES + EEPROM_SIZE / 4 / FEE_COMPACTION_SLICE_WORDS; i++) {
+        EEPROM_Task();
+    }
+    int bank = active_bank();
+
+    /* Already copied, not copied yet, and bytes below 0x80 */
+    eeprom_write_word((uint16_t*)2, 0xabcd);
+    eeprom_write_byte((uint8_t*)5, 0x42);
+    eeprom_write_word((uint16_t*)(EEPROM_SIZE - 2), 1);
+    eeprom_write_word((uint16_t*)(EEPROM_SIZE - 4), 0x9876);
+
+    /* A reset now keeps the old bank */
+    EEPROM_Init();
+    EXPECT_EQ(active_bank(), bank);
+    EXPECT_EQ(eeprom_read_word((uint16_t*)2), 0xabcd);
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)5), 0x42);
+    EXPECT_EQ(eeprom_read_word((uint16_t*)(EEPROM_SIZE - 2)), 1);
+    EXPECT_EQ(eeprom_read_word((uint16_t*)(EEPROM_SIZE - 4)), 0x9876);
+
+    /* Which compacts again, taking the writes above into account */
+    for (int i = 0; i < FEE_BANK_PAGES + EEPROM_SIZE / 4 / FEE_COMPACTION_SLICE_WORDS; i++) {
+        EEPROM_Task();
+    }
+    eeprom_write_word((uint16_t*)2, 0xef01);
+    eeprom_write_word((uint16_t*)(EEPROM_SIZE - 2), 0x2345);
+    for (int i = 0; i < COMPACTION_STEPS; i++) {
+        EEPROM_Task();
+    }
+    EXPECT_NE(active_bank(), bank);
+    EEPROM_Init();
+    EXPECT_EQ(eeprom_read_word((uint16_t*)2), 0xef01);
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)5), 0x42);
+    EXPECT_EQ(eeprom_read_word((uint16_t*)(EEPROM_SIZE - 2)), 0x2345);
+    EXPECT_EQ(eeprom_read_word((uint16_t*)(EEPROM_SIZE - 4)), 0x9876);
+}
+
+TEST_F(EepromStm32Test, TestFullLogCompactsOnTheSpot) {
+    eeprom_write_dword((uint32_t*)8, 0xdeadbeef);
+    uint16_t i;
+    for (i = 0; i * 4 < FEE_BANK_WRITE_LOG_BYTES + 8; i++) {
+        eeprom_write_word((uint16_t*)200, 0x1000 + i);
+    }
+    EXPECT_EQ(active_bank(), 1);
+    EXPECT_EQ(eeprom_read_word((uint16_t*)200), 0x1000 + i - 1);
+    EXPECT_EQ(eeprom_read_dword((uint32_t*)8), 0xdeadbeef);
+    EEPROM_Init();
+    EXPECT_EQ(eeprom_read_word((uint16_t*)200), 0x1000 + i - 1);
+    EXPECT_EQ(eeprom_read_dword((uint32_t*)8), 0xdeadbeef);
+}
+
+TEST_F(EepromStm32Test, TestRandomWritesAndResets) {
+    static uint8_t model[EEPROM_SIZE];
+    memset(model, 0, sizeof(model));
+
+    uint32_t state     = 1;
+    auto     next      = [&state]() { return (state = state * 1664525 + 1013904223) >> 8; };
+    int      first     = active_bank();
+    bool     compacted = false;
+
+    for (int op = 0; op < 20000; op++) {
+        uint16_t address = next() % (EEPROM_SIZE - 1);
+        uint16_t value   = next() % 4 == 0 ? next() % 2 : next();
+        if (next() % 2) {
+            eeprom_write_byte((uint8_t*)(uintptr_t)address, value);
+            model[address] = value;
+        } else {
+            eeprom_write_word((uint16_t*)(uintptr_t)address, value);
+            model[address]     = value;
+            model[address + 1] = value >> 8;
+        }
+        if (next() % 4 == 0) {
+            EEPROM_Task();
+        }
+        compacted |= active_bank() != first;
+
+        if (op % 2500 == 2499) {
+            EEPROM_Init();
+            for (uint16_t a = 0; a < EEPROM_SIZE; a++) {
+                ASSERT_EQ(EEPROM_ReadDataByte(a), model[a]) << "address " << a << " after operation " << op;
+            }
+        }
+    }
+    EXPECT_TRUE(compacted);
+}
+
+TEST_F(EepromStm32Test, TestErasesRotateOverAllPages) {
+    memset(FlashEraseCount, 0, sizeof(FlashEraseCount));
+    for (int round = 0; round < 4 * FEE_BANK_COUNT; round++) {
+        fill_log_to_threshold();
+        for (int i = 0; i < COMPACTION_STEPS; i++) {
+            EEPROM_Task();
+        }
+    }
+
+    uint32_t low  = UINT32_MAX;
+    uint32_t high = 0;
+    for (int page = 0; page < FEE_PAGE_COUNT; page++) {
+        uint32_t count = FlashEraseCount[(FEE_PAGE_BASE_ADDRESS - (uintptr_t)FlashBuf) / FEE_PAGE_SIZE + page];
+        low            = count < low ? count : low;
+        high           = count > high ? count : high;
+    }
+    EXPECT_GT(low, 0u);
+    EXPECT_LE(high - low, 1u);
+}
+#endif
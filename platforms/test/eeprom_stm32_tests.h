@@ -5,4 +5,9 @@
 #include "flash_stm32.h"
 #include "eeprom_stm32.h"
 
-#define EEPROM_SIZE (FEE_PAGE_SIZE * FEE_PAGE_COUNT / 2)
+#ifdef EEPROM_STM32_BANKED
+#    include "eeprom_stm32_defs.h"
+#    define EEPROM_SIZE (FEE_DENSITY_BYTES)
+#else
+#    define EEPROM_SIZE (FEE_PAGE_SIZE * FEE_PAGE_COUNT / 2)
+#endif
@@ -18,7 +18,8 @@
 #include <stdbool.h>
 #include "flash_stm32.h"
 
-uint8_t FlashBuf[MOCK_FLASH_SIZE] = {0};
+uint8_t  FlashBuf[MOCK_FLASH_SIZE]                         = {0};
+uint32_t FlashEraseCount[MOCK_FLASH_SIZE / FEE_PAGE_SIZE] = {0};
 
 static bool flash_locked = true;
 
@@ -28,6 +29,7 @@ FLASH_Status FLASH_ErasePage(uint32_t Page_Address) {
     Page_Address -= (Page_Address % FEE_PAGE_SIZE);
     if (Page_Address >= MOCK_FLASH_SIZE) return FLASH_BAD_ADDRESS;
     memset(&FlashBuf[Page_Address], '\xff', FEE_PAGE_SIZE);
+    FlashEraseCount[Page_Address / FEE_PAGE_SIZE]++;
     return FLASH_COMPLETE;
 }
 
@@ -22,3 +22,28 @@ eeprom_stm32_SRC := \
 	$(PLATFORM_PATH)/chibios/eeprom_stm32.c
 eeprom_stm32_tiny_SRC := $(eeprom_stm32_SRC)
 eeprom_stm32_large_SRC := $(eeprom_stm32_SRC)
+
+eeprom_stm32_banked_DEFS := $(eeprom_stm32_DEFS) \
+	-DEEPROM_STM32_BANKED \
+	-DFEE_MCU_FLASH_SIZE=8 \
+	-DMOCK_FLASH_SIZE=8192 \
+	-DFEE_PAGE_SIZE=1024 \
+	-DFEE_PAGE_COUNT=4
+eeprom_stm32_banked_lean_DEFS := $(eeprom_stm32_DEFS) \
+	-DEEPROM_STM32_BANKED \
+	-DFEE_NO_RAM_CACHE \
+	-DFEE_MCU_FLASH_SIZE=8 \
+	-DMOCK_FLASH_SIZE=8192 \
+	-DFEE_PAGE_SIZE=1024 \
+	-DFEE_PAGE_COUNT=8 \
+	-DFEE_BANK_COUNT=4
+
+eeprom_stm32_banked_INC := $(eeprom_stm32_INC)
+eeprom_stm32_banked_lean_INC := $(eeprom_stm32_INC)
+
+eeprom_stm32_banked_SRC := \
+	$(TOP_DIR)/drivers/eeprom/eeprom_driver.c \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/eeprom_stm32_tests.cpp \
+	$(PLATFORM_PATH)/$(PLATFORM_KEY)/flash_stm32_mock.c \
+	$(PLATFORM_PATH)/chibios/eeprom_stm32_banked.c
+eeprom_stm32_banked_lean_SRC := $(eeprom_stm32_banked_SRC)
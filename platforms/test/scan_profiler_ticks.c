@@ -0,0 +1,33 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timer.h"
+#include "scan_profiler.h"
+
+static uint32_t extra_ticks = 0;
+
+// One tick per microsecond, on top of the test timer
+uint32_t scan_profiler_read_ticks(void) {
+    return timer_read32() * 1000 + extra_ticks;
+}
+
+uint32_t scan_profiler_ticks_per_ms(void) {
+    return 1000;
+}
+
+void advance_profiler_ticks(uint32_t ticks) {
+    extra_ticks += ticks;
+}
@@ -856,7 +856,11 @@ __attribute__((weak)) void register_code(uint8_t code) {
             // Force a new key press if the key is already pressed
             // without this, keys with the same keycode, but different
             // modifiers will be reported incorrectly, see issue #1708
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+            if (keyboard_bitmap_is_key_pressed(&keyboard_bitmap, code)) {
+#else
             if (is_key_pressed(keyboard_report, code)) {
+#endif
                 del_key(code);
                 send_keyboard_report();
             }
@@ -3,6 +3,9 @@
 #include "action.h"
 #include "util.h"
 #include "action_layer.h"
+#ifdef RESOLVED_LAYER_CACHE
+#    include "matrix.h"
+#endif
 
 #ifdef DEBUG_ACTION
 #    include "debug.h"
@@ -284,6 +287,28 @@ action_t store_or_get_action(bool pressed, keypos_t key) {
 #endif
 }
 
+#if !defined(NO_ACTION_LAYER) && defined(RESOLVED_LAYER_CACHE)
+/** \brief resolved layer cache
+ *
+ * Holds the topmost non-transparent layer of each key for the layer state in
+ * resolved_layer_state. Entries are filled lazily on first lookup, and the
+ * whole table is dropped whenever the effective layer state changes.
+ */
+static uint8_t       resolved_layer_cache[MATRIX_ROWS][MATRIX_COLS];
+static matrix_row_t  resolved_layer_valid[MATRIX_ROWS];
+static layer_state_t resolved_layer_state = 0;
+
+/** \brief clear resolved layer cache
+ *
+ * Must be called whenever the keymap contents change, e.g. on dynamic keymap writes.
+ */
+void resolved_layer_cache_clear(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        resolved_layer_valid[row] = 0;
+    }
+}
+#endif
+
 /** \brief Layer switch get layer
  *
  * Gets the layer based on key info
@@ -294,11 +319,29 @@ uint8_t layer_switch_get_layer(keypos_t key) {
     action.code = ACTION_TRANSPARENT;
 
     layer_state_t layers = layer_state | default_layer_state;
+#    ifdef RESOLVED_LAYER_CACHE
+    const bool cacheable = key.row < MATRIX_ROWS && key.col < MATRIX_COLS;
+    if (cacheable) {
+        if (layers != resolved_layer_state) {
+            resolved_layer_cache_clear();
+            resolved_layer_state = layers;
+        } else if (resolved_layer_valid[key.row] & ((matrix_row_t)1 << key.col)) {
+            return resolved_layer_cache[key.row][key.col];
+        }
+        resolved_layer_valid[key.row] |= ((matrix_row_t)1 << key.col);
+        resolved_layer_cache[key.row][key.col] = 0;
+    }
+#    endif
     /* check top layer first */
     for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
         if (layers & ((layer_state_t)1 << i)) {
             action = action_for_key(i, key);
             if (action.code != ACTION_TRANSPARENT) {
+#    ifdef RESOLVED_LAYER_CACHE
+                if (cacheable) {
+                    resolved_layer_cache[key.row][key.col] = i;
+                }
+#    endif
                 return i;
             }
         }
@@ -34,7 +34,13 @@ static uint8_t suppressed_mods    = 0;
 
 // TODO: pointer variable is not needed
 // report_keyboard_t keyboard_report = {};
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+static report_keyboard_t bitmap_report   = {};
+report_keyboard_t *      keyboard_report = &bitmap_report;
+keyboard_bitmap_t        keyboard_bitmap = {.report = &bitmap_report};
+#else
 report_keyboard_t *keyboard_report = &(report_keyboard_t){};
+#endif
 
 extern inline void add_key(uint8_t key);
 extern inline void del_key(uint8_t key);
@@ -257,7 +263,11 @@ void send_keyboard_report(void) {
         }
 #    endif
         keyboard_report->mods |= oneshot_mods;
+#    ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+        if (keyboard_bitmap_has_anykey(&keyboard_bitmap)) {
+#    else
         if (has_anykey(keyboard_report)) {
+#    endif
             clear_oneshot_mods();
         }
     }
@@ -272,6 +282,14 @@ void send_keyboard_report(void) {
 
 #ifdef PROTOCOL_VUSB
     host_keyboard_send(keyboard_report);
+#elif defined(KEYBOARD_REPORT_BITMAP_ENABLE)
+    static uint8_t last_mods = 0;
+
+    /* The bitmap knows whether the keys changed, so only the mods need comparing. */
+    if (keyboard_bitmap_take_changed(&keyboard_bitmap) || keyboard_report->mods != last_mods) {
+        last_mods = keyboard_report->mods;
+        host_keyboard_send(keyboard_report);
+    }
 #else
     static report_keyboard_t last_report;
 
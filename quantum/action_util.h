@@ -25,20 +25,35 @@ extern "C" {
 #endif
 
 extern report_keyboard_t *keyboard_report;
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+extern keyboard_bitmap_t keyboard_bitmap;
+#endif
 
 void send_keyboard_report(void);
 
 /* key */
 inline void add_key(uint8_t key) {
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+    keyboard_bitmap_add_key(&keyboard_bitmap, key);
+#else
     add_key_to_report(keyboard_report, key);
+#endif
 }
 
 inline void del_key(uint8_t key) {
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+    keyboard_bitmap_del_key(&keyboard_bitmap, key);
+#else
     del_key_from_report(keyboard_report, key);
+#endif
 }
 
 inline void clear_keys(void) {
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+    keyboard_bitmap_clear_keys(&keyboard_bitmap);
+#else
     clear_keys_from_report(keyboard_report);
+#endif
 }
 
 /* modifier */
@@ -52,6 +52,7 @@ typedef struct {
 
 #if DEBOUNCE > 0
 static debounce_counter_t *debounce_counters;
+static matrix_row_t *      debounce_active; // keys locked out after a press or waiting to release
 static fast_timer_t        last_time;
 static bool                counters_need_update;
 static bool                matrix_need_update;
@@ -64,17 +65,23 @@ static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], ui
 // we use num_rows rather than MATRIX_ROWS to support split keyboards
 void debounce_init(uint8_t num_rows) {
     debounce_counters = malloc(num_rows * MATRIX_COLS * sizeof(debounce_counter_t));
+    debounce_active   = malloc(num_rows * sizeof(matrix_row_t));
     int i             = 0;
     for (uint8_t r = 0; r < num_rows; r++) {
         for (uint8_t c = 0; c < MATRIX_COLS; c++) {
             debounce_counters[i++].time = DEBOUNCE_ELAPSED;
         }
+        debounce_active[r] = 0;
     }
+    counters_need_update = false;
+    matrix_need_update   = false;
 }
 
 void debounce_free(void) {
     free(debounce_counters);
     debounce_counters = NULL;
+    free(debounce_active);
+    debounce_active = NULL;
 }
 
 void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
@@ -105,62 +112,69 @@ void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool
 }
 
 static void update_debounce_counters_and_transfer_if_expired(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t elapsed_time) {
-    debounce_counter_t *debounce_pointer = debounce_counters;
-
     counters_need_update = false;
     matrix_need_update   = false;
 
     for (uint8_t row = 0; row < num_rows; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        matrix_row_t active = debounce_active[row];
+        while (active) {
+            uint8_t      col      = __builtin_ctzl(active);
             matrix_row_t col_mask = (ROW_SHIFTER << col);
+            active &= ~col_mask;
+
+            debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS + col];
+            if (debounce_pointer->time <= elapsed_time) {
+                debounce_pointer->time = DEBOUNCE_ELAPSED;
+                debounce_active[row] &= ~col_mask;
 
-            if (debounce_pointer->time != DEBOUNCE_ELAPSED) {
-                if (debounce_pointer->time <= elapsed_time) {
-                    debounce_pointer->time = DEBOUNCE_ELAPSED;
-
-                    if (debounce_pointer->pressed) {
-                        // key-down: eager
-                        matrix_need_update = true;
-                    } else {
-                        // key-up: defer
-                        cooked[row] = (cooked[row] & ~col_mask) | (raw[row] & col_mask);
-                    }
+                if (debounce_pointer->pressed) {
+                    // key-down: eager
+                    matrix_need_update = true;
                 } else {
-                    debounce_pointer->time -= elapsed_time;
-                    counters_need_update = true;
+                    // key-up: defer
+                    cooked[row] = (cooked[row] & ~col_mask) | (raw[row] & col_mask);
                 }
+            } else {
+                debounce_pointer->time -= elapsed_time;
+                counters_need_update = true;
             }
-            debounce_pointer++;
         }
     }
 }
 
 static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows) {
-    debounce_counter_t *debounce_pointer = debounce_counters;
-
     for (uint8_t row = 0; row < num_rows; row++) {
         matrix_row_t delta = raw[row] ^ cooked[row];
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            matrix_row_t col_mask = (ROW_SHIFTER << col);
 
-            if (delta & col_mask) {
-                if (debounce_pointer->time == DEBOUNCE_ELAPSED) {
-                    debounce_pointer->pressed = (raw[row] & col_mask);
-                    debounce_pointer->time    = DEBOUNCE;
-                    counters_need_update      = true;
+        matrix_row_t settled = debounce_active[row] & ~delta;
+        while (settled) {
+            uint8_t      col      = __builtin_ctzl(settled);
+            matrix_row_t col_mask = (ROW_SHIFTER << col);
+            settled &= ~col_mask;
 
-                    if (debounce_pointer->pressed) {
-                        // key-down: eager
-                        cooked[row] ^= col_mask;
-                    }
-                }
-            } else if (debounce_pointer->time != DEBOUNCE_ELAPSED) {
-                if (!debounce_pointer->pressed) {
-                    // key-up: defer
-                    debounce_pointer->time = DEBOUNCE_ELAPSED;
-                }
+            debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS + col];
+            if (!debounce_pointer->pressed) {
+                // key-up: defer
+                debounce_pointer->time = DEBOUNCE_ELAPSED;
+                debounce_active[row] &= ~col_mask;
             }
-            debounce_pointer++;
+        }
+
+        matrix_row_t started = delta & ~debounce_active[row];
+        if (!started) continue;
+
+        debounce_active[row] |= started;
+        counters_need_update = true;
+        // key-down: eager
+        cooked[row] ^= started & raw[row];
+        while (started) {
+            uint8_t      col      = __builtin_ctzl(started);
+            matrix_row_t col_mask = (ROW_SHIFTER << col);
+            started &= ~col_mask;
+
+            debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS + col];
+            debounce_pointer->pressed            = (raw[row] & col_mask);
+            debounce_pointer->time               = DEBOUNCE;
         }
     }
 }
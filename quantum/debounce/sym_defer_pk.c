@@ -46,6 +46,7 @@ typedef uint8_t debounce_counter_t;
 
 #if DEBOUNCE > 0
 static debounce_counter_t *debounce_counters;
+static matrix_row_t *      debounce_active; // keys waiting for their new state to settle
 static fast_timer_t        last_time;
 static bool                counters_need_update;
 
@@ -57,17 +58,22 @@ static void start_debounce_counters(matrix_row_t raw[], matrix_row_t cooked[], u
 // we use num_rows rather than MATRIX_ROWS to support split keyboards
 void debounce_init(uint8_t num_rows) {
     debounce_counters = (debounce_counter_t *)malloc(num_rows * MATRIX_COLS * sizeof(debounce_counter_t));
+    debounce_active   = (matrix_row_t *)malloc(num_rows * sizeof(matrix_row_t));
     int i             = 0;
     for (uint8_t r = 0; r < num_rows; r++) {
         for (uint8_t c = 0; c < MATRIX_COLS; c++) {
             debounce_counters[i++] = DEBOUNCE_ELAPSED;
         }
+        debounce_active[r] = 0;
     }
+    counters_need_update = false;
 }
 
 void debounce_free(void) {
     free(debounce_counters);
     debounce_counters = NULL;
+    free(debounce_active);
+    debounce_active = NULL;
 }
 
 void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
@@ -98,39 +104,50 @@ void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool
 }
 
 static void update_debounce_counters_and_transfer_if_expired(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t elapsed_time) {
-    counters_need_update                 = false;
-    debounce_counter_t *debounce_pointer = debounce_counters;
+    counters_need_update = false;
     for (uint8_t row = 0; row < num_rows; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            if (*debounce_pointer != DEBOUNCE_ELAPSED) {
-                if (*debounce_pointer <= elapsed_time) {
-                    *debounce_pointer = DEBOUNCE_ELAPSED;
-                    cooked[row]       = (cooked[row] & ~(ROW_SHIFTER << col)) | (raw[row] & (ROW_SHIFTER << col));
-                } else {
-                    *debounce_pointer -= elapsed_time;
-                    counters_need_update = true;
-                }
+        matrix_row_t active = debounce_active[row];
+        while (active) {
+            uint8_t      col      = __builtin_ctzl(active);
+            matrix_row_t col_mask = (ROW_SHIFTER << col);
+            active &= ~col_mask;
+
+            debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS + col];
+            if (*debounce_pointer <= elapsed_time) {
+                *debounce_pointer = DEBOUNCE_ELAPSED;
+                debounce_active[row] &= ~col_mask;
+                cooked[row] = (cooked[row] & ~col_mask) | (raw[row] & col_mask);
+            } else {
+                *debounce_pointer -= elapsed_time;
+                counters_need_update = true;
             }
-            debounce_pointer++;
         }
     }
 }
 
 static void start_debounce_counters(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows) {
-    debounce_counter_t *debounce_pointer = debounce_counters;
     for (uint8_t row = 0; row < num_rows; row++) {
         matrix_row_t delta = raw[row] ^ cooked[row];
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            if (delta & (ROW_SHIFTER << col)) {
-                if (*debounce_pointer == DEBOUNCE_ELAPSED) {
-                    *debounce_pointer    = DEBOUNCE;
-                    counters_need_update = true;
-                }
-            } else {
-                *debounce_pointer = DEBOUNCE_ELAPSED;
-            }
-            debounce_pointer++;
+
+        // Keys that bounced back to their debounced state simply drop out of the active set
+        matrix_row_t stopped = debounce_active[row] & ~delta;
+        while (stopped) {
+            uint8_t col = __builtin_ctzl(stopped);
+            stopped &= ~(ROW_SHIFTER << col);
+            debounce_counters[row * MATRIX_COLS + col] = DEBOUNCE_ELAPSED;
+        }
+
+        matrix_row_t started = delta & ~debounce_active[row];
+        if (started) {
+            counters_need_update = true;
         }
+        while (started) {
+            uint8_t col = __builtin_ctzl(started);
+            started &= ~(ROW_SHIFTER << col);
+            debounce_counters[row * MATRIX_COLS + col] = DEBOUNCE;
+        }
+
+        debounce_active[row] = delta;
     }
 }
 
@@ -46,6 +46,7 @@ typedef uint8_t debounce_counter_t;
 
 #if DEBOUNCE > 0
 static debounce_counter_t *debounce_counters;
+static matrix_row_t *      debounce_active; // keys locked out after reporting a change
 static fast_timer_t        last_time;
 static bool                counters_need_update;
 static bool                matrix_need_update;
@@ -58,17 +59,23 @@ static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], ui
 // we use num_rows rather than MATRIX_ROWS to support split keyboards
 void debounce_init(uint8_t num_rows) {
     debounce_counters = (debounce_counter_t *)malloc(num_rows * MATRIX_COLS * sizeof(debounce_counter_t));
+    debounce_active   = (matrix_row_t *)malloc(num_rows * sizeof(matrix_row_t));
     int i             = 0;
     for (uint8_t r = 0; r < num_rows; r++) {
         for (uint8_t c = 0; c < MATRIX_COLS; c++) {
             debounce_counters[i++] = DEBOUNCE_ELAPSED;
         }
+        debounce_active[r] = 0;
     }
+    counters_need_update = false;
+    matrix_need_update   = false;
 }
 
 void debounce_free(void) {
     free(debounce_counters);
     debounce_counters = NULL;
+    free(debounce_active);
+    debounce_active = NULL;
 }
 
 void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
@@ -100,43 +107,43 @@ void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool
 
 // If the current time is > debounce counter, set the counter to enable input.
 static void update_debounce_counters(uint8_t num_rows, uint8_t elapsed_time) {
-    counters_need_update                 = false;
-    matrix_need_update                   = false;
-    debounce_counter_t *debounce_pointer = debounce_counters;
+    counters_need_update = false;
+    matrix_need_update   = false;
     for (uint8_t row = 0; row < num_rows; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            if (*debounce_pointer != DEBOUNCE_ELAPSED) {
-                if (*debounce_pointer <= elapsed_time) {
-                    *debounce_pointer  = DEBOUNCE_ELAPSED;
-                    matrix_need_update = true;
-                } else {
-                    *debounce_pointer -= elapsed_time;
-                    counters_need_update = true;
-                }
+        matrix_row_t active = debounce_active[row];
+        while (active) {
+            uint8_t      col      = __builtin_ctzl(active);
+            matrix_row_t col_mask = (ROW_SHIFTER << col);
+            active &= ~col_mask;
+
+            debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS + col];
+            if (*debounce_pointer <= elapsed_time) {
+                *debounce_pointer = DEBOUNCE_ELAPSED;
+                debounce_active[row] &= ~col_mask;
+                matrix_need_update = true;
+            } else {
+                *debounce_pointer -= elapsed_time;
+                counters_need_update = true;
             }
-            debounce_pointer++;
         }
     }
 }
 
 // upload from raw_matrix to final matrix;
 static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows) {
-    debounce_counter_t *debounce_pointer = debounce_counters;
     for (uint8_t row = 0; row < num_rows; row++) {
-        matrix_row_t delta        = raw[row] ^ cooked[row];
-        matrix_row_t existing_row = cooked[row];
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            matrix_row_t col_mask = (ROW_SHIFTER << col);
-            if (delta & col_mask) {
-                if (*debounce_pointer == DEBOUNCE_ELAPSED) {
-                    *debounce_pointer    = DEBOUNCE;
-                    counters_need_update = true;
-                    existing_row ^= col_mask; // flip the bit.
-                }
-            }
-            debounce_pointer++;
+        // Keys with a running counter don't accept further input
+        matrix_row_t started = (raw[row] ^ cooked[row]) & ~debounce_active[row];
+        if (!started) continue;
+
+        cooked[row] ^= started; // flip the bits.
+        debounce_active[row] |= started;
+        counters_need_update = true;
+        while (started) {
+            uint8_t col = __builtin_ctzl(started);
+            started &= ~(ROW_SHIFTER << col);
+            debounce_counters[row * MATRIX_COLS + col] = DEBOUNCE;
         }
-        cooked[row] = existing_row;
     }
 }
 
@@ -392,3 +392,9 @@ TEST_F(DebounceTest, OneKeyDelayedScan8) {
     time_jumps_ = true;
     runEvents();
 }
+
+TEST_F(DebounceTest, AllKeysBouncingStaggered) {
+    /* Key-down is immediate and ignores the bounce, key-up waits for DEBOUNCE ms after its last bounce */
+    addStaggeredBounces(0, 7);
+    runEvents();
+}
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <map>
 #include <sstream>
 
 extern "C" {
@@ -35,6 +36,37 @@ void DebounceTest::addEvents(std::initializer_list<DebounceTestEvent> events) {
     events_.insert(events_.end(), events.begin(), events.end());
 }
 
+/*
+ * Press and release every key of the matrix with a bounce on each edge, staggered by 3ms per key
+ * so that a large number of counters are running at the same time:
+ *
+ *   press:   DOWN at t, UP at t+1, DOWN at t+2         -> expect DOWN at t+press_latency
+ *   release: UP at t+150, DOWN at t+151, UP at t+152   -> expect UP at t+150+release_latency
+ */
+void DebounceTest::addStaggeredBounces(fast_timer_t press_latency, fast_timer_t release_latency) {
+    std::map<fast_timer_t, std::pair<std::list<MatrixTestEvent>, std::list<MatrixTestEvent>>> timeline;
+
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            fast_timer_t start = (row * MATRIX_COLS + col) * 3;
+
+            timeline[start].first.emplace_back(row, col, DOWN);
+            timeline[start + 1].first.emplace_back(row, col, UP);
+            timeline[start + 2].first.emplace_back(row, col, DOWN);
+            timeline[start + press_latency].second.emplace_back(row, col, DOWN);
+
+            timeline[start + 150].first.emplace_back(row, col, UP);
+            timeline[start + 151].first.emplace_back(row, col, DOWN);
+            timeline[start + 152].first.emplace_back(row, col, UP);
+            timeline[start + 150 + release_latency].second.emplace_back(row, col, UP);
+        }
+    }
+
+    for (auto &entry : timeline) {
+        events_.emplace_back(entry.first, entry.second.first, entry.second.second);
+    }
+}
+
 void DebounceTest::runEvents() {
     /* Run the test multiple times, from 1kHz to 10kHz scan rate */
     for (extra_iterations_ = 0; extra_iterations_ < 10; extra_iterations_++) {
@@ -204,4 +236,6 @@ void DebounceTest::matrixUpdate(matrix_row_t matrix[], const std::string &name,
 
 DebounceTestEvent::DebounceTestEvent(fast_timer_t time, std::initializer_list<MatrixTestEvent> inputs, std::initializer_list<MatrixTestEvent> outputs) : time_(time), inputs_(inputs), outputs_(outputs) {}
 
+DebounceTestEvent::DebounceTestEvent(fast_timer_t time, const std::list<MatrixTestEvent> &inputs, const std::list<MatrixTestEvent> &outputs) : time_(time), inputs_(inputs), outputs_(outputs) {}
+
 MatrixTestEvent::MatrixTestEvent(int row, int col, Direction direction) : row_(row), col_(col), direction_(direction) {}
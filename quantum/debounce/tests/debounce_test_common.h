@@ -43,6 +43,7 @@ class DebounceTestEvent {
    public:
     // 0, {{0, 1, DOWN}}, {{0, 1, DOWN}})
     DebounceTestEvent(fast_timer_t time, std::initializer_list<MatrixTestEvent> inputs, std::initializer_list<MatrixTestEvent> outputs);
+    DebounceTestEvent(fast_timer_t time, const std::list<MatrixTestEvent> &inputs, const std::list<MatrixTestEvent> &outputs);
 
     const fast_timer_t               time_;
     const std::list<MatrixTestEvent> inputs_;
@@ -52,6 +53,7 @@ class DebounceTestEvent {
 class DebounceTest : public ::testing::Test {
    protected:
     void addEvents(std::initializer_list<DebounceTestEvent> events);
+    void addStaggeredBounces(fast_timer_t press_latency, fast_timer_t release_latency);
     void runEvents();
 
     fast_timer_t time_offset_ = 7777;
@@ -238,3 +238,9 @@ TEST_F(DebounceTest, OneKeyDelayedScan4) {
     time_jumps_ = true;
     runEvents();
 }
+
+TEST_F(DebounceTest, AllKeysBouncingStaggered) {
+    /* Every key is only pushed once it has been stable for DEBOUNCE ms after its last bounce */
+    addStaggeredBounces(7, 7);
+    runEvents();
+}
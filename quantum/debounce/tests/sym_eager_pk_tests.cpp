@@ -251,3 +251,9 @@ TEST_F(DebounceTest, OneKeyDelayedScan6) {
     time_jumps_ = true;
     runEvents();
 }
+
+TEST_F(DebounceTest, AllKeysBouncingStaggered) {
+    /* Both edges are immediate and the bounces land while the counter is still running */
+    addStaggeredBounces(0, 0);
+    runEvents();
+}
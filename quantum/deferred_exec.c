@@ -12,107 +12,215 @@
 //------------------------------------
 // Helpers
 //
+// Live executors are kept in a binary min-heap ordered by trigger time, so the next deadline is always at the root.
+// The heap is stored inside the table itself as a permutation of slot indices: heap positions [0, count) hold the
+// slots of live executors, positions [count, table_count) the free ones. Both the permutation and its inverse are
+// stored XORed with the entry index, which makes an all-zero table a valid empty heap without any initialisation.
+// Tokens encode their slot as ((token - 1) % table_count), so lookups by token need no search.
+//
 
 static deferred_token current_token = 0;
 
-static inline bool token_can_be_used(deferred_executor_t *table, size_t table_count, deferred_token token) {
-    if (token == INVALID_DEFERRED_TOKEN) {
-        return false;
+static inline uint16_t heap_slot(deferred_executor_t *table, uint16_t pos) {
+    return table[pos].heap_slot ^ pos;
+}
+
+static inline uint16_t heap_pos(deferred_executor_t *table, uint16_t slot) {
+    return table[slot].heap_pos ^ slot;
+}
+
+static inline void heap_place(deferred_executor_t *table, uint16_t pos, uint16_t slot) {
+    table[pos].heap_slot = slot ^ pos;
+    table[slot].heap_pos = pos ^ slot;
+}
+
+static inline bool heap_before(deferred_executor_t *table, uint16_t slot_a, uint16_t slot_b) {
+    int32_t diff = (int32_t)TIMER_DIFF_32(table[slot_a].trigger_time, table[slot_b].trigger_time);
+    // Executors due at the same time run in table order
+    return diff < 0 || (diff == 0 && slot_a < slot_b);
+}
+
+static inline void heap_swap(deferred_executor_t *table, uint16_t pos_a, uint16_t pos_b) {
+    uint16_t slot_a = heap_slot(table, pos_a);
+    heap_place(table, pos_a, heap_slot(table, pos_b));
+    heap_place(table, pos_b, slot_a);
+}
+
+// Live executors occupy a prefix of the heap, so the count can be found with a binary search
+static uint16_t heap_count(deferred_executor_t *table, size_t table_count) {
+    uint16_t low = 0, high = table_count;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (table[heap_slot(table, mid)].token != INVALID_DEFERRED_TOKEN) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
-    for (int i = 0; i < table_count; ++i) {
-        if (table[i].token == token) {
-            return false;
+    return low;
+}
+
+static uint16_t heap_sift_up(deferred_executor_t *table, uint16_t pos) {
+    while (pos > 0) {
+        uint16_t parent = (pos - 1) / 2;
+        if (!heap_before(table, heap_slot(table, pos), heap_slot(table, parent))) {
+            break;
         }
+        heap_swap(table, pos, parent);
+        pos = parent;
     }
-    return true;
+    return pos;
 }
 
-static inline deferred_token allocate_token(deferred_executor_t *table, size_t table_count) {
-    deferred_token first = ++current_token;
-    while (!token_can_be_used(table, table_count, current_token)) {
-        ++current_token;
-        if (current_token == first) {
-            // If we've looped back around to the first, everything is already allocated (yikes!). Need to exit with a failure.
-            return INVALID_DEFERRED_TOKEN;
+static void heap_sift_down(deferred_executor_t *table, uint16_t count, uint16_t pos) {
+    while (true) {
+        uint16_t first = pos;
+        uint16_t left  = 2 * pos + 1;
+        uint16_t right = left + 1;
+        if (left < count && heap_before(table, heap_slot(table, left), heap_slot(table, first))) {
+            first = left;
+        }
+        if (right < count && heap_before(table, heap_slot(table, right), heap_slot(table, first))) {
+            first = right;
+        }
+        if (first == pos) {
+            break;
         }
+        heap_swap(table, pos, first);
+        pos = first;
     }
+}
+
+// Restores the heap order after the trigger time of the executor at `pos` changed
+static void heap_update(deferred_executor_t *table, size_t table_count, uint16_t pos) {
+    heap_sift_down(table, heap_count(table, table_count), heap_sift_up(table, pos));
+}
+
+static void heap_remove(deferred_executor_t *table, size_t table_count, deferred_executor_t *entry) {
+    uint16_t count = heap_count(table, table_count);
+    uint16_t pos   = heap_pos(table, entry - table);
+
+    // Free up the slot, and move it to the start of the free region
+    entry->token        = INVALID_DEFERRED_TOKEN;
+    entry->trigger_time = 0;
+    entry->callback     = NULL;
+    entry->cb_arg       = NULL;
+    heap_swap(table, pos, --count);
+
+    // The executor that took its place may have to move either way
+    if (pos < count) {
+        heap_sift_down(table, count, heap_sift_up(table, pos));
+    }
+}
+
+static inline deferred_token allocate_token(size_t table_count, uint16_t slot) {
+    // Hand out tokens in increasing order, skipping ahead to the next one that maps to the slot
+    uint32_t limit = (UINT16_MAX / table_count) * table_count;
+    uint32_t token = (uint32_t)current_token + 1;
+    token += (slot + table_count - ((token - 1) % table_count)) % table_count;
+    if (token > limit) {
+        token = slot + 1;
+    }
+    current_token = token;
     return current_token;
 }
 
+static inline deferred_executor_t *find_entry(deferred_executor_t *table, size_t table_count, deferred_token token) {
+    if (token == INVALID_DEFERRED_TOKEN) {
+        return NULL;
+    }
+    deferred_executor_t *entry = &table[(token - 1) % table_count];
+    return entry->token == token ? entry : NULL;
+}
+
+// Finds an executor that is due but has not run yet in the pass at `now`. Due executors form a subtree at the root of
+// the heap, which is walked in pre-order; repeating executors that are still due after running are part of it.
+static deferred_executor_t *next_due_entry(deferred_executor_t *table, uint16_t count, uint32_t now) {
+    uint16_t pos = 0;
+    while (pos < count) {
+        deferred_executor_t *entry = &table[heap_slot(table, pos)];
+        bool                 due   = ((int32_t)TIMER_DIFF_32(entry->trigger_time, now)) <= 0;
+        if (due && entry->last_pass_time != now) {
+            return entry;
+        }
+
+        // Descend into a due subtree, otherwise move on to the right sibling of the nearest left child on the way up
+        if (due && 2 * pos + 1 < count) {
+            pos = 2 * pos + 1;
+            continue;
+        }
+        while (pos > 0 && (pos % 2 == 0 || pos + 1 >= count)) {
+            pos = (pos - 1) / 2;
+        }
+        if (pos == 0) {
+            break;
+        }
+        pos++;
+    }
+    return NULL;
+}
+
 //------------------------------------
 // Advanced API: used when a custom-allocated table is used, primarily for core code.
 //
 
 deferred_token defer_exec_advanced(deferred_executor_t *table, size_t table_count, uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg) {
     // Ignore queueing if the table isn't valid, it's a zero-time delay, or the token is not valid
-    if (!table || table_count == 0 || delay_ms == 0 || !callback) {
+    if (!table || table_count == 0 || table_count > UINT16_MAX || delay_ms == 0 || !callback) {
         return INVALID_DEFERRED_TOKEN;
     }
 
-    // Find an unused slot and claim it
-    for (int i = 0; i < table_count; ++i) {
-        deferred_executor_t *entry = &table[i];
-        if (entry->token == INVALID_DEFERRED_TOKEN) {
-            // Work out the new token value, dropping out if none were available
-            deferred_token token = allocate_token(table, table_count);
-            if (token == INVALID_DEFERRED_TOKEN) {
-                return false;
-            }
-
-            // Set up the executor table entry
-            entry->token        = current_token;
-            entry->trigger_time = timer_read32() + delay_ms;
-            entry->callback     = callback;
-            entry->cb_arg       = cb_arg;
-            return current_token;
-        }
+    // Claim the first free slot, if there are none available then drop out
+    uint16_t count = heap_count(table, table_count);
+    if (count == table_count) {
+        return INVALID_DEFERRED_TOKEN;
     }
+    uint16_t             slot  = heap_slot(table, count);
+    deferred_executor_t *entry = &table[slot];
 
-    // None available
-    return INVALID_DEFERRED_TOKEN;
+    // Set up the executor table entry
+    entry->token          = allocate_token(table_count, slot);
+    entry->last_pass_time = timer_read32();
+    entry->trigger_time   = entry->last_pass_time + delay_ms;
+    entry->callback       = callback;
+    entry->cb_arg         = cb_arg;
+    heap_sift_up(table, count);
+    return entry->token;
 }
 
 bool extend_deferred_exec_advanced(deferred_executor_t *table, size_t table_count, deferred_token token, uint32_t delay_ms) {
     // Ignore queueing if the table isn't valid, it's a zero-time delay, or the token is not valid
-    if (!table || table_count == 0 || delay_ms == 0 || token == INVALID_DEFERRED_TOKEN) {
+    if (!table || table_count == 0 || table_count > UINT16_MAX || delay_ms == 0 || token == INVALID_DEFERRED_TOKEN) {
         return false;
     }
 
     // Find the entry corresponding to the token
-    for (int i = 0; i < table_count; ++i) {
-        deferred_executor_t *entry = &table[i];
-        if (entry->token == token) {
-            // Found it, extend the delay
-            entry->trigger_time = timer_read32() + delay_ms;
-            return true;
-        }
+    deferred_executor_t *entry = find_entry(table, table_count, token);
+    if (!entry) {
+        return false;
     }
 
-    // Not found
-    return false;
+    // Found it, extend the delay
+    entry->trigger_time = timer_read32() + delay_ms;
+    heap_update(table, table_count, heap_pos(table, entry - table));
+    return true;
 }
 
 bool cancel_deferred_exec_advanced(deferred_executor_t *table, size_t table_count, deferred_token token) {
     // Ignore request if the table/token are not valid
-    if (!table || table_count == 0 || token == INVALID_DEFERRED_TOKEN) {
+    if (!table || table_count == 0 || table_count > UINT16_MAX || token == INVALID_DEFERRED_TOKEN) {
         return false;
     }
 
     // Find the entry corresponding to the token
-    for (int i = 0; i < table_count; ++i) {
-        deferred_executor_t *entry = &table[i];
-        if (entry->token == token) {
-            // Found it, cancel and clear the table entry
-            entry->token        = INVALID_DEFERRED_TOKEN;
-            entry->trigger_time = 0;
-            entry->callback     = NULL;
-            entry->cb_arg       = NULL;
-            return true;
-        }
+    deferred_executor_t *entry = find_entry(table, table_count, token);
+    if (!entry) {
+        return false;
     }
 
-    // Not found
-    return false;
+    // Found it, cancel and clear the table entry
+    heap_remove(table, table_count, entry);
+    return true;
 }
 
 void deferred_exec_advanced_task(deferred_executor_t *table, size_t table_count, uint32_t *last_execution_time) {
@@ -122,29 +230,41 @@ void deferred_exec_advanced_task(deferred_executor_t *table, size_t table_count,
     if (((int32_t)TIMER_DIFF_32(now, (*last_execution_time))) > 0) {
         *last_execution_time = now;
 
-        // Run through each of the executors
-        for (int i = 0; i < table_count; ++i) {
-            deferred_executor_t *entry = &table[i];
-
-            // Check if we're supposed to execute this entry
-            if (entry->token != INVALID_DEFERRED_TOKEN && ((int32_t)TIMER_DIFF_32(entry->trigger_time, now)) <= 0) {
-                // Invoke the callback and work work out if we should be requeued
-                uint32_t delay_ms = entry->callback(entry->trigger_time, entry->cb_arg);
-
-                // Update the trigger time if we have to repeat, otherwise clear it out
-                if (delay_ms > 0) {
-                    // Intentionally add just the delay to the existing trigger time -- this ensures the next
-                    // invocation is with respect to the previous trigger, rather than when it got to execution. Under
-                    // normal circumstances this won't cause issue, but if another executor is invoked that takes a
-                    // considerable length of time, then this ensures best-effort timing between invocations.
-                    entry->trigger_time += delay_ms;
-                } else {
-                    // If it was zero, then the callback is cancelling repeated execution. Free up the slot.
-                    entry->token        = INVALID_DEFERRED_TOKEN;
-                    entry->trigger_time = 0;
-                    entry->callback     = NULL;
-                    entry->cb_arg       = NULL;
-                }
+        if (!table || table_count == 0 || table_count > UINT16_MAX) {
+            return;
+        }
+
+        // Only the earliest deadline needs checking while idle, if it's not due then nothing else is
+        deferred_executor_t *root = &table[heap_slot(table, 0)];
+        if (root->token == INVALID_DEFERRED_TOKEN || ((int32_t)TIMER_DIFF_32(root->trigger_time, now)) > 0) {
+            return;
+        }
+
+        // Every due executor runs once per pass, starting with the earliest deadline
+        deferred_executor_t *entry;
+        while ((entry = next_due_entry(table, heap_count(table, table_count), now)) != NULL) {
+            entry->last_pass_time = now;
+
+            // Invoke the callback and work work out if we should be requeued
+            deferred_token token    = entry->token;
+            uint32_t       delay_ms = entry->callback(entry->trigger_time, entry->cb_arg);
+
+            // The callback may have cancelled its own token, in which case the slot is no longer ours
+            if (entry->token != token) {
+                continue;
+            }
+
+            // Update the trigger time if we have to repeat, otherwise clear it out
+            if (delay_ms > 0) {
+                // Intentionally add just the delay to the existing trigger time -- this ensures the next
+                // invocation is with respect to the previous trigger, rather than when it got to execution. Under
+                // normal circumstances this won't cause issue, but if another executor is invoked that takes a
+                // considerable length of time, then this ensures best-effort timing between invocations.
+                entry->trigger_time += delay_ms;
+                heap_update(table, table_count, heap_pos(table, entry - table));
+            } else {
+                // If it was zero, then the callback is cancelling repeated execution. Free up the slot.
+                heap_remove(table, table_count, entry);
             }
         }
     }
@@ -14,7 +14,7 @@
 /**
  * @typedef A token that can be used to cancel or extend an existing deferred execution.
  */
-typedef uint8_t deferred_token;
+typedef uint16_t deferred_token;
 
 /**
  * @def The constant used to denote an invalid deferred execution token.
@@ -79,6 +79,9 @@ typedef struct deferred_executor_t {
     uint32_t               trigger_time;
     deferred_exec_callback callback;
     void *                 cb_arg;
+    uint32_t               last_pass_time;
+    uint16_t               heap_slot;
+    uint16_t               heap_pos;
 } deferred_executor_t;
 
 /**
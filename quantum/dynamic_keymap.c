@@ -73,12 +73,32 @@
 #    error Dynamic keymaps are configured to use more EEPROM than is available.
 #endif
 
+// Macros are read from EEPROM and sent in blocks of this many bytes
+#ifndef DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE
+#    define DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE 32
+#endif
+
 // Dynamic macros are stored after the keymaps and use what is available
 // up to and including DYNAMIC_KEYMAP_EEPROM_MAX_ADDR.
 #ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE
 #    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
 #endif
 
+#ifdef DYNAMIC_KEYMAP_CACHE
+// Only the first layers can be cached, to save RAM on boards with many layers
+#    ifndef DYNAMIC_KEYMAP_CACHE_LAYER_COUNT
+#        define DYNAMIC_KEYMAP_CACHE_LAYER_COUNT DYNAMIC_KEYMAP_LAYER_COUNT
+#    endif
+#    if DYNAMIC_KEYMAP_CACHE_LAYER_COUNT > DYNAMIC_KEYMAP_LAYER_COUNT
+#        error DYNAMIC_KEYMAP_CACHE_LAYER_COUNT must not exceed DYNAMIC_KEYMAP_LAYER_COUNT
+#    endif
+
+// Copy of the cached layers in native byte order, so lookups don't touch the EEPROM.
+// EEPROM stays the backing store, every write goes through to it immediately.
+static uint16_t keymap_cache[DYNAMIC_KEYMAP_CACHE_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS];
+static bool     keymap_cache_loaded = false;
+#endif
+
 uint8_t dynamic_keymap_get_layer_count(void) {
     return DYNAMIC_KEYMAP_LAYER_COUNT;
 }
@@ -88,7 +108,7 @@ void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t c
     return ((void *)DYNAMIC_KEYMAP_EEPROM_ADDR) + (layer * MATRIX_ROWS * MATRIX_COLS * 2) + (row * MATRIX_COLS * 2) + (column * 2);
 }
 
-uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+static uint16_t dynamic_keymap_read_keycode(uint8_t layer, uint8_t row, uint8_t column) {
     void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
     uint16_t keycode = eeprom_read_byte(address) << 8;
@@ -96,11 +116,61 @@ uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column)
     return keycode;
 }
 
+#ifdef DYNAMIC_KEYMAP_CACHE
+static inline bool dynamic_keymap_is_cached(uint8_t layer, uint8_t row, uint8_t column) {
+    return layer < DYNAMIC_KEYMAP_CACHE_LAYER_COUNT && row < MATRIX_ROWS && column < MATRIX_COLS;
+}
+
+void dynamic_keymap_cache_load(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_CACHE_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t column = 0; column < MATRIX_COLS; column++) {
+                keymap_cache[layer][row][column] = dynamic_keymap_read_keycode(layer, row, column);
+            }
+        }
+    }
+    keymap_cache_loaded = true;
+}
+
+// The cache is addressed like the big endian EEPROM buffer
+static uint8_t dynamic_keymap_cache_get_byte(uint16_t offset) {
+    uint16_t keycode = (&keymap_cache[0][0][0])[offset / 2];
+    return (offset & 1) ? keycode & 0xFF : keycode >> 8;
+}
+
+static void dynamic_keymap_cache_set_byte(uint16_t offset, uint8_t value) {
+    uint16_t *keycode = &(&keymap_cache[0][0][0])[offset / 2];
+    if (offset & 1) {
+        *keycode = (*keycode & 0xFF00) | value;
+    } else {
+        *keycode = (*keycode & 0x00FF) | (value << 8);
+    }
+}
+#endif
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+#ifdef DYNAMIC_KEYMAP_CACHE
+    if (dynamic_keymap_is_cached(layer, row, column)) {
+        if (!keymap_cache_loaded) {
+            dynamic_keymap_cache_load();
+        }
+        return keymap_cache[layer][row][column];
+    }
+#endif
+    return dynamic_keymap_read_keycode(layer, row, column);
+}
+
 void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
     void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
     eeprom_update_byte(address, (uint8_t)(keycode >> 8));
     eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+#ifdef DYNAMIC_KEYMAP_CACHE
+    if (keymap_cache_loaded && dynamic_keymap_is_cached(layer, row, column)) {
+        keymap_cache[layer][row][column] = keycode;
+    }
+#endif
+    resolved_layer_cache_clear();
 }
 
 void dynamic_keymap_reset(void) {
@@ -120,9 +190,18 @@ void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
     void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
     uint8_t *target                     = data;
+#ifdef DYNAMIC_KEYMAP_CACHE
+    if (!keymap_cache_loaded) {
+        dynamic_keymap_cache_load();
+    }
+#endif
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < dynamic_keymap_eeprom_size) {
+#ifdef DYNAMIC_KEYMAP_CACHE
+            *target = offset + i < sizeof(keymap_cache) ? dynamic_keymap_cache_get_byte(offset + i) : eeprom_read_byte(source);
+#else
             *target = eeprom_read_byte(source);
+#endif
         } else {
             *target = 0x00;
         }
@@ -139,9 +218,15 @@ void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
         if (offset + i < dynamic_keymap_eeprom_size) {
             eeprom_update_byte(target, *source);
         }
+#ifdef DYNAMIC_KEYMAP_CACHE
+        if (keymap_cache_loaded && offset + i < sizeof(keymap_cache)) {
+            dynamic_keymap_cache_set_byte(offset + i, *source);
+        }
+#endif
         source++;
         target++;
     }
+    resolved_layer_cache_clear();
 }
 
 // This overrides the one in quantum/keymap_common.c
@@ -175,6 +260,19 @@ void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *da
     }
 }
 
+// Offsets of the first DYNAMIC_KEYMAP_MACRO_COUNT macros within the macro buffer,
+// so playback does not have to count NULs from the start of the buffer every time.
+// Only the first macro_index_valid entries are known, the rest is found on demand.
+static uint16_t macro_index[DYNAMIC_KEYMAP_MACRO_COUNT];
+static uint8_t  macro_index_valid = 0;
+
+static void dynamic_keymap_macro_index_invalidate(uint16_t offset) {
+    // A write can only move macros that start after it
+    while (macro_index_valid > 0 && macro_index[macro_index_valid - 1] > offset) {
+        macro_index_valid--;
+    }
+}
+
 void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *source = data;
@@ -185,6 +283,7 @@ void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *da
         source++;
         target++;
     }
+    dynamic_keymap_macro_index_invalidate(offset);
 }
 
 void dynamic_keymap_macro_reset(void) {
@@ -194,6 +293,44 @@ void dynamic_keymap_macro_reset(void) {
         eeprom_update_byte(p, 0);
         ++p;
     }
+    macro_index_valid = 0;
+}
+
+/** \brief Find where macro `id` starts
+ *
+ * Extends the index by scanning the buffer in DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE
+ * blocks from the last known macro.
+ *
+ * \return false if the buffer does not hold that many macros
+ */
+static bool dynamic_keymap_macro_find(uint8_t id, uint16_t *offset) {
+    if (macro_index_valid == 0) {
+        macro_index[0]    = 0;
+        macro_index_valid = 1;
+    }
+
+    uint16_t position = macro_index[macro_index_valid - 1];
+    while (macro_index_valid <= id) {
+        uint8_t  chunk[DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE];
+        uint16_t length = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - position;
+        if (length == 0) {
+            // Not DYNAMIC_KEYMAP_MACRO_COUNT nulls in the buffer, so it is garbage
+            return false;
+        }
+        if (length > sizeof(chunk)) {
+            length = sizeof(chunk);
+        }
+        eeprom_read_block(chunk, (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + position), length);
+        for (uint16_t i = 0; i < length && macro_index_valid <= id; i++) {
+            if (chunk[i] == 0) {
+                macro_index[macro_index_valid++] = position + i + 1;
+            }
+        }
+        position += length;
+    }
+
+    *offset = macro_index[id];
+    return true;
 }
 
 void dynamic_keymap_macro_send(uint8_t id) {
@@ -210,45 +347,60 @@ void dynamic_keymap_macro_send(uint8_t id) {
         return;
     }
 
-    // Skip N null characters
-    // p will then point to the Nth macro
-    p         = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (id > 0) {
-        // If we are past the end of the buffer, then the buffer
-        // contents are garbage, i.e. there were not DYNAMIC_KEYMAP_MACRO_COUNT
-        // nulls in the buffer.
-        if (p == end) {
-            return;
-        }
-        if (eeprom_read_byte(p) == 0) {
-            --id;
-        }
-        ++p;
+    uint16_t offset;
+    if (!dynamic_keymap_macro_find(id, &offset)) {
+        return;
     }
 
-    // Send the macro string one or three chars at a time
-    // by making temporary 1 or 3 char strings
-    char data[4] = {0, 0, 0, 0};
+    // Read the macro in chunks and hand it to send_string() in as few calls as possible.
+    // Tap, down and up codes are stored without the SS_QMK_PREFIX, so those grow by a byte.
+    uint8_t chunk[DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE];
+    char    data[DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE + 4];
+    uint16_t length  = 0;
+    uint8_t  pending = 0; // magic code still waiting for its key, across chunks
+    bool     done    = false;
     // We already checked there was a null at the end of
     // the buffer, so this cannot go past the end
-    while (1) {
-        data[0] = eeprom_read_byte(p++);
-        data[1] = 0;
-        // Stop at the null terminator of this macro string
-        if (data[0] == 0) {
-            break;
+    while (!done) {
+        uint16_t count = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset;
+        if (count > sizeof(chunk)) {
+            count = sizeof(chunk);
         }
-        // If the char is magic (tap, down, up),
-        // add the next char (key to use) and send a 3 char string.
-        if (data[0] == SS_TAP_CODE || data[0] == SS_DOWN_CODE || data[0] == SS_UP_CODE) {
-            data[1] = data[0];
-            data[0] = SS_QMK_PREFIX;
-            data[2] = eeprom_read_byte(p++);
-            if (data[2] == 0) {
+        eeprom_read_block(chunk, (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset), count);
+        offset += count;
+
+        for (uint16_t i = 0; i < count; i++) {
+            uint8_t c = chunk[i];
+            // Stop at the null terminator of this macro string
+            if (c == 0) {
+                done = true;
                 break;
             }
+            if (pending) {
+                data[length++] = SS_QMK_PREFIX;
+                data[length++] = pending;
+                data[length++] = c;
+                pending        = 0;
+            } else if (c == SS_TAP_CODE || c == SS_DOWN_CODE || c == SS_UP_CODE) {
+                // If the char is magic (tap, down, up),
+                // the next char is the key to use
+                pending = c;
+                continue;
+            } else {
+                data[length++] = c;
+            }
+            if (length >= DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE) {
+                data[length] = 0;
+                send_string(data);
+                length = 0;
+            }
+        }
+        if (offset >= DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
+            done = true;
         }
+    }
+    if (length) {
+        data[length] = 0;
         send_string(data);
     }
 }
@@ -34,6 +34,11 @@ void     dynamic_keymap_reset(void);
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 
+#ifdef DYNAMIC_KEYMAP_CACHE
+// Copies the cached layers from EEPROM into RAM. Otherwise that happens on the first lookup.
+void dynamic_keymap_cache_load(void);
+#endif
+
 // This overrides the one in quantum/keymap_common.c
 // uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 
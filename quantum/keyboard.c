@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sendchar.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "scan_profiler.h"
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
@@ -108,6 +109,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef BLUETOOTH_ENABLE
 #    include "outputselect.h"
 #endif
+#ifdef HOST_REPORT_QUEUE_ENABLE
+#    include "host_report_queue.h"
+#endif
+#ifdef I2C_QUEUE_ENABLE
+#    include "i2c_queue.h"
+#endif
+#ifdef EEPROM_STM32_BANKED
+#    include "eeprom_stm32.h"
+#endif
 
 static uint32_t last_input_modification_time = 0;
 uint32_t        last_input_activity_time(void) {
@@ -167,12 +177,11 @@ uint32_t get_matrix_scan_rate(void) {
 #endif
 
 #ifdef MATRIX_HAS_GHOST
-extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
-static matrix_row_t   get_real_keys(uint8_t row, matrix_row_t rowdata) {
+static matrix_row_t get_real_keys(uint8_t row, matrix_row_t rowdata) {
     matrix_row_t out = 0;
     for (uint8_t col = 0; col < MATRIX_COLS; col++) {
         // read each key in the row data and check if the keymap defines it as a real key
-        if (pgm_read_byte(&keymaps[0][row][col]) && (rowdata & (1 << col))) {
+        if ((rowdata & (1 << col)) && keymap_key_to_keycode(0, (keypos_t){.row = row, .col = col})) {
             // this creates new row data, if a key is defined in the keymap, it will be set here
             out |= 1 << col;
         }
@@ -366,6 +375,9 @@ void keyboard_init(void) {
 #ifdef VIA_ENABLE
     via_init();
 #endif
+#if defined(DYNAMIC_KEYMAP_ENABLE) && defined(DYNAMIC_KEYMAP_CACHE)
+    dynamic_keymap_cache_load();
+#endif
 #ifdef SPLIT_KEYBOARD
     split_pre_init();
 #endif
@@ -438,60 +450,79 @@ void switch_events(uint8_t row, uint8_t col, bool pressed) {
 
 /** \brief Perform scan of keyboard matrix
  *
- * Any detected changes in state are sent out as part of the processing
+ * Any detected changes in state are sent out as part of the processing.
+ *
+ * All rows are diffed against the previous state in a single pass, and every
+ * changed key is fed into the action layer in matrix order, stamped with the
+ * time of this scan. A TICK event is only generated when no key was sent to
+ * the action layer, so the tapping/combo state machines advance exactly once
+ * per scan either way, also while ghosted rows are held back.
  */
 bool matrix_scan_task(void) {
     static matrix_row_t matrix_prev[MATRIX_ROWS];
-    matrix_row_t        matrix_row    = 0;
-    matrix_row_t        matrix_change = 0;
-#ifdef QMK_KEYS_PER_SCAN
-    uint8_t keys_processed = 0;
-#endif
 
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_MATRIX_SCAN);
     uint8_t matrix_changed = matrix_scan();
+    SCAN_PROFILE_END(SCAN_PROFILE_MATRIX_SCAN);
     if (matrix_changed) last_matrix_activity_trigger();
 
+    matrix_row_t matrix_change[MATRIX_ROWS];
+    bool         any_change = false;
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_change[r] = matrix_get_row(r) ^ matrix_prev[r];
+        any_change |= (matrix_change[r] != 0);
+    }
+
+    if (!any_change) {
+        // call with pseudo tick event when no real key event.
+        SCAN_PROFILE_BEGIN(SCAN_PROFILE_ACTION_EXEC);
+        action_exec(TICK);
+        SCAN_PROFILE_END(SCAN_PROFILE_ACTION_EXEC);
+        matrix_scan_perf_task();
+        return matrix_changed;
+    }
+
+    if (debug_matrix) matrix_print();
+
+    const bool     process_keypress = should_process_keypress();
+    const uint16_t event_time       = timer_read() | 1; /* time should not be 0 */
+    bool           key_processed    = false;
+
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        matrix_row    = matrix_get_row(r);
-        matrix_change = matrix_row ^ matrix_prev[r];
-        if (matrix_change) {
+        if (!matrix_change[r]) {
+            continue;
+        }
+
+        matrix_row_t matrix_row = matrix_get_row(r);
 #ifdef MATRIX_HAS_GHOST
-            if (has_ghost_in_row(r, matrix_row)) {
-                continue;
-            }
+        if (has_ghost_in_row(r, matrix_row)) {
+            continue;
+        }
 #endif
-            if (debug_matrix) matrix_print();
-            matrix_row_t col_mask = 1;
-            for (uint8_t c = 0; c < MATRIX_COLS; c++, col_mask <<= 1) {
-                if (matrix_change & col_mask) {
-                    if (should_process_keypress()) {
-                        action_exec((keyevent_t){
-                            .key = (keypos_t){.row = r, .col = c}, .pressed = (matrix_row & col_mask), .time = (timer_read() | 1) /* time should not be 0 */
-                        });
-                    }
-                    // record a processed key
-                    matrix_prev[r] ^= col_mask;
-
-                    switch_events(r, c, (matrix_row & col_mask));
-
-#ifdef QMK_KEYS_PER_SCAN
-                    // only jump out if we have processed "enough" keys.
-                    if (++keys_processed >= QMK_KEYS_PER_SCAN)
-#endif
-                        // process a key per task call
-                        goto MATRIX_LOOP_END;
+        matrix_row_t col_mask = 1;
+        for (uint8_t c = 0; c < MATRIX_COLS; c++, col_mask <<= 1) {
+            if (matrix_change[r] & col_mask) {
+                bool pressed = matrix_row & col_mask;
+                if (process_keypress) {
+                    SCAN_PROFILE_BEGIN(SCAN_PROFILE_ACTION_EXEC);
+                    action_exec((keyevent_t){.key = (keypos_t){.row = r, .col = c}, .pressed = pressed, .time = event_time});
+                    SCAN_PROFILE_END(SCAN_PROFILE_ACTION_EXEC);
+                    key_processed = true;
                 }
+
+                switch_events(r, c, pressed);
             }
         }
+
+        // record the processed keys
+        matrix_prev[r] = matrix_row;
     }
-    // call with pseudo tick event when no real key event.
-#ifdef QMK_KEYS_PER_SCAN
-    // we can get here with some keys processed now.
-    if (!keys_processed)
-#endif
-        action_exec(TICK);
 
-MATRIX_LOOP_END:
+    if (!key_processed) {
+        SCAN_PROFILE_BEGIN(SCAN_PROFILE_ACTION_EXEC);
+        action_exec(TICK);
+        SCAN_PROFILE_END(SCAN_PROFILE_ACTION_EXEC);
+    }
 
     matrix_scan_perf_task();
     return matrix_changed;
@@ -576,11 +607,16 @@ void quantum_task(void) {
  * This is repeatedly called as fast as possible.
  */
 void keyboard_task(void) {
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_KEYBOARD_TASK);
+
     bool matrix_changed = matrix_scan_task();
     (void)matrix_changed;
 
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_QUANTUM_TASK);
     quantum_task();
+    SCAN_PROFILE_END(SCAN_PROFILE_QUANTUM_TASK);
 
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_LIGHTING);
 #if defined(RGBLIGHT_ENABLE)
     rgblight_task();
 #endif
@@ -591,6 +627,7 @@ void keyboard_task(void) {
 #ifdef RGB_MATRIX_ENABLE
     rgb_matrix_task();
 #endif
+    SCAN_PROFILE_END(SCAN_PROFILE_LIGHTING);
 
 #if defined(BACKLIGHT_ENABLE)
 #    if defined(BACKLIGHT_PIN) || defined(BACKLIGHT_PINS)
@@ -604,7 +641,9 @@ void keyboard_task(void) {
 #endif
 
 #ifdef OLED_ENABLE
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_OLED);
     oled_task();
+    SCAN_PROFILE_END(SCAN_PROFILE_OLED);
 #    if OLED_TIMEOUT > 0
     // Wake up oled if user is using those fabulous keys or spinning those encoders!
 #        ifdef ENCODER_ENABLE
@@ -662,5 +701,27 @@ void keyboard_task(void) {
     programmable_button_send();
 #endif
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+    send_string_async_task();
+#endif
+
+#ifdef HOST_REPORT_QUEUE_ENABLE
+    host_report_queue_task();
+#endif
+
+#ifdef I2C_QUEUE_ENABLE
+    i2c_queue_task();
+#endif
+
+#ifdef EEPROM_STM32_BANKED
+    // Background compaction of the emulated eeprom
+    EEPROM_Task();
+#endif
+
     led_task();
+
+    SCAN_PROFILE_END(SCAN_PROFILE_KEYBOARD_TASK);
+#ifdef SCAN_PROFILER_ENABLE
+    scan_profiler_task();
+#endif
 }
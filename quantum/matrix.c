@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 #include "matrix.h"
 #include "debounce.h"
+#include "scan_profiler.h"
 #include "quantum.h"
 #ifdef SPLIT_KEYBOARD
 #    include "split_common/split_util.h"
@@ -337,10 +338,14 @@ uint8_t matrix_scan(void) {
     if (changed) memcpy(raw_matrix, curr_matrix, sizeof(curr_matrix));
 
 #ifdef SPLIT_KEYBOARD
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix + thisHand, ROWS_PER_HAND, changed);
+    SCAN_PROFILE_END(SCAN_PROFILE_DEBOUNCE);
     changed = (changed || matrix_post_scan());
 #else
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix, ROWS_PER_HAND, changed);
+    SCAN_PROFILE_END(SCAN_PROFILE_DEBOUNCE);
     matrix_scan_quantum();
 #endif
     return (uint8_t)changed;
@@ -1,6 +1,7 @@
 #include "quantum.h"
 #include "matrix.h"
 #include "debounce.h"
+#include "scan_profiler.h"
 #include "wait.h"
 #include "print.h"
 #include "debug.h"
@@ -169,10 +170,14 @@ __attribute__((weak)) uint8_t matrix_scan(void) {
     bool changed = matrix_scan_custom(raw_matrix);
 
 #ifdef SPLIT_KEYBOARD
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix + thisHand, ROWS_PER_HAND, changed);
+    SCAN_PROFILE_END(SCAN_PROFILE_DEBOUNCE);
     changed = (changed || matrix_post_scan());
 #else
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix, ROWS_PER_HAND, changed);
+    SCAN_PROFILE_END(SCAN_PROFILE_DEBOUNCE);
     matrix_scan_quantum();
 #endif
 
@@ -28,6 +28,7 @@
 #if defined(SPLIT_POINTING_ENABLE)
 #    include "transactions.h"
 #    include "keyboard.h"
+#    include "atomic_util.h"
 
 report_mouse_t shared_mouse_report = {};
 uint16_t       shared_cpi          = 0;
@@ -70,6 +71,165 @@ static report_mouse_t local_mouse_report = {};
 
 extern const pointing_device_driver_t pointing_device_driver;
 
+#if defined(POINTING_DEVICE_HAS_MOTION)
+static pointing_device_motion_t local_motion = {}; // Read from the sensor but not reported yet
+#    if defined(SPLIT_POINTING_ENABLE)
+static pointing_device_motion_t shared_motion = {}; // Received from the other side but not reported yet
+static pointing_device_motion_t motion_total  = {}; // Everything read on this side, wraps around
+
+/**
+ * @brief Gets the running total of motion read on this side
+ *
+ * The target side publishes this in the split transaction. Being a total rather than a delta,
+ * nothing is lost or counted twice however often the transaction runs.
+ *
+ * NOTE : Only available when using SPLIT_POINTING_ENABLE with a sensor reporting motion. Must be
+ * called atomically, as the split transaction handlers are.
+ *
+ * @return pointing_device_motion_t running total
+ */
+pointing_device_motion_t pointing_device_get_motion_total(void) {
+    return motion_total;
+}
+#    endif
+
+/**
+ * @brief Adds motion to an accumulator, saturating at int16_t
+ *
+ * @param[in] accumulated int16_t
+ * @param[in] delta int16_t
+ * @return int16_t sum
+ */
+static inline int16_t pointing_device_motion_add(int16_t accumulated, int16_t delta) {
+    int32_t sum = (int32_t)accumulated + delta;
+    if (sum < INT16_MIN) {
+        return INT16_MIN;
+    } else if (sum > INT16_MAX) {
+        return INT16_MAX;
+    } else {
+        return sum;
+    }
+}
+
+#    if defined(SPLIT_POINTING_ENABLE)
+static pointing_device_motion_t shared_motion_last_total = {};
+static bool                     shared_motion_synced     = false;
+
+/**
+ * @brief Takes the running total of motion received from the other side
+ *
+ * Adds whatever the total moved by since the last call to the motion waiting to be reported. The
+ * first total after pointing_device_resync_shared_motion_total() only sets the starting point.
+ *
+ * NOTE : Only available when using SPLIT_POINTING_ENABLE with a sensor reporting motion
+ *
+ * @param[in] total pointing_device_motion_t
+ */
+void pointing_device_set_shared_motion_total(pointing_device_motion_t total) {
+    if (shared_motion_synced) {
+        pointing_device_motion_t delta = pointing_device_motion_delta(total, shared_motion_last_total);
+
+        shared_motion.x = pointing_device_motion_add(shared_motion.x, delta.x);
+        shared_motion.y = pointing_device_motion_add(shared_motion.y, delta.y);
+    }
+    shared_motion_last_total = total;
+    shared_motion_synced     = true;
+}
+
+/**
+ * @brief Forgets the last total received from the other side
+ *
+ * Call when the other side may have restarted its total, e.g. after it reconnects, so the jump back
+ * to zero isn't reported as motion.
+ *
+ * NOTE : Only available when using SPLIT_POINTING_ENABLE with a sensor reporting motion
+ */
+void pointing_device_resync_shared_motion_total(void) {
+    shared_motion_synced = false;
+}
+#    endif
+
+/**
+ * @brief Takes as much accumulated motion as fits in a report
+ *
+ * @param[in] accumulated int16_t pointer, left holding the remainder
+ * @return int8_t movement for the report
+ */
+static inline int8_t pointing_device_motion_take(int16_t *accumulated) {
+    int8_t movement = *accumulated < -127 ? -127 : (*accumulated > 127 ? 127 : *accumulated);
+    *accumulated -= movement;
+    return movement;
+}
+
+/**
+ * @brief Moves accumulated motion into a mouse report
+ *
+ * @param[in] mouse_report report_mouse_t
+ * @param[in] motion pointing_device_motion_t pointer, left holding what did not fit
+ * @return report_mouse_t with x and y set
+ */
+static report_mouse_t pointing_device_report_motion(report_mouse_t mouse_report, pointing_device_motion_t *motion) {
+    mouse_report.x = pointing_device_motion_take(&motion->x);
+    mouse_report.y = pointing_device_motion_take(&motion->y);
+    return mouse_report;
+}
+
+/**
+ * @brief Reads the sensor when it has motion to report
+ *
+ * Runs on every call of pointing_device_task, independently of the report rate. With
+ * POINTING_DEVICE_MOTION_PIN the sensor is only read while it signals motion, otherwise it is read
+ * once every POINTING_DEVICE_TASK_THROTTLE_MS.
+ */
+static void pointing_device_read_motion(void) {
+#    if defined(SPLIT_POINTING_ENABLE)
+    if (!(POINTING_DEVICE_THIS_SIDE)) {
+        return;
+    }
+#    endif
+#    if defined(POINTING_DEVICE_MOTION_PIN)
+    if (readPin(POINTING_DEVICE_MOTION_PIN)) {
+        return;
+    }
+#    elif (POINTING_DEVICE_TASK_THROTTLE_MS > 0)
+    static uint32_t last_read = 0;
+    if (timer_elapsed32(last_read) < POINTING_DEVICE_TASK_THROTTLE_MS) {
+        return;
+    }
+    last_read = timer_read32();
+#    endif
+
+    pointing_device_motion_t motion = pointing_device_driver.get_motion();
+#    if defined(SPLIT_POINTING_ENABLE)
+    if (!is_keyboard_master()) {
+        ATOMIC_BLOCK_FORCEON {
+            motion_total.x = (uint16_t)motion_total.x + (uint16_t)motion.x;
+            motion_total.y = (uint16_t)motion_total.y + (uint16_t)motion.y;
+        }
+        return;
+    }
+#    endif
+    local_motion.x = pointing_device_motion_add(local_motion.x, motion.x);
+    local_motion.y = pointing_device_motion_add(local_motion.y, motion.y);
+}
+#endif // defined(POINTING_DEVICE_HAS_MOTION)
+
+/**
+ * @brief Gets the report of this side's pointing device
+ *
+ * @param[in] mouse_report report_mouse_t
+ * @return report_mouse_t
+ */
+static report_mouse_t pointing_device_get_local_report(report_mouse_t mouse_report) {
+    if (pointing_device_driver.get_report) {
+        mouse_report = pointing_device_driver.get_report(mouse_report);
+    }
+#if defined(POINTING_DEVICE_HAS_MOTION)
+    mouse_report = pointing_device_report_motion(mouse_report, &local_motion);
+#endif
+    return mouse_report;
+}
+
 /**
  * @brief Compares 2 mouse reports for difference and returns result
  *
@@ -220,6 +380,11 @@ report_mouse_t pointing_device_adjust_by_defines(report_mouse_t mouse_report) {
  *
  */
 __attribute__((weak)) void pointing_device_task(void) {
+#if defined(POINTING_DEVICE_HAS_MOTION)
+    // Keep up with the sensor, whatever the report rate
+    pointing_device_read_motion();
+#endif
+
 #if defined(SPLIT_POINTING_ENABLE)
     // Don't poll the target side pointing device.
     if (!is_keyboard_master()) {
@@ -236,26 +401,31 @@ __attribute__((weak)) void pointing_device_task(void) {
 #endif
 
     // Gather report info
-#ifdef POINTING_DEVICE_MOTION_PIN
+#if defined(POINTING_DEVICE_MOTION_PIN) && !defined(POINTING_DEVICE_HAS_MOTION)
 #    if defined(SPLIT_POINTING_ENABLE)
 #        error POINTING_DEVICE_MOTION_PIN not supported when sharing the pointing device report between sides.
 #    endif
     if (!readPin(POINTING_DEVICE_MOTION_PIN))
 #endif
 
+#if defined(SPLIT_POINTING_ENABLE) && defined(POINTING_DEVICE_HAS_MOTION)
+        // The other side's motion arrives as a running total, its report only carries the buttons
+        shared_mouse_report = pointing_device_report_motion(shared_mouse_report, &shared_motion);
+#endif
+
 #if defined(SPLIT_POINTING_ENABLE)
 #    if defined(POINTING_DEVICE_COMBINED)
         static uint8_t old_buttons = 0;
     local_mouse_report.buttons = old_buttons;
-    local_mouse_report         = pointing_device_driver.get_report(local_mouse_report);
+    local_mouse_report         = pointing_device_get_local_report(local_mouse_report);
     old_buttons                = local_mouse_report.buttons;
 #    elif defined(POINTING_DEVICE_LEFT) || defined(POINTING_DEVICE_RIGHT)
-        local_mouse_report = POINTING_DEVICE_THIS_SIDE ? pointing_device_driver.get_report(local_mouse_report) : shared_mouse_report;
+        local_mouse_report = POINTING_DEVICE_THIS_SIDE ? pointing_device_get_local_report(local_mouse_report) : shared_mouse_report;
 #    else
 #        error "You need to define the side(s) the pointing device is on. POINTING_DEVICE_COMBINED / POINTING_DEVICE_LEFT / POINTING_DEVICE_RIGHT"
 #    endif
 #else
-    local_mouse_report = pointing_device_driver.get_report(local_mouse_report);
+    local_mouse_report = pointing_device_get_local_report(local_mouse_report);
 #endif // defined(SPLIT_POINTING_ENABLE)
 
     // allow kb to intercept and modify report
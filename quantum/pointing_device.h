@@ -21,6 +21,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "host.h"
 #include "report.h"
 
+/* Sensor motion since the last read, in counts. */
+typedef struct {
+    int16_t x;
+    int16_t y;
+} pointing_device_motion_t;
+
+/**
+ * Motion between two readings of a running total that wraps around at the int16_t limits. Valid as
+ * long as less than 32768 counts were added in between.
+ */
+static inline pointing_device_motion_t pointing_device_motion_delta(pointing_device_motion_t total, pointing_device_motion_t last_total) {
+    return (pointing_device_motion_t){
+        .x = (int16_t)((uint16_t)total.x - (uint16_t)last_total.x),
+        .y = (int16_t)((uint16_t)total.y - (uint16_t)last_total.y),
+    };
+}
+
 #if defined(POINTING_DEVICE_DRIVER_adns5050)
 #    include "drivers/sensors/adns5050.h"
 #elif defined(POINTING_DEVICE_DRIVER_adns9800)
@@ -47,14 +64,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #elif defined(POINTING_DEVICE_DRIVER_pmw3360)
 #    include "spi_master.h"
 #    include "drivers/sensors/pmw3360.h"
+#    define POINTING_DEVICE_HAS_MOTION
 #elif defined(POINTING_DEVICE_DRIVER_pmw3389)
 #    include "spi_master.h"
 #    include "drivers/sensors/pmw3389.h"
+#    define POINTING_DEVICE_HAS_MOTION
 #else
 void           pointing_device_driver_init(void);
 report_mouse_t pointing_device_driver_get_report(report_mouse_t mouse_report);
 uint16_t       pointing_device_driver_get_cpi(void);
 void           pointing_device_driver_set_cpi(uint16_t cpi);
+#    ifdef POINTING_DEVICE_HAS_MOTION
+pointing_device_motion_t pointing_device_driver_get_motion(void);
+#    endif
 #endif
 
 typedef struct {
@@ -62,6 +84,7 @@ typedef struct {
     report_mouse_t (*get_report)(report_mouse_t mouse_report);
     void (*set_cpi)(uint16_t);
     uint16_t (*get_cpi)(void);
+    pointing_device_motion_t (*get_motion)(void);
 } pointing_device_driver_t;
 
 typedef enum {
@@ -94,6 +117,11 @@ report_mouse_t pointing_device_adjust_by_defines(report_mouse_t mouse_report);
 #if defined(SPLIT_POINTING_ENABLE)
 void     pointing_device_set_shared_report(report_mouse_t report);
 uint16_t pointing_device_get_shared_cpi(void);
+#    if defined(POINTING_DEVICE_HAS_MOTION)
+void                     pointing_device_set_shared_motion_total(pointing_device_motion_t total);
+void                     pointing_device_resync_shared_motion_total(void);
+pointing_device_motion_t pointing_device_get_motion_total(void);
+#    endif
 #    if !defined(POINTING_DEVICE_TASK_THROTTLE_MS)
 #        define POINTING_DEVICE_TASK_THROTTLE_MS 1
 #    endif
@@ -105,3 +133,12 @@ report_mouse_t pointing_device_task_combined_user(report_mouse_t left_report, re
 report_mouse_t pointing_device_adjust_by_defines_right(report_mouse_t mouse_report);
 #    endif // defined(POINTING_DEVICE_COMBINED)
 #endif     // defined(SPLIT_POINTING_ENABLE)
+
+#if !defined(SPLIT_POINTING_ENABLE) && defined(POINTING_DEVICE_HAS_MOTION) && !defined(POINTING_DEVICE_TASK_THROTTLE_MS)
+// Motion is read as the sensor signals it, reports go out once per host poll
+#    ifdef USB_POLLING_INTERVAL_MS
+#        define POINTING_DEVICE_TASK_THROTTLE_MS USB_POLLING_INTERVAL_MS
+#    else
+#        define POINTING_DEVICE_TASK_THROTTLE_MS 1
+#    endif
+#endif
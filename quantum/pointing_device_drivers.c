@@ -211,35 +211,23 @@ static void pmw3360_device_init(void) {
     pmw3360_init();
 }
 
-report_mouse_t pmw3360_get_report(report_mouse_t mouse_report) {
-    report_pmw3360_t data        = pmw3360_read_burst();
-    static uint16_t  MotionStart = 0; // Timer for accel, 0 is resting state
+static pointing_device_motion_t pmw3360_get_motion(void) {
+    report_pmw3360_t         data   = pmw3360_read_burst();
+    pointing_device_motion_t motion = {0};
 
+    // Full 16 bit deltas, pointing_device_task splits them over as many reports as needed
     if (data.isOnSurface && data.isMotion) {
-        // Reset timer if stopped moving
-        if (!data.isMotion) {
-            if (MotionStart != 0) MotionStart = 0;
-            return mouse_report;
-        }
-
-        // Set timer if new motion
-        if ((MotionStart == 0) && data.isMotion) {
-#    ifdef CONSOLE_ENABLE
-            if (debug_mouse) dprintf("Starting motion.\n");
-#    endif
-            MotionStart = timer_read();
-        }
-        mouse_report.x = constrain_hid(data.dx);
-        mouse_report.y = constrain_hid(data.dy);
+        motion.x = data.dx;
+        motion.y = data.dy;
     }
 
-    return mouse_report;
+    return motion;
 }
 
 // clang-format off
 const pointing_device_driver_t pointing_device_driver = {
     .init       = pmw3360_device_init,
-    .get_report = pmw3360_get_report,
+    .get_motion = pmw3360_get_motion,
     .set_cpi    = pmw3360_set_cpi,
     .get_cpi    = pmw3360_get_cpi
 };
@@ -249,35 +237,23 @@ static void pmw3389_device_init(void) {
     pmw3389_init();
 }
 
-report_mouse_t pmw3389_get_report(report_mouse_t mouse_report) {
-    report_pmw3389_t data        = pmw3389_read_burst();
-    static uint16_t  MotionStart = 0; // Timer for accel, 0 is resting state
+static pointing_device_motion_t pmw3389_get_motion(void) {
+    report_pmw3389_t         data   = pmw3389_read_burst();
+    pointing_device_motion_t motion = {0};
 
+    // Full 16 bit deltas, pointing_device_task splits them over as many reports as needed
     if (data.isOnSurface && data.isMotion) {
-        // Reset timer if stopped moving
-        if (!data.isMotion) {
-            if (MotionStart != 0) MotionStart = 0;
-            return mouse_report;
-        }
-
-        // Set timer if new motion
-        if ((MotionStart == 0) && data.isMotion) {
-#    ifdef CONSOLE_ENABLE
-            if (debug_mouse) dprintf("Starting motion.\n");
-#    endif
-            MotionStart = timer_read();
-        }
-        mouse_report.x = constrain_hid(data.dx);
-        mouse_report.y = constrain_hid(data.dy);
+        motion.x = data.dx;
+        motion.y = data.dy;
     }
 
-    return mouse_report;
+    return motion;
 }
 
 // clang-format off
 const pointing_device_driver_t pointing_device_driver = {
     .init       = pmw3389_device_init,
-    .get_report = pmw3389_get_report,
+    .get_motion = pmw3389_get_motion,
     .set_cpi    = pmw3389_set_cpi,
     .get_cpi    = pmw3389_get_cpi
 };
@@ -291,11 +267,19 @@ __attribute__((weak)) uint16_t pointing_device_driver_get_cpi(void) {
     return 0;
 }
 __attribute__((weak)) void pointing_device_driver_set_cpi(uint16_t cpi) {}
+#    ifdef POINTING_DEVICE_HAS_MOTION
+__attribute__((weak)) pointing_device_motion_t pointing_device_driver_get_motion(void) {
+    return (pointing_device_motion_t){0};
+}
+#    endif
 
 // clang-format off
 const pointing_device_driver_t pointing_device_driver = {
     .init       = pointing_device_driver_init,
     .get_report = pointing_device_driver_get_report,
+#    ifdef POINTING_DEVICE_HAS_MOTION
+    .get_motion = pointing_device_driver_get_motion,
+#    endif
     .get_cpi    = pointing_device_driver_get_cpi,
     .set_cpi    = pointing_device_driver_set_cpi
 };
@@ -90,6 +90,35 @@ static queued_combo_t combo_buffer[COMBO_BUFFER_LENGTH];
 
 #define COMBO_KEY_POS ((keypos_t){.col = 254, .row = 254})
 
+#ifdef COMBO_INDEX_LENGTH
+/* Inverted index from keycode to the combos containing it. Entries are sorted
+ * by keycode, then by combo index, so that the combos of one keycode are
+ * visited in the same order as the linear scan would. */
+typedef struct {
+    uint16_t keycode;
+    uint16_t combo_index;
+    uint8_t  key_index;
+    uint8_t  key_count;
+} combo_index_entry_t;
+static combo_index_entry_t combo_index[COMBO_INDEX_LENGTH];
+static uint16_t            combo_index_size  = 0;
+static bool                combo_index_built = false;
+static bool                combo_index_valid = false;
+
+/* Combos whose state may have changed since the last clear_combos(). */
+static uint16_t combo_touched[COMBO_INDEX_LENGTH];
+static uint16_t combo_touched_count    = 0;
+static bool     combo_touched_overflow = false;
+
+static inline void touch_combo(uint16_t combo_index) {
+    if (combo_touched_count < COMBO_INDEX_LENGTH) {
+        combo_touched[combo_touched_count++] = combo_index;
+    } else {
+        combo_touched_overflow = true;
+    }
+}
+#endif
+
 #ifndef EXTRA_SHORT_COMBOS
 /* flags are their own elements in combo_t struct. */
 #    define COMBO_ACTIVE(combo) (combo->active)
@@ -195,6 +224,20 @@ static inline uint16_t _get_combo_term(uint16_t combo_index, combo_t *combo) {
 void clear_combos(void) {
     uint16_t index = 0;
     longest_term   = 0;
+#ifdef COMBO_INDEX_LENGTH
+    if (combo_index_valid && !combo_touched_overflow) {
+        for (index = 0; index < combo_touched_count; ++index) {
+            combo_t *combo = &key_combos[combo_touched[index]];
+            if (!COMBO_ACTIVE(combo)) {
+                RESET_COMBO_STATE(combo);
+            }
+        }
+        combo_touched_count = 0;
+        return;
+    }
+    combo_touched_count    = 0;
+    combo_touched_overflow = false;
+#endif
     for (index = 0; index < COMBO_LEN; ++index) {
         combo_t *combo = &key_combos[index];
         if (!COMBO_ACTIVE(combo)) {
@@ -405,15 +448,10 @@ static bool keys_pressed_in_order(uint16_t combo_index, combo_t *combo, uint16_t
 }
 #endif
 
-static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record, uint16_t combo_index) {
-    uint8_t  key_count = 0;
-    uint16_t key_index = -1;
-    _find_key_index_and_count(combo->keys, keycode, &key_index, &key_count);
-
-    /* Continue processing if key isn't part of current combo. */
-    if (-1 == (int16_t)key_index) {
-        return false;
-    }
+static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record, uint16_t combo_index, uint16_t key_index, uint8_t key_count) {
+#ifdef COMBO_INDEX_LENGTH
+    touch_combo(combo_index);
+#endif
 
     bool key_is_part_of_combo = (!COMBO_DISABLED(combo) && is_combo_enabled()
 #if defined(COMBO_MUST_PRESS_IN_ORDER) || defined(COMBO_MUST_PRESS_IN_ORDER_PER_COMBO)
@@ -525,9 +563,88 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
     return key_is_part_of_combo;
 }
 
+#ifdef COMBO_INDEX_LENGTH
+static inline bool combo_index_entry_less(combo_index_entry_t *a, combo_index_entry_t *b) {
+    return a->keycode < b->keycode || (a->keycode == b->keycode && a->combo_index < b->combo_index);
+}
+
+/** \brief Build the keycode to combo index
+ *
+ * Runs once, on the first processed key. If the combos hold more keys than
+ * COMBO_INDEX_LENGTH, the index is left invalid and the linear scan is used.
+ */
+static void build_combo_index(void) {
+    combo_index_built = true;
+    combo_index_valid = false;
+    combo_index_size  = 0;
+
+    for (uint16_t idx = 0; idx < COMBO_LEN; ++idx) {
+        const uint16_t *keys      = key_combos[idx].keys;
+        uint16_t        first     = combo_index_size;
+        uint8_t         key_count = 0;
+        uint16_t        key;
+
+        while ((key = pgm_read_word(&keys[key_count])) != COMBO_END) {
+            /* A keycode listed twice within one combo resolves to its last position. */
+            uint16_t i = first;
+            while (i < combo_index_size && combo_index[i].keycode != key) {
+                i++;
+            }
+            if (i == combo_index_size) {
+                if (combo_index_size >= COMBO_INDEX_LENGTH) {
+                    dprintf("combo index too small, falling back to linear scan\n");
+                    return;
+                }
+                combo_index_size++;
+            }
+            combo_index[i] = (combo_index_entry_t){
+                .keycode     = key,
+                .combo_index = idx,
+                .key_index   = key_count,
+            };
+            key_count++;
+        }
+
+        for (uint16_t i = first; i < combo_index_size; ++i) {
+            combo_index[i].key_count = key_count;
+        }
+    }
+
+    /* Shell sort, as the index can hold a few thousand entries. */
+    for (uint16_t gap = combo_index_size / 2; gap > 0; gap /= 2) {
+        for (uint16_t i = gap; i < combo_index_size; ++i) {
+            combo_index_entry_t entry = combo_index[i];
+            uint16_t            j     = i;
+            for (; j >= gap && combo_index_entry_less(&entry, &combo_index[j - gap]); j -= gap) {
+                combo_index[j] = combo_index[j - gap];
+            }
+            combo_index[j] = entry;
+        }
+    }
+
+    combo_index_valid = true;
+}
+
+/** \brief Find the first index entry for keycode
+ *
+ * Returns combo_index_size if no combo contains the keycode.
+ */
+static uint16_t find_combo_index_start(uint16_t keycode) {
+    uint16_t low = 0, high = combo_index_size;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (combo_index[mid].keycode < keycode) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+#endif
+
 bool process_combo(uint16_t keycode, keyrecord_t *record) {
-    bool is_combo_key          = false;
-    bool no_combo_keys_pressed = true;
+    bool is_combo_key = false;
 
     if (keycode == CMB_ON && record->event.pressed) {
         combo_enable();
@@ -549,10 +666,33 @@ bool process_combo(uint16_t keycode, keyrecord_t *record) {
     keycode = keymap_key_to_keycode(COMBO_ONLY_FROM_LAYER, record->event.key);
 #endif
 
-    for (uint16_t idx = 0; idx < COMBO_LEN; ++idx) {
-        combo_t *combo = &key_combos[idx];
-        is_combo_key |= process_single_combo(combo, keycode, record, idx);
-        no_combo_keys_pressed = no_combo_keys_pressed && (NO_COMBO_KEYS_ARE_DOWN || COMBO_ACTIVE(combo) || COMBO_DISABLED(combo));
+#ifdef COMBO_INDEX_LENGTH
+    if (!combo_index_built) {
+        build_combo_index();
+    }
+
+    /* COMBO_END doubles as KC_NO, which the linear scan matches against every combo's terminator. */
+    if (combo_index_valid && keycode != COMBO_END) {
+        for (uint16_t i = find_combo_index_start(keycode); i < combo_index_size && combo_index[i].keycode == keycode; ++i) {
+            combo_index_entry_t *entry = &combo_index[i];
+            is_combo_key |= process_single_combo(&key_combos[entry->combo_index], keycode, record, entry->combo_index, entry->key_index, entry->key_count);
+        }
+    } else
+#endif
+    {
+        for (uint16_t idx = 0; idx < COMBO_LEN; ++idx) {
+            combo_t *combo     = &key_combos[idx];
+            uint8_t  key_count = 0;
+            uint16_t key_index = -1;
+            _find_key_index_and_count(combo->keys, keycode, &key_index, &key_count);
+
+            /* Continue processing if key isn't part of current combo. */
+            if (-1 == (int16_t)key_index) {
+                continue;
+            }
+
+            is_combo_key |= process_single_combo(combo, keycode, record, idx, key_index, key_count);
+        }
     }
 
     if (record->event.pressed && is_combo_key) {
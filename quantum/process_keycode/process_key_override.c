@@ -243,138 +243,292 @@ static bool check_activation_event(const key_override_t *override, const bool ke
     }
 }
 
-/** Iterates through the list of key overrides and tries activating each, until it finds one that activates or reaches the end of overrides. Returns true if the key action for `keycode` should be sent */
-static bool try_activating_override(const uint16_t keycode, const uint8_t layer, const bool key_down, const bool is_mod, const uint8_t active_mods, bool *activated) {
-    if (key_overrides == NULL) {
-        return true;
+/** Tries activating a single override. Returns true if it was activated, in which case `send_key_action` is set to whether the key action for `keycode` should be sent */
+static bool try_activating_single_override(const key_override_t *const override, const uint16_t keycode, const uint8_t layer, const bool key_down, const bool is_mod, const uint8_t active_mods, bool *send_key_action) {
+    // Fast, but not full mods check. Most key presses will not have any mods down, and most overrides will require mods. Hence here we filter overrides that require mods to be down while no mods are down
+    if (active_mods == 0 && override->trigger_mods != 0) {
+        key_override_printf("Not activating override: Modifiers don't match\n");
+        return false;
     }
 
-    for (uint8_t i = 0;; i++) {
-        const key_override_t *const override = key_overrides[i];
+    // Check layer
+    if ((override->layers & (1 << layer)) == 0) {
+        key_override_printf("Not activating override: Not set to activate on pressed layer\n");
+        return false;
+    }
 
-        // End of array
-        if (override == NULL) {
-            break;
-        }
+    // Check allowed activation events
+    if (!check_activation_event(override, key_down, is_mod)) {
+        key_override_printf("Not activating override: Activation event not allowed\n");
+        return false;
+    }
 
-        // Fast, but not full mods check. Most key presses will not have any mods down, and most overrides will require mods. Hence here we filter overrides that require mods to be down while no mods are down
-        if (active_mods == 0 && override->trigger_mods != 0) {
-            key_override_printf("Not activating override: Modifiers don't match\n");
-            continue;
-        }
+    const bool is_trigger = override->trigger == keycode;
 
-        // Check layer
-        if ((override->layers & (1 << layer)) == 0) {
-            key_override_printf("Not activating override: Not set to activate on pressed layer\n");
-            continue;
-        }
+    // Check if trigger lifted. This is a small optimization in order to skip the remaining checks
+    if (is_trigger && !key_down) {
+        key_override_printf("Not activating override: Trigger lifted\n");
+        return false;
+    }
 
-        // Check allowed activation events
-        if (!check_activation_event(override, key_down, is_mod)) {
-            key_override_printf("Not activating override: Activation event not allowed\n");
-            continue;
-        }
+    // If the trigger is KC_NO it means 'no key', so only the required modifiers need to be down.
+    const bool no_trigger = override->trigger == KC_NO;
+
+    // Check if aleady active
+    if (override == active_override) {
+        key_override_printf("Not activating override: Alerady actived\n");
+        return false;
+    }
 
-        const bool is_trigger = override->trigger == keycode;
+    // Check if enabled
+    if (override->enabled != NULL && !((*(override->enabled) & 1))) {
+        key_override_printf("Not activating override: Not enabled\n");
+        return false;
+    }
+
+    // Check mods precisely
+    if (!key_override_matches_active_modifiers(override, active_mods)) {
+        key_override_printf("Not activating override: Modifiers don't match\n");
+        return false;
+    }
 
-        // Check if trigger lifted. This is a small optimization in order to skip the remaining checks
-        if (is_trigger && !key_down) {
-            key_override_printf("Not activating override: Trigger lifted\n");
-            continue;
+    // Check if trigger key is down.
+    const bool trigger_down = is_trigger && key_down;
+
+    // At this point, all requirements for activation are checked, except whether the trigger key is pressed. Now we check if the required trigger is down
+    // If no trigger key is required, yes.
+    // If the trigger was just pressed, yes.
+    // If the last non-mod key that was pressed down is the trigger key, yes.
+    bool should_activate = no_trigger || trigger_down || last_key_down == override->trigger;
+
+    if (!should_activate) {
+        key_override_printf("Not activating override. Trigger not down\n");
+        return false;
+    }
+
+    key_override_printf("Activating override\n");
+
+    clear_active_override(false);
+
+    active_override                 = override;
+    active_override_trigger_is_down = true;
+
+    set_suppressed_override_mods(override->suppressed_mods);
+
+    if (!trigger_down && !no_trigger) {
+        // When activating a key override the trigger is is always unregistered. In the case where the key that newly pressed is not the trigger key, we have to explicitly remove the trigger key from the keyboard report. If the trigger was just pressed down we simply suppress the event which also has the effect of the trigger key not being registered in the keyboard report.
+        if (IS_KEY(override->trigger)) {
+            del_key(override->trigger);
+        } else {
+            unregister_code(override->trigger);
         }
+    }
+
+    const uint16_t mod_free_replacement = clear_mods_from(override->replacement);
 
-        // If the trigger is KC_NO it means 'no key', so only the required modifiers need to be down.
-        const bool no_trigger = override->trigger == KC_NO;
+    bool register_replacement = mod_free_replacement != KC_NO &&   // KC_NO is never registered
+                                mod_free_replacement < SAFE_RANGE; // Custom keycodes are never registered
 
-        // Check if aleady active
-        if (override == active_override) {
-            key_override_printf("Not activating override: Alerady actived\n");
-            continue;
+    // Try firing the custom handler
+    if (override->custom_action != NULL) {
+        register_replacement &= override->custom_action(true, override->context);
+    }
+
+    if (register_replacement) {
+        const uint8_t override_mods = extract_mod_bits(override->replacement);
+        set_weak_override_mods(override_mods);
+
+        // If this is a modifier event that activates the key override we _always_ defer the actual full activation of the override
+        if (is_mod) {
+            key_override_printf("Deferring register replacement key\n");
+            schedule_deferred_register(mod_free_replacement);
+            send_keyboard_report();
+        } else {
+            if (IS_KEY(mod_free_replacement)) {
+                add_key(mod_free_replacement);
+            } else {
+                key_override_printf("NOT KEY 2\n");
+                send_keyboard_report();
+                // On macOS there seems to be a race condition when it comes to the keyboard report and consumer keycodes. It seems the OS may recognize a consumer keycode before an updated keyboard report, even if the keyboard report is actually sent before the consumer key. I assume it is some sort of race condition because it happens infrequently and very irregularly. Waiting for about at least 10ms between sending the keyboard report and sending the consumer code has shown to fix this.
+                wait_ms(10);
+                register_code(mod_free_replacement);
+            }
         }
+    } else {
+        // If not registering the replacement key send keyboard report to update the unregistered keys.
+        send_keyboard_report();
+    }
+
+    // If the trigger is down, suppress the event so that it does not get added to the keyboard report.
+    *send_key_action = !trigger_down;
+    return true;
+}
+#ifdef KEY_OVERRIDE_INDEX_LENGTH
+/* Index of the key overrides, sorted by trigger keycode and then by position in key_overrides, so that KC_NO (mods only) overrides form a bucket of their own. The mod masks are precomputed, candidates that cannot match are skipped without touching the override itself. */
+typedef struct {
+    uint16_t trigger;
+    uint8_t  position;
+    uint8_t  options;
+    uint8_t  trigger_mods;
+    uint8_t  one_sided_required_mods;
+    uint8_t  negative_mod_mask;
+} key_override_index_entry_t;
+static key_override_index_entry_t key_override_index[KEY_OVERRIDE_INDEX_LENGTH];
+static uint8_t                    key_override_index_size   = 0;
+static bool                       key_override_index_valid  = false;
+static const key_override_t **    key_override_index_source = NULL;
+
+static inline bool key_override_index_entry_less(const key_override_index_entry_t *a, const key_override_index_entry_t *b) {
+    return a->trigger < b->trigger || (a->trigger == b->trigger && a->position < b->position);
+}
 
-        // Check if enabled
-        if (override->enabled != NULL && !((*(override->enabled) & 1))) {
-            key_override_printf("Not activating override: Not enabled\n");
-            continue;
+/** \brief Build the trigger keycode to key override index
+ *
+ * Runs on the first processed key, and again whenever key_overrides points to another array. If there are more than KEY_OVERRIDE_INDEX_LENGTH overrides, the index is left invalid and the linear scan is used.
+ */
+static void build_key_override_index(void) {
+    key_override_index_source = key_overrides;
+    key_override_index_valid  = false;
+    key_override_index_size   = 0;
+
+    for (uint8_t i = 0; key_overrides[i] != NULL; i++) {
+        if (key_override_index_size >= KEY_OVERRIDE_INDEX_LENGTH || i == UINT8_MAX) {
+            key_override_printf("Key override index too small, falling back to linear scan\n");
+            return;
         }
 
-        // Check mods precisely
-        if (!key_override_matches_active_modifiers(override, active_mods)) {
-            key_override_printf("Not activating override: Modifiers don't match\n");
-            continue;
+        const key_override_t *const override = key_overrides[i];
+
+        ko_option_t options = override->options;
+        if ((options & ko_options_all_activations) == 0) {
+            options |= ko_options_all_activations;
         }
 
-        // Check if trigger key is down.
-        const bool trigger_down = is_trigger && key_down;
+        key_override_index[key_override_index_size++] = (key_override_index_entry_t){
+            .trigger                 = override->trigger,
+            .position                = i,
+            .options                 = options,
+            .trigger_mods            = override->trigger_mods,
+            .one_sided_required_mods = (override->trigger_mods & 0b1111) | (override->trigger_mods >> 4),
+            .negative_mod_mask       = override->negative_mod_mask,
+        };
+    }
+
+    for (uint8_t i = 1; i < key_override_index_size; i++) {
+        key_override_index_entry_t entry = key_override_index[i];
+        uint8_t                    j     = i;
+        for (; j > 0 && key_override_index_entry_less(&entry, &key_override_index[j - 1]); j--) {
+            key_override_index[j] = key_override_index[j - 1];
+        }
+        key_override_index[j] = entry;
+    }
 
-        // At this point, all requirements for activation are checked, except whether the trigger key is pressed. Now we check if the required trigger is down
-        // If no trigger key is required, yes.
-        // If the trigger was just pressed, yes.
-        // If the last non-mod key that was pressed down is the trigger key, yes.
-        bool should_activate = no_trigger || trigger_down || last_key_down == override->trigger;
+    key_override_index_valid = true;
+}
 
-        if (!should_activate) {
-            key_override_printf("Not activating override. Trigger not down\n");
-            continue;
+/** \brief Find the first index entry for trigger */
+static uint8_t find_key_override_index_start(const uint16_t trigger) {
+    uint8_t low = 0, high = key_override_index_size;
+    while (low < high) {
+        uint8_t mid = low + (high - low) / 2;
+        if (key_override_index[mid].trigger < trigger) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
+    }
+    return low;
+}
 
-        key_override_printf("Activating override\n");
+/** \brief Same checks as key_override_matches_active_modifiers() and check_activation_event(), on the precomputed masks */
+static bool key_override_index_entry_matches(const key_override_index_entry_t *entry, const uint8_t activation, const uint8_t active_mods) {
+    if ((entry->options & activation) == 0 || (entry->negative_mod_mask & active_mods) != 0) {
+        return false;
+    }
 
-        clear_active_override(false);
+    if (entry->trigger_mods == 0) {
+        return true;
+    }
 
-        active_override                 = override;
-        active_override_trigger_is_down = true;
+    const uint8_t active_required_mods = entry->trigger_mods & active_mods;
+    if ((entry->options & ko_option_one_mod) != 0) {
+        return active_required_mods != 0;
+    }
+    return ((active_required_mods & 0b1111) | (active_required_mods >> 4)) == entry->one_sided_required_mods;
+}
+#endif
 
-        set_suppressed_override_mods(override->suppressed_mods);
+/** Iterates through the list of key overrides and tries activating each, until it finds one that activates or reaches the end of overrides. Returns true if the key action for `keycode` should be sent */
+static bool try_activating_override(const uint16_t keycode, const uint8_t layer, const bool key_down, const bool is_mod, const uint8_t active_mods, bool *activated) {
+    bool send_key_action = true;
 
-        if (!trigger_down && !no_trigger) {
-            // When activating a key override the trigger is is always unregistered. In the case where the key that newly pressed is not the trigger key, we have to explicitly remove the trigger key from the keyboard report. If the trigger was just pressed down we simply suppress the event which also has the effect of the trigger key not being registered in the keyboard report.
-            if (IS_KEY(override->trigger)) {
-                del_key(override->trigger);
-            } else {
-                unregister_code(override->trigger);
-            }
-        }
+    if (key_overrides == NULL) {
+        return true;
+    }
 
-        const uint16_t mod_free_replacement = clear_mods_from(override->replacement);
+#ifdef KEY_OVERRIDE_INDEX_LENGTH
+    if (key_overrides != key_override_index_source) {
+        build_key_override_index();
+    }
 
-        bool register_replacement = mod_free_replacement != KC_NO &&   // KC_NO is never registered
-                                    mod_free_replacement < SAFE_RANGE; // Custom keycodes are never registered
+    if (key_override_index_valid) {
+        // Only mods-only overrides, those triggered by this key going down and those triggered by the last key held down can activate
+        const uint16_t triggers[3] = {KC_NO, key_down ? keycode : KC_NO, last_key_down};
+        uint8_t        next[3], end[3];
 
-        // Try firing the custom handler
-        if (override->custom_action != NULL) {
-            register_replacement &= override->custom_action(true, override->context);
+        for (uint8_t b = 0; b < 3; b++) {
+            next[b] = end[b] = 0;
+            if (b > 0 && (triggers[b] == KC_NO || triggers[b] == triggers[b - 1] || triggers[b] == triggers[0])) {
+                continue;
+            }
+            next[b] = end[b] = find_key_override_index_start(triggers[b]);
+            while (end[b] < key_override_index_size && key_override_index[end[b]].trigger == triggers[b]) {
+                end[b]++;
+            }
         }
 
-        if (register_replacement) {
-            const uint8_t override_mods = extract_mod_bits(override->replacement);
-            set_weak_override_mods(override_mods);
+        const uint8_t activation = is_mod ? (key_down ? ko_option_activation_required_mod_down : ko_option_activation_negative_mod_up) : (key_down ? ko_option_activation_trigger_down : 0);
 
-            // If this is a modifier event that activates the key override we _always_ defer the actual full activation of the override
-            if (is_mod) {
-                key_override_printf("Deferring register replacement key\n");
-                schedule_deferred_register(mod_free_replacement);
-                send_keyboard_report();
-            } else {
-                if (IS_KEY(mod_free_replacement)) {
-                    add_key(mod_free_replacement);
-                } else {
-                    key_override_printf("NOT KEY 2\n");
-                    send_keyboard_report();
-                    // On macOS there seems to be a race condition when it comes to the keyboard report and consumer keycodes. It seems the OS may recognize a consumer keycode before an updated keyboard report, even if the keyboard report is actually sent before the consumer key. I assume it is some sort of race condition because it happens infrequently and very irregularly. Waiting for about at least 10ms between sending the keyboard report and sending the consumer code has shown to fix this.
-                    wait_ms(10);
-                    register_code(mod_free_replacement);
+        // Merge the buckets by position, so overrides are tried in the same order as the linear scan
+        while (true) {
+            int8_t best = -1;
+            for (uint8_t b = 0; b < 3; b++) {
+                if (next[b] < end[b] && (best < 0 || key_override_index[next[b]].position < key_override_index[next[best]].position)) {
+                    best = b;
                 }
             }
-        } else {
-            // If not registering the replacement key send keyboard report to update the unregistered keys.
-            send_keyboard_report();
+            if (best < 0) {
+                break;
+            }
+
+            const key_override_index_entry_t *entry = &key_override_index[next[best]++];
+            if (!key_override_index_entry_matches(entry, activation, active_mods)) {
+                continue;
+            }
+
+            if (try_activating_single_override(key_overrides[entry->position], keycode, layer, key_down, is_mod, active_mods, &send_key_action)) {
+                *activated = true;
+                return send_key_action;
+            }
         }
 
-        *activated = true;
+        *activated = false;
+        return true;
+    }
+#endif
+
+    for (uint8_t i = 0;; i++) {
+        const key_override_t *const override = key_overrides[i];
 
-        // If the trigger is down, suppress the event so that it does not get added to the keyboard report.
-        return !trigger_down;
+        // End of array
+        if (override == NULL) {
+            break;
+        }
+
+        if (try_activating_single_override(override, keycode, layer, key_down, is_mod, active_mods, &send_key_action)) {
+            *activated = true;
+            return send_key_action;
+        }
     }
 
     *activated = false;
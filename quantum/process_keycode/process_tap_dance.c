@@ -19,9 +19,31 @@
 uint8_t get_oneshot_mods(void);
 #endif
 
+#ifndef TAP_DANCE_MAX_SIMULTANEOUS
+#    define TAP_DANCE_MAX_SIMULTANEOUS 8
+#endif
+
 static uint16_t last_td;
 static int16_t  highest_td = -1;
 
+/* Dances with a non-zero count, sorted by index so they are interrupted in
+ * the same order as tap_dance_actions. The deadline is fixed when the key
+ * goes down; dances that already timed out but are still held have none. */
+typedef struct {
+    uint8_t  index;
+    bool     has_deadline;
+    uint16_t deadline;
+} active_tap_dance_t;
+
+static active_tap_dance_t active_tds[TAP_DANCE_MAX_SIMULTANEOUS];
+static uint8_t            active_td_count = 0;
+/* Set when more dances were in flight than fit, the full table is scanned until they are all done. */
+static bool active_td_overflow = false;
+
+/* Earliest deadline of all active dances, the only timer checked every scan. */
+static bool     next_deadline_set = false;
+static uint16_t next_deadline     = 0;
+
 void qk_tap_dance_pair_on_each_tap(qk_tap_dance_state_t *state, void *user_data) {
     qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
 
@@ -106,6 +128,78 @@ static inline void process_tap_dance_action_on_reset(qk_tap_dance_action_t *acti
     send_keyboard_report();
 }
 
+static uint16_t get_tap_dance_term(qk_tap_dance_action_t *action) {
+    if (action->custom_tapping_term > 0) {
+        return action->custom_tapping_term;
+    }
+#ifdef TAPPING_TERM_PER_KEY
+    return get_tapping_term(action->state.keycode, &(keyrecord_t){});
+#else
+    return TAPPING_TERM;
+#endif
+}
+
+static void update_next_deadline(void) {
+    next_deadline_set = false;
+    for (uint8_t i = 0; i < active_td_count; i++) {
+        if (!active_tds[i].has_deadline) continue;
+        if (!next_deadline_set || timer_expired(next_deadline, active_tds[i].deadline)) {
+            next_deadline = active_tds[i].deadline;
+        }
+        next_deadline_set = true;
+    }
+}
+
+static void track_tap_dance(uint8_t index, uint16_t deadline) {
+    uint8_t i = 0;
+    while (i < active_td_count && active_tds[i].index < index) {
+        i++;
+    }
+    if (i == active_td_count || active_tds[i].index != index) {
+        if (active_td_count >= TAP_DANCE_MAX_SIMULTANEOUS) {
+            active_td_overflow = true;
+            return;
+        }
+        for (uint8_t j = active_td_count; j > i; j--) {
+            active_tds[j] = active_tds[j - 1];
+        }
+        active_td_count++;
+        active_tds[i].index = index;
+    }
+    active_tds[i].has_deadline = true;
+    active_tds[i].deadline     = deadline;
+    update_next_deadline();
+}
+
+static void untrack_tap_dance(uint8_t index) {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < active_td_count; i++) {
+        if (active_tds[i].index != index) {
+            active_tds[count++] = active_tds[i];
+        }
+    }
+    if (count != active_td_count) {
+        active_td_count = count;
+        update_next_deadline();
+    }
+}
+
+static void interrupt_tap_dance(qk_tap_dance_action_t *action, uint16_t keycode) {
+    action->state.interrupted          = true;
+    action->state.interrupting_keycode = keycode;
+    process_tap_dance_action_on_dance_finished(action);
+    reset_tap_dance(&action->state);
+
+    // Tap dance actions can leave some weak mods active (e.g., if the tap dance is mapped to a keycode with
+    // modifiers), but these weak mods should not affect the keypress which interrupted the tap dance.
+    clear_weak_mods();
+}
+
+static void time_out_tap_dance(qk_tap_dance_action_t *action) {
+    process_tap_dance_action_on_dance_finished(action);
+    reset_tap_dance(&action->state);
+}
+
 void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
     qk_tap_dance_action_t *action;
 
@@ -113,18 +207,26 @@ void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
     if (highest_td == -1) return;
 
-    for (int i = 0; i <= highest_td; i++) {
-        action = &tap_dance_actions[i];
-        if (action->state.count) {
-            if (keycode == action->state.keycode && keycode == last_td) continue;
-            action->state.interrupted          = true;
-            action->state.interrupting_keycode = keycode;
-            process_tap_dance_action_on_dance_finished(action);
-            reset_tap_dance(&action->state);
-
-            // Tap dance actions can leave some weak mods active (e.g., if the tap dance is mapped to a keycode with
-            // modifiers), but these weak mods should not affect the keypress which interrupted the tap dance.
-            clear_weak_mods();
+    if (active_td_overflow) {
+        for (int i = 0; i <= highest_td; i++) {
+            action = &tap_dance_actions[i];
+            if (action->state.count) {
+                if (keycode == action->state.keycode && keycode == last_td) continue;
+                interrupt_tap_dance(action, keycode);
+            }
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < active_td_count;) {
+        uint8_t index = active_tds[i].index;
+        action        = &tap_dance_actions[index];
+        if (action->state.count && !(keycode == action->state.keycode && keycode == last_td)) {
+            interrupt_tap_dance(action, keycode);
+        }
+        // Interrupting resets the dance, which removes it from the active list
+        if (i < active_td_count && active_tds[i].index == index) {
+            i++;
         }
     }
 }
@@ -150,6 +252,7 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 #endif
                 action->state.weak_mods = get_mods();
                 action->state.weak_mods |= get_weak_mods();
+                track_tap_dance(idx, action->state.timer + get_tap_dance_term(action) + 1);
                 process_tap_dance_action_on_each_tap(action);
 
                 last_td = keycode;
@@ -167,24 +270,44 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
 void tap_dance_task() {
     if (highest_td == -1) return;
-    uint16_t tap_user_defined;
 
-    for (uint8_t i = 0; i <= highest_td; i++) {
-        qk_tap_dance_action_t *action = &tap_dance_actions[i];
-        if (action->custom_tapping_term > 0) {
-            tap_user_defined = action->custom_tapping_term;
-        } else {
-#ifdef TAPPING_TERM_PER_KEY
-            tap_user_defined = get_tapping_term(action->state.keycode, &(keyrecord_t){});
-#else
-            tap_user_defined = TAPPING_TERM;
-#endif
+    if (active_td_overflow) {
+        bool active = false;
+        for (int i = 0; i <= highest_td; i++) {
+            qk_tap_dance_action_t *action = &tap_dance_actions[i];
+            if (action->state.count && timer_elapsed(action->state.timer) > get_tap_dance_term(action)) {
+                time_out_tap_dance(action);
+            }
+            active |= action->state.count != 0;
+        }
+        if (!active) {
+            active_td_overflow = false;
+            active_td_count    = 0;
+            update_next_deadline();
+        }
+        return;
+    }
+
+    if (!next_deadline_set) return;
+
+    uint16_t now = timer_read();
+    if (!timer_expired(now, next_deadline)) return;
+
+    for (uint8_t i = 0; i < active_td_count;) {
+        uint8_t index = active_tds[i].index;
+        if (!active_tds[i].has_deadline || !timer_expired(now, active_tds[i].deadline)) {
+            i++;
+            continue;
         }
-        if (action->state.count && timer_elapsed(action->state.timer) > tap_user_defined) {
-            process_tap_dance_action_on_dance_finished(action);
-            reset_tap_dance(&action->state);
+
+        // A dance that is still held stays active without a deadline, it is reset when released
+        active_tds[i].has_deadline = false;
+        time_out_tap_dance(&tap_dance_actions[index]);
+        if (i < active_td_count && active_tds[i].index == index) {
+            i++;
         }
     }
+    update_next_deadline();
 }
 
 void reset_tap_dance(qk_tap_dance_state_t *state) {
@@ -201,4 +324,6 @@ void reset_tap_dance(qk_tap_dance_state_t *state) {
     state->finished             = false;
     state->interrupting_keycode = 0;
     last_td                     = 0;
+
+    untrack_tap_dance(state->keycode - QK_TAP_DANCE);
 }
@@ -198,118 +198,166 @@ void post_process_record_quantum(keyrecord_t *record) {
     post_process_record_kb(keycode, record);
 }
 
-/* Core keycode function, hands off handling to other functions,
-    then processes internal quantum keycodes, and then processes
-    ACTIONs.                                                      */
-bool process_record_quantum(keyrecord_t *record) {
-    uint16_t keycode = get_record_keycode(record, true);
-
-    // This is how you use actions here
-    // if (keycode == KC_LEAD) {
-    //   action_t action;
-    //   action.code = ACTION_DEFAULT_LAYER_SET(0);
-    //   process_action(record, action);
-    //   return false;
-    // }
-
-#ifdef VELOCIKEY_ENABLE
-    if (velocikey_enabled() && record->event.pressed) {
-        velocikey_accelerate();
-    }
+#ifdef KEY_OVERRIDE_ENABLE
+static bool process_key_override_handler(uint16_t keycode, keyrecord_t *record) {
+    return process_key_override(keycode, record);
+}
 #endif
 
-#ifdef WPM_ENABLE
-    if (record->event.pressed) {
-        update_wpm(keycode);
-    }
+#if defined(RGBLIGHT_ENABLE) || defined(RGB_MATRIX_ENABLE)
+static bool process_rgb_handler(uint16_t keycode, keyrecord_t *record) {
+    return process_rgb(keycode, record);
+}
 #endif
 
-#ifdef TAP_DANCE_ENABLE
-    preprocess_tap_dance(keycode, record);
-#endif
+typedef struct {
+    bool (*process)(uint16_t keycode, keyrecord_t *record);
+    uint16_t min;
+    uint16_t max;
+} process_record_handler_t;
 
-    if (!(
-#if defined(KEY_LOCK_ENABLE)
-            // Must run first to be able to mask key_up events.
-            process_key_lock(&keycode, record) &&
-#endif
+/* Every key event visits these handlers in order, until one returns false.
+ * Handlers are only called for the keycodes in their range: those that only
+ * handle their own keycodes list them, those that act on other keys as well
+ * (recording, feedback, user code, or modes that capture typing) take
+ * ALL_KEYCODES. */
+#define ALL_KEYCODES 0x0000, 0xFFFF
+
+static const process_record_handler_t process_record_handlers[] = {
 #if defined(DYNAMIC_MACRO_ENABLE) && !defined(DYNAMIC_MACRO_USER_CALL)
-            // Must run asap to ensure all keypresses are recorded.
-            process_dynamic_macro(keycode, record) &&
+    // Must run asap to ensure all keypresses are recorded.
+    {process_dynamic_macro, ALL_KEYCODES},
 #endif
 #if defined(AUDIO_ENABLE) && defined(AUDIO_CLICKY)
-            process_clicky(keycode, record) &&
+    {process_clicky, ALL_KEYCODES},
 #endif
 #ifdef HAPTIC_ENABLE
-            process_haptic(keycode, record) &&
+    {process_haptic, ALL_KEYCODES},
 #endif
 #if defined(VIA_ENABLE)
-            process_record_via(keycode, record) &&
+    {process_record_via, FN_MO13, MACRO15},
 #endif
-            process_record_kb(keycode, record) &&
+    {process_record_kb, ALL_KEYCODES},
 #if defined(SEQUENCER_ENABLE)
-            process_sequencer(keycode, record) &&
+    {process_sequencer, SQ_ON, SEQUENCER_TRACK_MAX},
 #endif
 #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-            process_midi(keycode, record) &&
+    {process_midi, MIDI_TONE_MIN, MI_BENDU},
 #endif
 #ifdef AUDIO_ENABLE
-            process_audio(keycode, record) &&
+    {process_audio, AU_ON, MUV_DE},
 #endif
 #if defined(BACKLIGHT_ENABLE) || defined(LED_MATRIX_ENABLE)
-            process_backlight(keycode, record) &&
+    {process_backlight, BL_ON, BL_BRTG},
 #endif
 #ifdef STENO_ENABLE
-            process_steno(keycode, record) &&
+    {process_steno, QK_STENO, QK_STENO_MAX},
 #endif
 #if (defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
-            process_music(keycode, record) &&
+    {process_music, ALL_KEYCODES},
 #endif
 #ifdef KEY_OVERRIDE_ENABLE
-            process_key_override(keycode, record) &&
+    {process_key_override_handler, ALL_KEYCODES},
 #endif
 #ifdef TAP_DANCE_ENABLE
-            process_tap_dance(keycode, record) &&
+    {process_tap_dance, QK_TAP_DANCE, QK_TAP_DANCE_MAX},
 #endif
 #if defined(UNICODE_COMMON_ENABLE)
-            process_unicode_common(keycode, record) &&
+#    ifdef UCIS_ENABLE
+    {process_unicode_common, ALL_KEYCODES},
+#    else
+    {process_unicode_common, UNICODE_MODE_FORWARD, 0xFFFF},
+#    endif
 #endif
 #ifdef LEADER_ENABLE
-            process_leader(keycode, record) &&
+    {process_leader, ALL_KEYCODES},
 #endif
 #ifdef PRINTING_ENABLE
-            process_printer(keycode, record) &&
+    {process_printer, ALL_KEYCODES},
 #endif
 #ifdef AUTO_SHIFT_ENABLE
-            process_auto_shift(keycode, record) &&
+    {process_auto_shift, ALL_KEYCODES},
 #endif
 #ifdef DYNAMIC_TAPPING_TERM_ENABLE
-            process_dynamic_tapping_term(keycode, record) &&
+    {process_dynamic_tapping_term, DT_PRNT, DT_DOWN},
 #endif
 #ifdef TERMINAL_ENABLE
-            process_terminal(keycode, record) &&
+    {process_terminal, ALL_KEYCODES},
 #endif
 #ifdef SPACE_CADET_ENABLE
-            process_space_cadet(keycode, record) &&
+    // Any other key press ends a space cadet tap
+    {process_space_cadet, ALL_KEYCODES},
 #endif
 #ifdef MAGIC_KEYCODE_ENABLE
-            process_magic(keycode, record) &&
+    {process_magic, MAGIC_SWAP_CONTROL_CAPSLOCK, MAGIC_TOGGLE_CONTROL_CAPSLOCK},
 #endif
 #ifdef GRAVE_ESC_ENABLE
-            process_grave_esc(keycode, record) &&
+    {process_grave_esc, QK_GRAVE_ESCAPE, QK_GRAVE_ESCAPE},
 #endif
 #if defined(RGBLIGHT_ENABLE) || defined(RGB_MATRIX_ENABLE)
-            process_rgb(keycode, record) &&
+    {process_rgb_handler, RGB_TOG, RGB_MODE_TWINKLE},
 #endif
 #ifdef JOYSTICK_ENABLE
-            process_joystick(keycode, record) &&
+    {process_joystick, JS_BUTTON_MIN, JS_BUTTON_MAX},
 #endif
 #ifdef PROGRAMMABLE_BUTTON_ENABLE
-            process_programmable_button(keycode, record) &&
+    {process_programmable_button, PROGRAMMABLE_BUTTON_MIN, PROGRAMMABLE_BUTTON_MAX},
 #endif
-            true)) {
+};
+
+#ifdef PROCESS_RECORD_HANDLER_STATS
+uint32_t process_record_handler_calls = 0;
+#endif
+
+/* Core keycode function, hands off handling to other functions,
+    then processes internal quantum keycodes, and then processes
+    ACTIONs.                                                      */
+bool process_record_quantum(keyrecord_t *record) {
+    uint16_t keycode = get_record_keycode(record, true);
+
+    // This is how you use actions here
+    // if (keycode == KC_LEAD) {
+    //   action_t action;
+    //   action.code = ACTION_DEFAULT_LAYER_SET(0);
+    //   process_action(record, action);
+    //   return false;
+    // }
+
+#ifdef VELOCIKEY_ENABLE
+    if (velocikey_enabled() && record->event.pressed) {
+        velocikey_accelerate();
+    }
+#endif
+
+#ifdef WPM_ENABLE
+    if (record->event.pressed) {
+        update_wpm(keycode);
+    }
+#endif
+
+#ifdef TAP_DANCE_ENABLE
+    preprocess_tap_dance(keycode, record);
+#endif
+
+#if defined(KEY_LOCK_ENABLE)
+    // Must run first to be able to mask key_up events.
+    if (!process_key_lock(&keycode, record)) {
         return false;
     }
+#endif
+
+    for (uint8_t i = 0; i < sizeof(process_record_handlers) / sizeof(process_record_handlers[0]); i++) {
+        const process_record_handler_t *handler = &process_record_handlers[i];
+        if (keycode < handler->min || keycode > handler->max) {
+            continue;
+        }
+#ifdef PROCESS_RECORD_HANDLER_STATS
+        process_record_handler_calls++;
+#endif
+        if (!handler->process(keycode, record)) {
+            return false;
+        }
+    }
 
     if (record->event.pressed) {
         switch (keycode) {
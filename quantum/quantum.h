@@ -58,6 +58,14 @@
 #    include "deferred_exec.h"
 #endif
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+#    include "send_string_async.h"
+#endif
+
+#ifdef SCAN_PROFILER_ENABLE
+#    include "scan_profiler.h"
+#endif
+
 extern layer_state_t default_layer_state;
 
 #ifndef NO_ACTION_LAYER
@@ -240,6 +248,11 @@ bool     process_record_user(uint16_t keycode, keyrecord_t *record);
 void     post_process_record_kb(uint16_t keycode, keyrecord_t *record);
 void     post_process_record_user(uint16_t keycode, keyrecord_t *record);
 
+#ifdef PROCESS_RECORD_HANDLER_STATS
+/* Handler calls made by process_record_quantum(), for benchmarking */
+extern uint32_t process_record_handler_calls;
+#endif
+
 void reset_keyboard(void);
 
 void startup_user(void);
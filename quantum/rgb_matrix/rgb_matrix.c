@@ -119,6 +119,9 @@ uint8_t g_rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 last_hit_t g_last_hit_tracker;
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+led_geometry_t g_led_geometry[DRIVER_LED_TOTAL];
+#endif // RGB_MATRIX_GEOMETRY_CACHE
 
 // internals
 static bool            suspend_state     = false;
@@ -136,6 +139,13 @@ static uint32_t rgb_timer_buffer;
 static last_hit_t last_hit_buffer;
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 
+// distances from every led to the leds of recent hits, rows in most recently used order
+#if defined(RGB_MATRIX_GEOMETRY_CACHE) && defined(RGB_MATRIX_KEYREACTIVE_ENABLED)
+static uint8_t hit_distance_order[LED_HITS_TO_REMEMBER];
+static uint8_t hit_distance_led[LED_HITS_TO_REMEMBER];
+static uint8_t hit_distance[LED_HITS_TO_REMEMBER][DRIVER_LED_TOTAL];
+#endif // defined(RGB_MATRIX_GEOMETRY_CACHE) && defined(RGB_MATRIX_KEYREACTIVE_ENABLED)
+
 // split rgb matrix
 #if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
 const uint8_t k_rgb_matrix_split[2] = RGB_MATRIX_SPLIT;
@@ -470,9 +480,61 @@ __attribute__((weak)) void rgb_matrix_indicators_advanced_kb(uint8_t led_min, ui
 
 __attribute__((weak)) void rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {}
 
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+void rgb_matrix_update_geometry(void) {
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        int16_t dx              = g_led_config.point[i].x - k_rgb_matrix_center.x;
+        int16_t dy              = g_led_config.point[i].y - k_rgb_matrix_center.y;
+        g_led_geometry[i].dist  = sqrt16(dx * dx + dy * dy);
+        g_led_geometry[i].angle = atan2_8(dy, dx);
+    }
+
+#    ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
+    for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; i++) {
+        hit_distance_order[i] = i;
+        hit_distance_led[i]   = NO_LED;
+    }
+#    endif // RGB_MATRIX_KEYREACTIVE_ENABLED
+}
+
+#    ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
+/* Distances from every led to a hit on the given led.
+ *
+ * Rows are filled on first use and the least recently used row is reused. As there are as many
+ * rows as remembered hits, looking up every hit of a frame never evicts a row of the same frame.
+ */
+const uint8_t *rgb_matrix_hit_distances(uint8_t led) {
+    uint8_t pos = 0;
+    while (pos < LED_HITS_TO_REMEMBER - 1 && hit_distance_led[hit_distance_order[pos]] != led) {
+        pos++;
+    }
+
+    uint8_t row = hit_distance_order[pos];
+    for (; pos > 0; pos--) {
+        hit_distance_order[pos] = hit_distance_order[pos - 1];
+    }
+    hit_distance_order[0] = row;
+
+    if (hit_distance_led[row] != led) {
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            int16_t dx           = g_led_config.point[i].x - g_led_config.point[led].x;
+            int16_t dy           = g_led_config.point[i].y - g_led_config.point[led].y;
+            hit_distance[row][i] = sqrt16(dx * dx + dy * dy);
+        }
+        hit_distance_led[row] = led;
+    }
+    return hit_distance[row];
+}
+#    endif // RGB_MATRIX_KEYREACTIVE_ENABLED
+#endif     // RGB_MATRIX_GEOMETRY_CACHE
+
 void rgb_matrix_init(void) {
     rgb_matrix_driver.init();
 
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+    rgb_matrix_update_geometry();
+#endif // RGB_MATRIX_GEOMETRY_CACHE
+
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     g_last_hit_tracker.count = 0;
     for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
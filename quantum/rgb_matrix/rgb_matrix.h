@@ -138,6 +138,14 @@ void rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max);
 
 void rgb_matrix_init(void);
 
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+// Call after changing g_led_config.point at runtime
+void rgb_matrix_update_geometry(void);
+#    ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
+const uint8_t *rgb_matrix_hit_distances(uint8_t led);
+#    endif
+#endif
+
 void rgb_matrix_reload_from_eeprom(void);
 
 void        rgb_matrix_set_suspend_state(bool state);
@@ -260,6 +268,9 @@ extern led_config_t g_led_config;
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 extern last_hit_t g_last_hit_tracker;
 #endif
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+extern led_geometry_t g_led_geometry[DRIVER_LED_TOTAL];
+#endif
 #ifdef RGB_MATRIX_FRAMEBUFFER_EFFECTS
 extern uint8_t g_rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS];
 #endif
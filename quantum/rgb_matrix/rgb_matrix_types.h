@@ -64,6 +64,11 @@ typedef struct PACKED {
     uint8_t y;
 } led_point_t;
 
+typedef struct PACKED {
+    uint8_t dist;  // distance from k_rgb_matrix_center
+    uint8_t angle; // atan2_8() angle around k_rgb_matrix_center
+} led_geometry_t;
+
 #define HAS_FLAGS(bits, flags) ((bits & flags) == flags)
 #define HAS_ANY_FLAGS(bits, flags) ((bits & flags) != 0x00)
 
@@ -0,0 +1,188 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "scan_profiler.h"
+#include "timer.h"
+#include "debug.h"
+
+#ifndef SCAN_PROFILER_REPORT_INTERVAL
+#    define SCAN_PROFILER_REPORT_INTERVAL 5000
+#endif
+
+#ifdef __AVR__
+// Timer0 ticks every 4us, so 16 buckets reach 262ms and a 32-bit sum lasts for hours
+#    ifndef SCAN_PROFILER_BUCKETS
+#        define SCAN_PROFILER_BUCKETS 16
+#    endif
+typedef uint32_t scan_profile_sum_t;
+typedef uint8_t  scan_profile_bucket_t;
+#    define SCAN_PROFILE_BUCKET_MAX UINT8_MAX
+#else
+#    ifndef SCAN_PROFILER_BUCKETS
+#        define SCAN_PROFILER_BUCKETS 32
+#    endif
+typedef uint64_t scan_profile_sum_t;
+typedef uint16_t scan_profile_bucket_t;
+#    define SCAN_PROFILE_BUCKET_MAX UINT16_MAX
+#endif
+
+typedef struct {
+    uint32_t              count;
+    uint32_t              min;
+    uint32_t              max;
+    scan_profile_sum_t    sum;
+    // Bucket n holds durations in [2^n, 2^(n+1)), bucket 0 also holds zero and the last bucket everything above
+    scan_profile_bucket_t buckets[SCAN_PROFILER_BUCKETS];
+} scan_profile_t;
+
+static scan_profile_t profiles[SCAN_PROFILE_STAGE_COUNT];
+static uint32_t       last_report_time = 0;
+
+static const char *const stage_names[SCAN_PROFILE_STAGE_COUNT] = {
+    [SCAN_PROFILE_KEYBOARD_TASK]   = "keyboard_task",
+    [SCAN_PROFILE_MATRIX_SCAN]     = "matrix_scan",
+    [SCAN_PROFILE_DEBOUNCE]        = "debounce",
+    [SCAN_PROFILE_SPLIT_TRANSPORT] = "split_transport",
+    [SCAN_PROFILE_ACTION_EXEC]     = "action_exec",
+    [SCAN_PROFILE_QUANTUM_TASK]    = "quantum_task",
+    [SCAN_PROFILE_LIGHTING]        = "lighting",
+    [SCAN_PROFILE_OLED]            = "oled",
+    [SCAN_PROFILE_USB_SEND]        = "usb_send",
+};
+
+static inline uint8_t bucket_of(uint32_t ticks) {
+    uint8_t bucket = ticks ? (sizeof(unsigned long) * 8 - 1) - __builtin_clzl(ticks) : 0;
+    return bucket < SCAN_PROFILER_BUCKETS ? bucket : SCAN_PROFILER_BUCKETS - 1;
+}
+
+void scan_profiler_record(scan_profile_stage_t stage, uint32_t ticks) {
+    if (stage >= SCAN_PROFILE_STAGE_COUNT) {
+        return;
+    }
+
+    scan_profile_t *profile = &profiles[stage];
+    if (profile->count == 0 || ticks < profile->min) profile->min = ticks;
+    if (ticks > profile->max) profile->max = ticks;
+    profile->count++;
+    profile->sum += ticks;
+
+    // Halve the whole histogram rather than saturating a bucket, which keeps its shape intact
+    uint8_t bucket = bucket_of(ticks);
+    if (profile->buckets[bucket] == SCAN_PROFILE_BUCKET_MAX) {
+        for (uint8_t i = 0; i < SCAN_PROFILER_BUCKETS; ++i) {
+            profile->buckets[i] >>= 1;
+        }
+    }
+    profile->buckets[bucket]++;
+}
+
+static uint32_t percentile_99(const scan_profile_t *profile) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < SCAN_PROFILER_BUCKETS; ++i) {
+        total += profile->buckets[i];
+    }
+
+    uint32_t wanted = total - total / 100;
+    uint32_t seen   = 0;
+    for (uint8_t i = 0; i < SCAN_PROFILER_BUCKETS; ++i) {
+        seen += profile->buckets[i];
+        if (seen >= wanted) {
+            uint32_t upper = (i == SCAN_PROFILER_BUCKETS - 1) ? UINT32_MAX : (((uint32_t)2 << i) - 1);
+            return upper < profile->max ? upper : profile->max;
+        }
+    }
+    return profile->max;
+}
+
+bool scan_profiler_get_stats(scan_profile_stage_t stage, scan_profile_stats_t *stats) {
+    if (stage >= SCAN_PROFILE_STAGE_COUNT) {
+        return false;
+    }
+
+    const scan_profile_t *profile = &profiles[stage];
+    stats->count = profile->count;
+    if (profile->count == 0) {
+        stats->min = stats->avg = stats->max = stats->p99 = 0;
+        return true;
+    }
+
+    stats->min = profile->min;
+    stats->avg = profile->sum / profile->count;
+    stats->max = profile->max;
+    stats->p99 = percentile_99(profile);
+    if (stats->p99 < stats->min) stats->p99 = stats->min;
+    return true;
+}
+
+void scan_profiler_reset(void) {
+    memset(profiles, 0, sizeof(profiles));
+}
+
+const char *scan_profiler_stage_name(scan_profile_stage_t stage) {
+    return stage < SCAN_PROFILE_STAGE_COUNT ? stage_names[stage] : "";
+}
+
+static inline uint8_t *put_u32(uint8_t *data, uint32_t value) {
+    data[0] = (value >> 24) & 0xFF;
+    data[1] = (value >> 16) & 0xFF;
+    data[2] = (value >> 8) & 0xFF;
+    data[3] = value & 0xFF;
+    return data + 4;
+}
+
+uint8_t scan_profiler_raw_hid_report(uint8_t stage, uint8_t *data, uint8_t length) {
+    scan_profile_stats_t stats;
+    if (length < SCAN_PROFILER_RAW_HID_REPORT_SIZE || !scan_profiler_get_stats(stage, &stats)) {
+        return 0;
+    }
+
+    *data++ = stage;
+    data    = put_u32(data, scan_profiler_ticks_per_ms());
+    data    = put_u32(data, stats.count);
+    data    = put_u32(data, stats.min);
+    data    = put_u32(data, stats.avg);
+    data    = put_u32(data, stats.max);
+    put_u32(data, stats.p99);
+    return SCAN_PROFILER_RAW_HID_REPORT_SIZE;
+}
+
+#ifdef CONSOLE_ENABLE
+static uint32_t ticks_to_us(uint32_t ticks, uint32_t ticks_per_ms) {
+    return (ticks / ticks_per_ms) * 1000 + (ticks % ticks_per_ms) * 1000 / ticks_per_ms;
+}
+#endif
+
+void scan_profiler_task(void) {
+    uint32_t timer_now = timer_read32();
+    if (TIMER_DIFF_32(timer_now, last_report_time) < SCAN_PROFILER_REPORT_INTERVAL) {
+        return;
+    }
+    last_report_time = timer_now;
+
+#ifdef CONSOLE_ENABLE
+    uint32_t ticks_per_ms = scan_profiler_ticks_per_ms();
+    dprintf("scan profile (us): stage count min avg max p99\n");
+    for (uint8_t stage = 0; stage < SCAN_PROFILE_STAGE_COUNT; ++stage) {
+        scan_profile_stats_t stats;
+        scan_profiler_get_stats(stage, &stats);
+        if (stats.count == 0) continue;
+        dprintf("  %s %lu %lu %lu %lu %lu\n", stage_names[stage], stats.count, ticks_to_us(stats.min, ticks_per_ms), ticks_to_us(stats.avg, ticks_per_ms), ticks_to_us(stats.max, ticks_per_ms), ticks_to_us(stats.p99, ticks_per_ms));
+    }
+#endif
+    scan_profiler_reset();
+}
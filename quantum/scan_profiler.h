@@ -0,0 +1,94 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Per-stage latency profiler for keyboard_task().
+ *
+ * Each instrumented stage records how long it took, in platform ticks (see
+ * scan_profiler_read_ticks()), into a log2 histogram together with its min,
+ * max and running sum. Stages nest: matrix_scan includes debounce and the
+ * split transactions, action_exec includes USB sends, and keyboard_task
+ * covers the whole scan. Statistics cover the window since the last reset.
+ */
+
+typedef enum {
+    SCAN_PROFILE_KEYBOARD_TASK,
+    SCAN_PROFILE_MATRIX_SCAN,
+    SCAN_PROFILE_DEBOUNCE,
+    SCAN_PROFILE_SPLIT_TRANSPORT,
+    SCAN_PROFILE_ACTION_EXEC,
+    SCAN_PROFILE_QUANTUM_TASK,
+    SCAN_PROFILE_LIGHTING,
+    SCAN_PROFILE_OLED,
+    SCAN_PROFILE_USB_SEND,
+    SCAN_PROFILE_STAGE_COUNT,
+} scan_profile_stage_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p99; // upper bound of the histogram bucket holding the 99th percentile
+} scan_profile_stats_t;
+
+// Size of a raw HID stage report, see scan_profiler_raw_hid_report()
+#define SCAN_PROFILER_RAW_HID_REPORT_SIZE 25
+
+/**
+ * \brief Free-running tick counter, provided by the platform.
+ *
+ * Wraps at 32 bits; stage durations are computed with unsigned subtraction.
+ */
+uint32_t scan_profiler_read_ticks(void);
+
+/**
+ * \brief Number of ticks per millisecond, provided by the platform.
+ */
+uint32_t scan_profiler_ticks_per_ms(void);
+
+void scan_profiler_record(scan_profile_stage_t stage, uint32_t ticks);
+bool scan_profiler_get_stats(scan_profile_stage_t stage, scan_profile_stats_t *stats);
+void scan_profiler_reset(void);
+
+const char *scan_profiler_stage_name(scan_profile_stage_t stage);
+
+/**
+ * \brief Print all stages to the console every SCAN_PROFILER_REPORT_INTERVAL ms, then reset.
+ */
+void scan_profiler_task(void);
+
+/**
+ * \brief Serialise the statistics of a stage for raw HID.
+ *
+ * Writes the stage, then ticks per ms, count, min, avg, max and p99 as big endian 32-bit values.
+ *
+ * \return The number of bytes written, or 0 if the stage is invalid or \a length is too small.
+ */
+uint8_t scan_profiler_raw_hid_report(uint8_t stage, uint8_t *data, uint8_t length);
+
+#ifdef SCAN_PROFILER_ENABLE
+#    define SCAN_PROFILE_BEGIN(stage) uint32_t scan_profile_start_##stage = scan_profiler_read_ticks()
+#    define SCAN_PROFILE_END(stage) scan_profiler_record(stage, scan_profiler_read_ticks() - scan_profile_start_##stage)
+#else
+#    define SCAN_PROFILE_BEGIN(stage)
+#    define SCAN_PROFILE_END(stage)
+#endif
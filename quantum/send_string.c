@@ -151,6 +151,12 @@ void send_string_P(const char *str) {
 }
 
 void send_string_with_delay(const char *str, uint8_t interval) {
+#ifdef SEND_STRING_ASYNC_ENABLE
+    // Let anything already queued finish first, so strings never interleave
+    send_string_async_flush();
+    send_string_async(str, interval, NULL, NULL);
+    send_string_async_flush();
+#else
     while (1) {
         char ascii_code = *str;
         if (!ascii_code) break;
@@ -191,9 +197,15 @@ void send_string_with_delay(const char *str, uint8_t interval) {
                 wait_ms(1);
         }
     }
+#endif
 }
 
 void send_string_with_delay_P(const char *str, uint8_t interval) {
+#ifdef SEND_STRING_ASYNC_ENABLE
+    send_string_async_flush();
+    send_string_async_P(str, interval, NULL, NULL);
+    send_string_async_flush();
+#else
     while (1) {
         char ascii_code = pgm_read_byte(str);
         if (!ascii_code) break;
@@ -234,6 +246,7 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
                 wait_ms(1);
         }
     }
+#endif
 }
 
 void send_char(char ascii_code) {
@@ -0,0 +1,276 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+
+#include "quantum.h"
+#include "eeprom.h"
+
+#include "send_string_async.h"
+
+#if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
+#    include "audio.h"
+extern float bell_song[][2];
+#endif
+
+// Same bit order as in send_string.c
+#define PGM_LOADBIT(mem, pos) ((pgm_read_byte(&((mem)[(pos) / 8])) >> ((pos) % 8)) & 0x01)
+
+// Shift, AltGr, tap, AltGr, Shift, dead key space tap and the interval
+#define SEND_STRING_ASYNC_MAX_OPS 12
+
+enum {
+    SEND_STRING_OP_DOWN,
+    SEND_STRING_OP_UP,
+    SEND_STRING_OP_WAIT,
+    SEND_STRING_OP_BELL,
+};
+
+typedef struct {
+    uint8_t  kind;
+    uint16_t arg;
+} send_string_op_t;
+
+typedef struct {
+    const char *                 str;
+    send_string_async_callback_t callback;
+    void *                       cb_arg;
+    uint8_t                      source;
+    uint8_t                      interval;
+} send_string_job_t;
+
+static send_string_job_t queue[SEND_STRING_ASYNC_QUEUE_SIZE];
+static uint8_t           queue_head  = 0;
+static uint8_t           queue_count = 0;
+
+// Operations left of the character being typed
+static send_string_op_t ops[SEND_STRING_ASYNC_MAX_OPS];
+static uint8_t          ops_count = 0;
+static uint8_t          ops_pos   = 0;
+
+// Waits count from the last report, the next report is never sent before ready_time
+static uint32_t wait_from  = 0;
+static uint32_t ready_time = 0;
+
+static char read_char(const send_string_job_t *job, const char *str) {
+    switch (job->source) {
+        case SEND_STRING_SOURCE_PROGMEM:
+            return pgm_read_byte(str);
+        case SEND_STRING_SOURCE_EEPROM:
+            return eeprom_read_byte((const uint8_t *)str);
+        default:
+            return *str;
+    }
+}
+
+static void push_op(uint8_t kind, uint16_t arg) {
+    if (kind == SEND_STRING_OP_WAIT && !arg) return;
+    ops[ops_count].kind = kind;
+    ops[ops_count].arg  = arg;
+    ops_count++;
+}
+
+static void push_tap(uint8_t keycode) {
+    push_op(SEND_STRING_OP_DOWN, keycode);
+    push_op(SEND_STRING_OP_WAIT, keycode == KC_CAPS_LOCK ? TAP_HOLD_CAPS_DELAY : TAP_CODE_DELAY);
+    push_op(SEND_STRING_OP_UP, keycode);
+}
+
+// Mirrors send_char()
+static void push_char(char ascii_code) {
+#if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
+    if (ascii_code == '\a') { // BEL
+        push_op(SEND_STRING_OP_BELL, 0);
+        return;
+    }
+#endif
+
+    uint8_t keycode    = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
+    bool    is_shifted = PGM_LOADBIT(ascii_to_shift_lut, (uint8_t)ascii_code);
+    bool    is_altgred = PGM_LOADBIT(ascii_to_altgr_lut, (uint8_t)ascii_code);
+    bool    is_dead    = PGM_LOADBIT(ascii_to_dead_lut, (uint8_t)ascii_code);
+
+    if (is_shifted) {
+        push_op(SEND_STRING_OP_DOWN, KC_LSFT);
+    }
+    if (is_altgred) {
+        push_op(SEND_STRING_OP_DOWN, KC_RALT);
+    }
+    push_tap(keycode);
+    if (is_altgred) {
+        push_op(SEND_STRING_OP_UP, KC_RALT);
+    }
+    if (is_shifted) {
+        push_op(SEND_STRING_OP_UP, KC_LSFT);
+    }
+    if (is_dead) {
+        push_tap(KC_SPACE);
+    }
+}
+
+/* Turn the next character or SS_ sequence of the current job into operations, the same way
+ * send_string_with_delay() used to run them.
+ *
+ * Returns false at the end of the string.
+ */
+static bool decode_next(void) {
+    send_string_job_t *job = &queue[queue_head];
+
+    ops_count = 0;
+    ops_pos   = 0;
+
+    char ascii_code = read_char(job, job->str);
+    if (!ascii_code) return false;
+
+    if (ascii_code == SS_QMK_PREFIX) {
+        ascii_code = read_char(job, ++job->str);
+        if (ascii_code == SS_TAP_CODE) {
+            push_tap(read_char(job, ++job->str));
+        } else if (ascii_code == SS_DOWN_CODE) {
+            push_op(SEND_STRING_OP_DOWN, (uint8_t)read_char(job, ++job->str));
+        } else if (ascii_code == SS_UP_CODE) {
+            push_op(SEND_STRING_OP_UP, (uint8_t)read_char(job, ++job->str));
+        } else if (ascii_code == SS_DELAY_CODE) {
+            uint32_t ms      = 0;
+            uint8_t  keycode = read_char(job, ++job->str);
+            while (isdigit(keycode)) {
+                ms *= 10;
+                ms += keycode - '0';
+                keycode = read_char(job, ++job->str);
+            }
+            push_op(SEND_STRING_OP_WAIT, ms > UINT16_MAX ? UINT16_MAX : ms);
+        } else if (!ascii_code) {
+            return false;
+        }
+    } else {
+        push_char(ascii_code);
+    }
+    ++job->str;
+
+    push_op(SEND_STRING_OP_WAIT, job->interval);
+    return true;
+}
+
+static void run_op(const send_string_op_t *op) {
+    switch (op->kind) {
+        case SEND_STRING_OP_DOWN:
+            register_code(op->arg);
+            break;
+        case SEND_STRING_OP_UP:
+            unregister_code(op->arg);
+            break;
+#if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
+        case SEND_STRING_OP_BELL:
+            PLAY_SONG(bell_song);
+            break;
+#endif
+    }
+}
+
+static void finish_job(void) {
+    send_string_job_t job = queue[queue_head];
+
+    queue_head = (queue_head + 1) % SEND_STRING_ASYNC_QUEUE_SIZE;
+    queue_count--;
+    ops_count = 0;
+    ops_pos   = 0;
+    wait_from = timer_read32();
+
+    // Last, the callback is free to queue or even block on another string
+    if (job.callback) {
+        job.callback(job.cb_arg);
+    }
+}
+
+bool send_string_async_ex(const char *str, send_string_source_t source, uint8_t interval, send_string_async_callback_t callback, void *cb_arg) {
+    if (queue_count >= SEND_STRING_ASYNC_QUEUE_SIZE) {
+        return false;
+    }
+
+    if (!queue_count) {
+        uint32_t now = timer_read32();
+        wait_from    = now;
+        if (timer_expired32(now, ready_time)) {
+            ready_time = now;
+        }
+    }
+
+    send_string_job_t *job = &queue[(queue_head + queue_count) % SEND_STRING_ASYNC_QUEUE_SIZE];
+    job->str               = str;
+    job->source            = source;
+    job->interval          = interval;
+    job->callback          = callback;
+    job->cb_arg            = cb_arg;
+    queue_count++;
+    return true;
+}
+
+uint8_t send_string_async_pending(void) {
+    return queue_count;
+}
+
+void send_string_async_flush(void) {
+    while (queue_count) {
+        if (ops_pos == ops_count) {
+            if (!decode_next()) {
+                finish_job();
+            }
+            continue;
+        }
+
+        const send_string_op_t *op = &ops[ops_pos++];
+        if (op->kind == SEND_STRING_OP_WAIT) {
+            for (uint16_t i = op->arg; i > 0; i--) {
+                wait_ms(1);
+            }
+        } else {
+            run_op(op);
+        }
+    }
+    wait_from = ready_time = timer_read32();
+}
+
+void send_string_async_task(void) {
+    while (queue_count) {
+        uint32_t now = timer_read32();
+        if (!timer_expired32(now, ready_time)) return;
+
+        if (ops_pos == ops_count) {
+            if (!decode_next()) {
+                finish_job();
+                return;
+            }
+            continue;
+        }
+
+        const send_string_op_t *op = &ops[ops_pos++];
+        if (op->kind == SEND_STRING_OP_WAIT) {
+            wait_from += op->arg;
+            if (timer_expired32(wait_from, ready_time)) {
+                ready_time = wait_from;
+            }
+            continue;
+        }
+
+        run_op(op);
+        if (op->kind != SEND_STRING_OP_BELL) {
+            // One report per call and host poll interval
+            wait_from  = now;
+            ready_time = now + SEND_STRING_ASYNC_INTERVAL;
+            return;
+        }
+    }
+}
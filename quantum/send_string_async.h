@@ -0,0 +1,98 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "progmem.h"
+
+/*
+ * Non-blocking send_string.
+ *
+ * Strings are queued and typed from keyboard_task(), at most one register/unregister per
+ * SEND_STRING_ASYNC_INTERVAL milliseconds. Per-character intervals, SS_DELAY() and tap delays are
+ * tracked with timestamps instead of wait_ms(), so scanning carries on while a string is typed.
+ * The reports sent are exactly those of the blocking send_string() functions, which drain this
+ * queue while it is enabled.
+ *
+ * The string is read in place: RAM and EEPROM strings must stay unchanged until the job completes.
+ */
+
+#define SEND_STRING_ASYNC(string) send_string_async_P(PSTR(string), 0, NULL, NULL)
+
+#ifndef SEND_STRING_ASYNC_QUEUE_SIZE
+#    define SEND_STRING_ASYNC_QUEUE_SIZE 4
+#endif
+
+#ifndef SEND_STRING_ASYNC_INTERVAL
+#    ifdef USB_POLLING_INTERVAL_MS
+#        define SEND_STRING_ASYNC_INTERVAL USB_POLLING_INTERVAL_MS
+#    else
+#        define SEND_STRING_ASYNC_INTERVAL 1
+#    endif
+#endif
+
+typedef enum {
+    SEND_STRING_SOURCE_RAM,
+    SEND_STRING_SOURCE_PROGMEM,
+    SEND_STRING_SOURCE_EEPROM,
+} send_string_source_t;
+
+/**
+ * \brief Called once the last report of a string has been sent.
+ */
+typedef void (*send_string_async_callback_t)(void *cb_arg);
+
+/**
+ * \brief Queue a string to be typed.
+ *
+ * \param str The string, its address is interpreted according to \a source
+ * \param source Where the string lives
+ * \param interval Milliseconds to wait after every character, as in send_string_with_delay()
+ * \param callback Completion callback, may be NULL
+ * \param cb_arg Passed to \a callback
+ * \return false if the queue is full
+ */
+bool send_string_async_ex(const char *str, send_string_source_t source, uint8_t interval, send_string_async_callback_t callback, void *cb_arg);
+
+static inline bool send_string_async(const char *str, uint8_t interval, send_string_async_callback_t callback, void *cb_arg) {
+    return send_string_async_ex(str, SEND_STRING_SOURCE_RAM, interval, callback, cb_arg);
+}
+
+static inline bool send_string_async_P(const char *str, uint8_t interval, send_string_async_callback_t callback, void *cb_arg) {
+    return send_string_async_ex(str, SEND_STRING_SOURCE_PROGMEM, interval, callback, cb_arg);
+}
+
+static inline bool send_string_async_E(const char *str, uint8_t interval, send_string_async_callback_t callback, void *cb_arg) {
+    return send_string_async_ex(str, SEND_STRING_SOURCE_EEPROM, interval, callback, cb_arg);
+}
+
+/**
+ * \brief Number of strings queued, including the one being typed.
+ */
+uint8_t send_string_async_pending(void);
+
+/**
+ * \brief Type everything queued right away, blocking until done.
+ */
+void send_string_async_flush(void);
+
+/**
+ * \brief Advance the string being typed. Called from keyboard_task().
+ */
+void send_string_async_task(void);
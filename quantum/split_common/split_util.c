@@ -19,6 +19,7 @@
 #include "config.h"
 #include "timer.h"
 #include "transport.h"
+#include "scan_profiler.h"
 #include "quantum.h"
 #include "wait.h"
 #include "usb_util.h"
@@ -175,7 +176,9 @@ bool transport_master_if_connected(matrix_row_t master_matrix[], matrix_row_t sl
     }
 #endif // SPLIT_MAX_CONNECTION_ERRORS > 0 && SPLIT_CONNECTION_CHECK_TIMEOUT > 0
 
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_SPLIT_TRANSPORT);
     __attribute__((unused)) bool okay = transport_master(master_matrix, slave_matrix);
+    SCAN_PROFILE_END(SCAN_PROFILE_SPLIT_TRANSPORT);
 #if SPLIT_MAX_CONNECTION_ERRORS > 0
     if (!okay) {
         if (connection_errors < UINT8_MAX) {
@@ -0,0 +1,16 @@
+split_transport_batch_DEFS := \
+	-DSPLIT_TRANSPORT_BATCH \
+	-DSERIAL_DRIVER_USART \
+	-DSPLIT_TRANSACTION_IDS_USER=USER_SYNC_A \
+	-DMATRIX_ROWS=4 \
+	-DMATRIX_COLS=4
+
+split_transport_batch_INC := \
+	$(QUANTUM_PATH)/split_common
+
+split_transport_batch_SRC := \
+	$(QUANTUM_PATH)/split_common/tests/serial_loopback.c \
+	$(QUANTUM_PATH)/split_common/tests/transport_batch_tests.cpp \
+	$(QUANTUM_PATH)/split_common/transport.c \
+	$(QUANTUM_PATH)/split_common/transport_batch.c \
+	$(QUANTUM_PATH)/crc.c
@@ -0,0 +1,106 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <stddef.h>
+
+#include "serial.h"
+#include "serial_loopback.h"
+#include "transport_batch.h"
+
+#define sizeof_member(type, member) sizeof(((type *)NULL)->member)
+
+static void user_sync_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    user_sync_calls++;
+    user_sync_last = *(const uint8_t *)in_data;
+    // Echo back the inverted request so the master can tell it was processed on the slave
+    *(uint8_t *)out_data = ~user_sync_last;
+}
+
+split_transaction_desc_t split_transaction_table[NUM_TOTAL_TRANSACTIONS] = {
+    [0 ...(NUM_TOTAL_TRANSACTIONS - 1)] = {0, 0, 0, 0, 0},
+
+    [GET_SLAVE_MATRIX_CHECKSUM] = {0, 0, sizeof_member(split_shared_memory_t, smatrix.checksum), offsetof(split_shared_memory_t, smatrix.checksum), NULL},
+    [GET_SLAVE_MATRIX_DATA]     = {0, 0, sizeof_member(split_shared_memory_t, smatrix.matrix), offsetof(split_shared_memory_t, smatrix.matrix), NULL},
+    [PUT_SYNC_TIMER]            = {sizeof_member(split_shared_memory_t, sync_timer), offsetof(split_shared_memory_t, sync_timer), 0, 0, NULL},
+    [USER_SYNC_A]               = {1, offsetof(split_shared_memory_t, rpc_m2s_buffer), 1, offsetof(split_shared_memory_t, rpc_s2m_buffer), user_sync_slave_handler},
+};
+
+split_shared_memory_t loopback_slave_memory;
+
+uint16_t loopback_frames;
+bool     loopback_corrupt_request;
+bool     loopback_corrupt_response;
+
+uint16_t user_sync_calls;
+uint8_t  user_sync_last;
+
+void loopback_reset(void) {
+    memset(split_shmem, 0, sizeof(split_shared_memory_t));
+    memset(&loopback_slave_memory, 0, sizeof(loopback_slave_memory));
+    loopback_frames           = 0;
+    loopback_corrupt_request  = false;
+    loopback_corrupt_response = false;
+    user_sync_calls           = 0;
+    user_sync_last            = 0;
+}
+
+void soft_serial_initiator_init(void) {}
+
+void soft_serial_target_init(void) {}
+
+void soft_serial_batch_target_init(uint8_t *request, uint8_t *response, uint16_t buffer_size) {}
+
+bool soft_serial_transaction(int sstd_index) {
+    return false;
+}
+
+bool soft_serial_batch_transaction(const uint8_t *request, uint16_t request_length, uint8_t *response, uint16_t response_length) {
+    static uint8_t        wire[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+    static uint8_t        answer[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+    split_shared_memory_t master_memory;
+
+    loopback_frames++;
+
+    memcpy(wire, request, request_length);
+    if (loopback_corrupt_request) {
+        wire[request_length / 2] ^= 0x10;
+    }
+
+    // Play the slave half against its own copy of the shared memory
+    memcpy(&master_memory, split_shmem, sizeof(master_memory));
+    memcpy(split_shmem, &loopback_slave_memory, sizeof(loopback_slave_memory));
+    uint16_t answer_length = split_batch_handle_request(wire, request_length, answer, sizeof(answer));
+    memcpy(&loopback_slave_memory, split_shmem, sizeof(loopback_slave_memory));
+    memcpy(split_shmem, &master_memory, sizeof(master_memory));
+
+    // A silent slave looks like a timeout to the master
+    if (answer_length != response_length) {
+        return false;
+    }
+
+    memcpy(response, answer, answer_length);
+    if (loopback_corrupt_response) {
+        response[response_length / 2] ^= 0x10;
+    }
+    return true;
+}
+
+bool transactions_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    return true;
+}
+
+void transactions_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {}
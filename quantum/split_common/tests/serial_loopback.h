@@ -0,0 +1,34 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "transactions.h"
+
+// The slave half's view of the shared memory, swapped in while it handles a frame
+extern split_shared_memory_t loopback_slave_memory;
+
+extern uint16_t loopback_frames;
+extern bool     loopback_corrupt_request;
+extern bool     loopback_corrupt_response;
+
+extern uint16_t user_sync_calls;
+extern uint8_t  user_sync_last;
+
+void loopback_reset(void);
@@ -0,0 +1,183 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+// The split headers are C11 only
+#define _Static_assert static_assert
+
+extern "C" {
+#include "transport.h"
+#include "transport_batch.h"
+#include "split_common/tests/serial_loopback.h"
+}
+
+#define BIT(id) ((uint32_t)1 << (id))
+#define SLAVE_MATRIX_POLL (BIT(GET_SLAVE_MATRIX_CHECKSUM) | BIT(GET_SLAVE_MATRIX_DATA))
+
+class TransportBatch : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        loopback_reset();
+        // Flush whatever an earlier test left queued
+        transport_batch_commit(0);
+        loopback_reset();
+    }
+};
+
+TEST_F(TransportBatch, WritesAreQueuedUntilCommit) {
+    uint32_t sync_timer = 0x12345678;
+    EXPECT_TRUE(transport_execute_transaction(PUT_SYNC_TIMER, &sync_timer, sizeof(sync_timer), NULL, 0));
+    EXPECT_EQ(loopback_frames, 0);
+    EXPECT_EQ(loopback_slave_memory.sync_timer, 0u);
+
+    EXPECT_TRUE(transport_batch_commit(0));
+    EXPECT_EQ(loopback_frames, 1);
+    EXPECT_EQ(loopback_slave_memory.sync_timer, sync_timer);
+
+    // Nothing left to send
+    EXPECT_TRUE(transport_batch_commit(0));
+    EXPECT_EQ(loopback_frames, 1);
+}
+
+TEST_F(TransportBatch, WritesAndReadsShareOneFrame) {
+    loopback_slave_memory.smatrix.matrix[0] = 0x05;
+    loopback_slave_memory.smatrix.matrix[1] = 0x0A;
+    loopback_slave_memory.smatrix.checksum  = 0x5A;
+
+    uint32_t sync_timer = 1000;
+    uint8_t  user_data  = 0x42;
+    EXPECT_TRUE(transport_execute_transaction(PUT_SYNC_TIMER, &sync_timer, sizeof(sync_timer), NULL, 0));
+    EXPECT_TRUE(transport_execute_transaction(USER_SYNC_A, &user_data, sizeof(user_data), NULL, 0));
+    EXPECT_TRUE(transport_batch_commit(SLAVE_MATRIX_POLL));
+    EXPECT_EQ(loopback_frames, 1);
+    EXPECT_EQ(loopback_slave_memory.sync_timer, sync_timer);
+    EXPECT_EQ(user_sync_calls, 1);
+    EXPECT_EQ(user_sync_last, user_data);
+
+    // The reads are served from that frame
+    uint8_t      checksum = 0;
+    matrix_row_t matrix[(MATRIX_ROWS) / 2];
+    EXPECT_TRUE(transport_execute_transaction(GET_SLAVE_MATRIX_CHECKSUM, NULL, 0, &checksum, sizeof(checksum)));
+    EXPECT_TRUE(transport_execute_transaction(GET_SLAVE_MATRIX_DATA, NULL, 0, matrix, sizeof(matrix)));
+    EXPECT_EQ(loopback_frames, 1);
+    EXPECT_EQ(checksum, 0x5A);
+    EXPECT_EQ(matrix[0], 0x05);
+    EXPECT_EQ(matrix[1], 0x0A);
+
+    // ...but only once, a second read goes back to the slave
+    loopback_slave_memory.smatrix.checksum = 0xA5;
+    EXPECT_TRUE(transport_execute_transaction(GET_SLAVE_MATRIX_CHECKSUM, NULL, 0, &checksum, sizeof(checksum)));
+    EXPECT_EQ(loopback_frames, 2);
+    EXPECT_EQ(checksum, 0xA5);
+}
+
+TEST_F(TransportBatch, ReadCarriesQueuedWrites) {
+    uint32_t sync_timer = 2000;
+    uint8_t  checksum   = 0;
+    loopback_slave_memory.smatrix.checksum = 0x33;
+    EXPECT_TRUE(transport_execute_transaction(PUT_SYNC_TIMER, &sync_timer, sizeof(sync_timer), NULL, 0));
+    EXPECT_TRUE(transport_execute_transaction(GET_SLAVE_MATRIX_CHECKSUM, NULL, 0, &checksum, sizeof(checksum)));
+    EXPECT_EQ(loopback_frames, 1);
+    EXPECT_EQ(loopback_slave_memory.sync_timer, sync_timer);
+    EXPECT_EQ(checksum, 0x33);
+}
+
+TEST_F(TransportBatch, CallbackTransactionsAreNotCoalesced) {
+    uint8_t first = 1, second = 2;
+    EXPECT_TRUE(transport_execute_transaction(USER_SYNC_A, &first, sizeof(first), NULL, 0));
+    EXPECT_TRUE(transport_execute_transaction(USER_SYNC_A, &second, sizeof(second), NULL, 0));
+    EXPECT_EQ(loopback_frames, 1);
+    EXPECT_EQ(user_sync_calls, 1);
+    EXPECT_EQ(user_sync_last, first);
+
+    EXPECT_TRUE(transport_batch_commit(0));
+    EXPECT_EQ(loopback_frames, 2);
+    EXPECT_EQ(user_sync_calls, 2);
+    EXPECT_EQ(user_sync_last, second);
+
+    uint8_t third = 3, response = 0;
+    EXPECT_TRUE(transport_execute_transaction(USER_SYNC_A, &third, sizeof(third), &response, sizeof(response)));
+    EXPECT_EQ(loopback_frames, 3);
+    EXPECT_EQ(response, (uint8_t)~third);
+}
+
+TEST_F(TransportBatch, CorruptedRequestIsNotApplied) {
+    uint32_t sync_timer = 3000;
+    EXPECT_TRUE(transport_execute_transaction(PUT_SYNC_TIMER, &sync_timer, sizeof(sync_timer), NULL, 0));
+
+    loopback_corrupt_request = true;
+    EXPECT_FALSE(transport_batch_commit(0));
+    EXPECT_EQ(loopback_slave_memory.sync_timer, 0u);
+
+    // The write stays queued for the next attempt
+    loopback_corrupt_request = false;
+    EXPECT_TRUE(transport_batch_commit(0));
+    EXPECT_EQ(loopback_slave_memory.sync_timer, sync_timer);
+}
+
+TEST_F(TransportBatch, CorruptedResponseIsNotApplied) {
+    loopback_slave_memory.smatrix.matrix[0] = 0x0F;
+    loopback_corrupt_response               = true;
+    EXPECT_FALSE(transport_batch_commit(SLAVE_MATRIX_POLL));
+    EXPECT_EQ(split_shmem->smatrix.matrix[0], 0);
+
+    // Nothing was fetched, so the read has to go to the slave again
+    matrix_row_t matrix[(MATRIX_ROWS) / 2];
+    loopback_corrupt_response = false;
+    EXPECT_TRUE(transport_execute_transaction(GET_SLAVE_MATRIX_DATA, NULL, 0, matrix, sizeof(matrix)));
+    EXPECT_EQ(loopback_frames, 2);
+    EXPECT_EQ(matrix[0], 0x0F);
+}
+
+TEST_F(TransportBatch, PackStopsAtFirstTransactionThatDoesNotFit) {
+    uint8_t  frame[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+    uint32_t transactions = SLAVE_MATRIX_POLL | BIT(PUT_SYNC_TIMER);
+
+    // Room for the checksum and the matrix rows, but not for the sync timer after them
+    uint16_t size   = SPLIT_BATCH_REQUEST_HEADER_SIZE + 1 + sizeof(split_shmem->smatrix);
+    uint16_t length = split_batch_pack_request(&transactions, frame, size);
+    EXPECT_EQ(transactions, SLAVE_MATRIX_POLL);
+    EXPECT_EQ(length, SPLIT_BATCH_REQUEST_HEADER_SIZE + 1);
+    EXPECT_EQ(split_batch_request_length(frame), length);
+
+    transactions = BIT(PUT_SYNC_TIMER);
+    EXPECT_EQ(split_batch_pack_request(&transactions, frame, SPLIT_BATCH_REQUEST_HEADER_SIZE + 1), 0);
+    EXPECT_EQ(transactions, 0u);
+}
+
+TEST_F(TransportBatch, RejectsMalformedRequests) {
+    uint8_t  request[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+    uint8_t  response[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+    uint32_t transactions = BIT(PUT_SYNC_TIMER);
+    uint16_t length       = split_batch_pack_request(&transactions, request, sizeof(request));
+    ASSERT_NE(length, 0);
+
+    // Truncated
+    EXPECT_EQ(split_batch_handle_request(request, length - 1, response, sizeof(response)), 0);
+
+    // Unknown transaction
+    uint8_t header[SPLIT_BATCH_REQUEST_HEADER_SIZE];
+    memcpy(header, request, sizeof(header));
+    header[4] = 0x80;
+    EXPECT_EQ(split_batch_request_length(header), 0);
+
+    // Not a frame at all
+    header[0] = GET_SLAVE_MATRIX_DATA;
+    EXPECT_EQ(split_batch_request_length(header), 0);
+
+    EXPECT_EQ(split_batch_handle_request(request, length, response, sizeof(response)), SPLIT_BATCH_RESPONSE_HEADER_SIZE + 1);
+}
@@ -144,6 +144,8 @@ static void slave_matrix_handlers_slave(matrix_row_t master_matrix[], matrix_row
 #define TRANSACTIONS_SLAVE_MATRIX_REGISTRATIONS \
     [GET_SLAVE_MATRIX_CHECKSUM] = trans_target2initiator_initializer(smatrix.checksum), \
     [GET_SLAVE_MATRIX_DATA]     = trans_target2initiator_initializer(smatrix.matrix),
+#define TRANSACTIONS_SLAVE_MATRIX_POLL \
+    (1UL << GET_SLAVE_MATRIX_CHECKSUM) | (1UL << GET_SLAVE_MATRIX_DATA) |
 // clang-format on
 
 ////////////////////////////////////////////////////
@@ -202,6 +204,8 @@ static void encoder_handlers_slave(matrix_row_t master_matrix[], matrix_row_t sl
 #    define TRANSACTIONS_ENCODERS_REGISTRATIONS \
     [GET_ENCODERS_CHECKSUM] = trans_target2initiator_initializer(encoders.checksum), \
     [GET_ENCODERS_DATA]     = trans_target2initiator_initializer(encoders.state),
+#    define TRANSACTIONS_ENCODERS_POLL \
+    (1UL << GET_ENCODERS_CHECKSUM) | (1UL << GET_ENCODERS_DATA) |
 // clang-format on
 
 #else // ENCODER_ENABLE
@@ -209,6 +213,7 @@ static void encoder_handlers_slave(matrix_row_t master_matrix[], matrix_row_t sl
 #    define TRANSACTIONS_ENCODERS_MASTER()
 #    define TRANSACTIONS_ENCODERS_SLAVE()
 #    define TRANSACTIONS_ENCODERS_REGISTRATIONS
+#    define TRANSACTIONS_ENCODERS_POLL
 
 #endif // ENCODER_ENABLE
 
@@ -603,10 +608,23 @@ static bool pointing_handlers_master(matrix_row_t master_matrix[], matrix_row_t
 #    endif
     static uint32_t last_update = 0;
     static uint16_t last_cpi    = 0;
-    report_mouse_t  temp_state;
-    uint16_t        temp_cpi;
-    bool            okay = read_if_checksum_mismatch(GET_POINTING_CHECKSUM, GET_POINTING_DATA, &last_update, &temp_state, &split_shmem->pointing.report, sizeof(temp_state));
-    if (okay) pointing_device_set_shared_report(temp_state);
+    split_pointing_state_t temp_state;
+    uint16_t               temp_cpi;
+#    if defined(POINTING_DEVICE_HAS_MOTION)
+    // A side that dropped out may have restarted its running total, take its next one as the new starting point
+    static bool was_connected = false;
+    if (!was_connected) {
+        pointing_device_resync_shared_motion_total();
+    }
+    was_connected = is_transport_connected();
+#    endif
+    bool okay = read_if_checksum_mismatch(GET_POINTING_CHECKSUM, GET_POINTING_DATA, &last_update, &temp_state, &split_shmem->pointing.state, sizeof(temp_state));
+    if (okay) {
+        pointing_device_set_shared_report(temp_state.report);
+#    if defined(POINTING_DEVICE_HAS_MOTION)
+        pointing_device_set_shared_motion_total(temp_state.motion_total);
+#    endif
+    }
     temp_cpi = pointing_device_get_shared_cpi();
     if (temp_cpi && memcmp(&last_cpi, &temp_cpi, sizeof(temp_cpi)) != 0) {
         memcpy(&split_shmem->pointing.cpi, &temp_cpi, sizeof(temp_cpi));
@@ -630,8 +648,8 @@ static void pointing_handlers_slave(matrix_row_t master_matrix[], matrix_row_t s
         return;
     }
 #    endif
-    report_mouse_t temp_report;
-    uint16_t       temp_cpi;
+    split_pointing_state_t temp_state;
+    uint16_t               temp_cpi;
 #    if (POINTING_DEVICE_TASK_THROTTLE_MS > 0)
     static uint32_t last_exec = 0;
     if (timer_elapsed32(last_exec) < POINTING_DEVICE_TASK_THROTTLE_MS) {
@@ -645,25 +663,47 @@ static void pointing_handlers_slave(matrix_row_t master_matrix[], matrix_row_t s
             pointing_device_driver.set_cpi(split_shmem->pointing.cpi);
         }
     }
-    memset(&temp_report, 0, sizeof(temp_report));
-    temp_report = pointing_device_driver.get_report(temp_report);
-    memcpy(&split_shmem->pointing.report, &temp_report, sizeof(temp_report));
+    memset(&temp_state, 0, sizeof(temp_state));
+    if (pointing_device_driver.get_report) {
+        temp_state.report = pointing_device_driver.get_report(temp_state.report);
+    }
+#    if defined(POINTING_DEVICE_HAS_MOTION)
+    // Motion is read by pointing_device_task as the sensor signals it
+    temp_state.motion_total = pointing_device_get_motion_total();
+#    endif
+    memcpy(&split_shmem->pointing.state, &temp_state, sizeof(temp_state));
     // Now update the checksum given that the pointing has been written to
-    split_shmem->pointing.checksum = crc8(&temp_report, sizeof(temp_report));
+    split_shmem->pointing.checksum = crc8(&temp_state, sizeof(temp_state));
 }
 
 #    define TRANSACTIONS_POINTING_MASTER() TRANSACTION_HANDLER_MASTER(pointing)
 #    define TRANSACTIONS_POINTING_SLAVE() TRANSACTION_HANDLER_SLAVE(pointing)
-#    define TRANSACTIONS_POINTING_REGISTRATIONS [GET_POINTING_CHECKSUM] = trans_target2initiator_initializer(pointing.checksum), [GET_POINTING_DATA] = trans_target2initiator_initializer(pointing.report), [PUT_POINTING_CPI] = trans_initiator2target_initializer(pointing.cpi),
+#    define TRANSACTIONS_POINTING_REGISTRATIONS [GET_POINTING_CHECKSUM] = trans_target2initiator_initializer(pointing.checksum), [GET_POINTING_DATA] = trans_target2initiator_initializer(pointing.state), [PUT_POINTING_CPI] = trans_initiator2target_initializer(pointing.cpi),
+#    define TRANSACTIONS_POINTING_POLL (1UL << GET_POINTING_CHECKSUM) | (1UL << GET_POINTING_DATA) |
 
 #else // defined(POINTING_DEVICE_ENABLE) && defined(SPLIT_POINTING_ENABLE)
 
 #    define TRANSACTIONS_POINTING_MASTER()
 #    define TRANSACTIONS_POINTING_SLAVE()
 #    define TRANSACTIONS_POINTING_REGISTRATIONS
+#    define TRANSACTIONS_POINTING_POLL
 
 #endif // defined(POINTING_DEVICE_ENABLE) && defined(SPLIT_POINTING_ENABLE)
 
+////////////////////////////////////////////////////
+// Batched transport
+
+#ifdef SPLIT_TRANSPORT_BATCH
+
+static bool batch_handlers_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    // Everything queued so far goes out together with every read the slave-data handlers are about to make
+    return transport_batch_commit(TRANSACTIONS_SLAVE_MATRIX_POLL TRANSACTIONS_ENCODERS_POLL TRANSACTIONS_POINTING_POLL 0);
+}
+
+#    define TRANSACTIONS_BATCH_MASTER() TRANSACTION_HANDLER_MASTER(batch)
+
+#endif // SPLIT_TRANSPORT_BATCH
+
 ////////////////////////////////////////////////////
 
 split_transaction_desc_t split_transaction_table[NUM_TOTAL_TRANSACTIONS] = {
@@ -701,6 +741,25 @@ split_transaction_desc_t split_transaction_table[NUM_TOTAL_TRANSACTIONS] = {
 };
 
 bool transactions_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+#ifdef SPLIT_TRANSPORT_BATCH
+    // Writes only queue up, so run those handlers first and exchange everything in a single frame
+    TRANSACTIONS_MASTER_MATRIX_MASTER();
+    TRANSACTIONS_SYNC_TIMER_MASTER();
+    TRANSACTIONS_LAYER_STATE_MASTER();
+    TRANSACTIONS_LED_STATE_MASTER();
+    TRANSACTIONS_MODS_MASTER();
+    TRANSACTIONS_BACKLIGHT_MASTER();
+    TRANSACTIONS_RGBLIGHT_MASTER();
+    TRANSACTIONS_LED_MATRIX_MASTER();
+    TRANSACTIONS_RGB_MATRIX_MASTER();
+    TRANSACTIONS_WPM_MASTER();
+    TRANSACTIONS_OLED_MASTER();
+    TRANSACTIONS_ST7565_MASTER();
+    TRANSACTIONS_BATCH_MASTER();
+    TRANSACTIONS_SLAVE_MATRIX_MASTER();
+    TRANSACTIONS_ENCODERS_MASTER();
+    TRANSACTIONS_POINTING_MASTER();
+#else  // SPLIT_TRANSPORT_BATCH
     TRANSACTIONS_SLAVE_MATRIX_MASTER();
     TRANSACTIONS_MASTER_MATRIX_MASTER();
     TRANSACTIONS_ENCODERS_MASTER();
@@ -716,6 +775,7 @@ bool transactions_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix
     TRANSACTIONS_OLED_MASTER();
     TRANSACTIONS_ST7565_MASTER();
     TRANSACTIONS_POINTING_MASTER();
+#endif // SPLIT_TRANSPORT_BATCH
     return true;
 }
 
@@ -760,6 +820,11 @@ bool transaction_rpc_exec(int8_t transaction_id, uint8_t initiator2target_buffer
     if (initiator2target_buffer_size > RPC_M2S_BUFFER_SIZE) return false;
     if (target2initiator_buffer_size > RPC_S2M_BUFFER_SIZE) return false;
 
+#    ifdef SPLIT_TRANSPORT_BATCH
+    // Queued RPC writes were sized for their own request, send them before the sizes change
+    if (!transport_batch_commit(0)) return false;
+#    endif // SPLIT_TRANSPORT_BATCH
+
     // Prepare the metadata block
     rpc_sync_info_t info = {.transaction_id = transaction_id, .m2s_length = initiator2target_buffer_size, .s2m_length = target2initiator_buffer_size};
 
@@ -22,6 +22,10 @@
 #include "transaction_id_define.h"
 #include "atomic_util.h"
 
+#if defined(SPLIT_TRANSPORT_BATCH) && (defined(USE_I2C) || !defined(SERIAL_DRIVER_USART))
+#    error "SPLIT_TRANSPORT_BATCH is only supported by the USART serial driver, set SERIAL_DRIVER = usart"
+#endif
+
 #ifdef USE_I2C
 
 #    ifndef SLAVE_I2C_TIMEOUT
@@ -93,13 +97,87 @@ bool transport_execute_transaction(int8_t id, const void *initiator2target_buf,
 static split_shared_memory_t shared_memory;
 split_shared_memory_t *const split_shmem = &shared_memory;
 
+#    ifdef SPLIT_TRANSPORT_BATCH
+
+#        include "transport_batch.h"
+
+// Shared by both halves: the master builds requests in them, the slave receives into them
+static uint8_t  batch_request[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+static uint8_t  batch_response[SPLIT_TRANSPORT_BATCH_BUFFER_SIZE];
+static uint32_t batch_pending = 0; // writes queued for the next frame
+static uint32_t batch_fetched = 0; // reads refreshed by a frame and not yet consumed
+
+#    endif // SPLIT_TRANSPORT_BATCH
+
 void transport_master_init(void) {
     soft_serial_initiator_init();
 }
 void transport_slave_init(void) {
+#    ifdef SPLIT_TRANSPORT_BATCH
+    soft_serial_batch_target_init(batch_request, batch_response, sizeof(batch_request));
+#    endif // SPLIT_TRANSPORT_BATCH
     soft_serial_target_init();
 }
 
+#    ifdef SPLIT_TRANSPORT_BATCH
+
+bool transport_batch_commit(uint32_t transactions) {
+    uint32_t remaining = batch_pending | transactions;
+    while (remaining) {
+        uint32_t frame_transactions = remaining;
+        uint16_t request_length     = split_batch_pack_request(&frame_transactions, batch_request, sizeof(batch_request));
+        if (!request_length) {
+            return false;
+        }
+
+        uint16_t response_length = split_batch_response_length(frame_transactions);
+        if (!soft_serial_batch_transaction(batch_request, request_length, batch_response, response_length)) {
+            return false;
+        }
+        if (!split_batch_unpack_response(frame_transactions, batch_response, response_length)) {
+            return false;
+        }
+
+        batch_pending &= ~frame_transactions;
+        batch_fetched |= frame_transactions;
+        remaining &= ~frame_transactions;
+    }
+    return true;
+}
+
+bool transport_execute_transaction(int8_t id, const void *initiator2target_buf, uint16_t initiator2target_length, void *target2initiator_buf, uint16_t target2initiator_length) {
+    split_transaction_desc_t *trans = &split_transaction_table[id];
+    uint32_t                  mask  = (uint32_t)1 << id;
+
+    // A slave callback has to run once per call, so flush the one still queued before overwriting its buffer
+    if ((batch_pending & mask) && trans->slave_callback && !transport_batch_commit(0)) {
+        return false;
+    }
+
+    if (initiator2target_length > 0) {
+        size_t len = trans->initiator2target_buffer_size < initiator2target_length ? trans->initiator2target_buffer_size : initiator2target_length;
+        memcpy(split_trans_initiator2target_buffer(trans), initiator2target_buf, len);
+    }
+
+    if (target2initiator_length == 0) {
+        // Writes go out with the next frame
+        batch_pending |= mask;
+        return true;
+    }
+
+    // Reads are served from the last frame if it carried them, otherwise exchanged right away
+    if ((initiator2target_length > 0 || !(batch_fetched & mask)) && !transport_batch_commit(mask)) {
+        return false;
+    }
+    batch_fetched &= ~mask;
+
+    size_t len = trans->target2initiator_buffer_size < target2initiator_length ? trans->target2initiator_buffer_size : target2initiator_length;
+    memcpy(target2initiator_buf, split_trans_target2initiator_buffer(trans), len);
+    return true;
+}
+
+#    else // SPLIT_TRANSPORT_BATCH
+
 bool transport_execute_transaction(int8_t id, const void *initiator2target_buf, uint16_t initiator2target_length, void *target2initiator_buf, uint16_t target2initiator_length) {
     split_transaction_desc_t *trans = &split_transaction_table[id];
     if (initiator2target_length > 0) {
@@ -119,6 +197,8 @@ bool transport_execute_transaction(int8_t id, const void *initiator2target_buf,
     return true;
 }
 
+#    endif // SPLIT_TRANSPORT_BATCH
+
 #endif // USE_I2C
 
 bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
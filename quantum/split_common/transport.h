@@ -40,6 +40,11 @@ void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
 
 bool transport_execute_transaction(int8_t id, const void *initiator2target_buf, uint16_t initiator2target_length, void *target2initiator_buf, uint16_t target2initiator_length);
 
+#ifdef SPLIT_TRANSPORT_BATCH
+// sends every queued write plus `transactions` to the slave in as few frames as possible
+bool transport_batch_commit(uint32_t transactions);
+#endif // SPLIT_TRANSPORT_BATCH
+
 #ifdef ENCODER_ENABLE
 #    include "encoder.h"
 #    define NUMBER_OF_ENCODERS (sizeof((pin_t[])ENCODERS_PAD_A) / sizeof(pin_t))
@@ -108,10 +113,17 @@ typedef struct _split_mods_sync_t {
 
 #if defined(POINTING_DEVICE_ENABLE) && defined(SPLIT_POINTING_ENABLE)
 #    include "pointing_device.h"
-typedef struct _split_slave_pointing_sync_t {
-    uint8_t        checksum;
+typedef struct _split_pointing_state_t {
     report_mouse_t report;
-    uint16_t       cpi;
+#    if defined(POINTING_DEVICE_HAS_MOTION)
+    pointing_device_motion_t motion_total;
+#    endif
+} split_pointing_state_t;
+
+typedef struct _split_slave_pointing_sync_t {
+    uint8_t                checksum;
+    split_pointing_state_t state;
+    uint16_t               cpi;
 } split_slave_pointing_sync_t;
 #endif // defined(POINTING_DEVICE_ENABLE) && defined(SPLIT_POINTING_ENABLE)
 
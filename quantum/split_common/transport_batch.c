@@ -0,0 +1,156 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "crc.h"
+#include "transport_batch.h"
+
+#define SPLIT_BATCH_ALL_TRANSACTIONS ((uint32_t)((((uint64_t)1) << NUM_TOTAL_TRANSACTIONS) - 1))
+
+static inline void put_u16(uint8_t *dest, uint16_t value) {
+    dest[0] = value & 0xFF;
+    dest[1] = value >> 8;
+}
+
+static inline uint16_t get_u16(const uint8_t *src) {
+    return src[0] | ((uint16_t)src[1] << 8);
+}
+
+uint16_t split_batch_pack_request(uint32_t *transactions, uint8_t *frame, uint16_t size) {
+    uint32_t packed          = 0;
+    uint32_t wanted          = *transactions & SPLIT_BATCH_ALL_TRANSACTIONS;
+    uint16_t request_length  = SPLIT_BATCH_REQUEST_HEADER_SIZE + 1;
+    uint16_t response_length = SPLIT_BATCH_RESPONSE_HEADER_SIZE + 1;
+    uint8_t *payload         = &frame[SPLIT_BATCH_REQUEST_HEADER_SIZE];
+
+    for (uint8_t id = 0; id < NUM_TOTAL_TRANSACTIONS && wanted; ++id) {
+        uint32_t mask = (uint32_t)1 << id;
+        if (!(wanted & mask)) continue;
+
+        // Stop at the first one that does not fit, later IDs must not overtake it
+        split_transaction_desc_t *trans = &split_transaction_table[id];
+        if (request_length + trans->initiator2target_buffer_size > size || response_length + trans->target2initiator_buffer_size > size) break;
+
+        memcpy(payload, split_trans_initiator2target_buffer(trans), trans->initiator2target_buffer_size);
+        payload += trans->initiator2target_buffer_size;
+        request_length += trans->initiator2target_buffer_size;
+        response_length += trans->target2initiator_buffer_size;
+        packed |= mask;
+        wanted &= ~mask;
+    }
+
+    *transactions = packed;
+    if (!packed) {
+        return 0;
+    }
+
+    frame[0] = SPLIT_BATCH_FRAME_START;
+    frame[1] = packed & 0xFF;
+    frame[2] = (packed >> 8) & 0xFF;
+    frame[3] = (packed >> 16) & 0xFF;
+    frame[4] = (packed >> 24) & 0xFF;
+    put_u16(&frame[5], request_length - SPLIT_BATCH_REQUEST_HEADER_SIZE - 1);
+    *payload = crc8(frame, request_length - 1);
+    return request_length;
+}
+
+uint16_t split_batch_response_length(uint32_t transactions) {
+    uint16_t length = SPLIT_BATCH_RESPONSE_HEADER_SIZE + 1;
+    for (uint8_t id = 0; id < NUM_TOTAL_TRANSACTIONS; ++id) {
+        if (transactions & ((uint32_t)1 << id)) {
+            length += split_transaction_table[id].target2initiator_buffer_size;
+        }
+    }
+    return length;
+}
+
+bool split_batch_unpack_response(uint32_t transactions, const uint8_t *frame, uint16_t length) {
+    if (length < SPLIT_BATCH_RESPONSE_HEADER_SIZE + 1 || get_u16(frame) != length - SPLIT_BATCH_RESPONSE_HEADER_SIZE - 1) {
+        return false;
+    }
+    if (crc8(frame, length - 1) != frame[length - 1]) {
+        return false;
+    }
+
+    const uint8_t *payload = &frame[SPLIT_BATCH_RESPONSE_HEADER_SIZE];
+    const uint8_t *end     = &frame[length - 1];
+    for (uint8_t id = 0; id < NUM_TOTAL_TRANSACTIONS; ++id) {
+        if (!(transactions & ((uint32_t)1 << id))) continue;
+
+        split_transaction_desc_t *trans = &split_transaction_table[id];
+        if (payload + trans->target2initiator_buffer_size > end) {
+            return false;
+        }
+        memcpy(split_trans_target2initiator_buffer(trans), payload, trans->target2initiator_buffer_size);
+        payload += trans->target2initiator_buffer_size;
+    }
+    return payload == end;
+}
+
+uint16_t split_batch_request_length(const uint8_t *header) {
+    uint32_t transactions = header[1] | ((uint32_t)header[2] << 8) | ((uint32_t)header[3] << 16) | ((uint32_t)header[4] << 24);
+    if (header[0] != SPLIT_BATCH_FRAME_START || !transactions || (transactions & ~SPLIT_BATCH_ALL_TRANSACTIONS)) {
+        return 0;
+    }
+    return SPLIT_BATCH_REQUEST_HEADER_SIZE + get_u16(&header[5]) + 1;
+}
+
+uint16_t split_batch_handle_request(const uint8_t *request, uint16_t length, uint8_t *response, uint16_t size) {
+    if (length < SPLIT_BATCH_REQUEST_HEADER_SIZE + 1 || split_batch_request_length(request) != length || size < SPLIT_BATCH_RESPONSE_HEADER_SIZE + 1) {
+        return 0;
+    }
+    // Nothing is applied unless the whole frame made it across intact
+    if (crc8(request, length - 1) != request[length - 1]) {
+        return 0;
+    }
+
+    uint32_t       transactions = request[1] | ((uint32_t)request[2] << 8) | ((uint32_t)request[3] << 16) | ((uint32_t)request[4] << 24);
+    const uint8_t *payload      = &request[SPLIT_BATCH_REQUEST_HEADER_SIZE];
+    const uint8_t *payload_end  = &request[length - 1];
+    uint8_t *      out          = &response[SPLIT_BATCH_RESPONSE_HEADER_SIZE];
+    uint8_t *      out_end      = &response[size - 1];
+
+    for (uint8_t id = 0; id < NUM_TOTAL_TRANSACTIONS; ++id) {
+        if (!(transactions & ((uint32_t)1 << id))) continue;
+
+        // Sizes are looked up as we go, slave callbacks (e.g. RPC info) may change those of higher IDs
+        split_transaction_desc_t *trans = &split_transaction_table[id];
+        if (payload + trans->initiator2target_buffer_size > payload_end) {
+            return 0;
+        }
+        memcpy(split_trans_initiator2target_buffer(trans), payload, trans->initiator2target_buffer_size);
+        payload += trans->initiator2target_buffer_size;
+
+        if (trans->slave_callback) {
+            trans->slave_callback(trans->initiator2target_buffer_size, split_trans_initiator2target_buffer(trans), trans->target2initiator_buffer_size, split_trans_target2initiator_buffer(trans));
+        }
+
+        if (out + trans->target2initiator_buffer_size > out_end) {
+            return 0;
+        }
+        memcpy(out, split_trans_target2initiator_buffer(trans), trans->target2initiator_buffer_size);
+        out += trans->target2initiator_buffer_size;
+    }
+
+    if (payload != payload_end) {
+        return 0;
+    }
+
+    put_u16(response, out - &response[SPLIT_BATCH_RESPONSE_HEADER_SIZE]);
+    *out = crc8(response, out - response);
+    return out - response + 1;
+}
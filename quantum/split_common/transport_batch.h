@@ -0,0 +1,85 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "transactions.h"
+
+/*
+ * Batched split transport frames.
+ *
+ * Request (initiator -> target):
+ *   [0]     SPLIT_BATCH_FRAME_START
+ *   [1..4]  bitmask of transaction IDs carried by this frame, little endian
+ *   [5..6]  payload length, little endian
+ *   [...]   initiator2target buffers of every carried transaction, in ascending ID order
+ *   [n]     crc8 over everything before it
+ *
+ * Response (target -> initiator):
+ *   [0..1]  payload length, little endian
+ *   [...]   target2initiator buffers of every carried transaction, in ascending ID order
+ *   [n]     crc8 over everything before it
+ *
+ * The target processes the carried transactions in ascending ID order, exactly as if they had
+ * been issued one by one, so the slave callback of a transaction sees the data of every lower ID.
+ */
+
+// Never a valid transaction ID, so the target can tell a frame apart from a single transaction
+#define SPLIT_BATCH_FRAME_START 0xA5
+
+#define SPLIT_BATCH_REQUEST_HEADER_SIZE 7
+#define SPLIT_BATCH_RESPONSE_HEADER_SIZE 2
+
+#ifndef SPLIT_TRANSPORT_BATCH_BUFFER_SIZE
+#    define SPLIT_TRANSPORT_BATCH_BUFFER_SIZE (sizeof(split_shared_memory_t) + SPLIT_BATCH_REQUEST_HEADER_SIZE + 1)
+#endif // SPLIT_TRANSPORT_BATCH_BUFFER_SIZE
+
+/**
+ * \brief Build a request frame.
+ *
+ * Packs the transactions in \a transactions in ascending ID order until the request or its
+ * response would no longer fit in \a size bytes. \a transactions is updated to the packed subset.
+ *
+ * \return The frame length, or 0 if not even the first transaction fits.
+ */
+uint16_t split_batch_pack_request(uint32_t *transactions, uint8_t *frame, uint16_t size);
+
+/**
+ * \brief Total length of the response frame for a request carrying \a transactions.
+ */
+uint16_t split_batch_response_length(uint32_t transactions);
+
+/**
+ * \brief Validate a response frame and copy the target2initiator buffers into shared memory.
+ */
+bool split_batch_unpack_response(uint32_t transactions, const uint8_t *frame, uint16_t length);
+
+/**
+ * \brief Total length of a request frame, given its first SPLIT_BATCH_REQUEST_HEADER_SIZE bytes.
+ *
+ * \return The frame length, or 0 if the header is invalid.
+ */
+uint16_t split_batch_request_length(const uint8_t *header);
+
+/**
+ * \brief Execute every transaction of a request frame and build the response frame.
+ *
+ * \return The response length, or 0 if the request was rejected.
+ */
+uint16_t split_batch_handle_request(const uint8_t *request, uint16_t length, uint8_t *response, uint16_t size);
@@ -0,0 +1,214 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "quantum.h"
+#include "dynamic_keymap.h"
+#include "eeprom_driver.h"
+}
+
+// Stands in for an external EEPROM, counting every byte that crosses the bus
+static uint8_t  eeprom[TOTAL_EEPROM_BYTE_COUNT];
+static uint32_t eeprom_reads  = 0;
+static uint32_t eeprom_writes = 0;
+
+static std::vector<std::string> sent_strings;
+
+extern "C" {
+const uint16_t keymaps[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS] = {{{KC_A, KC_B, KC_C, KC_D}}, {{KC_1, KC_2, KC_3, KC_4}}, {{KC_F1, KC_F2}}, {{KC_LEFT, KC_RIGHT}}};
+
+void eeprom_driver_init(void) {}
+
+void eeprom_driver_erase(void) {
+    memset(eeprom, 0, sizeof(eeprom));
+}
+
+void eeprom_read_block(void *buf, const void *addr, size_t len) {
+    eeprom_reads += len;
+    memcpy(buf, &eeprom[(uintptr_t)addr], len);
+}
+
+void eeprom_write_block(const void *buf, void *addr, size_t len) {
+    eeprom_writes += len;
+    memcpy(&eeprom[(uintptr_t)addr], buf, len);
+}
+
+void send_string(const char *str) {
+    sent_strings.push_back(str);
+}
+}
+
+class DynamicKeymap : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        dynamic_keymap_reset();
+#ifdef DYNAMIC_KEYMAP_CACHE
+        // As done by keyboard_init()
+        dynamic_keymap_cache_load();
+#endif
+        eeprom_reads  = 0;
+        eeprom_writes = 0;
+        sent_strings.clear();
+    }
+
+    void set_macros(const std::string &macros) {
+        dynamic_keymap_macro_set_buffer(0, macros.size(), (uint8_t *)macros.data());
+        eeprom_reads = 0;
+    }
+
+    std::string sent(void) {
+        std::string all;
+        for (auto &str : sent_strings) {
+            all += str;
+        }
+        return all;
+    }
+
+    uint16_t lookup(uint8_t layer, uint8_t row, uint8_t col) {
+        return keymap_key_to_keycode(layer, (keypos_t){.col = col, .row = row});
+    }
+};
+
+TEST_F(DynamicKeymap, KeycodesAreStoredBigEndian) {
+    dynamic_keymap_set_keycode(1, 2, 3, 0x1234);
+    uint8_t *address = (uint8_t *)dynamic_keymap_key_to_eeprom_address(1, 2, 3);
+    EXPECT_EQ(eeprom[(uintptr_t)address], 0x12);
+    EXPECT_EQ(eeprom[(uintptr_t)address + 1], 0x34);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 2, 3), 0x1234);
+}
+
+TEST_F(DynamicKeymap, EepromReadsPerKeypress) {
+    // A keypress looks the key up on the highest active layer and again on release,
+    // here with a transparent walk down from layer 3 to layer 0
+    for (int layer = 3; layer >= 0; layer--) {
+        lookup(layer, 0, 0);
+    }
+    EXPECT_EQ(lookup(0, 0, 0), KC_A);
+    EXPECT_EQ(lookup(3, 0, 1), KC_RIGHT);
+#ifdef DYNAMIC_KEYMAP_CACHE
+    // Only the layers that are not cached still go to the EEPROM
+    EXPECT_EQ(eeprom_reads, 3 * 2);
+#else
+    EXPECT_EQ(eeprom_reads, 6 * 2);
+#endif
+}
+
+TEST_F(DynamicKeymap, WritesGoThroughToEeprom) {
+    dynamic_keymap_set_keycode(0, 1, 1, KC_Z);
+    EXPECT_EQ(lookup(0, 1, 1), KC_Z);
+
+    uint8_t data[4] = {0x00, KC_X, 0x00, KC_Y};
+    dynamic_keymap_set_buffer(MATRIX_COLS * 2 + 1, 3, &data[1]);
+    dynamic_keymap_set_buffer(MATRIX_COLS * 2, 1, &data[0]);
+    EXPECT_EQ(lookup(0, 1, 0), KC_X);
+    EXPECT_EQ(lookup(0, 1, 1), KC_Y);
+    EXPECT_GT(eeprom_writes, 0);
+
+    // What the host reads back matches the EEPROM byte for byte
+    const uint16_t size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
+    uint8_t        buffer[size + 2];
+    dynamic_keymap_get_buffer(0, sizeof(buffer), buffer);
+    EXPECT_EQ(memcmp(buffer, &eeprom[DYNAMIC_KEYMAP_EEPROM_ADDR], size), 0);
+    EXPECT_EQ(buffer[size], 0);
+    EXPECT_EQ(buffer[size + 1], 0);
+}
+
+TEST_F(DynamicKeymap, ResetRestoresDefaults) {
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_set_keycode(3, 0, 0, KC_Z);
+    dynamic_keymap_reset();
+    EXPECT_EQ(lookup(0, 0, 0), KC_A);
+    EXPECT_EQ(lookup(3, 0, 0), KC_LEFT);
+}
+
+TEST_F(DynamicKeymap, OutOfRangeKeysAreNoop) {
+    EXPECT_EQ(lookup(DYNAMIC_KEYMAP_LAYER_COUNT, 0, 0), KC_NO);
+    EXPECT_EQ(lookup(0, MATRIX_ROWS, 0), KC_NO);
+}
+
+TEST_F(DynamicKeymap, MacrosAreFoundByIndex) {
+    dynamic_keymap_macro_reset();
+    set_macros(std::string("first\0second\0third\0", 19));
+
+    dynamic_keymap_macro_send(2);
+    EXPECT_EQ(sent(), "third");
+    sent_strings.clear();
+    dynamic_keymap_macro_send(1);
+    EXPECT_EQ(sent(), "second");
+    sent_strings.clear();
+    dynamic_keymap_macro_send(3);
+    EXPECT_EQ(sent(), "");
+
+    // Once indexed, playing a macro back only reads the valid flag and the macro itself
+    eeprom_reads = 0;
+    dynamic_keymap_macro_send(2);
+    EXPECT_LE(eeprom_reads, 1 + DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE);
+}
+
+TEST_F(DynamicKeymap, MacroIndexFollowsWrites) {
+    dynamic_keymap_macro_reset();
+    set_macros(std::string("a\0b\0c\0", 6));
+    dynamic_keymap_macro_send(2);
+    EXPECT_EQ(sent(), "c");
+
+    // Growing the first macro moves the others
+    set_macros(std::string("aaa\0b\0c\0", 8));
+    sent_strings.clear();
+    dynamic_keymap_macro_send(2);
+    EXPECT_EQ(sent(), "c");
+    sent_strings.clear();
+    dynamic_keymap_macro_send(0);
+    EXPECT_EQ(sent(), "aaa");
+}
+
+TEST_F(DynamicKeymap, MacroMagicCodesGetPrefix) {
+    dynamic_keymap_macro_reset();
+    set_macros(std::string("x\1\x04y\2\x05\3\x05\0", 10));
+    dynamic_keymap_macro_send(0);
+    EXPECT_EQ(sent(), std::string("x" SS_TAP(X_A) "y" SS_DOWN(X_B) SS_UP(X_B)));
+}
+
+TEST_F(DynamicKeymap, MacroMagicCodeAcrossChunks) {
+    std::string prefix(DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE - 1, 'p');
+    dynamic_keymap_macro_reset();
+    set_macros(prefix + std::string("\1\x04z\0", 4));
+    dynamic_keymap_macro_send(0);
+    EXPECT_EQ(sent(), prefix + SS_TAP(X_A) "z");
+}
+
+TEST_F(DynamicKeymap, LongMacrosAreSentInChunks) {
+    std::string macro(DYNAMIC_KEYMAP_MACRO_CHUNK_SIZE * 3 + 5, 'k');
+    dynamic_keymap_macro_reset();
+    set_macros(macro + std::string(1, '\0'));
+    dynamic_keymap_macro_send(0);
+    EXPECT_EQ(sent(), macro);
+    EXPECT_EQ(sent_strings.size(), 4);
+}
+
+TEST_F(DynamicKeymap, IncompleteMacroBufferIsIgnored) {
+    dynamic_keymap_macro_reset();
+    set_macros("a");
+    uint8_t busy = 0xFF;
+    dynamic_keymap_macro_set_buffer(dynamic_keymap_macro_get_buffer_size() - 1, 1, &busy);
+    dynamic_keymap_macro_send(0);
+    EXPECT_TRUE(sent_strings.empty());
+}
@@ -0,0 +1,31 @@
+# dynamic_keymap.c turns 16 bit EEPROM offsets into pointers, which is fine on the MCUs only
+dynamic_keymap_COMMON_DEFS := \
+	-Wno-int-to-pointer-cast \
+	-DEEPROM_DRIVER \
+	-DEEPROM_CUSTOM \
+	-DEEPROM_SIZE=1024 \
+	-DDYNAMIC_KEYMAP_ENABLE \
+	-DDYNAMIC_KEYMAP_LAYER_COUNT=4 \
+	-DDYNAMIC_KEYMAP_EEPROM_ADDR=32 \
+	-DMATRIX_ROWS=4 \
+	-DMATRIX_COLS=4 \
+	-DDYNAMIC_KEYMAP_MACRO_CHUNK_SIZE=16
+
+dynamic_keymap_DEFS := $(dynamic_keymap_COMMON_DEFS)
+
+dynamic_keymap_INC := \
+	$(DRIVER_PATH)/eeprom
+
+dynamic_keymap_SRC := \
+	$(QUANTUM_PATH)/tests/dynamic_keymap_tests.cpp \
+	$(QUANTUM_PATH)/dynamic_keymap.c \
+	$(DRIVER_PATH)/eeprom/eeprom_driver.c
+
+dynamic_keymap_cache_DEFS := \
+	$(dynamic_keymap_COMMON_DEFS) \
+	-DDYNAMIC_KEYMAP_CACHE \
+	-DDYNAMIC_KEYMAP_CACHE_LAYER_COUNT=2
+
+dynamic_keymap_cache_INC := $(dynamic_keymap_INC)
+
+dynamic_keymap_cache_SRC := $(dynamic_keymap_SRC)
@@ -19,6 +19,7 @@
 
 using testing::_;
 using testing::InSequence;
+using testing::SaveArg;
 
 class KeyPress : public TestFixture {};
 
@@ -57,6 +58,7 @@ TEST_F(KeyPress, ANonMappedKeyDoesNothing) {
 
 TEST_F(KeyPress, CorrectKeysAreReportedWhenTwoKeysArePressed) {
     TestDriver driver;
+    InSequence s;
     auto       key_b = KeymapKey(0, 0, 0, KC_B);
     auto       key_c = KeymapKey(0, 1, 1, KC_C);
 
@@ -64,26 +66,21 @@ TEST_F(KeyPress, CorrectKeysAreReportedWhenTwoKeysArePressed) {
 
     key_b.press();
     key_c.press();
-    // Note that QMK only processes one key at a time
-    // See issue #1476 for more information
+    // All keys that changed within the same scan are processed in matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_b.report_code)));
-    keyboard_task();
-
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_b.report_code, key_c.report_code)));
     keyboard_task();
 
     key_b.release();
     key_c.release();
-    // Note that the first key released is the first one in the matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_c.report_code)));
-    keyboard_task();
-
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     keyboard_task();
 }
 
 TEST_F(KeyPress, LeftShiftIsReportedCorrectly) {
     TestDriver driver;
+    InSequence s;
     auto       key_a    = KeymapKey(0, 0, 0, KC_A);
     auto       key_lsft = KeymapKey(0, 3, 0, KC_LEFT_SHIFT);
 
@@ -92,10 +89,8 @@ TEST_F(KeyPress, LeftShiftIsReportedCorrectly) {
     key_lsft.press();
     key_a.press();
 
-    // Unfortunately modifiers are also processed in the wrong order
-    // See issue #1476 for more information
+    // All keys that changed within the same scan are processed in matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_a.report_code)));
-    keyboard_task();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_a.report_code, key_lsft.report_code)));
     keyboard_task();
 
@@ -110,6 +105,7 @@ TEST_F(KeyPress, LeftShiftIsReportedCorrectly) {
 
 TEST_F(KeyPress, PressLeftShiftAndControl) {
     TestDriver driver;
+    InSequence s;
     auto       key_lsft  = KeymapKey(0, 3, 0, KC_LEFT_SHIFT);
     auto       key_lctrl = KeymapKey(0, 5, 0, KC_LEFT_CTRL);
 
@@ -118,11 +114,8 @@ TEST_F(KeyPress, PressLeftShiftAndControl) {
     key_lsft.press();
     key_lctrl.press();
 
-    // Unfortunately modifiers are also processed in the wrong order
-    // See issue #1476 for more information
+    // All keys that changed within the same scan are processed in matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_lsft.report_code)));
-    keyboard_task();
-
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_lsft.report_code, key_lctrl.report_code)));
     keyboard_task();
 
@@ -130,14 +123,13 @@ TEST_F(KeyPress, PressLeftShiftAndControl) {
     key_lctrl.release();
 
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_lctrl.report_code)));
-    keyboard_task();
-
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     keyboard_task();
 }
 
 TEST_F(KeyPress, LeftAndRightShiftCanBePressedAtTheSameTime) {
     TestDriver driver;
+    InSequence s;
     auto       key_lsft = KeymapKey(0, 3, 0, KC_LEFT_SHIFT);
     auto       key_rsft = KeymapKey(0, 4, 0, KC_RIGHT_SHIFT);
 
@@ -145,11 +137,8 @@ TEST_F(KeyPress, LeftAndRightShiftCanBePressedAtTheSameTime) {
 
     key_lsft.press();
     key_rsft.press();
-    // Unfortunately modifiers are also processed in the wrong order
-    // See issue #1476 for more information
+    // All keys that changed within the same scan are processed in matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_lsft.report_code)));
-    keyboard_task();
-
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_lsft.report_code, key_rsft.report_code)));
     keyboard_task();
 
@@ -157,8 +146,6 @@ TEST_F(KeyPress, LeftAndRightShiftCanBePressedAtTheSameTime) {
     key_rsft.release();
 
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(key_rsft.report_code)));
-    keyboard_task();
-
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     keyboard_task();
 }
@@ -312,3 +299,43 @@ TEST_F(KeyPress, PressEqualPlusDontReleaseBeforePress) {
     run_one_scan_loop();
     testing::Mock::VerifyAndClearExpectations(&driver);
 }
+
+TEST_F(KeyPress, TenKeyRollIsReportedWithinOneScan) {
+    TestDriver driver;
+    /* Eight modifiers and two plain keys, so that the whole roll fits into a 6KRO report. */
+    const uint16_t keycodes[] = {KC_LEFT_CTRL, KC_LEFT_SHIFT, KC_LEFT_ALT, KC_LEFT_GUI, KC_RIGHT_CTRL, KC_RIGHT_SHIFT, KC_RIGHT_ALT, KC_RIGHT_GUI, KC_A, KC_B};
+    std::vector<KeymapKey> keys;
+
+    for (uint8_t i = 0; i < 10; i++) {
+        keys.push_back(KeymapKey(0, (i * 3) % MATRIX_COLS, i % MATRIX_ROWS, keycodes[i]));
+        add_key(keys.back());
+    }
+
+    report_keyboard_t last_report = {};
+    EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(SaveArg<0>(&last_report));
+
+    for (auto& key : keys) {
+        key.press();
+    }
+
+    auto     full_report = KeyboardReport(KC_LEFT_CTRL, KC_LEFT_SHIFT, KC_LEFT_ALT, KC_LEFT_GUI, KC_RIGHT_CTRL, KC_RIGHT_SHIFT, KC_RIGHT_ALT, KC_RIGHT_GUI, KC_A, KC_B);
+    unsigned scans       = 0;
+    while (!full_report.Matches(last_report) && scans < 20) {
+        run_one_scan_loop();
+        scans++;
+    }
+    EXPECT_EQ(scans, 1u) << "Pressing a 10 key roll took " << scans << " scans to reach the report";
+
+    for (auto& key : keys) {
+        key.release();
+    }
+
+    auto empty_report = KeyboardReport();
+    scans             = 0;
+    while (!empty_report.Matches(last_report) && scans < 20) {
+        run_one_scan_loop();
+        scans++;
+    }
+    EXPECT_EQ(scans, 1u) << "Releasing a 10 key roll took " << scans << " scans to reach the report";
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,222 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+
+extern "C" {
+#include "process_combo.h"
+
+void advance_time(uint32_t ms);
+}
+
+using testing::_;
+using testing::InSequence;
+
+/* A large generated combo set in the style of a chorded layout:
+ * combo 0 is a plain keycode combo, followed by every pair of the first 20
+ * letters and every triple of the first 12 letters, all as combo actions. */
+#define PAIR_KEYS 20
+#define TRIPLE_KEYS 12
+#define GENERATED_COMBO_COUNT (1 + PAIR_KEYS * (PAIR_KEYS - 1) / 2 + TRIPLE_KEYS * (TRIPLE_KEYS - 1) * (TRIPLE_KEYS - 2) / 6)
+
+static uint16_t                                  combo_keys[GENERATED_COMBO_COUNT][4];
+static std::map<std::vector<uint16_t>, uint16_t> combo_indices;
+static std::vector<std::pair<uint16_t, bool>>    combo_events;
+
+extern "C" {
+combo_t  key_combos[GENERATED_COMBO_COUNT];
+uint16_t COMBO_LEN = GENERATED_COMBO_COUNT;
+
+void process_combo_event(uint16_t combo_index, bool pressed) {
+    combo_events.push_back({combo_index, pressed});
+}
+}
+
+static void add_combo(std::vector<uint16_t> keys, uint16_t keycode) {
+    uint16_t index = combo_indices.size();
+    for (uint8_t i = 0; i < keys.size(); i++) {
+        combo_keys[index][i] = keys[i];
+    }
+    combo_keys[index][keys.size()] = COMBO_END;
+    key_combos[index]              = (combo_t){.keys = combo_keys[index], .keycode = keycode};
+    combo_indices[keys]            = index;
+}
+
+static struct GeneratedCombos {
+    GeneratedCombos() {
+        add_combo({KC_1, KC_2}, KC_ESCAPE);
+        for (uint16_t i = 0; i < PAIR_KEYS; i++) {
+            for (uint16_t j = i + 1; j < PAIR_KEYS; j++) {
+                add_combo({KC_A + i, KC_A + j}, KC_NO);
+            }
+        }
+        for (uint16_t i = 0; i < TRIPLE_KEYS; i++) {
+            for (uint16_t j = i + 1; j < TRIPLE_KEYS; j++) {
+                for (uint16_t k = j + 1; k < TRIPLE_KEYS; k++) {
+                    add_combo({KC_A + i, KC_A + j, KC_A + k}, KC_NO);
+                }
+            }
+        }
+    }
+} generated_combos;
+
+class Combo : public TestFixture {
+   public:
+    Combo() {
+        /* Letters and digits laid out over the whole test matrix. */
+        for (uint8_t i = 0; i < 36; i++) {
+            add_key(KeymapKey(0, i % MATRIX_COLS, i / MATRIX_COLS, i < 26 ? KC_A + i : KC_1 + (i - 26)));
+        }
+        combo_events.clear();
+        /* The combo timer treats a timestamp of 0 as "not running", keep the clock away from it. */
+        advance_time(1);
+    }
+
+    KeymapKey key(uint16_t keycode) {
+        uint8_t i = keycode >= KC_1 ? 26 + keycode - KC_1 : keycode - KC_A;
+        return KeymapKey(0, i % MATRIX_COLS, i / MATRIX_COLS, keycode);
+    }
+};
+
+TEST_F(Combo, KeycodeComboIsReported) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_1 = key(KC_1);
+    auto       key_2 = key(KC_2);
+
+    key_1.press();
+    key_2.press();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESCAPE)));
+    idle_for(COMBO_TERM + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    key_1.release();
+    key_2.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Combo, PairComboFiresItsAction) {
+    TestDriver driver;
+    auto       key_m = key(KC_M);
+    auto       key_n = key(KC_N);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    key_m.press();
+    key_n.press();
+    idle_for(COMBO_TERM + 1);
+    key_m.release();
+    key_n.release();
+    idle_for(COMBO_TERM + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    uint16_t index = combo_indices[{KC_M, KC_N}];
+    EXPECT_EQ(combo_events, (std::vector<std::pair<uint16_t, bool>>{{index, true}, {index, false}}));
+}
+
+TEST_F(Combo, LongestOverlappingComboWins) {
+    TestDriver driver;
+    auto       key_a = key(KC_A);
+    auto       key_b = key(KC_B);
+    auto       key_c = key(KC_C);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    key_a.press();
+    run_one_scan_loop();
+    key_b.press();
+    run_one_scan_loop();
+    key_c.press();
+    idle_for(COMBO_TERM + 1);
+    key_a.release();
+    key_b.release();
+    key_c.release();
+    idle_for(COMBO_TERM + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    uint16_t index = combo_indices[{KC_A, KC_B, KC_C}];
+    EXPECT_EQ(combo_events, (std::vector<std::pair<uint16_t, bool>>{{index, true}, {index, false}}));
+}
+
+TEST_F(Combo, ComboKeyAloneIsTypedAfterComboTerm) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_a = key(KC_A);
+
+    key_a.press();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(COMBO_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    key_a.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_TRUE(combo_events.empty());
+}
+
+TEST_F(Combo, NonComboKeyIsTypedImmediately) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_z = key(KC_Z);
+
+    key_z.press();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    key_z.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Combo, EventProcessingCost) {
+    const unsigned iterations = 2000;
+
+    auto measure = [&](uint16_t keycode) {
+        keyrecord_t record = {.event = {.key = key(keycode).position, .pressed = true, .time = 1}};
+        auto        start  = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            record.event.pressed = true;
+            process_combo(keycode, &record);
+            record.event.pressed = false;
+            process_combo(keycode, &record);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (2 * iterations);
+    };
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(testing::AnyNumber());
+    std::cout << "[ COMBO    ] " << COMBO_LEN << " combos, ns per event: key in no combo " << measure(KC_Z) << ", key in " << (PAIR_KEYS - 1) << "+ combos " << measure(KC_A) << std::endl;
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
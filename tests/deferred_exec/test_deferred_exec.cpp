@@ -0,0 +1,245 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "test_common.hpp"
+
+extern "C" {
+void advance_time(uint32_t ms);
+}
+
+namespace {
+
+struct Invocation {
+    uint32_t trigger_time;
+    uint32_t id;
+};
+
+std::vector<Invocation> invocations;
+uint32_t                repeat_delay = 0;
+
+uint32_t record_callback(uint32_t trigger_time, void *cb_arg) {
+    invocations.push_back({trigger_time, (uint32_t)(uintptr_t)cb_arg});
+    return repeat_delay;
+}
+
+class DeferredExec : public TestFixture {
+   protected:
+    std::vector<deferred_executor_t> table;
+    uint32_t                         last_execution = 0;
+
+    void SetUp() override {
+        invocations.clear();
+        repeat_delay   = 0;
+        last_execution = timer_read32();
+    }
+
+    void make_table(size_t count) {
+        table.assign(count, deferred_executor_t{});
+    }
+
+    void run_for(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; ++i) {
+            advance_time(1);
+            deferred_exec_advanced_task(table.data(), table.size(), &last_execution);
+        }
+    }
+};
+
+} // namespace
+
+TEST_F(DeferredExec, BasicExecutorRunsOnceAfterDelay) {
+    uint32_t       start = timer_read32();
+    deferred_token token = defer_exec(10, record_callback, (void *)1);
+    EXPECT_NE(token, INVALID_DEFERRED_TOKEN);
+
+    for (int i = 0; i < 9; ++i) {
+        advance_time(1);
+        deferred_exec_task();
+    }
+    EXPECT_TRUE(invocations.empty());
+
+    for (int i = 0; i < 10; ++i) {
+        advance_time(1);
+        deferred_exec_task();
+    }
+    ASSERT_EQ(invocations.size(), 1);
+    EXPECT_EQ(invocations[0].trigger_time, start + 10);
+    EXPECT_FALSE(cancel_deferred_exec(token));
+}
+
+TEST_F(DeferredExec, RepeatingExecutorKeepsCadence) {
+    make_table(4);
+    repeat_delay   = 10;
+    uint32_t start = timer_read32();
+    ASSERT_NE(defer_exec_advanced(table.data(), table.size(), 10, record_callback, NULL), INVALID_DEFERRED_TOKEN);
+
+    // A late task run still reports, and requeues from, the original trigger times
+    advance_time(35);
+    deferred_exec_advanced_task(table.data(), table.size(), &last_execution);
+    run_for(20);
+
+    ASSERT_EQ(invocations.size(), 5);
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        EXPECT_EQ(invocations[i].trigger_time, start + 10 * (i + 1));
+    }
+}
+
+TEST_F(DeferredExec, OverdueExecutorsRunOncePerPass) {
+    make_table(4);
+    repeat_delay   = 1;
+    uint32_t start = timer_read32();
+    ASSERT_NE(defer_exec_advanced(table.data(), table.size(), 1, record_callback, (void *)1), INVALID_DEFERRED_TOKEN);
+    ASSERT_NE(defer_exec_advanced(table.data(), table.size(), 8, record_callback, (void *)2), INVALID_DEFERRED_TOKEN);
+
+    // Both are overdue, the first one by far more than its period, but neither catches up within a single pass
+    advance_time(10);
+    deferred_exec_advanced_task(table.data(), table.size(), &last_execution);
+    ASSERT_EQ(invocations.size(), 2);
+    EXPECT_EQ(invocations[0].id, 1);
+    EXPECT_EQ(invocations[0].trigger_time, start + 1);
+    EXPECT_EQ(invocations[1].id, 2);
+    EXPECT_EQ(invocations[1].trigger_time, start + 8);
+
+    invocations.clear();
+    run_for(1);
+    ASSERT_EQ(invocations.size(), 2);
+    EXPECT_EQ(invocations[0].trigger_time, start + 2);
+    EXPECT_EQ(invocations[1].trigger_time, start + 9);
+}
+
+TEST_F(DeferredExec, ThousandsOfExecutorsRunInTriggerOrder) {
+    const size_t count = 4096;
+    make_table(count);
+
+    std::set<deferred_token> tokens;
+    for (size_t i = 0; i < count; ++i) {
+        // Scatter the delays, with plenty of duplicates
+        uint32_t       delay = 1 + (i * 7919) % 500;
+        deferred_token token = defer_exec_advanced(table.data(), table.size(), delay, record_callback, (void *)(uintptr_t)i);
+        ASSERT_NE(token, INVALID_DEFERRED_TOKEN);
+        tokens.insert(token);
+    }
+    EXPECT_EQ(tokens.size(), count);
+
+    // The table is full now
+    EXPECT_EQ(defer_exec_advanced(table.data(), table.size(), 1, record_callback, NULL), INVALID_DEFERRED_TOKEN);
+
+    run_for(500);
+    ASSERT_EQ(invocations.size(), count);
+    EXPECT_TRUE(std::is_sorted(invocations.begin(), invocations.end(), [](const Invocation &a, const Invocation &b) { return a.trigger_time < b.trigger_time; }));
+
+    std::set<uint32_t> ids;
+    for (auto &invocation : invocations) {
+        ids.insert(invocation.id);
+    }
+    EXPECT_EQ(ids.size(), count);
+
+    // Every slot was released again
+    for (auto token : tokens) {
+        EXPECT_FALSE(cancel_deferred_exec_advanced(table.data(), table.size(), token));
+    }
+    EXPECT_NE(defer_exec_advanced(table.data(), table.size(), 1, record_callback, NULL), INVALID_DEFERRED_TOKEN);
+}
+
+TEST_F(DeferredExec, CancelAndExtendAcrossLargeTable) {
+    const size_t count = 2048;
+    make_table(count);
+    uint32_t start = timer_read32();
+
+    std::vector<deferred_token> tokens;
+    for (size_t i = 0; i < count; ++i) {
+        tokens.push_back(defer_exec_advanced(table.data(), table.size(), 100 + i % 50, record_callback, (void *)(uintptr_t)i));
+        ASSERT_NE(tokens.back(), INVALID_DEFERRED_TOKEN);
+    }
+
+    // Cancel every odd executor, and push every fourth one out by another 200ms
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 2) {
+            EXPECT_TRUE(cancel_deferred_exec_advanced(table.data(), table.size(), tokens[i]));
+            EXPECT_FALSE(cancel_deferred_exec_advanced(table.data(), table.size(), tokens[i]));
+            EXPECT_FALSE(extend_deferred_exec_advanced(table.data(), table.size(), tokens[i], 10));
+        } else if (i % 4 == 0) {
+            EXPECT_TRUE(extend_deferred_exec_advanced(table.data(), table.size(), tokens[i], 300));
+        }
+    }
+
+    run_for(200);
+    EXPECT_EQ(invocations.size(), count / 4);
+    for (auto &invocation : invocations) {
+        EXPECT_EQ(invocation.id % 4, 2);
+        EXPECT_EQ(invocation.trigger_time, start + 100 + invocation.id % 50);
+    }
+
+    invocations.clear();
+    run_for(200);
+    EXPECT_EQ(invocations.size(), count / 4);
+    for (auto &invocation : invocations) {
+        EXPECT_EQ(invocation.id % 4, 0);
+        EXPECT_EQ(invocation.trigger_time, start + 300);
+    }
+}
+
+namespace {
+
+deferred_executor_t reentrant_table[8];
+deferred_token      reentrant_token = INVALID_DEFERRED_TOKEN;
+
+uint32_t cancel_self_callback(uint32_t trigger_time, void *cb_arg) {
+    invocations.push_back({trigger_time, 0});
+    // Cancel ourselves and let a new executor take over the freed slot
+    cancel_deferred_exec_advanced(reentrant_table, 8, reentrant_token);
+    reentrant_token = defer_exec_advanced(reentrant_table, 8, 5, record_callback, (void *)1);
+    // Must not affect the newly queued executor
+    return 1;
+}
+
+} // namespace
+
+TEST_F(DeferredExec, CallbackMayReenterTheApi) {
+    memset(reentrant_table, 0, sizeof(reentrant_table));
+    uint32_t start  = timer_read32();
+    reentrant_token = defer_exec_advanced(reentrant_table, 8, 5, cancel_self_callback, NULL);
+    ASSERT_NE(reentrant_token, INVALID_DEFERRED_TOKEN);
+
+    for (int i = 0; i < 20; ++i) {
+        advance_time(1);
+        deferred_exec_advanced_task(reentrant_table, 8, &last_execution);
+    }
+
+    ASSERT_EQ(invocations.size(), 2);
+    EXPECT_EQ(invocations[0].id, 0);
+    EXPECT_EQ(invocations[0].trigger_time, start + 5);
+    EXPECT_EQ(invocations[1].id, 1);
+    EXPECT_EQ(invocations[1].trigger_time, start + 10);
+}
+
+TEST_F(DeferredExec, StaleTokensAreRejected) {
+    make_table(3);
+    deferred_token token = defer_exec_advanced(table.data(), table.size(), 5, record_callback, NULL);
+    run_for(10);
+    ASSERT_EQ(invocations.size(), 1);
+
+    // The slot gets reused, but under a different token
+    deferred_token reused = defer_exec_advanced(table.data(), table.size(), 5, record_callback, NULL);
+    EXPECT_NE(reused, token);
+    EXPECT_FALSE(extend_deferred_exec_advanced(table.data(), table.size(), token, 5));
+    EXPECT_FALSE(cancel_deferred_exec_advanced(table.data(), table.size(), token));
+    EXPECT_TRUE(cancel_deferred_exec_advanced(table.data(), table.size(), reused));
+}
@@ -0,0 +1,207 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+
+#include "keycode.h"
+#include "test_common.hpp"
+#include "host_report_queue.h"
+
+using testing::_;
+using testing::InSequence;
+using testing::Invoke;
+
+extern "C" {
+void advance_time(uint32_t ms);
+}
+
+class HostReportQueue : public TestFixture {
+   public:
+    void SetUp() override {
+        // Let whatever the previous test sent age past the polling interval
+        advance_time(HOST_REPORT_QUEUE_INTERVAL);
+        host_report_queue_task();
+        host_report_queue_reset_stats();
+    }
+
+    void record_mouse(TestDriver& driver) {
+        EXPECT_CALL(driver, send_mouse_mock(_)).WillRepeatedly(Invoke([this](report_mouse_t& report) { mouse_reports.push_back(report); }));
+    }
+
+    void send_mouse(uint8_t buttons, int8_t x, int8_t y) {
+        report_mouse_t report = {};
+        report.buttons        = buttons;
+        report.x              = x;
+        report.y              = y;
+        host_mouse_send(&report);
+    }
+
+    host_report_queue_stats_t stats(host_report_queue_endpoint_t endpoint) {
+        host_report_queue_stats_t stats;
+        host_report_queue_get_stats(endpoint, &stats);
+        return stats;
+    }
+
+    std::vector<report_mouse_t> mouse_reports;
+};
+
+TEST_F(HostReportQueue, PressesInTheSameScanGoOutOnePerPoll) {
+    TestDriver driver;
+    auto       key_b = KeymapKey(0, 0, 0, KC_B);
+    auto       key_c = KeymapKey(0, 1, 1, KC_C);
+
+    set_keymap({key_b, key_c});
+
+    key_b.press();
+    key_c.press();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(host_report_queue_depth(HOST_REPORT_QUEUE_KEYBOARD), 1);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_EQ(host_report_queue_depth(HOST_REPORT_QUEUE_KEYBOARD), 0);
+
+    key_b.release();
+    key_c.release();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    run_one_scan_loop();
+    run_one_scan_loop();
+}
+
+TEST_F(HostReportQueue, ReleasesAreMerged) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_a = KeymapKey(0, 0, 0, KC_A);
+    auto       key_b = KeymapKey(0, 1, 0, KC_B);
+    auto       key_c = KeymapKey(0, 2, 0, KC_C);
+
+    set_keymap({key_a, key_b, key_c});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(3);
+    for (auto key : {key_a, key_b, key_c}) {
+        key.press();
+        run_one_scan_loop();
+    }
+
+    key_a.release();
+    key_b.release();
+    key_c.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    run_one_scan_loop();
+
+    EXPECT_EQ(stats(HOST_REPORT_QUEUE_KEYBOARD).merged, 1);
+}
+
+TEST_F(HostReportQueue, MouseMovementIsAddedUp) {
+    TestDriver driver;
+    record_mouse(driver);
+
+    send_mouse(0, 1, -1);
+    send_mouse(0, 2, -2);
+    send_mouse(0, 3, -3);
+    ASSERT_EQ(mouse_reports.size(), 1);
+    EXPECT_EQ(mouse_reports[0].x, 1);
+
+    advance_time(HOST_REPORT_QUEUE_INTERVAL);
+    host_report_queue_task();
+    ASSERT_EQ(mouse_reports.size(), 2);
+    EXPECT_EQ(mouse_reports[1].x, 5);
+    EXPECT_EQ(mouse_reports[1].y, -5);
+    EXPECT_EQ(stats(HOST_REPORT_QUEUE_MOUSE).merged, 1);
+}
+
+TEST_F(HostReportQueue, MouseMovementDoesNotOverflow) {
+    TestDriver driver;
+    record_mouse(driver);
+
+    send_mouse(0, 1, 0);
+    send_mouse(0, 100, 0);
+    send_mouse(0, 100, 0);
+    EXPECT_EQ(host_report_queue_depth(HOST_REPORT_QUEUE_MOUSE), 2);
+
+    for (int i = 0; i < 2; i++) {
+        advance_time(HOST_REPORT_QUEUE_INTERVAL);
+        host_report_queue_task();
+    }
+    ASSERT_EQ(mouse_reports.size(), 3);
+    EXPECT_EQ(mouse_reports[1].x, 100);
+    EXPECT_EQ(mouse_reports[2].x, 100);
+}
+
+TEST_F(HostReportQueue, ButtonChangesKeepTheirOwnMovement) {
+    TestDriver driver;
+    record_mouse(driver);
+
+    send_mouse(0, 1, 0);
+    send_mouse(1, 0, 0);
+    send_mouse(1, 4, 0);
+    send_mouse(1, 4, 0);
+    EXPECT_EQ(host_report_queue_depth(HOST_REPORT_QUEUE_MOUSE), 2);
+
+    for (int i = 0; i < 2; i++) {
+        advance_time(HOST_REPORT_QUEUE_INTERVAL);
+        host_report_queue_task();
+    }
+    ASSERT_EQ(mouse_reports.size(), 3);
+    EXPECT_EQ(mouse_reports[1].buttons, 1);
+    EXPECT_EQ(mouse_reports[1].x, 0);
+    EXPECT_EQ(mouse_reports[2].buttons, 1);
+    EXPECT_EQ(mouse_reports[2].x, 8);
+
+    send_mouse(0, 0, 0);
+    advance_time(HOST_REPORT_QUEUE_INTERVAL);
+    host_report_queue_task();
+}
+
+TEST_F(HostReportQueue, ReportsWithoutMovementAreDropped) {
+    TestDriver driver;
+    record_mouse(driver);
+
+    send_mouse(0, 2, 0);
+    advance_time(HOST_REPORT_QUEUE_INTERVAL);
+    send_mouse(0, 0, 0);
+    EXPECT_EQ(mouse_reports.size(), 1);
+    EXPECT_EQ(stats(HOST_REPORT_QUEUE_MOUSE).dropped, 1);
+}
+
+TEST_F(HostReportQueue, FullQueueSendsEarly) {
+    TestDriver           driver;
+    std::vector<uint16_t> sent;
+    EXPECT_CALL(driver, send_consumer_mock(_)).WillRepeatedly(Invoke([&sent](uint16_t report) { sent.push_back(report); }));
+
+    for (uint16_t usage = 1; usage <= HOST_REPORT_QUEUE_CONSUMER_SIZE + 2; usage++) {
+        host_consumer_send(usage);
+    }
+    EXPECT_EQ(sent.size(), 2);
+    EXPECT_EQ(stats(HOST_REPORT_QUEUE_CONSUMER).overflowed, 1);
+    EXPECT_EQ(stats(HOST_REPORT_QUEUE_CONSUMER).max_depth, HOST_REPORT_QUEUE_CONSUMER_SIZE);
+
+    host_consumer_send(0);
+    while (host_report_queue_depth(HOST_REPORT_QUEUE_CONSUMER)) {
+        advance_time(HOST_REPORT_QUEUE_INTERVAL);
+        host_report_queue_task();
+    }
+    ASSERT_EQ(sent.size(), HOST_REPORT_QUEUE_CONSUMER_SIZE + 3);
+    for (uint16_t i = 0; i < HOST_REPORT_QUEUE_CONSUMER_SIZE + 2; i++) {
+        EXPECT_EQ(sent[i], i + 1);
+    }
+    EXPECT_EQ(sent.back(), 0);
+}
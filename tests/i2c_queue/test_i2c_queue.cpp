@@ -0,0 +1,233 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include "test_common.hpp"
+
+extern "C" {
+#include "i2c_master.h"
+#include "i2c_queue.h"
+
+extern uint8_t g_pwm_buffer[DRIVER_COUNT][192];
+
+const is31_led PROGMEM g_is31_leds[DRIVER_LED_TOTAL] = {
+    {0, A_1, A_2, A_3},
+    {0, A_4, A_5, A_6},
+    {0, E_1, F_1, G_1},
+    {0, L_14, L_15, L_16},
+};
+
+led_config_t g_led_config = {{
+    {0, 1, 2, 3, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+    {NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+    {NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+    {NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+}, {
+    {0, 0}, {64, 0}, {128, 0}, {192, 0},
+}, {
+    4, 4, 4, 4,
+}};
+
+static uint32_t blocking_transfers = 0;
+
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    blocking_transfers++;
+    return I2C_STATUS_SUCCESS;
+}
+
+/* Mock transport: transfers complete once the bus is no longer busy. */
+static std::vector<i2c_transfer_t *> started;
+static bool                          bus_busy   = false;
+static i2c_status_t                  bus_status = I2C_STATUS_SUCCESS;
+
+void i2c_queue_transport_start(i2c_transfer_t *transfer) {
+    started.push_back(transfer);
+}
+
+bool i2c_queue_transport_poll(i2c_status_t *status) {
+    if (bus_busy) {
+        return false;
+    }
+    *status = bus_status;
+    return true;
+}
+}
+
+static std::vector<i2c_transfer_t *> completed;
+
+static void record_completion(i2c_transfer_t *transfer, i2c_status_t status) {
+    completed.push_back(transfer);
+}
+
+static i2c_transfer_t make_transfer(uint8_t priority, const uint8_t *data, uint16_t length) {
+    i2c_transfer_t transfer = {};
+    transfer.address        = 0x50 << 1;
+    transfer.priority       = priority;
+    transfer.reg_length     = 1;
+    transfer.tx_data        = data;
+    transfer.tx_length      = length;
+    transfer.callback       = record_completion;
+    return transfer;
+}
+
+class I2CQueue : public TestFixture {
+   protected:
+    void SetUp() override {
+        // Bring the LED driver in sync with the buffers, whatever the effect did before
+        bus_busy   = false;
+        bus_status = I2C_STATUS_SUCCESS;
+        rgb_matrix_set_color_all(0, 0, 0);
+        rgb_matrix_driver.flush();
+        i2c_queue_flush();
+        started.clear();
+        completed.clear();
+        blocking_transfers = 0;
+    }
+
+    void TearDown() override {
+        bus_busy = false;
+        i2c_queue_flush();
+    }
+};
+
+TEST_F(I2CQueue, CallbacksRunFromTheTask) {
+    uint8_t        data[4]  = {1, 2, 3, 4};
+    i2c_transfer_t transfer = make_transfer(I2C_QUEUE_PRIORITY_NORMAL, data, sizeof(data));
+
+    EXPECT_TRUE(i2c_queue_submit(&transfer));
+    ASSERT_EQ(started.size(), 1);
+    // The buffer goes to the transport as is
+    EXPECT_EQ(started[0]->tx_data, data);
+    EXPECT_TRUE(completed.empty());
+    EXPECT_TRUE(i2c_transfer_pending(&transfer));
+
+    i2c_queue_task();
+    EXPECT_EQ(completed, std::vector<i2c_transfer_t *>({&transfer}));
+    EXPECT_FALSE(i2c_transfer_pending(&transfer));
+}
+
+TEST_F(I2CQueue, PendingTransferIsNotQueuedTwice) {
+    uint8_t        data     = 0;
+    i2c_transfer_t transfer = make_transfer(I2C_QUEUE_PRIORITY_NORMAL, &data, 1);
+
+    bus_busy = true;
+    EXPECT_TRUE(i2c_queue_submit(&transfer));
+    EXPECT_FALSE(i2c_queue_submit(&transfer));
+    i2c_queue_task();
+    EXPECT_TRUE(completed.empty());
+
+    bus_busy = false;
+    i2c_queue_task();
+    EXPECT_EQ(completed.size(), 1);
+    EXPECT_TRUE(i2c_queue_submit(&transfer));
+    i2c_queue_task();
+    EXPECT_EQ(completed.size(), 2);
+}
+
+TEST_F(I2CQueue, HighPriorityTransfersGoFirst) {
+    uint8_t        data   = 0;
+    i2c_transfer_t first  = make_transfer(I2C_QUEUE_PRIORITY_NORMAL, &data, 1);
+    i2c_transfer_t second = make_transfer(I2C_QUEUE_PRIORITY_NORMAL, &data, 1);
+    i2c_transfer_t sensor = make_transfer(I2C_QUEUE_PRIORITY_HIGH, &data, 1);
+
+    bus_busy = true;
+    i2c_queue_submit(&first);
+    i2c_queue_submit(&second);
+    i2c_queue_submit(&sensor);
+    // The transfer in flight is not interrupted
+    EXPECT_EQ(started, std::vector<i2c_transfer_t *>({&first}));
+
+    bus_busy = false;
+    i2c_queue_flush();
+    EXPECT_EQ(started, std::vector<i2c_transfer_t *>({&first, &sensor, &second}));
+    EXPECT_EQ(completed, std::vector<i2c_transfer_t *>({&first, &sensor, &second}));
+}
+
+TEST_F(I2CQueue, TransferMayBeQueuedAgainFromItsCallback) {
+    static unsigned       runs = 0;
+    static uint8_t        data = 0;
+    static i2c_transfer_t transfer;
+
+    runs              = 0;
+    transfer          = make_transfer(I2C_QUEUE_PRIORITY_NORMAL, &data, 1);
+    transfer.callback = [](i2c_transfer_t *transfer, i2c_status_t status) {
+        if (++runs < 3) {
+            i2c_queue_submit(transfer);
+        }
+    };
+
+    i2c_queue_submit(&transfer);
+    i2c_queue_flush();
+    EXPECT_EQ(runs, 3);
+    EXPECT_EQ(started.size(), 3);
+}
+
+TEST_F(I2CQueue, LedFlushDoesNotWaitForTheBus) {
+    bus_busy = true;
+    rgb_matrix_set_color(0, 1, 2, 3);
+    rgb_matrix_set_color(3, 4, 5, 6);
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(started.size(), 1);
+    EXPECT_EQ(blocking_transfers, 0);
+
+    // Nothing more is queued while the update is on the bus
+    rgb_matrix_set_color(1, 7, 8, 9);
+    rgb_matrix_driver.flush();
+
+    bus_busy = false;
+    i2c_queue_flush();
+    // Unlock, page select and one burst from A_1 to L_16, straight from the PWM buffer
+    ASSERT_EQ(started.size(), 3);
+    EXPECT_EQ(started[2]->reg, 0x00);
+    EXPECT_EQ(started[2]->tx_length, 192);
+    EXPECT_EQ(started[2]->tx_data, &g_pwm_buffer[0][0]);
+
+    // The change made in the meantime goes out with the next update
+    started.clear();
+    rgb_matrix_driver.flush();
+    i2c_queue_flush();
+    ASSERT_EQ(started.size(), 3);
+    EXPECT_EQ(started[2]->reg, 0x00);
+    EXPECT_EQ(started[2]->tx_length, 16);
+}
+
+TEST_F(I2CQueue, FailedLedFlushFallsBackToFullRefresh) {
+    bus_status = I2C_STATUS_ERROR;
+    rgb_matrix_set_color(2, 1, 2, 3);
+    rgb_matrix_driver.flush();
+    i2c_queue_flush();
+    bus_status = I2C_STATUS_SUCCESS;
+
+    started.clear();
+    rgb_matrix_driver.flush();
+    i2c_queue_flush();
+    ASSERT_EQ(started.size(), 3);
+    EXPECT_EQ(started[2]->tx_length, 192);
+}
+
+TEST_F(I2CQueue, BlockingWritesWaitForQueuedTransfers) {
+    rgb_matrix_set_color(0, 1, 2, 3);
+    rgb_matrix_driver.flush();
+    ASSERT_EQ(started.size(), 1);
+    EXPECT_TRUE(i2c_transfer_pending(started[0]));
+
+    IS31FL3733_write_register(DRIVER_ADDR_1, 0x00, 0x00);
+    EXPECT_EQ(started.size(), 3);
+    EXPECT_FALSE(i2c_transfer_pending(started.back()));
+    EXPECT_EQ(blocking_transfers, 1);
+}
@@ -0,0 +1,303 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+
+extern "C" {
+#include "process_key_override.h"
+}
+
+using testing::_;
+using testing::Invoke;
+
+/* A large generated override set in the style of shifted-symbol remaps:
+ * every letter and digit has a shift override and a ctrl/alt override,
+ * followed by alt overrides that only apply on layer 1. */
+#define DISABLED_OVERRIDES 40
+
+static bool                                disabled = false;
+static std::vector<key_override_t>         override_storage;
+static std::vector<const key_override_t *> generated_overrides;
+static std::vector<const key_override_t *> padded_overrides;
+
+extern "C" {
+const key_override_t **key_overrides = NULL;
+}
+
+static key_override_t make_override(uint8_t trigger_mods, uint16_t trigger, uint16_t replacement, layer_state_t layers = ~0, uint8_t negative_mod_mask = 0, uint8_t options = ko_options_default) {
+    key_override_t override    = {};
+    override.trigger           = trigger;
+    override.trigger_mods      = trigger_mods;
+    override.layers            = layers;
+    override.negative_mod_mask = negative_mod_mask;
+    override.suppressed_mods   = trigger_mods;
+    override.replacement       = replacement;
+    override.options           = (ko_option_t)options;
+    return override;
+}
+
+static struct GeneratedOverrides {
+    GeneratedOverrides() {
+        override_storage.reserve(256);
+
+        key_override_t ctrl_1 = make_override(MOD_BIT(KC_LCTL), KC_1, KC_ESCAPE);
+        ctrl_1.enabled        = &disabled;
+        override_storage.push_back(ctrl_1);
+        override_storage.push_back(make_override(MOD_BIT(KC_LALT) | MOD_BIT(KC_RSFT), KC_NO, KC_ESCAPE));
+
+        for (uint16_t i = 0; i < 26; i++) {
+            override_storage.push_back(make_override(MOD_MASK_SHIFT, KC_A + i, KC_A + (i + 1) % 26, ~0, MOD_MASK_CA));
+            override_storage.push_back(make_override(MOD_MASK_CA, KC_A + i, KC_1 + i % 10, ~0, MOD_MASK_SHIFT, ko_options_default | ko_option_one_mod));
+        }
+        for (uint16_t i = 0; i < 10; i++) {
+            override_storage.push_back(make_override(MOD_MASK_SHIFT, KC_1 + i, KC_F1 + i));
+            override_storage.push_back(make_override(MOD_BIT(KC_LCTL), KC_1 + i, S(KC_A + i)));
+        }
+        for (uint16_t i = 0; i < 36; i++) {
+            override_storage.push_back(make_override(MOD_MASK_ALT, i < 26 ? KC_A + i : KC_1 + (i - 26), KC_ESCAPE, 1 << 1));
+        }
+        // Never reached, the shift override for KC_Z above comes first
+        override_storage.push_back(make_override(MOD_MASK_SHIFT, KC_Z, KC_ENTER));
+
+        for (auto &override : override_storage) {
+            generated_overrides.push_back(&override);
+        }
+        generated_overrides.push_back(nullptr);
+
+        /* The same overrides, followed by enough disabled ones to exceed the
+         * index, so that they are processed by the linear scan. */
+        padded_overrides = generated_overrides;
+        padded_overrides.pop_back();
+        for (uint16_t i = 0; i < DISABLED_OVERRIDES; i++) {
+            override_storage.push_back(make_override(0, KC_A + i % 26, KC_ESCAPE));
+            override_storage.back().enabled = &disabled;
+            padded_overrides.push_back(&override_storage.back());
+        }
+        padded_overrides.push_back(nullptr);
+    }
+} generated;
+
+class KeyOverride : public TestFixture {
+   protected:
+    TestDriver                     driver;
+    std::vector<report_keyboard_t> sent;
+
+    void SetUp() override {
+        /* Letters and digits, then modifiers, laid out over the whole test matrix. */
+        for (uint8_t i = 0; i < 36; i++) {
+            add_key(KeymapKey(0, i % MATRIX_COLS, i / MATRIX_COLS, i < 26 ? KC_A + i : KC_1 + (i - 26)));
+        }
+        add_key(KeymapKey(0, 6, 3, KC_LSFT));
+        add_key(KeymapKey(0, 7, 3, KC_LCTL));
+        add_key(KeymapKey(0, 8, 3, KC_LALT));
+        add_key(KeymapKey(0, 9, 3, KC_RSFT));
+
+        key_overrides = generated_overrides.data();
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([this](report_keyboard_t &report) { sent.push_back(report); }));
+    }
+
+    void TearDown() override {
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+
+    KeymapKey key(uint16_t keycode) {
+        switch (keycode) {
+            case KC_LSFT:
+                return KeymapKey(0, 6, 3, KC_LSFT);
+            case KC_LCTL:
+                return KeymapKey(0, 7, 3, KC_LCTL);
+            case KC_LALT:
+                return KeymapKey(0, 8, 3, KC_LALT);
+            case KC_RSFT:
+                return KeymapKey(0, 9, 3, KC_RSFT);
+        }
+        uint8_t i = keycode >= KC_1 ? 26 + keycode - KC_1 : keycode - KC_A;
+        return KeymapKey(0, i % MATRIX_COLS, i / MATRIX_COLS, keycode);
+    }
+
+    void tap_with(std::vector<uint16_t> mods, uint16_t keycode) {
+        for (auto mod : mods) {
+            key(mod).press();
+            run_one_scan_loop();
+        }
+        key(keycode).press();
+        run_one_scan_loop();
+        last = sent.back();
+        key(keycode).release();
+        run_one_scan_loop();
+        for (auto mod : mods) {
+            key(mod).release();
+            run_one_scan_loop();
+        }
+        idle_for(KEY_OVERRIDE_REPEAT_DELAY + 1);
+    }
+
+    report_keyboard_t last;
+};
+
+static report_keyboard_t report(uint8_t mods, uint8_t keycode) {
+    report_keyboard_t report = {};
+    report.mods              = mods;
+    add_key_to_report(&report, keycode);
+    return report;
+}
+
+TEST_F(KeyOverride, KeyWithoutModsIsNotReplaced) {
+    tap_with({}, KC_A);
+    EXPECT_EQ(last, report(0, KC_A));
+}
+
+TEST_F(KeyOverride, ShiftedKeyIsReplaced) {
+    tap_with({KC_LSFT}, KC_A);
+    EXPECT_EQ(last, report(0, KC_B));
+
+    tap_with({KC_RSFT}, KC_5);
+    EXPECT_EQ(last, report(0, KC_F5));
+}
+
+TEST_F(KeyOverride, ReplacementMayHaveMods) {
+    tap_with({KC_LCTL}, KC_3);
+    EXPECT_EQ(last, report(MOD_BIT(KC_LSFT), KC_C));
+}
+
+TEST_F(KeyOverride, FirstMatchingOverrideWins) {
+    tap_with({KC_LSFT}, KC_Z);
+    EXPECT_EQ(last, report(0, KC_A));
+}
+
+TEST_F(KeyOverride, DisabledOverrideIsSkipped) {
+    tap_with({KC_LCTL}, KC_1);
+    EXPECT_EQ(last, report(MOD_BIT(KC_LSFT), KC_A));
+}
+
+TEST_F(KeyOverride, OneOfTheModsIsEnough) {
+    tap_with({KC_LALT}, KC_C);
+    EXPECT_EQ(last, report(0, KC_3));
+}
+
+TEST_F(KeyOverride, NegativeModBlocksOverride) {
+    tap_with({KC_LCTL, KC_LSFT}, KC_C);
+    EXPECT_EQ(last, report(MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT), KC_C));
+}
+
+TEST_F(KeyOverride, OverrideOnOtherLayerIsSkipped) {
+    tap_with({KC_LALT}, KC_5);
+    EXPECT_EQ(last, report(MOD_BIT(KC_LALT), KC_5));
+}
+
+TEST_F(KeyOverride, ModsOnlyOverride) {
+    auto alt   = key(KC_LALT);
+    auto shift = key(KC_RSFT);
+
+    alt.press();
+    run_one_scan_loop();
+    shift.press();
+    run_one_scan_loop();
+    idle_for(KEY_OVERRIDE_REPEAT_DELAY + 1);
+    EXPECT_EQ(sent.back(), report(0, KC_ESCAPE));
+
+    shift.release();
+    run_one_scan_loop();
+    alt.release();
+    run_one_scan_loop();
+    EXPECT_EQ(sent.back(), report(0, KC_NO));
+}
+
+TEST_F(KeyOverride, ModPressedAfterTriggerActivatesOverride) {
+    auto key_d = key(KC_D);
+    auto shift = key(KC_LSFT);
+
+    key_d.press();
+    run_one_scan_loop();
+    shift.press();
+    run_one_scan_loop();
+    idle_for(KEY_OVERRIDE_REPEAT_DELAY + 1);
+    EXPECT_EQ(sent.back(), report(0, KC_E));
+
+    shift.release();
+    run_one_scan_loop();
+    key_d.release();
+    run_one_scan_loop();
+    idle_for(KEY_OVERRIDE_REPEAT_DELAY + 1);
+    EXPECT_EQ(sent.back(), report(0, KC_NO));
+}
+
+/* Replays random key events once against the overrides, and once against the
+ * same overrides padded to force the linear scan, and compares the reports. */
+TEST_F(KeyOverride, MatchesLinearScan) {
+    static const uint16_t keycodes[] = {KC_A, KC_B, KC_C, KC_Z, KC_1, KC_2, KC_0, KC_LSFT, KC_LCTL, KC_LALT, KC_RSFT};
+
+    auto replay = [&](const key_override_t **overrides) {
+        std::mt19937      rng(1234);
+        std::vector<bool> pressed(sizeof(keycodes) / sizeof(keycodes[0]));
+        key_overrides = overrides;
+        sent.clear();
+        for (unsigned i = 0; i < 4000; i++) {
+            uint8_t k  = rng() % pressed.size();
+            pressed[k] = !pressed[k];
+            if (pressed[k]) {
+                key(keycodes[k]).press();
+            } else {
+                key(keycodes[k]).release();
+            }
+            run_one_scan_loop();
+            if (rng() % 8 == 0) {
+                idle_for(rng() % (KEY_OVERRIDE_REPEAT_DELAY + 100));
+            }
+        }
+        for (uint8_t k = 0; k < pressed.size(); k++) {
+            if (pressed[k]) {
+                key(keycodes[k]).release();
+                run_one_scan_loop();
+            }
+        }
+        idle_for(KEY_OVERRIDE_REPEAT_DELAY + 1);
+        return sent;
+    };
+
+    auto expected = replay(padded_overrides.data());
+    auto actual   = replay(generated_overrides.data());
+    ASSERT_GT(expected.size(), 1000);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(actual[i], expected[i]) << "report " << i;
+    }
+}
+
+TEST_F(KeyOverride, EventProcessingCost) {
+    const unsigned iterations = 2000;
+
+    auto measure = [&](uint16_t keycode) {
+        keyrecord_t record = {.event = {.key = key(keycode).position, .pressed = true, .time = 1}};
+        auto        start  = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            record.event.pressed = true;
+            process_key_override(keycode, &record);
+            record.event.pressed = false;
+            process_key_override(keycode, &record);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (2 * iterations);
+    };
+
+    std::cout << "[ KEY_OVR  ] " << generated_overrides.size() - 1 << " overrides, ns per event: key " << measure(KC_Q) << ", modifier " << measure(KC_LSFT) << std::endl;
+}
@@ -0,0 +1,208 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <functional>
+#include <string.h>
+
+#include "keycode.h"
+#include "test_common.hpp"
+#include "action_util.h"
+
+using testing::_;
+using testing::InSequence;
+
+namespace {
+
+// Small deterministic generator, so failures can be reproduced
+struct Lcg {
+    uint32_t state;
+
+    uint32_t next() {
+        state = state * 1664525 + 1013904223;
+        return state >> 8;
+    }
+};
+
+uint8_t random_code(Lcg& rng) {
+    // A narrow range makes repeated presses and releases of the same key likely
+    return KC_A + rng.next() % 12;
+}
+
+} // namespace
+
+class KeyboardReportBitmap : public TestFixture {};
+
+TEST_F(KeyboardReportBitmap, MatchesLinearBuilder) {
+    report_keyboard_t linear = {};
+    report_keyboard_t report = {};
+    keyboard_bitmap_t bitmap;
+    keyboard_bitmap_init(&bitmap, &report);
+
+    Lcg rng = {1};
+    for (int i = 0; i < 20000; i++) {
+        uint32_t op   = rng.next() % 16;
+        uint8_t  code = random_code(rng);
+        if (op < 8) {
+            add_key_to_report(&linear, code);
+            keyboard_bitmap_add_key(&bitmap, code);
+        } else if (op < 15) {
+            del_key_from_report(&linear, code);
+            keyboard_bitmap_del_key(&bitmap, code);
+        } else {
+            clear_keys_from_report(&linear);
+            keyboard_bitmap_clear_keys(&bitmap);
+        }
+
+        ASSERT_EQ(memcmp(linear.raw, report.raw, sizeof(report.raw)), 0) << "after operation " << i;
+        ASSERT_EQ(has_anykey(&linear), keyboard_bitmap_has_anykey(&bitmap)) << "after operation " << i;
+        ASSERT_EQ(get_first_key(&linear), keyboard_bitmap_get_first_key(&bitmap)) << "after operation " << i;
+        for (uint8_t k = KC_A; k < KC_A + 12; k++) {
+            ASSERT_EQ(is_key_pressed(&linear, k), keyboard_bitmap_is_key_pressed(&bitmap, k)) << "after operation " << i;
+        }
+    }
+}
+
+TEST_F(KeyboardReportBitmap, FirstKeyIsInFirstSlot) {
+    report_keyboard_t report = {};
+    keyboard_bitmap_t bitmap;
+    keyboard_bitmap_init(&bitmap, &report);
+
+    EXPECT_EQ(keyboard_bitmap_get_first_key(&bitmap), KC_NO);
+    keyboard_bitmap_add_key(&bitmap, KC_C);
+    keyboard_bitmap_add_key(&bitmap, KC_B);
+    EXPECT_EQ(keyboard_bitmap_get_first_key(&bitmap), KC_C);
+    // As with get_first_key, a released key leaves its slot empty rather than promoting the next one
+    keyboard_bitmap_del_key(&bitmap, KC_C);
+    EXPECT_EQ(keyboard_bitmap_get_first_key(&bitmap), KC_NO);
+    keyboard_bitmap_add_key(&bitmap, KC_D);
+    EXPECT_EQ(keyboard_bitmap_get_first_key(&bitmap), KC_D);
+}
+
+TEST_F(KeyboardReportBitmap, ChangedOnlyWhenKeysChange) {
+    report_keyboard_t report = {};
+    keyboard_bitmap_t bitmap;
+    keyboard_bitmap_init(&bitmap, &report);
+
+    EXPECT_FALSE(keyboard_bitmap_take_changed(&bitmap));
+    keyboard_bitmap_add_key(&bitmap, KC_A);
+    EXPECT_TRUE(keyboard_bitmap_take_changed(&bitmap));
+    EXPECT_FALSE(keyboard_bitmap_take_changed(&bitmap));
+
+    keyboard_bitmap_add_key(&bitmap, KC_A);
+    keyboard_bitmap_del_key(&bitmap, KC_B);
+    EXPECT_FALSE(keyboard_bitmap_take_changed(&bitmap));
+
+    keyboard_bitmap_clear_keys(&bitmap);
+    EXPECT_TRUE(keyboard_bitmap_take_changed(&bitmap));
+    keyboard_bitmap_clear_keys(&bitmap);
+    EXPECT_FALSE(keyboard_bitmap_take_changed(&bitmap));
+}
+
+TEST_F(KeyboardReportBitmap, SeventhKeyIsDropped) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_a = KeymapKey(0, 0, 0, KC_A);
+    auto       key_b = KeymapKey(0, 1, 0, KC_B);
+    auto       key_c = KeymapKey(0, 2, 0, KC_C);
+    auto       key_d = KeymapKey(0, 3, 0, KC_D);
+    auto       key_e = KeymapKey(0, 4, 0, KC_E);
+    auto       key_f = KeymapKey(0, 5, 0, KC_F);
+    auto       key_g = KeymapKey(0, 6, 0, KC_G);
+
+    set_keymap({key_a, key_b, key_c, key_d, key_e, key_f, key_g});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    for (auto key : {key_a, key_b, key_c, key_d, key_e, key_f}) {
+        key.press();
+        run_one_scan_loop();
+    }
+
+    key_g.press();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+
+    key_c.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_D, KC_E, KC_F)));
+    run_one_scan_loop();
+
+    // The freed slot is reused by the next key, as with the linear builder
+    key_c.press();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F)));
+    run_one_scan_loop();
+
+    // Releasing the dropped key does not produce a report
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    for (auto key : {key_a, key_b, key_c, key_d, key_e, key_f, key_g}) {
+        key.release();
+        run_one_scan_loop();
+    }
+}
+
+TEST_F(KeyboardReportBitmap, IdenticalReportsAreNotSent) {
+    TestDriver driver;
+    InSequence s;
+
+    ::add_key(KC_A);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    send_keyboard_report();
+
+    ::add_key(KC_A);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    send_keyboard_report();
+
+    add_mods(MOD_BIT(KC_LSFT));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    send_keyboard_report();
+
+    del_mods(MOD_BIT(KC_LSFT));
+    ::del_key(KC_A);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_keyboard_report();
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    send_keyboard_report();
+}
+
+TEST_F(KeyboardReportBitmap, Benchmark) {
+    const int         operations = 200000;
+    report_keyboard_t linear     = {};
+    report_keyboard_t report     = {};
+    keyboard_bitmap_t bitmap;
+    keyboard_bitmap_init(&bitmap, &report);
+
+    auto run = [&](std::function<void(uint8_t)> add, std::function<void(uint8_t)> del) {
+        Lcg  rng   = {7};
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < operations; i++) {
+            uint8_t code = random_code(rng);
+            if (rng.next() & 1) {
+                add(code);
+            } else {
+                del(code);
+            }
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto linear_ns = run([&](uint8_t code) { add_key_to_report(&linear, code); }, [&](uint8_t code) { del_key_from_report(&linear, code); });
+    auto bitmap_ns = run([&](uint8_t code) { keyboard_bitmap_add_key(&bitmap, code); }, [&](uint8_t code) { keyboard_bitmap_del_key(&bitmap, code); });
+
+    // Timings depend on the host, they are only recorded, see the XML output of the test
+    RecordProperty("linear_ns_per_op", (int)(linear_ns / operations));
+    RecordProperty("bitmap_ns_per_op", (int)(bitmap_ns / operations));
+    EXPECT_EQ(memcmp(linear.raw, report.raw, sizeof(report.raw)), 0);
+}
@@ -0,0 +1,166 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+
+#include "keycode.h"
+#include "test_common.hpp"
+#include "action_util.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+namespace {
+
+// Small deterministic generator, so failures can be reproduced
+struct Lcg {
+    uint32_t state;
+
+    uint32_t next() {
+        state = state * 1664525 + 1013904223;
+        return state >> 8;
+    }
+};
+
+} // namespace
+
+class KeyboardReportBitmapNkro : public TestFixture {
+   protected:
+    void SetUp() override {
+        keyboard_protocol  = 1;
+        keymap_config.nkro = true;
+    }
+
+    void TearDown() override {
+        keyboard_protocol  = 1;
+        keymap_config.nkro = false;
+    }
+};
+
+TEST_F(KeyboardReportBitmapNkro, MatchesLinearBuilder) {
+    report_keyboard_t linear = {};
+    report_keyboard_t report = {};
+    keyboard_bitmap_t bitmap;
+    keyboard_bitmap_init(&bitmap, &report);
+
+    Lcg rng = {3};
+    for (int i = 0; i < 20000; i++) {
+        uint32_t op   = rng.next() % 16;
+        uint8_t  code = KC_A + rng.next() % 40;
+        if (op < 8) {
+            add_key_to_report(&linear, code);
+            keyboard_bitmap_add_key(&bitmap, code);
+        } else if (op < 15) {
+            del_key_from_report(&linear, code);
+            keyboard_bitmap_del_key(&bitmap, code);
+        } else {
+            clear_keys_from_report(&linear);
+            keyboard_bitmap_clear_keys(&bitmap);
+        }
+
+        ASSERT_EQ(memcmp(&linear, &report, sizeof(report)), 0) << "after operation " << i;
+        // has_anykey counts the non-empty bytes of an NKRO report, only whether it is zero matters
+        ASSERT_EQ(!has_anykey(&linear), !keyboard_bitmap_has_anykey(&bitmap)) << "after operation " << i;
+        if (has_anykey(&linear)) {
+            // get_first_key reads past the bit array of an empty NKRO report
+            ASSERT_EQ(get_first_key(&linear), keyboard_bitmap_get_first_key(&bitmap)) << "after operation " << i;
+        }
+        for (uint8_t k = KC_A; k < KC_A + 40; k++) {
+            ASSERT_EQ(is_key_pressed(&linear, k), keyboard_bitmap_is_key_pressed(&bitmap, k)) << "after operation " << i;
+        }
+    }
+}
+
+TEST_F(KeyboardReportBitmapNkro, SwitchingProtocolRebuildsReport) {
+    report_keyboard_t report = {};
+    keyboard_bitmap_t bitmap;
+    keyboard_bitmap_init(&bitmap, &report);
+
+    for (uint8_t code = KC_H; code >= KC_A; code--) {
+        keyboard_bitmap_add_key(&bitmap, code);
+    }
+    EXPECT_TRUE(keyboard_bitmap_take_changed(&bitmap));
+    EXPECT_EQ(keyboard_bitmap_has_anykey(&bitmap), 8);
+    EXPECT_EQ(keyboard_bitmap_get_first_key(&bitmap), KC_D);
+
+    // Back in 6KRO, the lowest six keycodes fill the slots in order and the rest are released
+    keymap_config.nkro = false;
+    EXPECT_TRUE(keyboard_bitmap_take_changed(&bitmap));
+    EXPECT_EQ(keyboard_bitmap_has_anykey(&bitmap), 6);
+    for (uint8_t slot = 0; slot < KEYBOARD_REPORT_KEYS; slot++) {
+        EXPECT_EQ(report.keys[slot], KC_A + slot);
+    }
+    EXPECT_TRUE(keyboard_bitmap_is_key_pressed(&bitmap, KC_F));
+    EXPECT_FALSE(keyboard_bitmap_is_key_pressed(&bitmap, KC_G));
+    EXPECT_FALSE(keyboard_bitmap_is_key_pressed(&bitmap, KC_H));
+    EXPECT_FALSE(keyboard_bitmap_take_changed(&bitmap));
+
+    // Returning to NKRO brings back the keys that were kept, in the bit array this time
+    keymap_config.nkro = true;
+    EXPECT_TRUE(keyboard_bitmap_take_changed(&bitmap));
+    report_keyboard_t expected = {};
+    for (uint8_t code = KC_A; code <= KC_F; code++) {
+        add_key_to_report(&expected, code);
+    }
+    EXPECT_EQ(memcmp(expected.nkro.bits, report.nkro.bits, sizeof(report.nkro.bits)), 0);
+    EXPECT_EQ(keyboard_bitmap_has_anykey(&bitmap), 6);
+
+    // The boot protocol has no room for NKRO either
+    keyboard_protocol = 0;
+    EXPECT_TRUE(keyboard_bitmap_take_changed(&bitmap));
+    for (uint8_t slot = 0; slot < KEYBOARD_REPORT_KEYS; slot++) {
+        EXPECT_EQ(report.keys[slot], KC_A + slot);
+    }
+}
+
+TEST_F(KeyboardReportBitmapNkro, ReportHoldsMoreThanSixKeys) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_a = KeymapKey(0, 0, 0, KC_A);
+    auto       key_b = KeymapKey(0, 1, 0, KC_B);
+    auto       key_c = KeymapKey(0, 2, 0, KC_C);
+    auto       key_d = KeymapKey(0, 3, 0, KC_D);
+    auto       key_e = KeymapKey(0, 4, 0, KC_E);
+    auto       key_f = KeymapKey(0, 5, 0, KC_F);
+    auto       key_g = KeymapKey(0, 6, 0, KC_G);
+    auto       key_h = KeymapKey(0, 7, 0, KC_H);
+
+    set_keymap({key_a, key_b, key_c, key_d, key_e, key_f, key_g, key_h});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(7);
+    for (auto key : {key_a, key_b, key_c, key_d, key_e, key_f, key_g}) {
+        key.press();
+        run_one_scan_loop();
+    }
+
+    key_h.press();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H)));
+    run_one_scan_loop();
+
+    // The host falls back to the boot protocol, the next report only carries the first six keys
+    keyboard_protocol = 0;
+    key_h.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F)));
+    run_one_scan_loop();
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    for (auto key : {key_a, key_b, key_c, key_d, key_e, key_f, key_g}) {
+        key.release();
+        run_one_scan_loop();
+    }
+}
@@ -0,0 +1,77 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "action_tapping.h"
+#include "test_keymap_key.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class MatrixGhost : public TestFixture {
+   protected:
+    // Two keys on each of two rows, sharing both columns: every key reads as pressed when three are
+    KeymapKey ghost[4] = {KeymapKey(0, 0, 0, KC_A), KeymapKey(0, 1, 0, KC_B), KeymapKey(0, 0, 1, KC_C), KeymapKey(0, 1, 1, KC_D)};
+};
+
+TEST_F(MatrixGhost, GhostedRowsAreNotReported) {
+    TestDriver driver;
+
+    set_keymap({ghost[0], ghost[1], ghost[2], ghost[3]});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    for (auto &key : ghost) {
+        key.press();
+    }
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    for (auto &key : ghost) {
+        key.release();
+    }
+    run_one_scan_loop();
+}
+
+TEST_F(MatrixGhost, TappingTermRunsOutWhileARowIsGhosted) {
+    TestDriver driver;
+    InSequence s;
+    auto       mod_tap_hold_key = KeymapKey(0, 7, 3, SFT_T(KC_P));
+
+    set_keymap({mod_tap_hold_key, ghost[0], ghost[1], ghost[2], ghost[3]});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    mod_tap_hold_key.press();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // The ghosted rows are held back, time still moves on for the mod-tap key
+    for (auto &key : ghost) {
+        key.press();
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    idle_for(TAPPING_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    for (auto &key : ghost) {
+        key.release();
+    }
+    mod_tap_hold_key.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
@@ -0,0 +1,323 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <random>
+#include "test_common.hpp"
+
+extern "C" {
+#include "i2c_master.h"
+#include "oled_driver.h"
+#ifdef I2C_QUEUE_ENABLE
+#    include "i2c_queue.h"
+#endif
+
+extern uint8_t         oled_buffer[OLED_MATRIX_SIZE];
+extern OLED_BLOCK_TYPE oled_dirty;
+
+void advance_profiler_ticks(uint32_t ticks);
+}
+
+/* Host-side panel: the display RAM, written through the addressing commands
+ * oled_render() sends, horizontal addressing for the SSD1306 and page
+ * addressing for the SH1106. */
+static struct Panel {
+    uint8_t ram[OLED_DISPLAY_HEIGHT / 8][132];
+    uint8_t col, page, col_start = 0, col_end = 127, page_start = 0, page_end = OLED_DISPLAY_HEIGHT / 8 - 1;
+
+    uint32_t bursts       = 0;
+    uint32_t data_bytes   = 0;
+    uint16_t longest_data = 0;
+    bool     timed_bus    = false;
+
+    void command(const uint8_t *data, uint16_t length) {
+#if (OLED_IC == OLED_IC_SH1106)
+        if (length == 7 && (data[1] & 0xF0) == 0xB0) {
+            page = data[1] & 0x0F;
+            col  = (data[2] & 0x0F) | (data[3] & 0x0F) << 4;
+            bursts++;
+        }
+#else
+        if (length == 7 && data[1] == 0x21 && data[4] == 0x22) {
+            col = col_start = data[2];
+            col_end         = data[3];
+            page = page_start = data[5];
+            page_end          = data[6];
+            bursts++;
+        }
+#endif
+    }
+
+    void write(const uint8_t *data, uint16_t length) {
+        for (uint16_t i = 0; i < length; i++) {
+            ram[page][col] = data[i];
+#if (OLED_IC == OLED_IC_SH1106)
+            col++;
+#else
+            if (col++ == col_end) {
+                col = col_start;
+                if (page++ == page_end) {
+                    page = page_start;
+                }
+            }
+#endif
+        }
+        data_bytes += length;
+        if (length > longest_data) {
+            longest_data = length;
+        }
+    }
+
+    void bus_time(uint16_t length) {
+        // About 25us a byte at 400kHz, address included
+        if (timed_bus) {
+            advance_profiler_ticks((length + 1) * 25);
+        }
+    }
+
+    bool pixel(uint8_t x, uint8_t y) {
+        return ram[y / 8][x] & (1 << (y % 8));
+    }
+} panel;
+
+extern "C" {
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    panel.bus_time(length);
+    if (length && data[0] == 0x00) {
+        panel.command(data, length);
+    }
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    panel.bus_time(length + 1);
+    if (regaddr == 0x40) {
+        panel.write(data, length);
+    }
+    return I2C_STATUS_SUCCESS;
+}
+
+#ifdef I2C_QUEUE_ENABLE
+static i2c_status_t transport_status;
+
+// Transfers run as they start, like the AVR fallback. Like the ChibiOS transport, transfers that
+// don't fit in its buffer fail without being sent.
+void i2c_queue_transport_start(i2c_transfer_t *transfer) {
+    if (transfer->reg_length + transfer->tx_length > I2C_QUEUE_BUFFER_SIZE) {
+        transport_status = I2C_STATUS_ERROR;
+    } else if (transfer->reg_length) {
+        transport_status = i2c_writeReg(transfer->address, transfer->reg, transfer->tx_data, transfer->tx_length, transfer->timeout);
+    } else {
+        transport_status = i2c_transmit(transfer->address, transfer->tx_data, transfer->tx_length, transfer->timeout);
+    }
+}
+
+bool i2c_queue_transport_poll(i2c_status_t *status) {
+    *status = transport_status;
+    return true;
+}
+#endif
+}
+
+class OledRender : public TestFixture {
+   protected:
+    std::mt19937 rng{1234};
+
+    void SetUp() override {
+        oled_init(OLED_ROTATION_0);
+        render_all();
+        panel.bursts = panel.data_bytes = panel.longest_data = 0;
+        panel.timed_bus                                      = false;
+    }
+
+    void TearDown() override {
+        panel.timed_bus = false;
+    }
+
+    /* One render, done once its transfers are. */
+    void render() {
+        oled_render();
+#ifdef I2C_QUEUE_ENABLE
+        i2c_queue_flush();
+#endif
+    }
+
+    /* Renders until nothing is dirty, returns the number of calls. */
+    unsigned render_all() {
+        unsigned calls = 0;
+        while (oled_dirty) {
+            render();
+            calls++;
+        }
+        return calls;
+    }
+
+    void write_random(uint16_t from, uint16_t to) {
+        for (uint16_t i = from; i < to; i++) {
+            oled_write_raw_byte(rng(), i);
+        }
+    }
+
+    void invert(uint16_t from, uint16_t to) {
+        for (uint16_t i = from; i < to; i++) {
+            oled_write_raw_byte(~oled_buffer[i], i);
+        }
+    }
+
+    void expect_panel_matches_buffer() {
+        for (uint16_t i = 0; i < OLED_MATRIX_SIZE; i++) {
+            ASSERT_EQ(panel.ram[i / OLED_DISPLAY_WIDTH][i % OLED_DISPLAY_WIDTH], oled_buffer[i]) << "byte " << i;
+        }
+    }
+};
+
+TEST_F(OledRender, FullFrameIsPixelExact) {
+    write_random(0, OLED_MATRIX_SIZE);
+    render();
+    EXPECT_EQ(oled_dirty, 0);
+    expect_panel_matches_buffer();
+#if (OLED_IC == OLED_IC_SH1106)
+    EXPECT_EQ(panel.bursts, OLED_DISPLAY_HEIGHT / 8);
+#else
+    // As many whole pages per burst as fit in a transfer
+    const uint16_t burst_bytes = OLED_RENDER_BURST_SIZE / OLED_DISPLAY_WIDTH * OLED_DISPLAY_WIDTH;
+    EXPECT_EQ(panel.bursts, (OLED_MATRIX_SIZE + burst_bytes - 1) / burst_bytes);
+#endif
+    EXPECT_LE(panel.longest_data, OLED_RENDER_BURST_SIZE);
+}
+
+TEST_F(OledRender, AdjacentDirtyBlocksShareOneBurst) {
+    // Blocks 4 to 7 are the second page
+    invert(OLED_BLOCK_SIZE * 4, OLED_BLOCK_SIZE * 8);
+    render();
+    EXPECT_EQ(panel.bursts, 1);
+    EXPECT_EQ(panel.data_bytes, OLED_BLOCK_SIZE * 4);
+    expect_panel_matches_buffer();
+
+    // Across a page boundary, starting mid-page
+    panel.bursts = panel.data_bytes = 0;
+    invert(OLED_BLOCK_SIZE * 2, OLED_BLOCK_SIZE * 5);
+    render();
+    EXPECT_EQ(panel.bursts, 2);
+    EXPECT_EQ(panel.data_bytes, OLED_BLOCK_SIZE * 3);
+    expect_panel_matches_buffer();
+}
+
+TEST_F(OledRender, UnchangedBytesAreNotSent) {
+    invert(200, 201);
+    invert(203, 204);
+    render();
+    expect_panel_matches_buffer();
+#ifdef OLED_RENDER_SHADOW
+    // The two unchanged bytes in between cost less than a new address command
+    EXPECT_EQ(panel.bursts, 1);
+    EXPECT_EQ(panel.data_bytes, 4);
+#else
+    EXPECT_EQ(panel.data_bytes, OLED_BLOCK_SIZE);
+#endif
+
+    panel.bursts = panel.data_bytes = 0;
+    invert(OLED_BLOCK_SIZE + 1, OLED_BLOCK_SIZE + 2);
+    invert(OLED_BLOCK_SIZE * 2 - 2, OLED_BLOCK_SIZE * 2 - 1);
+    render();
+    expect_panel_matches_buffer();
+#ifdef OLED_RENDER_SHADOW
+    EXPECT_EQ(panel.bursts, 2);
+    EXPECT_EQ(panel.data_bytes, 2);
+#endif
+
+    // Rewriting the same data marks the block dirty, but sends nothing
+    panel.bursts = panel.data_bytes = 0;
+    oled_dirty |= (OLED_BLOCK_TYPE)1 << (300 / OLED_BLOCK_SIZE);
+    render();
+#ifdef OLED_RENDER_SHADOW
+    EXPECT_EQ(panel.bursts, 0);
+#endif
+    expect_panel_matches_buffer();
+}
+
+TEST_F(OledRender, RenderStopsAtTheTimeBudget) {
+    // Every other block, eight separate runs of 32 bytes, about 850us each on the bus
+    for (uint8_t block = 0; block < OLED_BLOCK_COUNT; block += 2) {
+        invert(OLED_BLOCK_SIZE * block, OLED_BLOCK_SIZE * (block + 1));
+    }
+    panel.timed_bus = true;
+
+    render();
+#ifdef I2C_QUEUE_ENABLE
+    // Queuing takes no bus time, all of it goes in one render
+    EXPECT_EQ(panel.bursts, OLED_BLOCK_COUNT / 2);
+    EXPECT_EQ(oled_dirty, 0);
+#else
+    EXPECT_GT(panel.bursts, 1);
+    EXPECT_LT(panel.bursts, OLED_BLOCK_COUNT / 2);
+    EXPECT_NE(oled_dirty, 0);
+#endif
+
+    unsigned calls = 1 + render_all();
+    expect_panel_matches_buffer();
+    std::cout << "[ OLED     ] " << OLED_BLOCK_COUNT / 2 << " dirty runs, " << calls << " renders with a " << OLED_RENDER_BUDGET_US << "us budget" << std::endl;
+}
+
+TEST_F(OledRender, RotatedFrameIsPixelExact) {
+    oled_init(OLED_ROTATION_90);
+    write_random(0, OLED_MATRIX_SIZE);
+    render_all();
+
+    // The buffer is OLED_DISPLAY_HEIGHT pixels wide and OLED_DISPLAY_WIDTH high
+    for (uint8_t y = 0; y < OLED_DISPLAY_WIDTH; y++) {
+        for (uint8_t x = 0; x < OLED_DISPLAY_HEIGHT; x++) {
+            bool set = oled_buffer[y / 8 * OLED_DISPLAY_HEIGHT + x] & (1 << (y % 8));
+            ASSERT_EQ(panel.pixel(y, OLED_DISPLAY_HEIGHT - 1 - x), set) << "x " << (int)x << ", y " << (int)y;
+        }
+    }
+
+    // A single changed pixel
+    panel.data_bytes = 0;
+    oled_write_pixel(5, 100, !(oled_buffer[100 / 8 * OLED_DISPLAY_HEIGHT + 5] & (1 << (100 % 8))));
+    render_all();
+    EXPECT_EQ(panel.pixel(100, OLED_DISPLAY_HEIGHT - 1 - 5), (bool)(oled_buffer[100 / 8 * OLED_DISPLAY_HEIGHT + 5] & (1 << (100 % 8))));
+#ifdef OLED_RENDER_SHADOW
+    EXPECT_EQ(panel.data_bytes, 1);
+#endif
+}
+
+#ifdef I2C_QUEUE_ENABLE
+TEST_F(OledRender, ChangesBeyondTheBurstPoolAreSentLater) {
+    // Twice as many separate runs as there are bursts to queue them in
+    for (uint16_t i = 0; i < OLED_RENDER_QUEUE_SIZE * 2; i++) {
+        invert(i * OLED_RENDER_SHADOW_GAP * 2, i * OLED_RENDER_SHADOW_GAP * 2 + 1);
+    }
+
+    render();
+    EXPECT_EQ(panel.bursts, OLED_RENDER_QUEUE_SIZE);
+    EXPECT_NE(oled_dirty, 0);
+
+    render_all();
+    expect_panel_matches_buffer();
+}
+#endif
+
+TEST_F(OledRender, LongRunsAreSplitIntoBursts) {
+    // Starting mid-page, so that the first burst cannot be whole pages
+    write_random(OLED_DISPLAY_WIDTH / 2, OLED_MATRIX_SIZE);
+    EXPECT_EQ(render_all(), 1);
+    expect_panel_matches_buffer();
+    EXPECT_GT(panel.bursts, 1);
+    EXPECT_LE(panel.longest_data, OLED_RENDER_BURST_SIZE);
+}
@@ -0,0 +1,35 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "test_common.h"
+#include <stdbool.h>
+
+#define POINTING_DEVICE_HAS_MOTION
+#define POINTING_DEVICE_TASK_THROTTLE_MS 4
+
+// Mock motion pin, active low while the mock sensor has motion queued
+#define POINTING_DEVICE_MOTION_PIN 0
+#define setPinInputHigh(pin)
+#define readPin(pin) mock_motion_pin_read()
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool mock_motion_pin_read(void);
+#ifdef __cplusplus
+}
+#endif
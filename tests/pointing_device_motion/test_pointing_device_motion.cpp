@@ -0,0 +1,159 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <deque>
+#include "keyboard_report_util.hpp"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+extern "C" {
+#include "pointing_device.h"
+
+/* Mock sensor: every read returns the next queued delta, the motion pin is active until none are left. */
+static std::deque<pointing_device_motion_t> sensor;
+static uint32_t                             sensor_reads = 0;
+
+bool mock_motion_pin_read(void) {
+    return sensor.empty();
+}
+
+pointing_device_motion_t pointing_device_driver_get_motion(void) {
+    sensor_reads++;
+    if (sensor.empty()) {
+        return (pointing_device_motion_t){0, 0};
+    }
+    pointing_device_motion_t motion = sensor.front();
+    sensor.pop_front();
+    return motion;
+}
+}
+
+class PointingDeviceMotion : public TestFixture {
+   protected:
+    std::vector<report_mouse_t> reports;
+
+    void SetUp() override {
+        sensor.clear();
+        sensor_reads = 0;
+        reports.clear();
+    }
+
+    void record_reports(TestDriver &driver) {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        EXPECT_CALL(driver, send_mouse_mock(_)).WillRepeatedly(Invoke([this](report_mouse_t &report) { reports.push_back(report); }));
+    }
+
+    int32_t sum_x() {
+        int32_t sum = 0;
+        for (auto &report : reports) {
+            sum += report.x;
+        }
+        return sum;
+    }
+
+    int32_t sum_y() {
+        int32_t sum = 0;
+        for (auto &report : reports) {
+            sum += report.y;
+        }
+        return sum;
+    }
+};
+
+TEST_F(PointingDeviceMotion, LargeMotionIsSplitAcrossReports) {
+    TestDriver driver;
+    record_reports(driver);
+
+    sensor.push_back({300, -200});
+    idle_for(40);
+
+    // Nothing is clamped away: 300 goes out as 127 + 127 + 46
+    ASSERT_GE(reports.size(), 3);
+    EXPECT_EQ(reports[0].x, 127);
+    EXPECT_EQ(reports[0].y, -127);
+    EXPECT_EQ(reports[1].x, 127);
+    EXPECT_EQ(reports[1].y, -73);
+    EXPECT_EQ(reports[2].x, 46);
+    EXPECT_EQ(sum_x(), 300);
+    EXPECT_EQ(sum_y(), -200);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(PointingDeviceMotion, ReadsBetweenReportsAccumulate) {
+    TestDriver driver;
+    record_reports(driver);
+
+    for (int i = 0; i < 10; i++) {
+        sensor.push_back({3, 1});
+    }
+    idle_for(60);
+
+    // The sensor is read on every scan while it signals motion, several times per report, and
+    // never once it has none
+    EXPECT_EQ(sensor_reads, 10);
+    EXPECT_LT(reports.size(), 10);
+    EXPECT_EQ(sum_x(), 30);
+    EXPECT_EQ(sum_y(), 10);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(PointingDeviceMotion, ReportsArePacedByTheThrottle) {
+    TestDriver driver;
+    record_reports(driver);
+
+    // Keep the sensor busy for 40 scans
+    for (int i = 0; i < 40; i++) {
+        sensor.push_back({100, 0});
+    }
+    idle_for(40);
+
+    // One report per POINTING_DEVICE_TASK_THROTTLE_MS, the rest stays accumulated
+    EXPECT_LE(reports.size(), 40 / POINTING_DEVICE_TASK_THROTTLE_MS + 1);
+    EXPECT_GE(reports.size(), 40 / POINTING_DEVICE_TASK_THROTTLE_MS - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    TestDriver drain;
+    EXPECT_CALL(drain, send_keyboard_mock(_)).Times(AnyNumber());
+    EXPECT_CALL(drain, send_mouse_mock(_)).WillRepeatedly(Invoke([this](report_mouse_t &report) { reports.push_back(report); }));
+    idle_for(200);
+    EXPECT_EQ(sum_x(), 4000);
+    testing::Mock::VerifyAndClearExpectations(&drain);
+}
+
+TEST_F(PointingDeviceMotion, AccumulatorSaturates) {
+    TestDriver driver;
+    record_reports(driver);
+
+    sensor.push_back({INT16_MAX, INT16_MIN});
+    sensor.push_back({INT16_MAX, INT16_MIN});
+    idle_for(4 * 300);
+
+    // Motion stops at the int16 limits instead of wrapping around to the other direction
+    for (auto &report : reports) {
+        EXPECT_GE(report.x, 0);
+        EXPECT_LE(report.y, 0);
+    }
+    // At most one report can go out between the two reads, the rest of the second one is dropped
+    EXPECT_GE(sum_x(), INT16_MAX);
+    EXPECT_LE(sum_x(), INT16_MAX + 127);
+    EXPECT_LE(sum_y(), INT16_MIN);
+    EXPECT_GE(sum_y(), INT16_MIN - 127);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,122 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "keyboard_report_util.hpp"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+extern "C" {
+#include "pointing_device.h"
+
+/* This half is the master and the left one, the sensor is on the other side. */
+bool is_keyboard_master(void) {
+    return true;
+}
+
+bool is_keyboard_left(void) {
+    return true;
+}
+
+pointing_device_motion_t pointing_device_driver_get_motion(void) {
+    return (pointing_device_motion_t){0, 0};
+}
+}
+
+class PointingDeviceMotionSplit : public TestFixture {
+   protected:
+    std::vector<report_mouse_t> reports;
+
+    void SetUp() override {
+        reports.clear();
+        pointing_device_resync_shared_motion_total();
+        // Drain whatever an earlier test left waiting to be reported
+        pointing_device_set_shared_motion_total((pointing_device_motion_t){0, 0});
+    }
+
+    void run(int ms) {
+        TestDriver driver;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        EXPECT_CALL(driver, send_mouse_mock(_)).WillRepeatedly(Invoke([this](report_mouse_t &report) { reports.push_back(report); }));
+        idle_for(ms);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+
+    int32_t sum_x() {
+        int32_t sum = 0;
+        for (auto &report : reports) {
+            sum += report.x;
+        }
+        return sum;
+    }
+
+    int32_t sum_y() {
+        int32_t sum = 0;
+        for (auto &report : reports) {
+            sum += report.y;
+        }
+        return sum;
+    }
+};
+
+TEST(PointingDeviceMotionDelta, WrapsAroundTheInt16Limits) {
+    pointing_device_motion_t delta = pointing_device_motion_delta((pointing_device_motion_t){-32766, 32765}, (pointing_device_motion_t){32760, -32760});
+    EXPECT_EQ(delta.x, 10);
+    EXPECT_EQ(delta.y, -11);
+
+    delta = pointing_device_motion_delta((pointing_device_motion_t){100, -100}, (pointing_device_motion_t){150, -150});
+    EXPECT_EQ(delta.x, -50);
+    EXPECT_EQ(delta.y, 50);
+}
+
+TEST_F(PointingDeviceMotionSplit, ReportsTheChangeOfTheSharedTotal) {
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){200, -20});
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){300, -30});
+    run(40);
+
+    EXPECT_EQ(sum_x(), 300);
+    EXPECT_EQ(sum_y(), -30);
+}
+
+TEST_F(PointingDeviceMotionSplit, SharedTotalWrapsAround) {
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){INT16_MAX - 10, INT16_MIN + 10});
+    run(400 * POINTING_DEVICE_TASK_THROTTLE_MS);
+    reports.clear();
+
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){INT16_MIN + 9, INT16_MAX - 9});
+    run(40);
+
+    EXPECT_EQ(sum_x(), 20);
+    EXPECT_EQ(sum_y(), -20);
+}
+
+TEST_F(PointingDeviceMotionSplit, ResyncDoesNotReportTheRestart) {
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){5000, 5000});
+    run(400 * POINTING_DEVICE_TASK_THROTTLE_MS);
+    reports.clear();
+
+    // The other side restarted: its total is back near zero
+    pointing_device_resync_shared_motion_total();
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){3, 0});
+    pointing_device_set_shared_motion_total((pointing_device_motion_t){10, -4});
+    run(40);
+
+    EXPECT_EQ(sum_x(), 7);
+    EXPECT_EQ(sum_y(), -4);
+}
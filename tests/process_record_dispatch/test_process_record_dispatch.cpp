@@ -0,0 +1,125 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+/* This build has seven handlers: process_record_kb, key override and space
+ * cadet see every key, tap dance, dynamic tapping term, magic and grave escape
+ * only their own keycodes. */
+#define HANDLERS_TOTAL 7
+#define HANDLERS_FOR_ALL_KEYS 3
+
+static qk_tap_dance_pair_t pair = {KC_X, KC_Y};
+
+extern "C" {
+qk_tap_dance_action_t tap_dance_actions[1];
+}
+
+static struct TapDances {
+    TapDances() {
+        tap_dance_actions[0].fn        = {qk_tap_dance_pair_on_each_tap, qk_tap_dance_pair_finished, qk_tap_dance_pair_reset};
+        tap_dance_actions[0].user_data = &pair;
+    }
+} tap_dances;
+
+class ProcessRecordDispatch : public TestFixture {
+   protected:
+    KeymapKey key_a    = KeymapKey(0, 0, 0, KC_A);
+    KeymapKey key_gesc = KeymapKey(0, 1, 0, QK_GESC);
+    KeymapKey key_td   = KeymapKey(0, 2, 0, TD(0));
+    KeymapKey key_dt   = KeymapKey(0, 3, 0, DT_UP);
+    KeymapKey key_nkro = KeymapKey(0, 4, 0, MAGIC_TOGGLE_NKRO);
+
+    void SetUp() override {
+        set_keymap({key_a, key_gesc, key_td, key_dt, key_nkro});
+    }
+
+    /* Handler calls for a press and for a release of key. */
+    std::pair<uint32_t, uint32_t> count_calls(KeymapKey &key) {
+        process_record_handler_calls = 0;
+        key.press();
+        run_one_scan_loop();
+        uint32_t pressed             = process_record_handler_calls;
+        process_record_handler_calls = 0;
+        key.release();
+        run_one_scan_loop();
+        return {pressed, process_record_handler_calls};
+    }
+};
+
+TEST_F(ProcessRecordDispatch, BasicKeyOnlyVisitsHandlersForAllKeys) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    auto calls = count_calls(key_a);
+    EXPECT_EQ(calls.first, HANDLERS_FOR_ALL_KEYS);
+    EXPECT_EQ(calls.second, HANDLERS_FOR_ALL_KEYS);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(ProcessRecordDispatch, OwnKeycodeReachesHandler) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESCAPE)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    auto calls = count_calls(key_gesc);
+    // The magic keycodes are spread out, their range spans grave escape
+    EXPECT_EQ(calls.first, HANDLERS_FOR_ALL_KEYS + 2);
+    EXPECT_EQ(calls.second, HANDLERS_FOR_ALL_KEYS + 2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    calls = count_calls(key_td);
+    EXPECT_EQ(calls.first, HANDLERS_FOR_ALL_KEYS + 1);
+    idle_for(TAPPING_TERM + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(ProcessRecordDispatch, HandlerReturningFalseStopsDispatch) {
+    TestDriver driver;
+    uint16_t   tapping_term = g_tapping_term;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    auto calls = count_calls(key_dt);
+    // process_record_kb and key override come first, the dynamic tapping term handler handles the press
+    EXPECT_EQ(calls.first, 3);
+    EXPECT_EQ(g_tapping_term, tapping_term + DYNAMIC_TAPPING_TERM_INCREMENT);
+    g_tapping_term = tapping_term;
+
+    calls = count_calls(key_nkro);
+    EXPECT_EQ(calls.first, HANDLERS_FOR_ALL_KEYS + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(ProcessRecordDispatch, HandlerCallsPerEvent) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    std::cout << "[ DISPATCH ] " << HANDLERS_TOTAL << " handlers, calls per press: KC_A " << count_calls(key_a).first << ", QK_GESC " << count_calls(key_gesc).first << ", TD(0) " << count_calls(key_td).first << std::endl;
+    idle_for(TAPPING_TERM + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
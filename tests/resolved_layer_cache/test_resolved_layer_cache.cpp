@@ -0,0 +1,123 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class ResolvedLayerCache : public TestFixture {};
+
+TEST_F(ResolvedLayerCache, TransparentKeysResolveToLowerLayer) {
+    TestDriver driver;
+    auto       key_a = KeymapKey(0, 0, 0, KC_A);
+
+    set_keymap({key_a, KeymapKey(1, 0, 0, KC_TRNS), KeymapKey(2, 0, 0, KC_B), KeymapKey(3, 0, 0, KC_TRNS)});
+
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    layer_on(1);
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    layer_on(3);
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    layer_on(2);
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 2);
+
+    layer_off(2);
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(ResolvedLayerCache, DirectLayerStateWritesAreHonoured) {
+    TestDriver driver;
+    auto       key_a = KeymapKey(0, 0, 0, KC_A);
+
+    set_keymap({key_a, KeymapKey(1, 0, 0, KC_B)});
+
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    /* Some keymaps write the state directly instead of going through layer_state_set() */
+    layer_state = 0b10;
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 1);
+
+    layer_state         = 0;
+    default_layer_state = 0b10;
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 1);
+
+    default_layer_state = 0;
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(ResolvedLayerCache, CachedLayerIsUsedUntilCleared) {
+    TestDriver driver;
+    auto       key_a = KeymapKey(0, 0, 0, KC_A);
+
+    set_keymap({key_a, KeymapKey(1, 0, 0, KC_TRNS)});
+
+    layer_on(1);
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    /* Swap the keymap behind the cache's back: a warm lookup must not walk the layers again */
+    keymap.clear();
+    keymap.push_back(key_a);
+    keymap.push_back(KeymapKey(1, 0, 0, KC_B));
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    /* This is what dynamic keymap writes do */
+    resolved_layer_cache_clear();
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 1);
+
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(ResolvedLayerCache, ReleaseUsesSourceLayerOfPress) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_a  = KeymapKey(0, 0, 0, KC_A);
+    auto       key_mo = KeymapKey(0, 1, 0, MO(1));
+
+    set_keymap({key_a, key_mo, KeymapKey(1, 0, 0, KC_B), KeymapKey(1, 1, 0, KC_TRNS)});
+
+    key_mo.press();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    key_a.press();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    key_mo.release();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    /* The layer cache moved on to layer 0, the release must still come from layer 1 */
+    EXPECT_EQ(layer_switch_get_layer(key_a.position), 0);
+
+    key_a.release();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
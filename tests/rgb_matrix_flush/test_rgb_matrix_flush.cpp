@@ -0,0 +1,120 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "i2c_master.h"
+
+// LEDs 0 and 1 share the first 16 PWM registers, 2 and 3 are spread over the others
+const is31_led PROGMEM g_is31_leds[DRIVER_LED_TOTAL] = {
+    {0, A_1, A_2, A_3},
+    {0, A_4, A_5, A_6},
+    {0, E_1, F_1, G_1},
+    {0, L_14, L_15, L_16},
+};
+
+led_config_t g_led_config = {{
+    {0, 1, 2, 3, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+    {NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+    {NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+    {NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED},
+}, {
+    {0, 0}, {64, 0}, {128, 0}, {192, 0},
+}, {
+    4, 4, 4, 4,
+}};
+
+static uint32_t bus_bytes     = 0;
+static uint32_t pwm_transfers = 0;
+static bool     bus_failing   = false;
+
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (bus_failing) {
+        return I2C_STATUS_ERROR;
+    }
+    bus_bytes += length;
+    // Everything else is a single register write
+    if (length == 17) {
+        pwm_transfers++;
+    }
+    return I2C_STATUS_SUCCESS;
+}
+}
+
+// Command register unlock and page select, both single register writes
+static const uint32_t page_select_bytes = 2 * 2;
+
+class RgbMatrixFlush : public TestFixture {
+   protected:
+    void SetUp() override {
+        // Bring the driver in sync with the buffers, whatever the effect did before
+        rgb_matrix_set_color_all(0, 0, 0);
+        rgb_matrix_driver.flush();
+        bus_bytes     = 0;
+        pwm_transfers = 0;
+        bus_failing   = false;
+    }
+};
+
+TEST_F(RgbMatrixFlush, UnchangedFrameSendsNothing) {
+    rgb_matrix_set_color_all(0, 0, 0);
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(bus_bytes, 0);
+}
+
+TEST_F(RgbMatrixFlush, OnlyChangedBlocksAreSent) {
+    rgb_matrix_set_color(0, 1, 2, 3);
+    rgb_matrix_set_color(1, 4, 5, 6);
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(pwm_transfers, 1);
+    EXPECT_EQ(bus_bytes, page_select_bytes + 17);
+
+    // Rewriting the same colours is not a change
+    bus_bytes = pwm_transfers = 0;
+    rgb_matrix_set_color(0, 1, 2, 3);
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(bus_bytes, 0);
+
+    bus_bytes = pwm_transfers = 0;
+    rgb_matrix_set_color(3, 7, 8, 9);
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(pwm_transfers, 1);
+}
+
+TEST_F(RgbMatrixFlush, FullFrameSendsEveryTouchedBlock) {
+    rgb_matrix_set_color_all(10, 20, 30);
+    rgb_matrix_driver.flush();
+    // A_x, E_1, F_1, G_1 and L_x live in 5 distinct blocks, compared to 12 for a full refresh
+    EXPECT_EQ(pwm_transfers, 5);
+    EXPECT_EQ(bus_bytes, page_select_bytes + 5 * 17);
+}
+
+TEST_F(RgbMatrixFlush, FailedFlushFallsBackToFullRefresh) {
+    rgb_matrix_set_color(0, 1, 2, 3);
+    bus_failing = true;
+    rgb_matrix_driver.flush();
+    bus_failing = false;
+
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(pwm_transfers, 12);
+
+    bus_bytes = pwm_transfers = 0;
+    rgb_matrix_driver.flush();
+    EXPECT_EQ(bus_bytes, 0);
+}
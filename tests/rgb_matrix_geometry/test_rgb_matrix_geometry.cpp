@@ -0,0 +1,226 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "test_common.hpp"
+
+extern "C" {
+#include "lib/lib8tion/lib8tion.h"
+
+/* 120 LEDs on a 15 by 8 grid covering the whole 224 by 64 area, the first 40
+ * of them under the keys of the test matrix. */
+led_config_t g_led_config;
+
+static struct GeneratedLedConfig {
+    GeneratedLedConfig() {
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            g_led_config.point[i] = {(uint8_t)(i % 15 * 16), (uint8_t)(i / 15 * 9)};
+            g_led_config.flags[i] = LED_FLAG_KEYLIGHT;
+        }
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                g_led_config.matrix_co[row][col] = row * MATRIX_COLS + col;
+            }
+        }
+    }
+} generated;
+
+// The effects write hue, saturation and value straight into the frame
+static HSV frame[DRIVER_LED_TOTAL];
+
+RGB rgb_matrix_hsv_to_rgb(HSV hsv) {
+    RGB rgb;
+    rgb.r = hsv.h;
+    rgb.g = hsv.s;
+    rgb.b = hsv.v;
+    return rgb;
+}
+
+static void frame_init(void) {}
+
+static void frame_set_color(int index, uint8_t r, uint8_t g, uint8_t b) {
+    frame[index] = {r, g, b};
+}
+
+static void frame_set_color_all(uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < DRIVER_LED_TOTAL; i++) {
+        frame_set_color(i, r, g, b);
+    }
+}
+
+static void frame_flush(void) {}
+
+extern const rgb_matrix_driver_t rgb_matrix_driver;
+const rgb_matrix_driver_t        rgb_matrix_driver = {frame_init, frame_set_color, frame_set_color_all, frame_flush};
+
+extern const led_point_t k_rgb_matrix_center;
+
+bool CYCLE_OUT_IN(effect_params_t *params);
+bool CYCLE_PINWHEEL(effect_params_t *params);
+bool CYCLE_SPIRAL(effect_params_t *params);
+bool SOLID_MULTISPLASH(effect_params_t *params);
+}
+
+static uint8_t distance(led_point_t a, led_point_t b) {
+    int16_t dx = a.x - b.x;
+    int16_t dy = a.y - b.y;
+    return sqrt16(dx * dx + dy * dy);
+}
+
+static uint8_t angle(led_point_t point) {
+    return atan2_8(point.y - k_rgb_matrix_center.y, point.x - k_rgb_matrix_center.x);
+}
+
+class RgbMatrixGeometry : public TestFixture {
+   protected:
+    effect_params_t params = {0, LED_FLAG_ALL, false};
+
+    void SetUp() override {
+        rgb_matrix_config.hsv   = {0, 255, 255};
+        rgb_matrix_config.speed = 128;
+        g_rgb_timer             = 0;
+    }
+
+    /* Renders a whole frame, in as many runs as RGB_MATRIX_LED_PROCESS_LIMIT needs. */
+    void render(bool (*effect)(effect_params_t *)) {
+        for (params.iter = 0; effect(&params); params.iter++) {
+        }
+    }
+
+    uint8_t time(void) {
+        return scale16by8(g_rgb_timer, rgb_matrix_config.speed / 2);
+    }
+
+    /* Remembers a hit on each of the given LEDs, the last one being the most recent. */
+    void set_hits(std::vector<uint8_t> leds, uint16_t tick) {
+        g_last_hit_tracker.count = leds.size();
+        for (uint8_t j = 0; j < leds.size(); j++) {
+            g_last_hit_tracker.x[j]     = g_led_config.point[leds[j]].x;
+            g_last_hit_tracker.y[j]     = g_led_config.point[leds[j]].y;
+            g_last_hit_tracker.index[j] = leds[j];
+            g_last_hit_tracker.tick[j]  = tick + 20 * (leds.size() - j);
+        }
+    }
+
+    // Same as SOLID_SPLASH_math folded over every hit
+    uint8_t splash_value(uint8_t i) {
+        uint8_t value = 0;
+        for (uint8_t j = 0; j < g_last_hit_tracker.count; j++) {
+            uint16_t tick   = scale16by8(g_last_hit_tracker.tick[j], qadd8(rgb_matrix_config.speed, 1));
+            uint16_t effect = tick - distance(g_led_config.point[i], g_led_config.point[g_last_hit_tracker.index[j]]);
+            if (effect > 255) effect = 255;
+            value = qadd8(value, 255 - effect);
+        }
+        return scale8(value, rgb_matrix_config.hsv.v);
+    }
+};
+
+TEST_F(RgbMatrixGeometry, DistanceFromCenter) {
+    for (g_rgb_timer = 0; g_rgb_timer < 5000; g_rgb_timer += 1234) {
+        render(CYCLE_OUT_IN);
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            EXPECT_EQ(frame[i].h, (uint8_t)(3 * distance(g_led_config.point[i], k_rgb_matrix_center) / 2 + time())) << "led " << (int)i;
+        }
+    }
+}
+
+TEST_F(RgbMatrixGeometry, AngleAroundCenter) {
+    for (g_rgb_timer = 0; g_rgb_timer < 5000; g_rgb_timer += 1234) {
+        render(CYCLE_PINWHEEL);
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            EXPECT_EQ(frame[i].h, (uint8_t)(angle(g_led_config.point[i]) + time())) << "led " << (int)i;
+        }
+
+        render(CYCLE_SPIRAL);
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            EXPECT_EQ(frame[i].h, (uint8_t)(distance(g_led_config.point[i], k_rgb_matrix_center) - time() - angle(g_led_config.point[i]))) << "led " << (int)i;
+        }
+    }
+}
+
+TEST_F(RgbMatrixGeometry, SplashDistanceFromEveryHit) {
+    set_hits({0, 17, 39}, 100);
+    render(SOLID_MULTISPLASH);
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        EXPECT_EQ(frame[i].v, splash_value(i)) << "led " << (int)i;
+    }
+}
+
+/* Random hits over more distinct LEDs than there are remembered hits, so that
+ * cached distances keep being replaced. */
+TEST_F(RgbMatrixGeometry, SplashFollowsChangingHits) {
+    std::mt19937         rng(1234);
+    std::vector<uint8_t> hits;
+
+    for (unsigned round = 0; round < 300; round++) {
+        if (hits.size() == LED_HITS_TO_REMEMBER) {
+            hits.erase(hits.begin());
+        }
+        hits.push_back(rng() % DRIVER_LED_TOTAL);
+        set_hits(hits, rng() % 400);
+
+        render(SOLID_MULTISPLASH);
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            ASSERT_EQ(frame[i].v, splash_value(i)) << "round " << round << ", led " << (int)i;
+        }
+    }
+}
+
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+TEST_F(RgbMatrixGeometry, UpdateAfterMovingLeds) {
+    led_point_t moved = g_led_config.point[5];
+
+    set_hits({5}, 100);
+    render(SOLID_MULTISPLASH);
+
+    g_led_config.point[5] = {200, 60};
+    rgb_matrix_update_geometry();
+    set_hits({5}, 100);
+    render(CYCLE_OUT_IN);
+    EXPECT_EQ(frame[5].h, (uint8_t)(3 * distance(g_led_config.point[5], k_rgb_matrix_center) / 2 + time()));
+    render(SOLID_MULTISPLASH);
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        EXPECT_EQ(frame[i].v, splash_value(i)) << "led " << (int)i;
+    }
+
+    g_led_config.point[5] = moved;
+    rgb_matrix_update_geometry();
+}
+#endif
+
+TEST_F(RgbMatrixGeometry, FrameCost) {
+    const unsigned iterations = 1000;
+
+    auto measure = [&](bool (*effect)(effect_params_t *)) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            g_rgb_timer = i;
+            render(effect);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+    };
+
+    std::vector<uint8_t> hits;
+    for (uint8_t j = 0; j < LED_HITS_TO_REMEMBER; j++) {
+        hits.push_back(j * 13 % DRIVER_LED_TOTAL);
+    }
+    set_hits(hits, 100);
+
+    std::cout << "[ RGB_GEOM ] " << DRIVER_LED_TOTAL << " leds, ns per frame: spiral " << measure(CYCLE_SPIRAL) << ", multisplash with " << LED_HITS_TO_REMEMBER << " hits " << measure(SOLID_MULTISPLASH) << std::endl;
+}
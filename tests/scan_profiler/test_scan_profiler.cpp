@@ -0,0 +1,160 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+extern "C" {
+void advance_time(uint32_t ms);
+void advance_profiler_ticks(uint32_t ticks);
+
+// Make processing KC_B take a known amount of time
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (keycode == KC_B) {
+        advance_profiler_ticks(250);
+    }
+    return true;
+}
+}
+
+class ScanProfiler : public TestFixture {
+   protected:
+    void SetUp() override {
+        // Start a fresh reporting window, so no report resets the statistics mid-test
+        advance_time(SCAN_PROFILER_REPORT_INTERVAL);
+        scan_profiler_task();
+    }
+
+    scan_profile_stats_t stats(scan_profile_stage_t stage) {
+        scan_profile_stats_t stats;
+        EXPECT_TRUE(scan_profiler_get_stats(stage, &stats));
+        return stats;
+    }
+};
+
+TEST_F(ScanProfiler, EveryScanRecordsEachStage) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+
+    keyboard_task();
+    keyboard_task();
+    keyboard_task();
+
+    EXPECT_EQ(stats(SCAN_PROFILE_KEYBOARD_TASK).count, 3);
+    EXPECT_EQ(stats(SCAN_PROFILE_MATRIX_SCAN).count, 3);
+    EXPECT_EQ(stats(SCAN_PROFILE_ACTION_EXEC).count, 3);
+    EXPECT_EQ(stats(SCAN_PROFILE_QUANTUM_TASK).count, 3);
+    EXPECT_EQ(stats(SCAN_PROFILE_LIGHTING).count, 3);
+    EXPECT_EQ(stats(SCAN_PROFILE_USB_SEND).count, 0);
+    EXPECT_EQ(stats(SCAN_PROFILE_KEYBOARD_TASK).max, 0);
+}
+
+TEST_F(ScanProfiler, SlowStageShowsUpInItsOwnAndEnclosingStages) {
+    TestDriver driver;
+    InSequence s;
+    auto       key_b = KeymapKey(0, 0, 0, KC_B);
+
+    set_keymap({key_b});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    key_b.press();
+    keyboard_task();
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    key_b.release();
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    auto action_exec = stats(SCAN_PROFILE_ACTION_EXEC);
+    EXPECT_EQ(action_exec.count, 2);
+    EXPECT_EQ(action_exec.min, 250);
+    EXPECT_EQ(action_exec.max, 250);
+
+    EXPECT_EQ(stats(SCAN_PROFILE_KEYBOARD_TASK).max, 250);
+    EXPECT_EQ(stats(SCAN_PROFILE_QUANTUM_TASK).max, 0);
+    EXPECT_EQ(stats(SCAN_PROFILE_USB_SEND).count, 2);
+}
+
+TEST_F(ScanProfiler, HistogramStatistics) {
+    for (int i = 0; i < 100; ++i) {
+        scan_profiler_record(SCAN_PROFILE_OLED, 10);
+    }
+    scan_profiler_record(SCAN_PROFILE_OLED, 1010);
+
+    auto oled = stats(SCAN_PROFILE_OLED);
+    EXPECT_EQ(oled.count, 101);
+    EXPECT_EQ(oled.min, 10);
+    EXPECT_EQ(oled.avg, 19);
+    EXPECT_EQ(oled.max, 1010);
+    // The single outlier is above the 99th percentile, which is the top of the [8, 16) bucket
+    EXPECT_EQ(oled.p99, 15);
+
+    // Outliers dominate once they reach 1%
+    scan_profiler_record(SCAN_PROFILE_OLED, 1010);
+    EXPECT_EQ(stats(SCAN_PROFILE_OLED).p99, 1010);
+
+    scan_profiler_reset();
+    EXPECT_EQ(stats(SCAN_PROFILE_OLED).count, 0);
+    EXPECT_EQ(stats(SCAN_PROFILE_OLED).max, 0);
+}
+
+TEST_F(ScanProfiler, HistogramSurvivesBucketOverflow) {
+    for (uint32_t i = 0; i < 70000; ++i) {
+        scan_profiler_record(SCAN_PROFILE_DEBOUNCE, 5);
+    }
+    for (uint32_t i = 0; i < 2000; ++i) {
+        scan_profiler_record(SCAN_PROFILE_DEBOUNCE, 100);
+    }
+
+    auto debounce = stats(SCAN_PROFILE_DEBOUNCE);
+    EXPECT_EQ(debounce.count, 72000);
+    EXPECT_EQ(debounce.min, 5);
+    EXPECT_EQ(debounce.max, 100);
+    EXPECT_EQ(debounce.p99, 100);
+}
+
+TEST_F(ScanProfiler, ReportsAreResetAfterTheInterval) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+
+    idle_for(SCAN_PROFILER_REPORT_INTERVAL);
+    keyboard_task();
+    EXPECT_LT(stats(SCAN_PROFILE_KEYBOARD_TASK).count, SCAN_PROFILER_REPORT_INTERVAL);
+}
+
+TEST_F(ScanProfiler, RawHidReport) {
+    scan_profiler_record(SCAN_PROFILE_USB_SEND, 0x01020304);
+
+    uint8_t data[32] = {0};
+    EXPECT_EQ(scan_profiler_raw_hid_report(SCAN_PROFILE_STAGE_COUNT, data, sizeof(data)), 0);
+    EXPECT_EQ(scan_profiler_raw_hid_report(SCAN_PROFILE_USB_SEND, data, SCAN_PROFILER_RAW_HID_REPORT_SIZE - 1), 0);
+    ASSERT_EQ(scan_profiler_raw_hid_report(SCAN_PROFILE_USB_SEND, data, sizeof(data)), SCAN_PROFILER_RAW_HID_REPORT_SIZE);
+
+    const uint8_t expected[SCAN_PROFILER_RAW_HID_REPORT_SIZE] = {
+        SCAN_PROFILE_USB_SEND,
+        0x00, 0x00, 0x03, 0xE8, // ticks per ms
+        0x00, 0x00, 0x00, 0x01, // count
+        0x01, 0x02, 0x03, 0x04, // min
+        0x01, 0x02, 0x03, 0x04, // avg
+        0x01, 0x02, 0x03, 0x04, // max
+        0x01, 0x02, 0x03, 0x04, // p99
+    };
+    EXPECT_EQ(memcmp(data, expected, sizeof(expected)), 0);
+}
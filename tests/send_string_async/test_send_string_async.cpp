@@ -0,0 +1,213 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+#include <string>
+#include <vector>
+
+#include "keycode.h"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::Invoke;
+
+extern "C" {
+#include "eeprom.h"
+
+void advance_time(uint32_t ms);
+}
+
+namespace {
+
+struct Sent {
+    report_keyboard_t report;
+    uint32_t          time;
+};
+
+std::vector<uintptr_t> completed;
+
+void record_completion(void *cb_arg) {
+    completed.push_back((uintptr_t)cb_arg);
+}
+
+// The loop send_string_with_delay() ran before it was queued, as the reference
+void legacy_send_string(const char *str, uint8_t interval) {
+    while (1) {
+        char ascii_code = *str;
+        if (!ascii_code) break;
+        if (ascii_code == SS_QMK_PREFIX) {
+            ascii_code = *(++str);
+            if (ascii_code == SS_TAP_CODE) {
+                tap_code(*(++str));
+            } else if (ascii_code == SS_DOWN_CODE) {
+                register_code(*(++str));
+            } else if (ascii_code == SS_UP_CODE) {
+                unregister_code(*(++str));
+            } else if (ascii_code == SS_DELAY_CODE) {
+                int     ms      = 0;
+                uint8_t keycode = *(++str);
+                while (isdigit(keycode)) {
+                    ms *= 10;
+                    ms += keycode - '0';
+                    keycode = *(++str);
+                }
+                while (ms--)
+                    wait_ms(1);
+            }
+        } else {
+            send_char(ascii_code);
+        }
+        ++str;
+        uint8_t ms = interval;
+        while (ms--)
+            wait_ms(1);
+    }
+}
+
+const char *const samples[] = {
+    "hello",
+    "Hello, World!",
+    "a" SS_TAP(X_ENTER) "b",
+    SS_DOWN(X_LCTL) "c" SS_UP(X_LCTL),
+    "x" SS_DELAY(20) "y",
+    "~`{}|\\\"",
+    "caps" SS_TAP(X_CAPS) "CAPS" SS_TAP(X_CAPS),
+};
+
+} // namespace
+
+class SendStringAsync : public TestFixture {
+   protected:
+    TestDriver        driver;
+    std::vector<Sent> sent;
+
+    void SetUp() override {
+        completed.clear();
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([this](report_keyboard_t &report) { sent.push_back({report, timer_read32()}); }));
+    }
+
+    void run_until_idle() {
+        for (int i = 0; i < 10000 && send_string_async_pending(); i++) {
+            run_one_scan_loop();
+        }
+        ASSERT_EQ(send_string_async_pending(), 0);
+    }
+
+    std::vector<report_keyboard_t> take_reports() {
+        std::vector<report_keyboard_t> reports;
+        for (auto &s : sent) {
+            reports.push_back(s.report);
+        }
+        sent.clear();
+        return reports;
+    }
+};
+
+TEST_F(SendStringAsync, MatchesBlockingReports) {
+    for (auto sample : samples) {
+        for (uint8_t interval : {0, 3}) {
+            legacy_send_string(sample, interval);
+            auto expected = take_reports();
+            ASSERT_FALSE(expected.empty());
+
+            send_string_with_delay(sample, interval);
+            EXPECT_EQ(take_reports(), expected) << "blocking \"" << sample << "\", interval " << (int)interval;
+
+            EXPECT_TRUE(send_string_async(sample, interval, NULL, NULL));
+            run_until_idle();
+            EXPECT_EQ(take_reports(), expected) << "queued \"" << sample << "\", interval " << (int)interval;
+        }
+    }
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SendStringAsync, DoesNotBlock) {
+    uint32_t start = timer_read32();
+    EXPECT_TRUE(send_string_async("ab" SS_DELAY(50) "c", 0, NULL, NULL));
+    EXPECT_EQ(timer_read32(), start);
+    EXPECT_TRUE(sent.empty());
+
+    run_until_idle();
+    ASSERT_EQ(sent.size(), 6);
+    for (size_t i = 1; i < sent.size(); i++) {
+        EXPECT_GE(sent[i].time - sent[i - 1].time, SEND_STRING_ASYNC_INTERVAL) << "report " << i;
+    }
+    // The release of "b" and the press of "c" sit either side of the delay
+    EXPECT_GE(sent[4].time - sent[3].time, 50);
+    EXPECT_LT(sent[4].time - sent[3].time, 50 + 2 * SEND_STRING_ASYNC_INTERVAL);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SendStringAsync, IntervalIsSpentBetweenCharacters) {
+    EXPECT_TRUE(send_string_async("abc", 10, NULL, NULL));
+    run_until_idle();
+    ASSERT_EQ(sent.size(), 6);
+    EXPECT_GE(sent[2].time - sent[1].time, 10);
+    EXPECT_GE(sent[4].time - sent[3].time, 10);
+    EXPECT_LT(sent[1].time - sent[0].time, 10);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SendStringAsync, CallbacksRunInOrder) {
+    EXPECT_TRUE(send_string_async("a", 0, record_completion, (void *)1));
+    EXPECT_TRUE(send_string_async_P(PSTR("b"), 0, record_completion, (void *)2));
+    EXPECT_EQ(send_string_async_pending(), 2);
+
+    run_one_scan_loop();
+    EXPECT_TRUE(completed.empty());
+
+    run_until_idle();
+    EXPECT_EQ(completed, std::vector<uintptr_t>({1, 2}));
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({{.keys = {KC_A}}, {}, {.keys = {KC_B}}, {}}));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SendStringAsync, QueueFull) {
+    for (int i = 0; i < SEND_STRING_ASYNC_QUEUE_SIZE; i++) {
+        EXPECT_TRUE(send_string_async("a", 0, NULL, NULL));
+    }
+    EXPECT_FALSE(send_string_async("b", 0, NULL, NULL));
+    EXPECT_EQ(send_string_async_pending(), SEND_STRING_ASYNC_QUEUE_SIZE);
+
+    send_string_async_flush();
+    EXPECT_EQ(send_string_async_pending(), 0);
+    EXPECT_EQ(sent.size(), 2 * SEND_STRING_ASYNC_QUEUE_SIZE);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SendStringAsync, BlockingCallFinishesQueueFirst) {
+    EXPECT_TRUE(send_string_async("a", 0, record_completion, (void *)1));
+    run_one_scan_loop();
+    send_string("b");
+    EXPECT_EQ(completed, std::vector<uintptr_t>({1}));
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({{.keys = {KC_A}}, {}, {.keys = {KC_B}}, {}}));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(SendStringAsync, ReadsFromEeprom) {
+    const char text[] = "Hi";
+    for (size_t i = 0; i < sizeof(text); i++) {
+        eeprom_write_byte((uint8_t *)(uintptr_t)(i + 4), text[i]);
+    }
+
+    legacy_send_string(text, 0);
+    auto expected = take_reports();
+
+    EXPECT_TRUE(send_string_async_E((const char *)(uintptr_t)4, 0, NULL, NULL));
+    run_until_idle();
+    EXPECT_EQ(take_reports(), expected);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,181 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+
+using testing::_;
+using testing::Invoke;
+
+/* Every possible tap dance, each sending a letter on a single tap and a
+ * digit on a double tap. */
+#define TAP_DANCE_COUNT 256
+
+static qk_tap_dance_pair_t pairs[TAP_DANCE_COUNT];
+
+extern "C" {
+qk_tap_dance_action_t tap_dance_actions[TAP_DANCE_COUNT];
+}
+
+static struct GeneratedTapDances {
+    GeneratedTapDances() {
+        for (uint16_t i = 0; i < TAP_DANCE_COUNT; i++) {
+            pairs[i]                       = {(uint16_t)(KC_A + i % 26), (uint16_t)(KC_1 + i % 10)};
+            tap_dance_actions[i].fn        = {qk_tap_dance_pair_on_each_tap, qk_tap_dance_pair_finished, qk_tap_dance_pair_reset};
+            tap_dance_actions[i].user_data = &pairs[i];
+        }
+    }
+} generated;
+
+class TapDance : public TestFixture {
+   protected:
+    TestDriver                     driver;
+    std::vector<report_keyboard_t> sent;
+
+    KeymapKey td_0   = KeymapKey(0, 0, 0, TD(0));
+    KeymapKey td_1   = KeymapKey(0, 1, 0, TD(1));
+    KeymapKey td_255 = KeymapKey(0, 2, 0, TD(255));
+    KeymapKey key_z  = KeymapKey(0, 3, 0, KC_Z);
+
+    void SetUp() override {
+        set_keymap({td_0, td_1, td_255, key_z});
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([this](report_keyboard_t &report) { sent.push_back(report); }));
+    }
+
+    void TearDown() override {
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+
+    void tap(KeymapKey &key) {
+        key.press();
+        run_one_scan_loop();
+        key.release();
+        run_one_scan_loop();
+    }
+
+    /* The reports sent so far, without repeats of the same report. */
+    std::vector<report_keyboard_t> take_reports() {
+        std::vector<report_keyboard_t> reports;
+        for (auto &report : sent) {
+            if (reports.empty() || !(reports.back() == report)) {
+                reports.push_back(report);
+            }
+        }
+        sent.clear();
+        return reports;
+    }
+};
+
+static report_keyboard_t report(std::vector<uint8_t> keycodes) {
+    report_keyboard_t report = {};
+    for (auto keycode : keycodes) {
+        add_key_to_report(&report, keycode);
+    }
+    return report;
+}
+
+TEST_F(TapDance, SingleTapWaitsForTappingTerm) {
+    tap(td_0);
+    idle_for(TAPPING_TERM - 10);
+    EXPECT_TRUE(take_reports().empty());
+
+    idle_for(20);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_A}), report({})}));
+}
+
+TEST_F(TapDance, DoubleTap) {
+    tap(td_0);
+    idle_for(TAPPING_TERM / 2);
+    tap(td_0);
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_1}), report({})}));
+}
+
+TEST_F(TapDance, TermCountsFromTheLastTap) {
+    tap(td_255);
+    idle_for(TAPPING_TERM - 10);
+    tap(td_255);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_6}), report({})}));
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_TRUE(take_reports().empty());
+}
+
+TEST_F(TapDance, OtherKeyInterruptsDance) {
+    tap(td_1);
+    tap(key_z);
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_B}), report({}), report({KC_Z}), report({})}));
+}
+
+TEST_F(TapDance, OtherDanceInterruptsDance) {
+    tap(td_1);
+    tap(td_255);
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_B}), report({}), report({KC_V}), report({})}));
+}
+
+TEST_F(TapDance, HeldDancesStayActiveUntilReleased) {
+    td_0.press();
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM + 1);
+    td_255.press();
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_A}), report({KC_A, KC_V})}));
+
+    td_0.release();
+    run_one_scan_loop();
+    td_255.release();
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_V}), report({})}));
+
+    // Both dances start over
+    tap(td_0);
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(take_reports(), std::vector<report_keyboard_t>({report({KC_A}), report({})}));
+}
+
+TEST_F(TapDance, TaskCost) {
+    const unsigned iterations = 10000;
+
+    // Make the whole table eligible for the task
+    tap(td_255);
+    idle_for(TAPPING_TERM + 1);
+
+    auto measure = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < iterations; i++) {
+            tap_dance_task();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+    };
+
+    auto idle = measure();
+    td_0.press();
+    run_one_scan_loop();
+    auto dancing = measure();
+    td_0.release();
+    run_one_scan_loop();
+    idle_for(TAPPING_TERM + 1);
+
+    std::cout << "[ TAPDANCE ] " << TAP_DANCE_COUNT << " dances, ns per task: idle " << idle << ", one dance active " << dancing << std::endl;
+}
@@ -13,4 +13,7 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-CUSTOM_MATRIX=yes
\ No newline at end of file
+CUSTOM_MATRIX=yes
+
+# The test driver stands in for the USB protocol
+OPT_DEFS += -DPROTOCOL_TEST
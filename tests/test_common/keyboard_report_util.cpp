@@ -19,36 +19,66 @@
 #include <algorithm>
 using namespace testing;
 
+extern "C" {
+#include "host.h"
+#include "keycode_config.h"
+}
+
 namespace {
+bool is_nkro(void) {
+#if defined(NKRO_ENABLE)
+    return keyboard_protocol && keymap_config.nkro;
+#else
+    return false;
+#endif
+}
+
 std::vector<uint8_t> get_keys(const report_keyboard_t& report) {
     std::vector<uint8_t> result;
-#if defined(NKRO_ENABLE)
-#    error NKRO support not implemented yet
-#elif defined(RING_BUFFERED_6KRO_REPORT_ENABLE)
+#if defined(RING_BUFFERED_6KRO_REPORT_ENABLE)
 #    error 6KRO support not implemented yet
-#else
+#endif
+#if defined(NKRO_ENABLE)
+    if (is_nkro()) {
+        for (size_t i = 0; i < KEYBOARD_REPORT_BITS * 8; i++) {
+            if (report.nkro.bits[i >> 3] & (1 << (i & 7))) {
+                result.emplace_back(i);
+            }
+        }
+        return result;
+    }
+#endif
     for (size_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
         if (report.keys[i]) {
             result.emplace_back(report.keys[i]);
         }
     }
-#endif
     std::sort(result.begin(), result.end());
     return result;
 }
+
+uint8_t get_mods(const report_keyboard_t& report) {
+#if defined(NKRO_ENABLE)
+    // host_keyboard_send() moves the mods when they live at a different offset in NKRO reports
+    if (is_nkro()) {
+        return report.nkro.mods;
+    }
+#endif
+    return report.mods;
+}
 } // namespace
 
 bool operator==(const report_keyboard_t& lhs, const report_keyboard_t& rhs) {
     auto lhskeys = get_keys(lhs);
     auto rhskeys = get_keys(rhs);
-    return lhs.mods == rhs.mods && lhskeys == rhskeys;
+    return get_mods(lhs) == get_mods(rhs) && lhskeys == rhskeys;
 }
 
 std::ostream& operator<<(std::ostream& stream, const report_keyboard_t& report) {
     auto keys = get_keys(report);
 
     // TODO: This should probably print friendly names for the keys
-    stream << "Keyboard Report: Mods (" << (uint32_t)report.mods << ") Keys (";
+    stream << "Keyboard Report: Mods (" << (uint32_t)get_mods(report) << ") Keys (";
 
     for (auto key = keys.cbegin(); key != keys.cend();) {
         stream << +(*key);
@@ -62,7 +92,7 @@ std::ostream& operator<<(std::ostream& stream, const report_keyboard_t& report)
 }
 
 KeyboardReportMatcher::KeyboardReportMatcher(const std::vector<uint8_t>& keys) {
-    memset(m_report.raw, 0, sizeof(m_report.raw));
+    memset(&m_report, 0, sizeof(m_report));
     for (auto k : keys) {
         if (IS_MOD(k)) {
             m_report.mods |= MOD_BIT(k);
@@ -70,6 +100,11 @@ KeyboardReportMatcher::KeyboardReportMatcher(const std::vector<uint8_t>& keys) {
             add_key_to_report(&m_report, k);
         }
     }
+#if defined(NKRO_ENABLE)
+    if (is_nkro()) {
+        m_report.nkro.mods = m_report.mods;
+    }
+#endif
 }
 
 bool KeyboardReportMatcher::MatchAndExplain(report_keyboard_t& report, MatchResultListener* listener) const {
@@ -18,6 +18,11 @@
 
 TestDriver* TestDriver::m_this = nullptr;
 
+extern "C" {
+// Report protocol, as set by the host once it configured the keyboard
+uint8_t keyboard_protocol = 1;
+}
+
 TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer} {
     host_set_driver(&m_driver);
     m_this = this;
@@ -45,5 +50,5 @@ void TestDriver::send_system(uint16_t data) {
 }
 
 void TestDriver::send_consumer(uint16_t data) {
-    m_this->send_consumer(data);
+    m_this->send_consumer_mock(data);
 }
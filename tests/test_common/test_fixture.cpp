@@ -99,10 +99,12 @@ void TestFixture::add_key(KeymapKey key) {
     }
 
     this->keymap.push_back(key);
+    resolved_layer_cache_clear();
 }
 
 void TestFixture::set_keymap(std::initializer_list<KeymapKey> keys) {
     this->keymap.clear();
+    resolved_layer_cache_clear();
     for (auto& key : keys) {
         add_key(key);
     }
@@ -0,0 +1,213 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vector>
+#include "test_common.hpp"
+
+extern "C" {
+#include "ws2812_encoder.h"
+}
+
+/* One spare symbol past each frame catches writes beyond RGBLED_NUM. */
+static ws2812_symbol_t buffers[2][WS2812_FRAME_SYMBOLS + 1];
+
+static const ws2812_symbol_t guard = 0x5A;
+
+static LED_TYPE make_led(uint8_t r, uint8_t g, uint8_t b) {
+    LED_TYPE led = {};
+    led.r        = r;
+    led.g        = g;
+    led.b        = b;
+#ifdef RGBW
+    led.w        = r ^ g ^ b;
+#endif
+    return led;
+}
+
+/* Reference waveform: the bits of each LED in wire order, most significant first. */
+static std::vector<bool> reference_bits(const LED_TYPE *leds, uint16_t count) {
+    std::vector<bool> bits;
+    for (uint16_t i = 0; i < count; i++) {
+#if (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB)
+        std::vector<uint8_t> bytes = {leds[i].g, leds[i].r, leds[i].b};
+#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB)
+        std::vector<uint8_t> bytes = {leds[i].r, leds[i].g, leds[i].b};
+#elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR)
+        std::vector<uint8_t> bytes = {leds[i].b, leds[i].g, leds[i].r};
+#endif
+#ifdef RGBW
+        // The white channel always follows the colour ones
+        bytes.push_back(leds[i].w);
+#endif
+        for (uint8_t byte : bytes) {
+            for (int8_t bit = 7; bit >= 0; bit--) {
+                bits.push_back(byte & (1 << bit));
+            }
+        }
+    }
+    return bits;
+}
+
+/* Play the symbols back as the line would see them: the high time of every bit period, in ns. */
+static std::vector<uint32_t> high_times(const ws2812_symbol_t *symbols, uint16_t count) {
+    std::vector<uint32_t> times;
+#if defined(WS2812_DRIVER_PWM)
+    for (uint32_t i = 0; i < count * WS2812_SYMBOLS_PER_LED; i++) {
+        times.push_back((uint64_t)symbols[i] * 1000000000 / WS2812_PWM_FREQUENCY);
+    }
+#else
+    // Four SPI bits per WS2812 bit; a valid pulse starts high and never goes high again
+    for (uint32_t i = 0; i < count * WS2812_SYMBOLS_PER_LED; i++) {
+        for (int8_t nibble = 1; nibble >= 0; nibble--) {
+            uint8_t  pulse = (symbols[i] >> (4 * nibble)) & 0x0F;
+            uint32_t high  = 0;
+            while (high < 4 && (pulse & (0x08 >> high))) {
+                high++;
+            }
+            EXPECT_EQ(pulse, (0x0F << (4 - high)) & 0x0F) << "symbol " << i;
+            times.push_back(high * WS2812_TIMING / 4);
+        }
+    }
+#endif
+    return times;
+}
+
+static void expect_waveform(const ws2812_symbol_t *symbols, const LED_TYPE *leds, uint16_t count) {
+    std::vector<bool>     bits  = reference_bits(leds, count);
+    std::vector<uint32_t> times = high_times(symbols, count);
+
+    ASSERT_EQ(bits.size(), times.size());
+    for (size_t i = 0; i < bits.size(); i++) {
+        // T0H and T1H windows accepted by both the WS2812 and the WS2812B
+        if (bits[i]) {
+            EXPECT_GE(times[i], 550) << "bit " << i;
+            EXPECT_LE(times[i], 1050) << "bit " << i;
+        } else {
+            EXPECT_GE(times[i], 200) << "bit " << i;
+            EXPECT_LE(times[i], 500) << "bit " << i;
+        }
+    }
+}
+
+class Ws2812Encoder : public TestFixture {
+   protected:
+    void SetUp() override {
+        for (auto &buffer : buffers) {
+            buffer[WS2812_FRAME_SYMBOLS] = guard;
+        }
+        ws2812_encoder_init(buffers[0], buffers[1]);
+    }
+};
+
+TEST_F(Ws2812Encoder, InitEncodesBlack) {
+    LED_TYPE black[RGBLED_NUM] = {};
+
+    expect_waveform(buffers[0], black, RGBLED_NUM);
+    expect_waveform(buffers[1], black, RGBLED_NUM);
+}
+
+TEST_F(Ws2812Encoder, FrameMatchesReferenceWaveform) {
+    LED_TYPE leds[RGBLED_NUM];
+    for (uint16_t i = 0; i < RGBLED_NUM; i++) {
+        leds[i] = make_led(i * 37, 255 - i * 11, 0x81 ^ i);
+    }
+
+    expect_waveform(ws2812_encoder_encode(leds, RGBLED_NUM), leds, RGBLED_NUM);
+}
+
+TEST_F(Ws2812Encoder, BackBufferIsNotTheOneBeingSent) {
+    LED_TYPE red[RGBLED_NUM], blue[RGBLED_NUM];
+    for (uint16_t i = 0; i < RGBLED_NUM; i++) {
+        red[i]  = make_led(255, 0, 0);
+        blue[i] = make_led(0, 0, 255);
+    }
+
+    ws2812_symbol_t *first = ws2812_encoder_encode(red, RGBLED_NUM);
+    EXPECT_EQ(ws2812_encoder_swap(), first);
+    EXPECT_EQ(ws2812_encoder_front(), first);
+
+    // While the red frame goes out, the blue one is encoded into the other buffer
+    ws2812_symbol_t *second = ws2812_encoder_encode(blue, RGBLED_NUM);
+    EXPECT_NE(second, first);
+    expect_waveform(first, red, RGBLED_NUM);
+    expect_waveform(second, blue, RGBLED_NUM);
+
+    // Re-encoding before the swap keeps writing the same back buffer
+    EXPECT_EQ(ws2812_encoder_encode(red, RGBLED_NUM), second);
+    EXPECT_EQ(ws2812_encoder_swap(), second);
+    EXPECT_EQ(ws2812_encoder_encode(blue, RGBLED_NUM), first);
+    expect_waveform(first, blue, RGBLED_NUM);
+}
+
+TEST_F(Ws2812Encoder, OnlyChangedLedsAreEncoded) {
+    LED_TYPE leds[RGBLED_NUM];
+    for (uint16_t i = 0; i < RGBLED_NUM; i++) {
+        leds[i] = make_led(i, i, i);
+    }
+
+    // Bring both buffers to the same frame
+    ws2812_encoder_encode(leds, RGBLED_NUM);
+    ws2812_encoder_swap();
+    ws2812_symbol_t *symbols = ws2812_encoder_encode(leds, RGBLED_NUM);
+
+    // Scribble over LED 0; it is left alone as long as its colour does not change
+    for (uint8_t i = 0; i < WS2812_SYMBOLS_PER_LED; i++) {
+        symbols[i] = guard;
+    }
+    leds[3] = make_led(200, 100, 50);
+    ws2812_encoder_encode(leds, RGBLED_NUM);
+
+    for (uint8_t i = 0; i < WS2812_SYMBOLS_PER_LED; i++) {
+        EXPECT_EQ(symbols[i], guard);
+    }
+    expect_waveform(&symbols[WS2812_SYMBOLS_PER_LED], &leds[1], RGBLED_NUM - 1);
+}
+
+TEST_F(Ws2812Encoder, ShortFrameKeepsTheRest) {
+    LED_TYPE leds[RGBLED_NUM];
+    for (uint16_t i = 0; i < RGBLED_NUM; i++) {
+        leds[i] = make_led(0, 0, 0);
+    }
+    leds[0] = make_led(10, 20, 30);
+    leds[1] = make_led(40, 50, 60);
+
+    expect_waveform(ws2812_encoder_encode(leds, 2), leds, RGBLED_NUM);
+}
+
+TEST_F(Ws2812Encoder, LongFrameIsClipped) {
+    LED_TYPE leds[RGBLED_NUM + 4];
+    for (uint16_t i = 0; i < RGBLED_NUM + 4; i++) {
+        leds[i] = make_led(255, 255, 255);
+    }
+
+    ws2812_symbol_t *symbols = ws2812_encoder_encode(leds, RGBLED_NUM + 4);
+    expect_waveform(symbols, leds, RGBLED_NUM);
+    EXPECT_EQ(symbols[WS2812_FRAME_SYMBOLS], guard);
+}
+
+#ifdef RGBW
+TEST_F(Ws2812Encoder, WhiteChangeIsEncoded) {
+    LED_TYPE leds[RGBLED_NUM] = {};
+
+    ws2812_symbol_t *symbols = ws2812_encoder_encode(leds, RGBLED_NUM);
+
+    // A change to the white channel alone must not be skipped as an unchanged LED
+    leds[2].w = 0xA5;
+    EXPECT_EQ(ws2812_encoder_encode(leds, RGBLED_NUM), symbols);
+    expect_waveform(symbols, leds, RGBLED_NUM);
+}
+#endif
@@ -60,6 +60,15 @@ ifeq ($(strip $(RING_BUFFERED_6KRO_REPORT_ENABLE)), yes)
     TMK_COMMON_DEFS += -DRING_BUFFERED_6KRO_REPORT_ENABLE
 endif
 
+ifeq ($(strip $(KEYBOARD_REPORT_BITMAP_ENABLE)), yes)
+    TMK_COMMON_DEFS += -DKEYBOARD_REPORT_BITMAP_ENABLE
+endif
+
+ifeq ($(strip $(HOST_REPORT_QUEUE_ENABLE)), yes)
+    TMK_COMMON_DEFS += -DHOST_REPORT_QUEUE_ENABLE
+    TMK_COMMON_SRC += $(PROTOCOL_DIR)/host_report_queue.c
+endif
+
 ifeq ($(strip $(NO_SUSPEND_POWER_DOWN)), yes)
     TMK_COMMON_DEFS += -DNO_SUSPEND_POWER_DOWN
 endif
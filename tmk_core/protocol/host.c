@@ -23,6 +23,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 #include "debug.h"
 #include "digitizer.h"
+#include "scan_profiler.h"
+#ifdef HOST_REPORT_QUEUE_ENABLE
+#    include "host_report_queue.h"
+#endif
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -78,7 +82,13 @@ void host_keyboard_send(report_keyboard_t *report) {
         report->report_id = REPORT_ID_KEYBOARD;
 #endif
     }
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_USB_SEND);
+#ifdef HOST_REPORT_QUEUE_ENABLE
+    host_report_queue_keyboard(report);
+#else
     (*driver->send_keyboard)(report);
+#endif
+    SCAN_PROFILE_END(SCAN_PROFILE_USB_SEND);
 
     if (debug_keyboard) {
         dprint("keyboard_report: ");
@@ -94,7 +104,13 @@ void host_mouse_send(report_mouse_t *report) {
 #ifdef MOUSE_SHARED_EP
     report->report_id = REPORT_ID_MOUSE;
 #endif
+    SCAN_PROFILE_BEGIN(SCAN_PROFILE_USB_SEND);
+#ifdef HOST_REPORT_QUEUE_ENABLE
+    host_report_queue_mouse(report);
+#else
     (*driver->send_mouse)(report);
+#endif
+    SCAN_PROFILE_END(SCAN_PROFILE_USB_SEND);
 }
 
 void host_system_send(uint16_t report) {
@@ -110,7 +126,11 @@ void host_consumer_send(uint16_t report) {
     last_consumer_report = report;
 
     if (!driver) return;
+#ifdef HOST_REPORT_QUEUE_ENABLE
+    host_report_queue_consumer(report);
+#else
     (*driver->send_consumer)(report);
+#endif
 }
 
 void host_digitizer_send(digitizer_t *digitizer) {
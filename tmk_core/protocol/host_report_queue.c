@@ -0,0 +1,239 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "host.h"
+#include "host_report_queue.h"
+#include "timer.h"
+
+#ifdef NKRO_ENABLE
+#    include "keycode_config.h"
+extern keymap_config_t keymap_config;
+#endif
+
+typedef struct {
+    uint8_t                   head;
+    uint8_t                   count;
+    bool                      busy; // a report went out at last_send
+    uint32_t                  last_send;
+    host_report_queue_stats_t stats;
+} report_queue_t;
+
+static report_queue_t queues[HOST_REPORT_QUEUE_COUNT];
+
+static report_keyboard_t keyboard_reports[HOST_REPORT_QUEUE_KEYBOARD_SIZE];
+static report_keyboard_t last_keyboard_report;
+static bool              has_last_keyboard_report = false;
+static report_mouse_t    mouse_reports[HOST_REPORT_QUEUE_MOUSE_SIZE];
+static uint8_t           last_mouse_buttons     = 0;
+static bool              has_last_mouse_buttons = false;
+static uint16_t          consumer_reports[HOST_REPORT_QUEUE_CONSUMER_SIZE];
+
+static const uint8_t queue_sizes[HOST_REPORT_QUEUE_COUNT] = {
+    [HOST_REPORT_QUEUE_KEYBOARD] = HOST_REPORT_QUEUE_KEYBOARD_SIZE,
+    [HOST_REPORT_QUEUE_MOUSE]    = HOST_REPORT_QUEUE_MOUSE_SIZE,
+    [HOST_REPORT_QUEUE_CONSUMER] = HOST_REPORT_QUEUE_CONSUMER_SIZE,
+};
+
+static inline uint8_t queue_index(host_report_queue_endpoint_t endpoint, uint8_t offset) {
+    return (queues[endpoint].head + offset) % queue_sizes[endpoint];
+}
+
+static inline uint8_t queue_tail(host_report_queue_endpoint_t endpoint) {
+    return queue_index(endpoint, queues[endpoint].count - 1);
+}
+
+static void send_head(host_report_queue_endpoint_t endpoint) {
+    report_queue_t *queue  = &queues[endpoint];
+    host_driver_t * driver = host_get_driver();
+    uint8_t         head   = queue->head;
+
+    queue->head = queue_index(endpoint, 1);
+    queue->count--;
+    queue->busy      = true;
+    queue->last_send = timer_read32();
+    queue->stats.sent++;
+
+    switch (endpoint) {
+        case HOST_REPORT_QUEUE_KEYBOARD:
+            memcpy(&last_keyboard_report, &keyboard_reports[head], sizeof(report_keyboard_t));
+            has_last_keyboard_report = true;
+            if (driver) (*driver->send_keyboard)(&keyboard_reports[head]);
+            break;
+        case HOST_REPORT_QUEUE_MOUSE:
+            last_mouse_buttons     = mouse_reports[head].buttons;
+            has_last_mouse_buttons = true;
+            if (driver) (*driver->send_mouse)(&mouse_reports[head]);
+            break;
+        case HOST_REPORT_QUEUE_CONSUMER:
+            if (driver) (*driver->send_consumer)(consumer_reports[head]);
+            break;
+        default:
+            break;
+    }
+}
+
+static void flush(host_report_queue_endpoint_t endpoint) {
+    report_queue_t *queue = &queues[endpoint];
+    if (!queue->busy || timer_elapsed32(queue->last_send) >= HOST_REPORT_QUEUE_INTERVAL) {
+        if (queue->count) {
+            send_head(endpoint);
+        } else {
+            queue->busy = false;
+        }
+    }
+}
+
+/** \brief Make room for one more report and return its slot
+ */
+static uint8_t push(host_report_queue_endpoint_t endpoint) {
+    report_queue_t *queue = &queues[endpoint];
+    if (queue->count == queue_sizes[endpoint]) {
+        send_head(endpoint);
+        queue->stats.overflowed++;
+    }
+    queue->count++;
+    if (queue->count > queue->stats.max_depth) {
+        queue->stats.max_depth = queue->count;
+    }
+    return queue_tail(endpoint);
+}
+
+/** \brief Checks that going from one report to the next does not press anything
+ */
+static bool keyboard_report_only_releases(const report_keyboard_t *from, const report_keyboard_t *to) {
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        if (to->nkro.mods & ~from->nkro.mods) {
+            return false;
+        }
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+            if (to->nkro.bits[i] & ~from->nkro.bits[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+    if (to->mods & ~from->mods) {
+        return false;
+    }
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (!to->keys[i]) continue;
+
+        bool found = false;
+        for (uint8_t j = 0; j < KEYBOARD_REPORT_KEYS && !found; j++) {
+            found = from->keys[j] == to->keys[i];
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void host_report_queue_keyboard(report_keyboard_t *report) {
+    report_queue_t *queue = &queues[HOST_REPORT_QUEUE_KEYBOARD];
+
+    if (queue->count) {
+        report_keyboard_t *tail = &keyboard_reports[queue_tail(HOST_REPORT_QUEUE_KEYBOARD)];
+        if (memcmp(tail, report, sizeof(report_keyboard_t)) == 0) {
+            queue->stats.dropped++;
+            return;
+        }
+
+        // Dropping the queued report only hides the order of releases, never a press
+        report_keyboard_t *before = NULL;
+        if (queue->count > 1) {
+            before = &keyboard_reports[queue_index(HOST_REPORT_QUEUE_KEYBOARD, queue->count - 2)];
+        } else if (has_last_keyboard_report) {
+            before = &last_keyboard_report;
+        }
+        if (before && keyboard_report_only_releases(before, tail) && keyboard_report_only_releases(tail, report)) {
+            memcpy(tail, report, sizeof(report_keyboard_t));
+            queue->stats.merged++;
+            return;
+        }
+    } else if (has_last_keyboard_report && memcmp(&last_keyboard_report, report, sizeof(report_keyboard_t)) == 0) {
+        queue->stats.dropped++;
+        return;
+    }
+
+    memcpy(&keyboard_reports[push(HOST_REPORT_QUEUE_KEYBOARD)], report, sizeof(report_keyboard_t));
+    flush(HOST_REPORT_QUEUE_KEYBOARD);
+}
+
+static inline bool mouse_delta_fits(int8_t a, int8_t b) {
+    int16_t sum = (int16_t)a + b;
+    return sum >= INT8_MIN && sum <= INT8_MAX;
+}
+
+void host_report_queue_mouse(report_mouse_t *report) {
+    report_queue_t *queue = &queues[HOST_REPORT_QUEUE_MOUSE];
+    bool            moves = report->x || report->y || report->v || report->h;
+
+    if (queue->count) {
+        report_mouse_t *tail = &mouse_reports[queue_tail(HOST_REPORT_QUEUE_MOUSE)];
+        // A report that changes the buttons keeps its own movement, so drags start where they should
+        bool tail_moves_only = queue->count > 1 ? mouse_reports[queue_index(HOST_REPORT_QUEUE_MOUSE, queue->count - 2)].buttons == tail->buttons : has_last_mouse_buttons && last_mouse_buttons == tail->buttons;
+        if (tail_moves_only && tail->buttons == report->buttons && mouse_delta_fits(tail->x, report->x) && mouse_delta_fits(tail->y, report->y) && mouse_delta_fits(tail->v, report->v) && mouse_delta_fits(tail->h, report->h)) {
+            tail->x += report->x;
+            tail->y += report->y;
+            tail->v += report->v;
+            tail->h += report->h;
+            queue->stats.merged++;
+            return;
+        }
+    } else if (!moves && has_last_mouse_buttons && last_mouse_buttons == report->buttons) {
+        // Movement is relative, a report without any is only needed for the buttons
+        queue->stats.dropped++;
+        return;
+    }
+
+    memcpy(&mouse_reports[push(HOST_REPORT_QUEUE_MOUSE)], report, sizeof(report_mouse_t));
+    flush(HOST_REPORT_QUEUE_MOUSE);
+}
+
+void host_report_queue_consumer(uint16_t report) {
+    consumer_reports[push(HOST_REPORT_QUEUE_CONSUMER)] = report;
+    flush(HOST_REPORT_QUEUE_CONSUMER);
+}
+
+void host_report_queue_task(void) {
+    for (uint8_t i = 0; i < HOST_REPORT_QUEUE_COUNT; i++) {
+        flush(i);
+    }
+}
+
+uint8_t host_report_queue_depth(host_report_queue_endpoint_t endpoint) {
+    return endpoint < HOST_REPORT_QUEUE_COUNT ? queues[endpoint].count : 0;
+}
+
+void host_report_queue_get_stats(host_report_queue_endpoint_t endpoint, host_report_queue_stats_t *stats) {
+    if (endpoint >= HOST_REPORT_QUEUE_COUNT) {
+        memset(stats, 0, sizeof(host_report_queue_stats_t));
+        return;
+    }
+    memcpy(stats, &queues[endpoint].stats, sizeof(host_report_queue_stats_t));
+    stats->depth = queues[endpoint].count;
+}
+
+void host_report_queue_reset_stats(void) {
+    for (uint8_t i = 0; i < HOST_REPORT_QUEUE_COUNT; i++) {
+        memset(&queues[i].stats, 0, sizeof(host_report_queue_stats_t));
+    }
+}
@@ -0,0 +1,86 @@
+/* Copyright 2022 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "report.h"
+
+/* Per endpoint queue between host.c and the host driver
+ *
+ * At most one report per endpoint is handed to the driver every
+ * HOST_REPORT_QUEUE_INTERVAL milliseconds, the rest wait in the queue:
+ *  - keyboard reports replace the queued one if both only release keys or mods,
+ *    so no press is lost and presses keep their order,
+ *  - mouse reports with the same buttons have their movement added up,
+ *  - consumer reports are sent in order.
+ * A full queue sends its oldest report right away rather than losing one.
+ */
+
+#ifndef HOST_REPORT_QUEUE_INTERVAL
+#    ifdef USB_POLLING_INTERVAL_MS
+#        define HOST_REPORT_QUEUE_INTERVAL USB_POLLING_INTERVAL_MS
+#    else
+#        define HOST_REPORT_QUEUE_INTERVAL 1
+#    endif
+#endif
+
+#ifndef HOST_REPORT_QUEUE_KEYBOARD_SIZE
+#    define HOST_REPORT_QUEUE_KEYBOARD_SIZE 4
+#endif
+
+#ifndef HOST_REPORT_QUEUE_MOUSE_SIZE
+#    define HOST_REPORT_QUEUE_MOUSE_SIZE 4
+#endif
+
+#ifndef HOST_REPORT_QUEUE_CONSUMER_SIZE
+#    define HOST_REPORT_QUEUE_CONSUMER_SIZE 4
+#endif
+
+typedef enum {
+    HOST_REPORT_QUEUE_KEYBOARD,
+    HOST_REPORT_QUEUE_MOUSE,
+    HOST_REPORT_QUEUE_CONSUMER,
+    HOST_REPORT_QUEUE_COUNT,
+} host_report_queue_endpoint_t;
+
+typedef struct {
+    uint8_t  depth;
+    uint8_t  max_depth;
+    uint16_t sent;
+    uint16_t merged;     // folded into a queued report
+    uint16_t dropped;    // identical to the previous report
+    uint16_t overflowed; // sent early because the queue was full
+} host_report_queue_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void host_report_queue_keyboard(report_keyboard_t *report);
+void host_report_queue_mouse(report_mouse_t *report);
+void host_report_queue_consumer(uint16_t report);
+
+/* Hands the next report of every endpoint whose interval has passed to the driver */
+void host_report_queue_task(void);
+
+uint8_t host_report_queue_depth(host_report_queue_endpoint_t endpoint);
+void    host_report_queue_get_stats(host_report_queue_endpoint_t endpoint, host_report_queue_stats_t *stats);
+void    host_report_queue_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
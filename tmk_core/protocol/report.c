@@ -278,3 +278,198 @@ void clear_keys_from_report(report_keyboard_t* keyboard_report) {
 #endif
     memset(keyboard_report->keys, 0, sizeof(keyboard_report->keys));
 }
+
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+#    ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+#        error "KEYBOARD_REPORT_BITMAP_ENABLE and RING_BUFFERED_6KRO_REPORT_ENABLE cannot be used together"
+#    endif
+
+#    define KEYBOARD_BITMAP_ALL_SLOTS ((uint8_t)((1 << KEYBOARD_REPORT_KEYS) - 1))
+
+static inline uint8_t lowest_bit(uint8_t bits) {
+    return biton(bits & -bits);
+}
+
+static inline bool keyboard_bitmap_use_nkro(void) {
+#    ifdef NKRO_ENABLE
+    return keyboard_protocol && keymap_config.nkro;
+#    else
+    return false;
+#    endif
+}
+
+static inline bool keyboard_bitmap_test(keyboard_bitmap_t* bitmap, uint8_t code) {
+    return bitmap->pressed[code >> 3] & (1 << (code & 7));
+}
+
+static void keyboard_bitmap_set(keyboard_bitmap_t* bitmap, uint8_t code) {
+    bitmap->pressed[code >> 3] |= 1 << (code & 7);
+    bitmap->pressed_bytes |= (uint32_t)1 << (code >> 3);
+    bitmap->count++;
+}
+
+static void keyboard_bitmap_reset(keyboard_bitmap_t* bitmap, uint8_t code) {
+    bitmap->pressed[code >> 3] &= ~(1 << (code & 7));
+    if (!bitmap->pressed[code >> 3]) {
+        bitmap->pressed_bytes &= ~((uint32_t)1 << (code >> 3));
+    }
+    bitmap->count--;
+}
+
+/** \brief Put a key into the report, without checking the bitmap
+ *
+ * Returns false if the report has no room for it.
+ */
+static bool keyboard_bitmap_emit(keyboard_bitmap_t* bitmap, uint8_t code) {
+#    ifdef NKRO_ENABLE
+    if (bitmap->nkro) {
+        if ((code >> 3) >= KEYBOARD_REPORT_BITS) {
+            dprintf("keyboard_bitmap_add_key: can't add: %02X\n", code);
+            return false;
+        }
+        bitmap->report->nkro.bits[code >> 3] |= 1 << (code & 7);
+        return true;
+    }
+#    endif
+    uint8_t free_slots = ~bitmap->slots & KEYBOARD_BITMAP_ALL_SLOTS;
+    if (!free_slots) {
+        return false;
+    }
+    // Same slot the linear builder would pick, so both produce identical reports
+    uint8_t slot               = lowest_bit(free_slots);
+    bitmap->report->keys[slot] = code;
+    bitmap->slots |= 1 << slot;
+    return true;
+}
+
+/** \brief Rebuild the report if the host switched between 6KRO and NKRO
+ *
+ * Keys that do not fit the new layout are released.
+ */
+static void keyboard_bitmap_sync_protocol(keyboard_bitmap_t* bitmap) {
+    bool nkro = keyboard_bitmap_use_nkro();
+    if (nkro == bitmap->nkro) {
+        return;
+    }
+
+    uint8_t pressed[sizeof(bitmap->pressed)];
+    memcpy(pressed, bitmap->pressed, sizeof(pressed));
+    keyboard_bitmap_clear_keys(bitmap);
+    bitmap->nkro = nkro;
+
+    for (uint16_t code = 0; code < sizeof(pressed) * 8; code++) {
+        if ((pressed[code >> 3] & (1 << (code & 7))) && keyboard_bitmap_emit(bitmap, code)) {
+            keyboard_bitmap_set(bitmap, code);
+        }
+    }
+    bitmap->changed = true;
+}
+
+/** \brief Start tracking an empty report
+ */
+void keyboard_bitmap_init(keyboard_bitmap_t* bitmap, report_keyboard_t* report) {
+    memset(bitmap, 0, sizeof(keyboard_bitmap_t));
+    bitmap->report = report;
+    bitmap->nkro   = keyboard_bitmap_use_nkro();
+}
+
+/** \brief Add a key to the report, in constant time
+ *
+ * As with add_key_to_report, keys that do not fit into a full 6KRO report are dropped.
+ */
+void keyboard_bitmap_add_key(keyboard_bitmap_t* bitmap, uint8_t code) {
+    keyboard_bitmap_sync_protocol(bitmap);
+    if (code == KC_NO || keyboard_bitmap_test(bitmap, code)) {
+        return;
+    }
+    if (keyboard_bitmap_emit(bitmap, code)) {
+        keyboard_bitmap_set(bitmap, code);
+        bitmap->changed = true;
+    }
+}
+
+/** \brief Remove a key from the report
+ *
+ * Keys which are not in the report return straight away, otherwise at most
+ * KEYBOARD_REPORT_KEYS slots are looked at to find the one to free.
+ */
+void keyboard_bitmap_del_key(keyboard_bitmap_t* bitmap, uint8_t code) {
+    keyboard_bitmap_sync_protocol(bitmap);
+    if (!keyboard_bitmap_test(bitmap, code)) {
+        return;
+    }
+    keyboard_bitmap_reset(bitmap, code);
+    bitmap->changed = true;
+
+#    ifdef NKRO_ENABLE
+    if (bitmap->nkro) {
+        bitmap->report->nkro.bits[code >> 3] &= ~(1 << (code & 7));
+        return;
+    }
+#    endif
+    for (uint8_t slots = bitmap->slots; slots; slots &= slots - 1) {
+        uint8_t slot = lowest_bit(slots);
+        if (bitmap->report->keys[slot] == code) {
+            bitmap->report->keys[slot] = 0;
+            bitmap->slots &= ~(1 << slot);
+            return;
+        }
+    }
+}
+
+/** \brief Remove every key from the report, leaving the mods alone
+ */
+void keyboard_bitmap_clear_keys(keyboard_bitmap_t* bitmap) {
+    if (bitmap->count) {
+        bitmap->changed = true;
+    }
+    memset(bitmap->pressed, 0, sizeof(bitmap->pressed));
+    bitmap->pressed_bytes = 0;
+    bitmap->count         = 0;
+    bitmap->slots         = 0;
+    memset(bitmap->report->keys, 0, sizeof(bitmap->report->keys));
+#    ifdef NKRO_ENABLE
+    memset(bitmap->report->nkro.bits, 0, sizeof(bitmap->report->nkro.bits));
+#    endif
+}
+
+/** \brief Number of keys in the report
+ */
+uint8_t keyboard_bitmap_has_anykey(keyboard_bitmap_t* bitmap) {
+    return bitmap->count;
+}
+
+/** \brief First key of the report
+ *
+ * Same as get_first_key: in NKRO mode this is the highest keycode of the lowest
+ * byte of the bit array with a key in it, in 6KRO mode whatever is in the first
+ * slot, which is 0 if that key was released.
+ */
+uint8_t keyboard_bitmap_get_first_key(keyboard_bitmap_t* bitmap) {
+    if (bitmap->nkro) {
+        if (!bitmap->pressed_bytes) {
+            return 0;
+        }
+        uint8_t i = biton32(bitmap->pressed_bytes & -bitmap->pressed_bytes);
+        return i << 3 | biton(bitmap->pressed[i]);
+    }
+    return bitmap->report->keys[0];
+}
+
+/** \brief Checks if a key is in the report, in constant time
+ */
+bool keyboard_bitmap_is_key_pressed(keyboard_bitmap_t* bitmap, uint8_t code) {
+    return code != KC_NO && keyboard_bitmap_test(bitmap, code);
+}
+
+/** \brief Whether the keys changed since the last call
+ *
+ * Changes to the mods are not tracked, those are written straight into the report.
+ */
+bool keyboard_bitmap_take_changed(keyboard_bitmap_t* bitmap) {
+    keyboard_bitmap_sync_protocol(bitmap);
+    bool changed    = bitmap->changed;
+    bitmap->changed = false;
+    return changed;
+}
+#endif
@@ -133,6 +133,9 @@ enum desktop_usages {
 #        define KEYBOARD_REPORT_BITS (NKRO_EPSIZE - 1)
 #        undef NKRO_SHARED_EP
 #        undef MOUSE_SHARED_EP
+#    elif defined(PROTOCOL_TEST)
+// Same size as the shared endpoint of LUFA and ChibiOS
+#        define KEYBOARD_REPORT_BITS 30
 #    else
 #        error "NKRO not supported with this protocol"
 #    endif
@@ -320,6 +323,33 @@ void add_key_to_report(report_keyboard_t* keyboard_report, uint8_t key);
 void del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key);
 void clear_keys_from_report(report_keyboard_t* keyboard_report);
 
+#ifdef KEYBOARD_REPORT_BITMAP_ENABLE
+/* Keyboard report builder backed by a bitmap of the pressed keys
+ *
+ * The bitmap is the source of truth, the 6KRO key array or the NKRO bits of the
+ * report are updated alongside it, so that adding, removing and querying keys
+ * never has to search the report.
+ */
+typedef struct {
+    report_keyboard_t* report;
+    uint8_t            pressed[32];   // one bit per keycode
+    uint32_t           pressed_bytes; // bit n is set if pressed[n] is not zero
+    uint8_t            count;
+    uint8_t            slots; // bit n is set if keys[n] is in use
+    bool               nkro;
+    bool               changed;
+} keyboard_bitmap_t;
+
+void    keyboard_bitmap_init(keyboard_bitmap_t* bitmap, report_keyboard_t* report);
+void    keyboard_bitmap_add_key(keyboard_bitmap_t* bitmap, uint8_t code);
+void    keyboard_bitmap_del_key(keyboard_bitmap_t* bitmap, uint8_t code);
+void    keyboard_bitmap_clear_keys(keyboard_bitmap_t* bitmap);
+uint8_t keyboard_bitmap_has_anykey(keyboard_bitmap_t* bitmap);
+uint8_t keyboard_bitmap_get_first_key(keyboard_bitmap_t* bitmap);
+bool    keyboard_bitmap_is_key_pressed(keyboard_bitmap_t* bitmap, uint8_t code);
+bool    keyboard_bitmap_take_changed(keyboard_bitmap_t* bitmap);
+#endif
+
 #ifdef __cplusplus
 }
 #endif